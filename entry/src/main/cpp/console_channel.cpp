@@ -0,0 +1,139 @@
+#include "console_channel.h"
+#include <algorithm>
+
+namespace {
+
+inline bool IsUtf8Continuation(char c)
+{
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+} // namespace
+
+ConsoleChannel::ConsoleChannel(Deliver deliver, size_t capacity, size_t batchBytes,
+                               std::chrono::milliseconds interval, unsigned maxInFlight)
+    : deliver_(std::move(deliver)),
+      capacity_(std::max(capacity, batchBytes)),
+      batch_bytes_(batchBytes),
+      interval_(interval),
+      max_in_flight_(std::max(1u, maxInFlight))
+{
+    pending_.reserve(capacity_);
+    thread_ = std::thread(&ConsoleChannel::Run, this);
+}
+
+ConsoleChannel::~ConsoleChannel()
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void ConsoleChannel::Write(const char* data, size_t len)
+{
+    if (!data || len == 0) return;
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stats_.bytes_in += len;
+        if (pending_.empty()) {
+            first_byte_ = std::chrono::steady_clock::now();
+            wake = true;
+        }
+        // 单次写入超过容量：只保留末尾
+        if (len > capacity_) {
+            const size_t skip = len - capacity_;
+            dropped_unreported_ += pending_.size() + skip;
+            stats_.dropped_bytes += pending_.size() + skip;
+            pending_.clear();
+            data += skip;
+            len = capacity_;
+        }
+        // 缓冲满：丢弃最旧的字节，切点对齐到 UTF-8 字符边界
+        if (pending_.size() + len > capacity_) {
+            size_t drop = pending_.size() + len - capacity_;
+            while (drop < pending_.size() && IsUtf8Continuation(pending_[drop])) drop++;
+            pending_.erase(0, drop);
+            dropped_unreported_ += drop;
+            stats_.dropped_bytes += drop;
+        }
+        const size_t before = pending_.size();
+        pending_.append(data, len);
+        wake = wake || (before < batch_bytes_ && pending_.size() >= batch_bytes_);
+    }
+    if (wake) cv_.notify_one();
+}
+
+void ConsoleChannel::Ack()
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (stats_.in_flight > 0) stats_.in_flight--;
+    }
+    cv_.notify_one();
+}
+
+void ConsoleChannel::ResetInFlight()
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stats_.in_flight = 0;
+    }
+    cv_.notify_one();
+}
+
+ConsoleChannel::Stats ConsoleChannel::GetStats()
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    Stats s = stats_;
+    s.buffered = pending_.size();
+    return s;
+}
+
+size_t ConsoleChannel::TakeLengthLocked() const
+{
+    size_t n = std::min(pending_.size(), batch_bytes_);
+    if (n < pending_.size()) {
+        // 不把多字节字符拆到两个批次里
+        size_t cut = n;
+        while (cut > 0 && IsUtf8Continuation(pending_[cut])) cut--;
+        if (cut > 0) n = cut;
+    }
+    return n;
+}
+
+void ConsoleChannel::Run()
+{
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (!stop_) {
+        if (pending_.empty() || stats_.in_flight >= max_in_flight_) {
+            cv_.wait(lk);
+            continue;
+        }
+        const auto due = first_byte_ + interval_;
+        if (pending_.size() < batch_bytes_ && std::chrono::steady_clock::now() < due) {
+            cv_.wait_until(lk, due);
+            continue;
+        }
+
+        const size_t n = TakeLengthLocked();
+        std::string batch(pending_, 0, n);
+        pending_.erase(0, n);
+        const uint64_t dropped = dropped_unreported_;
+        dropped_unreported_ = 0;
+        stats_.in_flight++;
+
+        lk.unlock();
+        const bool delivered = deliver_(std::move(batch), dropped);
+        lk.lock();
+        if (delivered) {
+            stats_.batches++;
+            stats_.bytes_out += n;
+        } else if (stats_.in_flight > 0) {
+            stats_.in_flight--;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef CONSOLE_CHANNEL_H
+#define CONSOLE_CHANNEL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 控制台输出合并通道：串口桥接 / stdout 捕获线程写入字节，后台线程按时间（默认 16ms）或大小（64KB）
+// 合并成批次交给 UI。UI 未确认的批次达到上限时数据留在有界缓冲里，缓冲满则丢弃最旧的字节并计数。
+// 写入方从不阻塞，避免反压到 QEMU 的 stdout/串口上拖慢来宾。
+class ConsoleChannel {
+public:
+    // 返回 false 表示当前没有接收方，该批次直接丢弃（不计入 in-flight）
+    using Deliver = std::function<bool(std::string&& batch, uint64_t droppedBytes)>;
+
+    struct Stats {
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t batches = 0;
+        uint64_t dropped_bytes = 0;
+        size_t buffered = 0;
+        unsigned in_flight = 0;
+    };
+
+    explicit ConsoleChannel(Deliver deliver, size_t capacity = 1024 * 1024, size_t batchBytes = 64 * 1024,
+                            std::chrono::milliseconds interval = std::chrono::milliseconds(16),
+                            unsigned maxInFlight = 2);
+    ~ConsoleChannel();
+
+    ConsoleChannel(const ConsoleChannel&) = delete;
+    ConsoleChannel& operator=(const ConsoleChannel&) = delete;
+
+    void Write(const char* data, size_t len);
+    void Write(const std::string& s) { Write(s.data(), s.size()); }
+    // UI 处理完一个批次（在 JS 线程调用）
+    void Ack();
+    // 接收方更换：未确认的批次作废，缓冲内容保留
+    void ResetInFlight();
+    Stats GetStats();
+
+private:
+    void Run();
+    size_t TakeLengthLocked() const;
+
+    Deliver deliver_;
+    const size_t capacity_;
+    const size_t batch_bytes_;
+    const std::chrono::milliseconds interval_;
+    const unsigned max_in_flight_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::string pending_;
+    std::chrono::steady_clock::time_point first_byte_ {};
+    uint64_t dropped_unreported_ = 0;
+    Stats stats_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+#endif // CONSOLE_CHANNEL_H
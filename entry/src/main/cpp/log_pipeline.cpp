@@ -0,0 +1,378 @@
+#include "log_pipeline.h"
+#include "log_store.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(__OHOS__)
+#include <hilog/log.h>
+#endif
+
+namespace {
+
+// 环：4096 个槽（约 1MB）。长记录占用连续多个槽，上限 kMaxParts 个，超出截断
+constexpr size_t kSlots = 4096;
+constexpr size_t kSlotData = 232;
+constexpr size_t kMaxParts = 64;
+constexpr size_t kMaxSinks = 256;
+constexpr size_t kDrainBatch = 1024;
+constexpr off_t kRotateBytes = 8 * 1024 * 1024;
+constexpr auto kIdleWait = std::chrono::milliseconds(50);
+
+struct Slot {
+    std::atomic<uint64_t> seq { 0 };
+    uint32_t len = 0;          // 记录总长度（仅首槽有效）
+    uint16_t sink = 0;
+    uint8_t flags = 0;
+    uint8_t parts = 0;
+    char data[kSlotData];
+};
+
+struct Sink {
+    std::string path;
+    std::string tag;
+    int fd = -1;               // 以下字段只在日志线程（持有 g_drain_mutex）访问
+    off_t size = 0;
+    bool failed = false;
+    std::string pending;
+};
+
+Slot g_slots[kSlots];
+alignas(64) std::atomic<uint64_t> g_enqueue { 0 };
+alignas(64) uint64_t g_dequeue = 0;            // 受 g_drain_mutex 保护
+std::atomic<uint64_t> g_dropped { 0 };
+uint64_t g_dropped_reported = 0;
+
+Sink g_sinks[kMaxSinks];
+std::atomic<size_t> g_sink_count { 1 };       // 0 号保留为“无文件”
+std::mutex g_sink_mutex;
+std::map<std::string, int> g_sink_ids;
+
+std::mutex g_drain_mutex;
+LogTapFn g_tap;                                // 受 g_drain_mutex 保护
+
+std::mutex g_wake_mutex;
+std::condition_variable g_wake_cv;
+std::atomic<bool> g_consumer_idle { false };
+std::once_flag g_start_once;
+
+void InitSlots()
+{
+    for (size_t i = 0; i < kSlots; i++) g_slots[i].seq.store(i, std::memory_order_relaxed);
+}
+
+void MakeParentDirs(const std::string& path)
+{
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+}
+
+void SystemLog(const char* msg)
+{
+#if defined(__OHOS__)
+    OH_LOG_Print(LOG_APP, LOG_INFO, 0x0000, "QEMU_CORE", "%{public}s", msg);
+#else
+    // 回退：stderr 也会被系统日志采集
+    std::fprintf(stderr, "[QEMU_CORE] %s\n", msg);
+#endif
+}
+
+void OpenSink(Sink& s)
+{
+    MakeParentDirs(s.path);
+    s.fd = open(s.path.c_str(), O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, 0644);
+    if (s.fd < 0) {
+        if (!s.failed) SystemLog(("[log] cannot open " + s.path + ": " + strerror(errno)).c_str());
+        s.failed = true;
+        return;
+    }
+    s.failed = false;
+    struct stat st;
+    s.size = fstat(s.fd, &st) == 0 ? st.st_size : 0;
+}
+
+void WriteSink(Sink& s)
+{
+    if (s.pending.empty()) return;
+    if (s.fd < 0) OpenSink(s);
+    if (s.fd >= 0) {
+        const char* p = s.pending.data();
+        size_t left = s.pending.size();
+        while (left > 0) {
+            ssize_t n = write(s.fd, p, left);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        s.size += static_cast<off_t>(s.pending.size() - left);
+        if (s.size >= kRotateBytes) {
+            close(s.fd);
+            s.fd = -1;
+            rename(s.path.c_str(), (s.path + ".1").c_str());
+        }
+    }
+    // 保留容量，后续批次不再分配
+    s.pending.clear();
+}
+
+// 需持有 g_drain_mutex。返回处理的记录数
+size_t DrainLocked()
+{
+    static std::string record;
+    size_t count = 0;
+    bool touched[kMaxSinks] = { false };
+    const size_t sinkCount = g_sink_count.load(std::memory_order_acquire);
+
+    while (count < kDrainBatch) {
+        Slot& head = g_slots[g_dequeue & (kSlots - 1)];
+        if (head.seq.load(std::memory_order_acquire) != g_dequeue + 1) break;
+        // 多槽记录从尾到头发布：首槽可见即全部可见
+        const size_t parts = head.parts;
+        const size_t len = head.len;
+        const unsigned flags = head.flags;
+        const size_t sinkId = head.sink;
+        record.assign(head.data, std::min(len, kSlotData));
+        for (size_t i = 1; i < parts; i++) {
+            const Slot& s = g_slots[(g_dequeue + i) & (kSlots - 1)];
+            record.append(s.data, std::min(len - i * kSlotData, kSlotData));
+        }
+        for (size_t i = 0; i < parts; i++) {
+            g_slots[(g_dequeue + i) & (kSlots - 1)].seq.store(g_dequeue + i + kSlots, std::memory_order_release);
+        }
+        g_dequeue += parts;
+        count++;
+
+        if ((flags & (kLogFile | kLogRaw)) && sinkId > 0 && sinkId < sinkCount) {
+            Sink& s = g_sinks[sinkId];
+            s.pending += record;
+            if (flags & kLogFile) s.pending += '\n';
+            touched[sinkId] = true;
+        }
+        if ((flags & kLogTap) && sinkId > 0 && sinkId < sinkCount && !g_sinks[sinkId].tag.empty()) {
+            const std::string& tag = g_sinks[sinkId].tag;
+            log_store_append(tag, record);
+            if (g_tap) g_tap(tag, record);
+        }
+        if (flags & kLogHilog) SystemLog(record.c_str());
+    }
+
+    const uint64_t dropped = g_dropped.load(std::memory_order_relaxed);
+    if (dropped != g_dropped_reported) {
+        const std::string note = "[log] " + std::to_string(dropped - g_dropped_reported) +
+                                 " records dropped (log ring full)";
+        g_dropped_reported = dropped;
+        SystemLog(note.c_str());
+        for (size_t i = 1; i < sinkCount; i++) {
+            if (touched[i]) g_sinks[i].pending += note + '\n';
+        }
+    }
+    for (size_t i = 1; i < sinkCount; i++) {
+        if (touched[i]) WriteSink(g_sinks[i]);
+    }
+    return count;
+}
+
+void ConsumerLoop()
+{
+    while (true) {
+        size_t n;
+        {
+            std::lock_guard<std::mutex> lk(g_drain_mutex);
+            n = DrainLocked();
+        }
+        if (n >= kDrainBatch) continue;
+        // 空闲时等待唤醒；错过的唤醒最多延迟 kIdleWait，日志在此期间自然攒成一批
+        std::unique_lock<std::mutex> lk(g_wake_mutex);
+        g_consumer_idle.store(true, std::memory_order_seq_cst);
+        g_wake_cv.wait_for(lk, kIdleWait);
+        g_consumer_idle.store(false, std::memory_order_relaxed);
+    }
+}
+
+void EnsureStarted()
+{
+    std::call_once(g_start_once, []() {
+        InitSlots();
+        std::thread(ConsumerLoop).detach();
+        // QEMU 可能在本进程内直接 exit()：退出前把环里的记录落盘
+        atexit(log_flush);
+    });
+}
+
+// 当前秒的时间戳前缀按线程缓存，每秒只格式化一次
+std::string_view TimestampPrefix()
+{
+    thread_local time_t cachedSec = 0;
+    thread_local char buf[32];
+    thread_local size_t len = 0;
+    const time_t now = time(nullptr);
+    if (now != cachedSec || len == 0) {
+        struct tm tmv;
+        localtime_r(&now, &tmv);
+        len = strftime(buf, sizeof(buf), "[%Y-%m-%d %H:%M:%S] ", &tmv);
+        cachedSec = now;
+    }
+    return std::string_view(buf, len);
+}
+
+} // namespace
+
+int log_sink(const std::string& path, const std::string& tag)
+{
+    if (path.empty()) return 0;
+    // 同一线程反复写同一文件（WriteLog）时免锁
+    thread_local std::string lastPath;
+    thread_local int lastId = 0;
+    if (lastId != 0 && path == lastPath) return lastId;
+
+    std::lock_guard<std::mutex> lk(g_sink_mutex);
+    auto it = g_sink_ids.find(path);
+    int id = 0;
+    if (it != g_sink_ids.end()) {
+        id = it->second;
+    } else {
+        const size_t n = g_sink_count.load(std::memory_order_relaxed);
+        if (n >= kMaxSinks) return 0;
+        g_sinks[n].path = path;
+        g_sinks[n].tag = tag;
+        g_sink_count.store(n + 1, std::memory_order_release);
+        g_sink_ids[path] = static_cast<int>(n);
+        id = static_cast<int>(n);
+    }
+    lastPath = path;
+    lastId = id;
+    return id;
+}
+
+bool log_submit(int sink, unsigned flags, std::string_view prefix, std::string_view msg)
+{
+    EnsureStarted();
+    const std::string_view ts = (flags & kLogTimestamp) ? TimestampPrefix() : std::string_view();
+    size_t len = ts.size() + prefix.size() + msg.size();
+    len = std::min(len, kMaxParts * kSlotData);
+    const size_t parts = std::max<size_t>(1, (len + kSlotData - 1) / kSlotData);
+
+    // 一次 CAS 预留连续 parts 个槽（Vyukov 有界队列的多槽变体）
+    uint64_t pos = g_enqueue.load(std::memory_order_relaxed);
+    while (true) {
+        bool stale = false;
+        bool full = false;
+        for (size_t i = 0; i < parts; i++) {
+            const uint64_t seq = g_slots[(pos + i) & (kSlots - 1)].seq.load(std::memory_order_acquire);
+            const int64_t dif = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + i);
+            if (dif < 0) {
+                full = true;
+                break;
+            }
+            if (dif > 0) {
+                stale = true;
+                break;
+            }
+        }
+        if (full) {
+            const uint64_t cur = g_enqueue.load(std::memory_order_relaxed);
+            if (cur == pos) {
+                g_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            pos = cur;
+            continue;
+        }
+        if (stale) {
+            pos = g_enqueue.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (g_enqueue.compare_exchange_weak(pos, pos + parts, std::memory_order_relaxed)) break;
+    }
+
+    // 拷贝 ts + prefix + msg 到连续槽
+    size_t written = 0;
+    auto copy = [&](std::string_view part) {
+        size_t off = 0;
+        while (off < part.size() && written < len) {
+            Slot& s = g_slots[(pos + written / kSlotData) & (kSlots - 1)];
+            const size_t inSlot = written % kSlotData;
+            const size_t n = std::min({ part.size() - off, kSlotData - inSlot, len - written });
+            memcpy(s.data + inSlot, part.data() + off, n);
+            off += n;
+            written += n;
+        }
+    };
+    copy(ts);
+    copy(prefix);
+    copy(msg);
+
+    Slot& head = g_slots[pos & (kSlots - 1)];
+    head.len = static_cast<uint32_t>(len);
+    head.sink = static_cast<uint16_t>(sink > 0 ? sink : 0);
+    head.flags = static_cast<uint8_t>(flags);
+    head.parts = static_cast<uint8_t>(parts);
+    for (size_t i = parts; i-- > 0;) {
+        g_slots[(pos + i) & (kSlots - 1)].seq.store(pos + i + 1, std::memory_order_release);
+    }
+
+    if (g_consumer_idle.load(std::memory_order_seq_cst)) g_wake_cv.notify_one();
+    return true;
+}
+
+void log_flush()
+{
+    EnsureStarted();
+    std::lock_guard<std::mutex> lk(g_drain_mutex);
+    while (DrainLocked() > 0) {
+    }
+}
+
+bool log_truncate(const std::string& path)
+{
+    if (path.empty()) return false;
+    EnsureStarted();
+    int id = 0;
+    {
+        std::lock_guard<std::mutex> lk(g_sink_mutex);
+        auto it = g_sink_ids.find(path);
+        if (it != g_sink_ids.end()) id = it->second;
+    }
+
+    std::lock_guard<std::mutex> lk(g_drain_mutex);
+    // 已提交的记录先落盘，避免清空后又被写回
+    while (DrainLocked() > 0) {
+    }
+    if (id > 0) {
+        Sink& s = g_sinks[id];
+        if (s.fd >= 0) {
+            close(s.fd);
+            s.fd = -1;
+        }
+        s.size = 0;
+        s.failed = false;
+    }
+    unlink((path + ".1").c_str());
+    const int fd = open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT;
+    close(fd);
+    return true;
+}
+
+uint64_t log_dropped()
+{
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+void log_set_tap(LogTapFn tap)
+{
+    std::lock_guard<std::mutex> lk(g_drain_mutex);
+    g_tap = std::move(tap);
+}
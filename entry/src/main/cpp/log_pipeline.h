@@ -0,0 +1,42 @@
+#ifndef LOG_PIPELINE_H
+#define LOG_PIPELINE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <functional>
+
+// 异步日志管线：
+// - 生产者把预格式化的记录写进有界 MPSC 无锁环（不加锁、不分配、不做 IO），环满时丢弃并计数
+// - 单个后台线程批量取出：每个文件一个常驻 fd，一批记录合并为一次 write；超过大小上限轮转为 <path>.1
+// - hilog 输出与内存日志（log_store 环形存储 + tap 通知）也在后台线程完成
+
+enum LogFlags : unsigned {
+    kLogFile = 1u << 0,       // 写入 sink 文件（自动追加换行）
+    kLogRaw = 1u << 1,        // 写入 sink 文件，原样不加换行（stdout/stderr 捕获）
+    kLogHilog = 1u << 2,      // 输出到 hilog（QEMU_CORE）
+    kLogTap = 1u << 3,        // 写入 sink tag 对应 VM 的 log_store，并通知 tap
+    kLogTimestamp = 1u << 4,  // 生产者加 "[YYYY-mm-dd HH:MM:SS] " 前缀
+};
+
+// 注册（或查找）日志文件，返回 sink id；tag 为 VM 名（log_store / tap 按它归类）。0 表示不写文件
+int log_sink(const std::string& path, const std::string& tag = "");
+
+// 提交一条记录（prefix + msg）。返回 false 表示环已满被丢弃
+bool log_submit(int sink, unsigned flags, std::string_view prefix, std::string_view msg);
+
+// 在调用线程同步排空环并落盘（进程退出、读取日志文件前）
+void log_flush();
+
+// 清空日志文件：先排空环，再关闭 sink 的常驻 fd、截断文件并删除轮转出的 <path>.1，
+// sink 的大小计数归零，下一批记录重新打开文件。path 未注册为 sink 时只截断文件
+bool log_truncate(const std::string& path);
+
+// 累计丢弃的记录数
+uint64_t log_dropped();
+
+// tap：记录写入 log_store 之后在日志线程中回调，line 不含换行
+using LogTapFn = std::function<void(const std::string& tag, std::string_view line)>;
+void log_set_tap(LogTapFn tap);
+
+#endif // LOG_PIPELINE_H
@@ -0,0 +1,146 @@
+#include "log_store.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// 每个 VM：512KB 文本 + 8192 行索引（约 640KB），按 VM 首次写日志时一次性分配
+constexpr size_t kRingBytes = 512 * 1024;
+constexpr size_t kRingLines = 8192;
+constexpr size_t kMaxLine = 16 * 1024;
+
+struct LineRef {
+    uint64_t start = 0;           // 在字节流中的绝对偏移
+    uint32_t len = 0;
+};
+
+class LogRing {
+public:
+    LogRing() : bytes_(kRingBytes), index_(kRingLines) {}
+
+    uint64_t Append(std::string_view line)
+    {
+        const size_t len = std::min(line.size(), kMaxLine);
+        const uint64_t end = write_end_ + len;
+        // 淘汰被新数据覆盖的行，以及超出索引容量的行
+        while (first_ < next_ &&
+               (next_ - first_ >= kRingLines || At(first_).start + kRingBytes < end)) {
+            first_++;
+        }
+        const size_t off = static_cast<size_t>(write_end_ % kRingBytes);
+        const size_t head = std::min(len, kRingBytes - off);
+        memcpy(bytes_.data() + off, line.data(), head);
+        memcpy(bytes_.data(), line.data() + head, len - head);
+
+        LineRef& ref = index_[next_ % kRingLines];
+        ref.start = write_end_;
+        ref.len = static_cast<uint32_t>(len);
+        write_end_ = end;
+        return next_++;
+    }
+
+    // 拷出一行（可能跨环尾）
+    void AppendLineTo(uint64_t seq, std::string& out) const
+    {
+        const LineRef& ref = At(seq);
+        const size_t off = static_cast<size_t>(ref.start % kRingBytes);
+        const size_t head = std::min<size_t>(ref.len, kRingBytes - off);
+        out.append(bytes_.data() + off, head);
+        out.append(bytes_.data(), ref.len - head);
+    }
+
+    uint32_t Length(uint64_t seq) const { return At(seq).len; }
+    void Clear() { first_ = next_; }
+
+    uint64_t first_ = 1;
+    uint64_t next_ = 1;
+
+private:
+    const LineRef& At(uint64_t seq) const { return index_[seq % kRingLines]; }
+
+    std::vector<char> bytes_;
+    std::vector<LineRef> index_;
+    uint64_t write_end_ = 0;
+};
+
+std::mutex g_store_mutex;
+std::map<std::string, std::unique_ptr<LogRing>> g_rings;
+
+LogRing* FindLocked(const std::string& vm)
+{
+    auto it = g_rings.find(vm);
+    return it == g_rings.end() ? nullptr : it->second.get();
+}
+
+} // namespace
+
+uint64_t log_store_append(const std::string& vm, std::string_view line)
+{
+    std::lock_guard<std::mutex> lk(g_store_mutex);
+    auto& ring = g_rings[vm];
+    if (!ring) ring = std::make_unique<LogRing>();
+    return ring->Append(line);
+}
+
+LogStoreRead log_store_read(const std::string& vm, uint64_t since_seq, size_t max_bytes)
+{
+    LogStoreRead r;
+    std::lock_guard<std::mutex> lk(g_store_mutex);
+    const LogRing* ring = FindLocked(vm);
+    if (!ring) {
+        r.first_seq = r.next_seq = std::max<uint64_t>(since_seq, 1);
+        return r;
+    }
+    uint64_t seq = since_seq;
+    if (seq < ring->first_) {
+        r.gap = since_seq != 0;
+        seq = ring->first_;
+    }
+    seq = std::min(seq, ring->next_);
+    r.first_seq = seq;
+    for (; seq < ring->next_; seq++) {
+        const size_t need = ring->Length(seq) + 1;
+        if (r.lines > 0 && r.text.size() + need > max_bytes) {
+            r.more = true;
+            break;
+        }
+        ring->AppendLineTo(seq, r.text);
+        r.text += '\n';
+        r.lines++;
+    }
+    r.next_seq = seq;
+    return r;
+}
+
+void log_store_visit(const std::string& vm, uint64_t since_seq, size_t max_lines,
+                     const std::function<void(uint64_t seq, std::string_view line)>& fn)
+{
+    std::lock_guard<std::mutex> lk(g_store_mutex);
+    const LogRing* ring = FindLocked(vm);
+    if (!ring) return;
+    std::string line;
+    uint64_t seq = std::max(since_seq, ring->first_);
+    for (size_t n = 0; seq < ring->next_ && n < max_lines; seq++, n++) {
+        line.clear();
+        ring->AppendLineTo(seq, line);
+        fn(seq, line);
+    }
+}
+
+void log_store_bounds(const std::string& vm, uint64_t& first, uint64_t& next)
+{
+    std::lock_guard<std::mutex> lk(g_store_mutex);
+    const LogRing* ring = FindLocked(vm);
+    first = ring ? ring->first_ : 1;
+    next = ring ? ring->next_ : 1;
+}
+
+void log_store_clear(const std::string& vm)
+{
+    std::lock_guard<std::mutex> lk(g_store_mutex);
+    if (LogRing* ring = FindLocked(vm)) ring->Clear();
+}
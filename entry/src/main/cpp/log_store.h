@@ -0,0 +1,38 @@
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// 每个 VM 一个环形日志存储：固定大小的字节区 + 固定条数的行索引，内存占用与 VM 运行时长无关
+// 每行有单调递增的序号（从 1 开始，清空后也不回退），增量查询只取序号之后的新行
+
+struct LogStoreRead {
+    std::string text;             // 各行以 '\n' 结尾拼接成的一个缓冲
+    uint64_t first_seq = 0;       // text 中首行的序号（无新行时等于 next_seq）
+    uint64_t next_seq = 0;        // 下次查询传入的序号
+    uint32_t lines = 0;
+    bool gap = false;             // 请求的起始行已被覆盖，丢失了部分旧行
+    bool more = false;            // 受 max_bytes 限制未取完
+};
+
+// 追加一行（由日志线程调用），返回该行序号
+uint64_t log_store_append(const std::string& vm, std::string_view line);
+
+// 取序号 >= since_seq 的行，总长度不超过 max_bytes（至少返回一行）
+LogStoreRead log_store_read(const std::string& vm, uint64_t since_seq, size_t max_bytes);
+
+// 逐行访问序号 >= since_seq 的行（最多 max_lines 行），回调期间持有存储锁
+void log_store_visit(const std::string& vm, uint64_t since_seq, size_t max_lines,
+                     const std::function<void(uint64_t seq, std::string_view line)>& fn);
+
+// 当前保留的行序号范围 [first, next)
+void log_store_bounds(const std::string& vm, uint64_t& first, uint64_t& next);
+
+// 丢弃已保留的行，序号继续递增
+void log_store_clear(const std::string& vm);
+
+#endif // LOG_STORE_H
@@ -1,6 +1,19 @@
 #include "napi_compat.h"
 #include "qemu_wrapper.h"
+#include "qmp_client.h"
+#include "snapshot_manager.h"
+#include "log_pipeline.h"
+#include "log_store.h"
+#include "console_channel.h"
+#include "vm_runtime.h"
+#include "vm_worker.h"
+#include "tcg_profile.h"
+#include "vm_sched.h"
+#include "plugins/aether_hotspot.h"
+#include "third_party/cjson/cJSON.h"
 #include <cstring>
+#include <cctype>
+#include <cinttypes>
 #include <cstdlib>
 #include <string>
 #include <vector>
@@ -11,13 +24,16 @@
 #include <unistd.h>
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 #include <fstream>
 #include <sstream>
 #include <setjmp.h>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dlfcn.h>
@@ -191,8 +207,87 @@ static bool NapiGetStringUtf8(napi_env env, napi_value value, std::string& out)
 #define EXTERN_C_START extern "C" {
 #define EXTERN_C_END }
 
-// 全局控制台回调
+// 全局控制台回调：不带 vmName 注册时接收所有 VM 的输出（回调第三个参数是来源 VM）
 static napi_threadsafe_function g_consoleCallback = nullptr;
+// 按 VM 注册的控制台回调，优先于全局回调
+static std::map<std::string, napi_threadsafe_function> g_vmConsoleCallbacks;
+static std::mutex g_consoleMutex;   // 保护上面两者的替换/释放与投递
+
+// 控制台批次：来源 VM + 合并后的输出 + 此前因 UI 跟不上而丢弃的字节数
+struct ConsoleBatch {
+    std::string vmName;
+    std::string text;
+    uint64_t droppedBytes = 0;
+};
+
+// 调用方持有 g_consoleMutex
+static napi_threadsafe_function ConsoleCallbackLocked(const std::string& vmName)
+{
+    auto it = g_vmConsoleCallbacks.find(vmName);
+    return it != g_vmConsoleCallbacks.end() ? it->second : g_consoleCallback;
+}
+
+static bool ConsoleHasListener(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lk(g_consoleMutex);
+    return ConsoleCallbackLocked(vmName) != nullptr;
+}
+
+// 释放某个 VM 的专属回调（VM 退出时调用）；全局回调仍服务其它 VM
+static void ConsoleReleaseCallback(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lk(g_consoleMutex);
+    auto it = g_vmConsoleCallbacks.find(vmName);
+    if (it == g_vmConsoleCallbacks.end()) return;
+    napi_release_threadsafe_function(it->second, napi_tsfn_abort);
+    g_vmConsoleCallbacks.erase(it);
+}
+
+// 每个 VM 一条合并通道（串口会话、工作进程转发、stdout/stderr 捕获共用）：
+// 每 16ms 或 64KB 投递一批，UI 未确认的批次最多 2 个；一个 VM 刷屏不会挤掉另一个 VM 的输出
+static std::mutex g_consoleChannelsMutex;
+
+static std::map<std::string, ConsoleChannel*>& ConsoleChannels()
+{
+    // 不析构：QEMU 可能在进程内直接 exit()，避免退出时与投递线程竞争
+    static auto* channels = new std::map<std::string, ConsoleChannel*>();
+    return *channels;
+}
+
+static ConsoleChannel& ConsoleOut(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lk(g_consoleChannelsMutex);
+    ConsoleChannel*& channel = ConsoleChannels()[vmName];
+    if (!channel) {
+        channel = new ConsoleChannel([vmName](std::string&& batch, uint64_t dropped) {
+            std::lock_guard<std::mutex> lk(g_consoleMutex);
+            napi_threadsafe_function cb = ConsoleCallbackLocked(vmName);
+            if (!cb) return false;
+            auto* b = new ConsoleBatch();
+            b->vmName = vmName;
+            if (dropped > 0) {
+                b->text = "\r\n[console: " + std::to_string(dropped) + " bytes dropped]\r\n";
+            }
+            b->text += batch;
+            b->droppedBytes = dropped;
+            if (napi_call_threadsafe_function(cb, b, napi_tsfn_nonblocking) != napi_ok) {
+                delete b;
+                return false;
+            }
+            return true;
+        });
+    }
+    return *channel;
+}
+
+// 回调更换：对应通道上未确认的批次不会再确认（vmName 为空表示全局回调，影响所有没有专属回调的 VM）
+static void ConsoleResetInFlight(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lk(g_consoleChannelsMutex);
+    for (auto& kv : ConsoleChannels()) {
+        if (vmName.empty() || kv.first == vmName) kv.second->ResetInFlight();
+    }
+}
 
 // 前向声明：CaptureQemuOutput 里需要用它把 QEMU 的 stdout/stderr 打进同一套 QEMU_CORE 日志里
 static void HilogPrint(const std::string& message);
@@ -202,8 +297,10 @@ static void HilogPrint(const std::string& message);
 // - 我们启动 QEMU 时把串口输出放到 TCP 4321 server 上。
 // - 但 ArkTS 的 ConsoleWindow 只注册了 consoleCallback，并不会自动去连 4321。
 // - 结果就是“串口没有透传到 ArkTS”，看起来像没有输出。
-// 这里在 Native 层自动连接 4321，并把收到的数据通过 g_consoleCallback 推给 ArkTS。
+// 这里在 Native 层自动连接 4321，并把收到的数据通过该 VM 的控制台回调推给 ArkTS。
+// 现在只是旧 core（无补丁 0004）的回退路径：有 aether-ring chardev 时串口走 ConsoleSession（见 StartVm）。
 static std::thread g_serial_thread;
+static std::atomic<bool> g_serial_use_tcp(true);   // 当前 VM 的串口是否在 TCP 4321 上
 static std::atomic<bool> g_serial_running(false);
 static int g_serial_fd = -1;
 static std::mutex g_serial_mtx;
@@ -216,11 +313,15 @@ static void SerialCloseLocked()
     }
 }
 
-static void SerialEmitToJs(const std::string& s)
+static void SerialEmitToJs(const std::string& vmName, const char* data, size_t len)
 {
-    if (!g_consoleCallback) return;
-    std::string* msg = new std::string(s);
-    napi_call_threadsafe_function(g_consoleCallback, msg, napi_tsfn_nonblocking);
+    if (!ConsoleHasListener(vmName)) return;
+    ConsoleOut(vmName).Write(data, len);
+}
+
+static void SerialEmitToJs(const std::string& vmName, const std::string& s)
+{
+    SerialEmitToJs(vmName, s.data(), s.size());
 }
 
 static bool SerialTryConnectLocked()
@@ -257,8 +358,10 @@ static bool SerialTryConnectLocked()
 
 static void SerialBridgeThread()
 {
+    // TCP 4321 只属于进程内 VM
+    const std::string vmName = vm_runtime_inprocess_vm();
     // 反复尝试连接，直到成功或被停止
-    SerialEmitToJs("[TTY] connecting to 127.0.0.1:4321 ...\n");
+    SerialEmitToJs(vmName, "[TTY] connecting to 127.0.0.1:4321 ...\n");
 
     while (g_serial_running.load()) {
         {
@@ -283,7 +386,7 @@ static void SerialBridgeThread()
         char buf[4096];
         ssize_t n = recv(fd, buf, sizeof(buf), 0);
         if (n > 0) {
-            SerialEmitToJs(std::string(buf, (size_t)n));
+            SerialEmitToJs(vmName, buf, (size_t)n);
             continue;
         }
 
@@ -291,7 +394,7 @@ static void SerialBridgeThread()
         if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
             std::lock_guard<std::mutex> lk(g_serial_mtx);
             SerialCloseLocked();
-            SerialEmitToJs("[TTY] disconnected, retrying...\n");
+            SerialEmitToJs(vmName, "[TTY] disconnected, retrying...\n");
         }
     }
 
@@ -319,23 +422,30 @@ static void SerialStop()
     if (g_serial_thread.joinable()) g_serial_thread.join();
 }
 
-// JS 回调包装器
+// JS 回调包装器：callback(text, droppedBytes, vmName)，处理完才确认，该 VM 的合并通道据此反压
 static void ConsoleJsCallback(napi_env env, napi_value js_cb, void* context, void* data) {
-    std::string* msg = static_cast<std::string*>(data);
-    if (!msg) return;
+    ConsoleBatch* batch = static_cast<ConsoleBatch*>(data);
+    if (!batch) return;
     
-    napi_value undefined, js_string;
-    napi_get_undefined(env, &undefined);
-    napi_create_string_utf8(env, msg->c_str(), msg->length(), &js_string);
-    napi_call_function(env, undefined, js_cb, 1, &js_string, nullptr);
+    if (env && js_cb) {
+        napi_value undefined;
+        napi_value argv[3];
+        napi_get_undefined(env, &undefined);
+        napi_create_string_utf8(env, batch->text.c_str(), batch->text.length(), &argv[0]);
+        napi_create_int64(env, static_cast<int64_t>(batch->droppedBytes), &argv[1]);
+        napi_create_string_utf8(env, batch->vmName.c_str(), batch->vmName.length(), &argv[2]);
+        napi_call_function(env, undefined, js_cb, 3, argv, nullptr);
+    }
     
-    delete msg;
+    ConsoleOut(batch->vmName).Ack();
+    delete batch;
 }
 
 // 捕获 stdout/stderr 并重定向到 hilog
 class CaptureQemuOutput {
 public:
-    explicit CaptureQemuOutput(const std::string& vmDir) : stdout_log_fd(-1), stderr_log_fd(-1) {
+    CaptureQemuOutput(const std::string& vmName, const std::string& vmDir)
+        : vm_name(vmName), stdout_log_sink(0), stderr_log_sink(0) {
         // 创建管道
         if (pipe(stdout_pipe) == -1 || pipe(stderr_pipe) == -1 || pipe(stdin_pipe) == -1) {
             OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_DOMAIN, LOG_TAG, "Failed to create pipes");
@@ -361,22 +471,16 @@ public:
 
         // 额外：把 QEMU 的 stdout/stderr 同步落盘到 VM 目录（用于诊断导出）
         // 注意：不要写到 qemu.log（该文件会被 QEMU -D 打开并可能清空），我们单独写 stdout/stderr 文件。
+        // 文件由日志线程打开并批量写入，读取线程只把数据放进日志环
         if (!vmDir.empty()) {
-            const std::string outPath = vmDir + "/qemu_stdout.log";
-            const std::string errPath = vmDir + "/qemu_stderr.log";
-            stdout_log_fd = open(outPath.c_str(), O_CREAT | O_WRONLY | O_APPEND, 0644);
-            stderr_log_fd = open(errPath.c_str(), O_CREAT | O_WRONLY | O_APPEND, 0644);
-            if (stdout_log_fd == -1 || stderr_log_fd == -1) {
-                OH_LOG_Print(LOG_APP, LOG_WARN, LOG_DOMAIN, LOG_TAG,
-                             "Failed to open stdout/stderr log files in vmDir (errno=%{public}d)",
-                             errno);
-            }
+            stdout_log_sink = log_sink(vmDir + "/qemu_stdout.log");
+            stderr_log_sink = log_sink(vmDir + "/qemu_stderr.log");
         }
 
         // 启动读取线程
         running = true;
-        stdout_thread = std::thread(&CaptureQemuOutput::ReadThread, this, stdout_pipe[0], stdout_log_fd, "QEMU_STDOUT");
-        stderr_thread = std::thread(&CaptureQemuOutput::ReadThread, this, stderr_pipe[0], stderr_log_fd, "QEMU_STDERR");
+        stdout_thread = std::thread(&CaptureQemuOutput::ReadThread, this, stdout_pipe[0], stdout_log_sink, "QEMU_STDOUT");
+        stderr_thread = std::thread(&CaptureQemuOutput::ReadThread, this, stderr_pipe[0], stderr_log_sink, "QEMU_STDERR");
         
         OH_LOG_Print(LOG_APP, LOG_INFO, LOG_DOMAIN, LOG_TAG, "QEMU output capture started");
     }
@@ -403,21 +507,7 @@ public:
         
         close(stdout_pipe[0]);
         close(stderr_pipe[0]);
-
-        if (stdout_log_fd != -1) {
-            close(stdout_log_fd);
-            stdout_log_fd = -1;
-        }
-        if (stderr_log_fd != -1) {
-            close(stderr_log_fd);
-            stderr_log_fd = -1;
-        }
-        
-        // 释放回调
-        if (g_consoleCallback) {
-            napi_release_threadsafe_function(g_consoleCallback, napi_tsfn_abort);
-            g_consoleCallback = nullptr;
-        }
+        log_flush();
     }
     
     void WriteToStdin(const std::string& data) {
@@ -437,31 +527,31 @@ private:
     std::thread stdout_thread;
     std::thread stderr_thread;
     std::atomic<bool> running;
-    int stdout_log_fd;
-    int stderr_log_fd;
+    const std::string vm_name;
+    int stdout_log_sink;
+    int stderr_log_sink;
 
-    void ReadThread(int fd, int logFd, const char* tag) {
+    void ReadThread(int fd, int logSink, const char* tag) {
+        const std::string hilogPrefix = std::string("QEMU: [") + tag + "] ";
         char buffer[1024];
         ssize_t n;
         while (running) {
             n = read(fd, buffer, sizeof(buffer) - 1);
             if (n > 0) {
-                // 先把原始输出落盘（保留换行符/原始内容）
-                if (logFd != -1) {
-                    (void)write(logFd, buffer, static_cast<size_t>(n));
+                // 先把原始输出落盘（保留换行符/原始内容），由日志线程批量写入
+                if (logSink > 0) {
+                    log_submit(logSink, kLogRaw, "", std::string_view(buffer, static_cast<size_t>(n)));
                 }
                 buffer[n] = '\0';
                 
-                // 发送给 JS (需要在 hilog 之前，保留换行符)
-                if (g_consoleCallback) {
-                    std::string* msg = new std::string(buffer);
-                    napi_call_threadsafe_function(g_consoleCallback, msg, napi_tsfn_nonblocking);
-                }
+                // 发送给 JS (需要在 hilog 之前，保留换行符)，由合并通道按批投递
+                SerialEmitToJs(vm_name, buffer, static_cast<size_t>(n));
                 
                 // 移除换行符，HilogPrint 会自动按行处理
-                if (buffer[n - 1] == '\n') buffer[n - 1] = '\0';
+                size_t len = static_cast<size_t>(n);
+                if (buffer[len - 1] == '\n') len--;
                 // 关键修复：用 QEMU_CORE 统一日志出口，确保你抓的 hilog.log 一定能看到
-                HilogPrint(std::string("QEMU: [") + tag + "] " + buffer);
+                log_submit(0, kLogHilog, hilogPrefix, std::string_view(buffer, len));
             } else if (n == 0) {
                 break; // EOF
             } else {
@@ -479,8 +569,10 @@ static std::unique_ptr<CaptureQemuOutput> g_logCapture;
 #define PRCTL_JIT_ENABLE 0x6a6974
 #endif
 
-// 日志缓冲区大小限制
+// getVmLogs（按行数组返回）最多返回的行数；完整历史在 log_store 环形存储中
 constexpr size_t MAX_LOG_BUFFER_SIZE = 1000;
+// 推送模式每次回调最多携带的字节数，剩余部分紧接着下一次回调
+constexpr size_t VM_LOG_PUSH_MAX_BYTES = 64 * 1024;
 
 // VM配置结构
 struct VMConfig {
@@ -491,6 +583,8 @@ struct VMConfig {
     int diskSizeGB;
     int memoryMB;
     int cpuCount;
+    bool memoryExplicit = false; // memoryMB / cpuCount 由调用方给出（否则由性能模式决定）
+    bool cpuExplicit = false;
     std::string cpuModel;        // CPU 型号（可选，不填则使用默认策略）
     std::string diskPath;
     std::string logPath;
@@ -508,21 +602,64 @@ struct VMConfig {
     std::string displayDevice;   // 显卡设备（virtio-gpu、ramfb、none）
     std::string networkDevice;   // 网卡设备（virtio-net、e1000、rtl8139、none）
     std::string audioDevice;     // 声卡设备（hda、ac97、none）
+    bool fastResume;             // 来宾 RAM 用 memory-backend-file 映射到 VM 目录下的文件，支持挂起 / 快速恢复
+    std::string snapshotRestoreTag;  // 非空：以 -incoming defer 启动，随后回灌该外部快照的 RAM
+    bool snapshotResume;         // 从挂起状态恢复：以 -incoming defer 启动，只回灌设备状态
+    std::string consoleChardev;  // 非空：串口接到进程内 aether-ring chardev（补丁 0004）；为空回退到 TCP 4321
+    std::string runtime;         // auto（默认）/ inprocess / worker
+    bool worker = false;         // 本次以工作进程方式运行（进程内 QEMU 已被其它 VM 占用，或显式指定）
+    VmPorts ports;               // 本次分配的宿主侧端口（vm_runtime）
+    std::string profile;         // 性能模式：powersaver / balanced（默认）/ turbo
+    std::string icount;          // 非空时追加 -icount（由性能模式决定）
+    bool profiler = false;       // TCG 热点分析（libaether_hotspot.so 插件），默认关闭
+    std::string hotspotPluginPath;  // 非空：以 -plugin 加载该插件
 };
 
 // VM状态管理
 static std::map<std::string, std::thread> g_vmThreads;
 static std::map<std::string, std::atomic<bool>*> g_vmRunning;
-static std::map<std::string, std::vector<std::string>> g_vmLogBuffers;
-static std::map<std::string, std::mutex> g_vmLogMutexes;
+// 日志推送订阅（setVmLogCallback）：日志线程只负责唤起，新行在 JS 线程从 log_store 批量读取
+struct VmLogSubscriber {
+    std::string vmName;
+    napi_threadsafe_function tsfn = nullptr;
+    uint64_t nextSeq = 1;                  // 仅 JS 线程访问
+    std::atomic<bool> scheduled { false }; // 已有一次待执行的回调，新行并入其中
+};
+static std::map<std::string, VmLogSubscriber*> g_vmLogSubscribers;
+static std::mutex g_vmLogSubscriberMutex;
 static std::mutex g_vmMutex;
 
 // 全局变量用于控制VM运行状态
 // 使用显式构造避免静态初始化问题
 static std::atomic<bool> g_qemu_shutdown_requested(false);
-static std::string g_current_vm_name;
-static std::string g_current_log_path;
-static std::string g_current_arch_type;  // 当前 VM 的架构类型 (aarch64, x86_64, i386)
+
+// 以工作进程方式运行的 VM（vm_worker）；VM 线程在工作进程退出后移除
+static std::map<std::string, std::shared_ptr<VmWorker>> g_vmWorkers;
+static std::mutex g_vmWorkersMutex;
+
+static std::shared_ptr<VmWorker> FindVmWorker(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lk(g_vmWorkersMutex);
+    auto it = g_vmWorkers.find(vmName);
+    return it == g_vmWorkers.end() ? nullptr : it->second;
+}
+
+// 每个 VM 本次启动采用的性能模式规划，以及从 startVm 到进入 running 的耗时（getVmProfile / 基准测试）
+struct VmProfileRecord {
+    TcgTuning tuning;
+    int64_t startMs = 0;
+    int64_t bootMs = -1;
+};
+static std::map<std::string, VmProfileRecord> g_vmProfiles;
+static std::mutex g_vmProfilesMutex;
+
+// 节能模式下 vCPU 线程也放到能效核
+static bool VmProfileIsPowerSaver(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lk(g_vmProfilesMutex);
+    auto it = g_vmProfiles.find(vmName);
+    return it != g_vmProfiles.end() && it->second.tuning.profile == TcgProfile::PowerSaver;
+}
 
 // VM 启动错误码
 enum class VmStartError {
@@ -936,6 +1073,43 @@ static napi_value GetSupportedDevices(napi_env env, napi_callback_info info) {
 // 这是获取 QEMU 真正支持的设备的最可靠方式
 // ============================================================================
 
+// 每个 VM 的 QMP socket（BuildQemuArgs 中 -qmp unix:...,server,nowait）
+static std::string VmQmpSocketPath(const std::string& vmName)
+{
+    return "/data/storage/el2/base/haps/entry/files/vms/" + vmName + "/qmp.sock";
+}
+
+// 该 VM 的共享 QMP 长连接（首次调用时建连，断开后下一次调用自动重连）
+static std::shared_ptr<QmpClient> VmQmpClient(const std::string& vmName)
+{
+    return qmp_client_for(VmQmpSocketPath(vmName));
+}
+
+// 快照引擎所需的 VM 位置信息（磁盘固定为 vmDir/disk.qcow2，见 ParseVMConfig）
+static SnapshotVm SnapshotVmFor(const std::string& vmName)
+{
+    SnapshotVm vm;
+    vm.name = vmName;
+    vm.dir = "/data/storage/el2/base/haps/entry/files/vms/" + vmName;
+    vm.qmp_socket = VmQmpSocketPath(vmName);
+    vm.base_disk = vm.dir + "/disk.qcow2";
+    return vm;
+}
+
+// 影响来宾可见硬件的配置摘要：挂起与恢复时不一致，设备状态就无法加载
+static std::string VmResumeFingerprint(const VMConfig& config)
+{
+    std::ostringstream fp;
+    fp << (config.archType.empty() ? "aarch64" : config.archType) << '|' << config.machine << '|' << config.cpuModel
+       << '|' << config.cpuCount << '|' << config.memoryMB << '|' << config.accel << '|' << config.efiFirmware << '|'
+       << config.displayDevice << '|' << config.networkDevice << '|' << config.audioDevice << '|' << config.display
+       << '|' << config.isoPath << '|' << config.installMode;
+    return fp.str();
+}
+
+// 本次启动使用的挂起指纹（fastResume 未开启时为空，suspendVm 拒绝执行），受 g_vmMutex 保护
+static std::map<std::string, std::string> g_vm_resume_fingerprints;
+
 // 通过 QMP 查询 QEMU 支持的设备类型
 // 参数：vmName - 虚拟机名称（用于定位 QMP socket）
 static napi_value ProbeQemuDevices(napi_env env, napi_callback_info info) {
@@ -967,7 +1141,7 @@ static napi_value ProbeQemuDevices(napi_env env, napi_callback_info info) {
     }
     
     // 构建 QMP socket 路径
-    std::string qmpSocketPath = "/data/storage/el2/base/haps/entry/files/vms/" + vmName + "/qmp.sock";
+    std::string qmpSocketPath = VmQmpSocketPath(vmName);
     
     // 检查 QMP socket 是否存在
     struct stat st;
@@ -981,63 +1155,18 @@ static napi_value ProbeQemuDevices(napi_env env, napi_callback_info info) {
         return result;
     }
     
-    // 连接 QMP socket
-    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        napi_value msg;
-        napi_create_string_utf8(env, "创建 socket 失败", NAPI_AUTO_LENGTH, &msg);
-        napi_set_named_property(env, result, "error", msg);
-        return result;
-    }
-    
-    struct sockaddr_un addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, qmpSocketPath.c_str(), sizeof(addr.sun_path) - 1);
-    
-    if (connect(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(sockfd);
+    // 查询设备类型（复用 VM 的 QMP 长连接）
+    QmpResult qr = VmQmpClient(vmName)->execute("qom-list-types", "{\"implements\": \"device\"}", 5000);
+    if (!qr.ok && (qr.error_class == "Disconnected" || qr.error_class == "SendFailed")) {
         napi_value msg;
         napi_create_string_utf8(env, 
-            ("连接 QMP socket 失败: " + std::string(strerror(errno))).c_str(), 
+            ("连接 QMP socket 失败: " + qr.error_desc).c_str(), 
             NAPI_AUTO_LENGTH, &msg);
         napi_set_named_property(env, result, "error", msg);
-        HilogPrint("QEMU: ProbeQemuDevices - connect failed: " + std::string(strerror(errno)));
+        HilogPrint("QEMU: ProbeQemuDevices - QMP failed: " + qr.error_desc);
         return result;
     }
-    
-    HilogPrint("QEMU: ProbeQemuDevices - connected to QMP socket");
-    
-    // 读取 QMP 欢迎消息
-    char buffer[4096];
-    ssize_t n = read(sockfd, buffer, sizeof(buffer) - 1);
-    if (n > 0) {
-        buffer[n] = '\0';
-        HilogPrint(std::string("QEMU: QMP greeting: ") + buffer);
-    }
-    
-    // 发送 qmp_capabilities 命令（必须先执行）
-    const char* capCmd = "{\"execute\": \"qmp_capabilities\"}\n";
-    write(sockfd, capCmd, strlen(capCmd));
-    n = read(sockfd, buffer, sizeof(buffer) - 1);
-    if (n > 0) buffer[n] = '\0';
-    
-    // 发送 qom-list-types 命令查询设备类型
-    const char* listCmd = "{\"execute\": \"qom-list-types\", \"arguments\": {\"implements\": \"device\"}}\n";
-    write(sockfd, listCmd, strlen(listCmd));
-    
-    // 读取响应
-    std::string response;
-    while ((n = read(sockfd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[n] = '\0';
-        response += buffer;
-        if (response.find("\"return\"") != std::string::npos || 
-            response.find("\"error\"") != std::string::npos) {
-            break;
-        }
-    }
-    
-    close(sockfd);
+    const std::string& response = qr.response;
     
     HilogPrint("QEMU: ProbeQemuDevices - response length: " + std::to_string(response.size()));
     
@@ -1102,118 +1231,6 @@ static napi_value ResumeVm(napi_env env, napi_callback_info info) {
     return result;
 }
 
-// 创建快照
-static napi_value CreateSnapshot(napi_env env, napi_callback_info info) {
-    size_t argc = 2;
-    napi_value args[2];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-    
-    if (argc < 2) {
-        napi_throw_error(env, nullptr, "Missing VM name and snapshot name parameters");
-        return nullptr;
-    }
-    
-    char vm_name[256];
-    char snapshot_name[256];
-    size_t name_len;
-    napi_get_value_string_utf8(env, args[0], vm_name, sizeof(vm_name), &name_len);
-    napi_get_value_string_utf8(env, args[1], snapshot_name, sizeof(snapshot_name), &name_len);
-    
-    // 调用真正的快照创建实现
-    bool success = qemu_create_snapshot_by_name(vm_name, snapshot_name);
-    
-    napi_value result;
-    napi_get_boolean(env, success, &result);
-    return result;
-}
-
-// 恢复快照
-static napi_value RestoreSnapshot(napi_env env, napi_callback_info info) {
-    size_t argc = 2;
-    napi_value args[2];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-    
-    if (argc < 2) {
-        napi_throw_error(env, nullptr, "Missing VM name and snapshot name parameters");
-        return nullptr;
-    }
-    
-    char vm_name[256];
-    char snapshot_name[256];
-    size_t name_len;
-    napi_get_value_string_utf8(env, args[0], vm_name, sizeof(vm_name), &name_len);
-    napi_get_value_string_utf8(env, args[1], snapshot_name, sizeof(snapshot_name), &name_len);
-    
-    // 调用真正的快照恢复实现
-    bool success = qemu_restore_snapshot_by_name(vm_name, snapshot_name);
-    
-    napi_value result;
-    napi_get_boolean(env, success, &result);
-    return result;
-}
-
-// 列出快照
-static napi_value ListSnapshots(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-    
-    if (argc < 1) {
-        napi_throw_error(env, nullptr, "Missing VM name parameter");
-        return nullptr;
-    }
-    
-    char vm_name[256];
-    size_t name_len;
-    napi_get_value_string_utf8(env, args[0], vm_name, sizeof(vm_name), &name_len);
-    
-    // 调用真正的快照列表实现
-    const int max_snapshots = 64;
-    char* snapshot_names[64] = {nullptr};
-    int count = qemu_list_snapshots_by_name(vm_name, snapshot_names, max_snapshots);
-    
-    napi_value result;
-    napi_create_array_with_length(env, count, &result);
-    
-    for (int i = 0; i < count; i++) {
-        napi_value snapshot;
-        if (snapshot_names[i]) {
-            napi_create_string_utf8(env, snapshot_names[i], NAPI_AUTO_LENGTH, &snapshot);
-            free(snapshot_names[i]);  // 释放 strdup 分配的内存
-        } else {
-            napi_create_string_utf8(env, "", NAPI_AUTO_LENGTH, &snapshot);
-        }
-        napi_set_element(env, result, i, snapshot);
-    }
-    
-    return result;
-}
-
-// 删除快照
-static napi_value DeleteSnapshot(napi_env env, napi_callback_info info) {
-    size_t argc = 2;
-    napi_value args[2];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
-    
-    if (argc < 2) {
-        napi_throw_error(env, nullptr, "Missing VM name and snapshot name parameters");
-        return nullptr;
-    }
-    
-    char vm_name[256];
-    char snapshot_name[256];
-    size_t name_len;
-    napi_get_value_string_utf8(env, args[0], vm_name, sizeof(vm_name), &name_len);
-    napi_get_value_string_utf8(env, args[1], snapshot_name, sizeof(snapshot_name), &name_len);
-    
-    // 调用真正的快照删除实现
-    bool success = qemu_delete_snapshot_by_name(vm_name, snapshot_name);
-    
-    napi_value result;
-    napi_get_boolean(env, success, &result);
-    return result;
-}
-
 // 解析VM配置参数
 static VMConfig ParseVMConfig(napi_env env, napi_value config, bool &ok) {
     OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_DOMAIN, "QEMU_PARSE", ">>> ParseVMConfig 开始 <<<");
@@ -1299,8 +1316,10 @@ static VMConfig ParseVMConfig(napi_env env, napi_value config, bool &ok) {
         napi_get_value_int32(env, memoryValue, &memVal);
         if (memVal >= 512) {
             vmConfig.memoryMB = memVal;
+            vmConfig.memoryExplicit = true;
         } else if (memVal > 0) {
             vmConfig.memoryMB = 512; // 强制最小值
+            vmConfig.memoryExplicit = true;
             HilogPrint("QEMU: Warning - memoryMB too small, using 512MB minimum");
         }
     }
@@ -1312,6 +1331,7 @@ static VMConfig ParseVMConfig(napi_env env, napi_value config, bool &ok) {
         napi_get_value_int32(env, cpuValue, &cpuVal);
         if (cpuVal >= 1) {
             vmConfig.cpuCount = cpuVal;
+            vmConfig.cpuExplicit = true;
         } else {
             HilogPrint("QEMU: Warning - cpuCount invalid, using 2 cores default");
         }
@@ -1344,6 +1364,21 @@ static VMConfig ParseVMConfig(napi_env env, napi_value config, bool &ok) {
         vmConfig.accel = kvmSupported() ? "kvm" : "tcg,thread=multi";
     }
     
+    // 性能模式（节能 / 标准 / Turbo），默认标准
+    vmConfig.profile = "balanced";
+    napi_value profileValue;
+    if (napi_get_named_property(env, config, "profile", &profileValue) == napi_ok) {
+        std::string profile;
+        TcgProfile parsed;
+        if (NapiGetStringUtf8(env, profileValue, profile) && !profile.empty()) {
+            if (tcg_profile_from_string(profile, parsed)) {
+                vmConfig.profile = tcg_profile_name(parsed);
+            } else {
+                HilogPrint("QEMU: Warning - unknown profile '" + profile + "', using balanced");
+            }
+        }
+    }
+
     // 获取显示类型
     napi_value displayValue;
     if (napi_get_named_property(env, config, "display", &displayValue) == napi_ok) {
@@ -1366,6 +1401,35 @@ static VMConfig ParseVMConfig(napi_env env, napi_value config, bool &ok) {
         vmConfig.nographic = false;
     }
 
+    // 运行方式（可选）：auto 时第一个 VM 在进程内运行，之后的 VM 各自使用工作进程
+    vmConfig.runtime = "auto";
+    napi_value runtimeValue;
+    if (napi_get_named_property(env, config, "runtime", &runtimeValue) == napi_ok) {
+        std::string runtime;
+        if (NapiGetStringUtf8(env, runtimeValue, runtime) && (runtime == "inprocess" || runtime == "worker")) {
+            vmConfig.runtime = runtime;
+        }
+    }
+
+    // 快速恢复（可选，默认 false）
+    vmConfig.fastResume = false;
+    napi_value fastResumeValue;
+    if (napi_get_named_property(env, config, "fastResume", &fastResumeValue) == napi_ok) {
+        bool fastResume = false;
+        if (napi_get_value_bool(env, fastResumeValue, &fastResume) == napi_ok) {
+            vmConfig.fastResume = fastResume;
+        }
+    }
+
+    // TCG 热点分析（可选，默认 false）
+    napi_value profilerValue;
+    if (napi_get_named_property(env, config, "profiler", &profilerValue) == napi_ok) {
+        bool profiler = false;
+        if (napi_get_value_bool(env, profilerValue, &profiler) == napi_ok) {
+            vmConfig.profiler = profiler;
+        }
+    }
+
     // 获取安装模式标志（可选，默认 false）
     vmConfig.installMode = false;
     napi_value installModeValue;
@@ -1630,7 +1694,8 @@ static bool CreateVmPerfenceFile(const VMConfig& config)
         perf << "  \"machine\": \"" << config.machine << "\",\n";
         perf << "  \"displayDevice\": \"" << config.displayDevice << "\",\n";
         perf << "  \"networkDevice\": \"" << config.networkDevice << "\",\n";
-        perf << "  \"audioDevice\": \"" << config.audioDevice << "\"\n";
+        perf << "  \"audioDevice\": \"" << config.audioDevice << "\",\n";
+        perf << "  \"profile\": \"" << config.profile << "\"\n";
         perf << "}\n";
 
         perf.close();
@@ -1661,6 +1726,174 @@ static bool UpdateVMStatus(const std::string& vmName, const std::string& status)
     }
 }
 
+// ============================================================
+// VM 状态机：由 StartVm/StopVm、qemu_main_loop 返回和 QMP 异步事件（STOP/RESUME/SHUTDOWN 等）驱动。
+// getVmStatus 直接读这里，不再走 QMP query-status 轮询；状态变化经 setVmStateCallback 推给 ArkTS。
+// ============================================================
+
+enum class VmState { Stopped, Preparing, Starting, Running, Paused, Stopping, Failed };
+
+static const char* VmStateName(VmState s)
+{
+    switch (s) {
+        case VmState::Preparing: return "preparing";
+        case VmState::Starting:  return "starting";
+        case VmState::Running:   return "running";
+        case VmState::Paused:    return "paused";
+        case VmState::Stopping:  return "stopping";
+        case VmState::Failed:    return "failed";
+        default:                 return "stopped";
+    }
+}
+
+struct VmStateRecord {
+    VmState state = VmState::Stopped;
+    int64_t sinceMs = 0;       // 进入当前状态的时间（Unix 毫秒）
+    std::string reason;
+};
+
+struct VmStateChange {
+    std::string vmName;
+    VmState state;
+    VmState previous;
+    std::string reason;
+    int64_t timestampMs;
+};
+
+static std::mutex g_vm_state_mutex;
+static std::condition_variable g_vm_state_cv;
+static std::map<std::string, VmStateRecord> g_vm_states;
+static std::map<std::string, uint64_t> g_vm_state_qmp_subs;   // vmName -> 内部 QMP 事件订阅 id
+static napi_threadsafe_function g_vm_state_tsfn = nullptr;
+
+static int64_t VmStateNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Stopped/Failed 为终态，只有 StartVm（Preparing）能离开；Stopping 只能走向终态。
+// 这样 VM 退出后迟到的 QMP 事件、关机过程中的 STOP 事件都不会把状态拉回去。
+static bool VmStateTransitionAllowed(VmState from, VmState to)
+{
+    if (from == to) return false;
+    if (to == VmState::Preparing) return from == VmState::Stopped || from == VmState::Failed;
+    if (from == VmState::Stopped || from == VmState::Failed) return false;
+    if (from == VmState::Stopping) return to == VmState::Stopped || to == VmState::Failed;
+    return true;
+}
+
+// 校验并记录状态变化、投递回调（全部在 g_vm_state_mutex 内）
+static bool RecordVmState(const std::string& vmName, VmState to, const std::string& reason)
+{
+    std::lock_guard<std::mutex> lk(g_vm_state_mutex);
+    VmStateRecord& rec = g_vm_states[vmName];
+    if (!VmStateTransitionAllowed(rec.state, to)) return false;
+
+    const VmState previous = rec.state;
+    rec.state = to;
+    rec.sinceMs = VmStateNowMs();
+    rec.reason = reason;
+    if (to == VmState::Running) {
+        std::lock_guard<std::mutex> plk(g_vmProfilesMutex);
+        auto it = g_vmProfiles.find(vmName);
+        if (it != g_vmProfiles.end() && it->second.bootMs < 0) it->second.bootMs = rec.sinceMs - it->second.startMs;
+    }
+    HilogPrint("QEMU: VM '" + vmName + "' state " + VmStateName(previous) + " -> " + VmStateName(to) +
+               (reason.empty() ? "" : " (" + reason + ")"));
+
+    // 持锁投递，保证 JS 侧收到的顺序与状态变化顺序一致
+    if (g_vm_state_tsfn) {
+        auto* change = new VmStateChange{ vmName, to, previous, reason, rec.sinceMs };
+        if (napi_call_threadsafe_function(g_vm_state_tsfn, change, napi_tsfn_nonblocking) != napi_ok) {
+            delete change;
+        }
+    }
+    g_vm_state_cv.notify_all();
+    return true;
+}
+
+// vm_status.txt 的写入：不在 g_vm_state_mutex 内、也不在调用线程上做（SetVmState 会在
+// QMP 读线程上调用，磁盘延迟不能卡住事件/回复分发和 getVmState）。写前重新取最新状态，
+// 并发的两次变化无论谁后写，文件里都是最新状态。
+static std::mutex g_vm_status_file_mutex;
+
+static void PersistVmState(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> flk(g_vm_status_file_mutex);
+    VmState state = VmState::Stopped;
+    {
+        std::lock_guard<std::mutex> lk(g_vm_state_mutex);
+        auto it = g_vm_states.find(vmName);
+        if (it == g_vm_states.end()) return;
+        state = it->second.state;
+    }
+    UpdateVMStatus(vmName, VmStateName(state));
+}
+
+static bool SetVmState(const std::string& vmName, VmState to, const std::string& reason)
+{
+    if (!RecordVmState(vmName, to, reason)) return false;
+    try {
+        std::thread([vmName]() { PersistVmState(vmName); }).detach();
+    } catch (...) {
+        PersistVmState(vmName);
+    }
+    return true;
+}
+
+static VmStateRecord GetVmStateRecord(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lk(g_vm_state_mutex);
+    auto it = g_vm_states.find(vmName);
+    return it == g_vm_states.end() ? VmStateRecord{} : it->second;
+}
+
+// 等待 VM 进入终态（Stopped/Failed）；超时返回 false
+static bool WaitVmStateFinal(const std::string& vmName, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lk(g_vm_state_mutex);
+    return g_vm_state_cv.wait_for(lk, timeout, [&vmName]() {
+        auto it = g_vm_states.find(vmName);
+        return it == g_vm_states.end() || it->second.state == VmState::Stopped || it->second.state == VmState::Failed;
+    });
+}
+
+// QMP 事件 -> 状态（在 QMP 读线程中执行）
+static void VmStateOnQmpEvent(const std::string& vmName, const QmpEvent& e)
+{
+    if (e.name == "STOP") {
+        SetVmState(vmName, VmState::Paused, "STOP");
+    } else if (e.name == "RESUME" || e.name == "WAKEUP") {
+        SetVmState(vmName, VmState::Running, e.name);
+    } else if (e.name == "SUSPEND") {
+        SetVmState(vmName, VmState::Paused, "SUSPEND");
+    } else if (e.name == "SHUTDOWN") {
+        std::string reason = "SHUTDOWN";
+        cJSON* data = cJSON_Parse(e.data.c_str());
+        if (data) {
+            const cJSON* r = cJSON_GetObjectItemCaseSensitive(data, "reason");
+            if (cJSON_IsString(r)) reason += std::string(": ") + r->valuestring;
+            cJSON_Delete(data);
+        }
+        SetVmState(vmName, VmState::Stopping, reason);
+    }
+    // QMP_DISCONNECTED 不改变状态：以 qemu_main_loop 返回为准
+}
+
+// 每个 VM 只挂一个内部订阅；QMP 会话按 socket 路径常驻，重连后订阅依然有效
+static void VmStateAttachQmp(const std::string& vmName)
+{
+    {
+        std::lock_guard<std::mutex> lk(g_vm_state_mutex);
+        if (g_vm_state_qmp_subs.count(vmName)) return;
+        g_vm_state_qmp_subs[vmName] = 0;
+    }
+    uint64_t id = VmQmpClient(vmName)->subscribe([vmName](const QmpEvent& e) { VmStateOnQmpEvent(vmName, e); });
+    std::lock_guard<std::mutex> lk(g_vm_state_mutex);
+    g_vm_state_qmp_subs[vmName] = id;
+}
+
 // 创建虚拟磁盘
 // QCOW2 文件头结构 (简化版)
 #pragma pack(push, 1)
@@ -1809,7 +2042,40 @@ static bool CreateVirtualDisk(const std::string& diskPath, int sizeGB) {
     }
 }
 
+// QemuOpts 的值中逗号需写成 ",,"
+static std::string QemuOptEscape(const std::string& value)
+{
+    std::string out;
+    for (char c : value) {
+        out += c;
+        if (c == ',') out += ',';
+    }
+    return out;
+}
+
 // 构建QEMU命令行参数
+// 串口：优先用进程内 aether-ring chardev（无 TCP、无固定端口，输出在 attach 前也保留在环里）
+// 另加一路 file 串口兜底落盘，便于排查“卡在 TianoCore/UEFI 阶段”
+// 注意：路径包含空格也没关系（argv 单独一项，不会被再次 split）
+static void AppendSerialConsoleArgs(std::vector<std::string>& args, const VMConfig& config)
+{
+    if (!config.consoleChardev.empty()) {
+        args.push_back("-chardev");
+        args.push_back("aether-ring,id=" + config.consoleChardev + ",size=65536");
+        args.push_back("-serial");
+        args.push_back("chardev:" + config.consoleChardev);
+        HilogPrint("QEMU: [DEBUG] Serial console on in-process ring " + config.consoleChardev);
+    } else {
+        // 旧 core（无补丁 0004）：串口使用TCP socket，可以通过 telnet localhost 4321 连接
+        args.push_back("-serial");
+        args.push_back("tcp:127.0.0.1:4321,server,nowait");
+        HilogPrint("QEMU: [DEBUG] Serial console on tcp:127.0.0.1:4321");
+    }
+    args.push_back("-serial");
+    args.push_back("file:" + config.vmDir + "/serial.log");
+    HilogPrint("QEMU: [DEBUG] Serial log file: " + config.vmDir + "/serial.log");
+}
+
 static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
     std::vector<std::string> args;
     bool scsiControllerAdded = false;
@@ -1868,6 +2134,11 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
     } else {
         args.push_back("qemu-system-aarch64"); // 默认 aarch64
     }
+
+    // 线程命名（"CPU 0/TCG" 等），vm_sched 据此把 vCPU 线程绑到性能核
+    const std::string guestName = QemuOptEscape(config.name);
+    args.push_back("-name");
+    args.push_back("guest=" + (guestName.empty() ? std::string("vm") : guestName) + ",debug-threads=on");
     
     // ============================================================
     // 设置 QEMU 数据目录 (-L 参数)
@@ -2072,10 +2343,30 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
     
     args.push_back("-m");
     args.push_back(std::to_string(config.memoryMB));
+
+    // 快速恢复：RAM 映射到文件（share=on），挂起时只需保存设备状态，恢复时按需缺页读入
+    if (config.fastResume) {
+        args.push_back("-object");
+        args.push_back("memory-backend-file,id=aether-ram,size=" + std::to_string(config.memoryMB) + "M,mem-path=" +
+                       QemuOptEscape(snapshot_ram_file(SnapshotVmFor(config.name))) + ",share=on");
+        args.push_back("-machine");
+        args.push_back("memory-backend=aether-ram");
+        HilogPrint("QEMU: [RAM] file-backed guest RAM for fast resume");
+    }
     
-    // 加速器配置
+    // 加速器配置（性能模式规划结果，见 ApplyTcgProfile）
     args.push_back("-accel");
     args.push_back(config.accel);
+    if (!config.icount.empty()) {
+        args.push_back("-icount");
+        args.push_back(config.icount);
+    }
+
+    // TCG 热点分析插件：每个 TB 的执行次数 / 访存 / MMIO 计数（getHotspots 读取）
+    if (!config.hotspotPluginPath.empty()) {
+        args.push_back("-plugin");
+        args.push_back(QemuOptEscape(config.hotspotPluginPath) + ",mmio=on");
+    }
     
     // UEFI/BIOS 固件配置
     std::string firmwarePath = config.efiFirmware;
@@ -2527,11 +2818,13 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
     } else if (needEnhancedNetwork) {
         // 增强启动：完整端口转发（支持RDP/SSH/HTTP等）
         HilogPrint(std::string("QEMU: [NET] Enhanced mode - full port forwarding enabled, netDev=") + netDev);
+        // 宿主端口来自 vm_runtime 端口池：第一个 VM 仍是 3390/2222/8080/8443，并行的 VM 各用一组
+        const VmPorts& ports = config.ports;
         std::string netdev = "user,id=n0";
-        netdev += ",hostfwd=tcp:127.0.0.1:3390-:3389";  // RDP
-        netdev += ",hostfwd=tcp:127.0.0.1:2222-:22";    // SSH
-        netdev += ",hostfwd=tcp:127.0.0.1:8080-:80";    // HTTP
-        netdev += ",hostfwd=tcp:127.0.0.1:8443-:443";   // HTTPS
+        netdev += ",hostfwd=tcp:127.0.0.1:" + std::to_string(ports.rdp) + "-:3389";    // RDP
+        netdev += ",hostfwd=tcp:127.0.0.1:" + std::to_string(ports.ssh) + "-:22";      // SSH
+        netdev += ",hostfwd=tcp:127.0.0.1:" + std::to_string(ports.http) + "-:80";     // HTTP
+        netdev += ",hostfwd=tcp:127.0.0.1:" + std::to_string(ports.https) + "-:443";   // HTTPS
     
         args.push_back("-netdev");
         args.push_back(netdev);
@@ -2563,17 +2856,9 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
     // ============================================================
     
     if (config.nographic) {
-        HilogPrint("QEMU: [DEBUG] Headless mode enabled (nographic + serial TCP)");
+        HilogPrint("QEMU: [DEBUG] Headless mode enabled (nographic + serial console)");
         args.push_back("-nographic");
-        // 串口使用TCP socket，可以通过 telnet localhost 4321 连接
-        args.push_back("-serial");
-        args.push_back("tcp:127.0.0.1:4321,server,nowait");
-        HilogPrint("QEMU: [DEBUG] Serial console on tcp:127.0.0.1:4321");
-        // 额外兜底：把串口内容落盘，便于排查“卡在 TianoCore/UEFI 阶段”
-        // 注意：路径包含空格也没关系（argv 单独一项，不会被再次 split）
-        args.push_back("-serial");
-        args.push_back("file:" + config.vmDir + "/serial.log");
-        HilogPrint("QEMU: [DEBUG] Serial log file: " + config.vmDir + "/serial.log");
+        AppendSerialConsoleArgs(args, config);
     } else {
         // 检查 keymaps 是否可用，决定是否启用 VNC
         bool vncAvailable = false;
@@ -2609,7 +2894,12 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
             HilogPrint("QEMU: [VNC_DEBUG] qemuDataDir empty, VNC disabled");
         }
         
-        if (vncAvailable) {
+        if (displayConfig == "xcomponent" || displayConfig.rfind("aether-xcomponent", 0) == 0) {
+            // 进程内显示桥（patches/qemu/0003）：控制台直接交给 XComponent，不经过 VNC，也不依赖 keymaps
+            args.push_back("-display");
+            args.push_back("aether-xcomponent");
+            HilogPrint("QEMU: [DEBUG] In-process XComponent display enabled");
+        } else if (vncAvailable) {
             // VNC 可用：使用 VNC 显示
             HilogPrint("QEMU: [DEBUG] VNC enabled (keymaps available)");
             
@@ -2640,6 +2930,13 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
                     HilogPrint(std::string("QEMU: [DEBUG] VNC display (RFB): ") + vncArg);
                 }
                 
+                // 默认显示号 :1 换成本 VM 分配到的 VNC 端口（并行 VM 不能共用 5901）
+                const size_t colon = vncArg.find(':');
+                const size_t comma = vncArg.find(',', colon == std::string::npos ? 0 : colon);
+                if (colon != std::string::npos && config.ports.vnc > 5900 &&
+                    vncArg.substr(colon + 1, comma == std::string::npos ? std::string::npos : comma - colon - 1) == "1") {
+                    vncArg.replace(colon + 1, 1, std::to_string(config.ports.vnc - 5900));
+                }
                 args.push_back("-vnc");
                 args.push_back(vncArg);
             } else {
@@ -2796,15 +3093,8 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
             }
         }
 
-        // 串口绑定到 TCP socket，用户可以通过网络连接进行交互
-        // 格式：telnet localhost 4321
-        args.push_back("-serial");
-        args.push_back("tcp:127.0.0.1:4321,server,nowait");
-        HilogPrint("QEMU: [DEBUG] Serial console on tcp:127.0.0.1:4321");
-        // 同时把串口落盘，排查 UEFI/Windows 引导卡点
-        args.push_back("-serial");
-        args.push_back("file:" + config.vmDir + "/serial.log");
-        HilogPrint("QEMU: [DEBUG] Serial log file: " + config.vmDir + "/serial.log");
+        // 串口：进程内环（或回退 TCP），同时落盘排查 UEFI/Windows 引导卡点
+        AppendSerialConsoleArgs(args, config);
     }
 
     // 声卡配置
@@ -2881,6 +3171,12 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
     std::string qmpSocketPath = "/data/storage/el2/base/haps/entry/files/vms/" + config.name + "/qmp.sock";
     args.push_back("-qmp");
     args.push_back("unix:" + qmpSocketPath + ",server,nowait");
+
+    // 恢复外部快照 / 挂起状态：等待 migrate-incoming（见 snapshot_finish_start）
+    if (!config.snapshotRestoreTag.empty() || config.snapshotResume) {
+        args.push_back("-incoming");
+        args.push_back("defer");
+    }
     
     // 监控接口：采用 QMP + guest 串口，主 monitor 关闭
     args.push_back("-monitor");
@@ -2895,65 +3191,45 @@ static std::vector<std::string> BuildQemuArgs(const VMConfig& config) {
 
 // 写入日志
 // 封装：同时写文件与Hilogs，便于 grep QEMU
+// 两者都只把预格式化记录放进无锁环，文件/hilog 输出由日志线程批量完成（log_pipeline）
 static void HilogPrint(const std::string& message)
 {
-    // 添加空指针保护 - 确保 message 内容有效
+    // 空消息不打印
     if (message.empty()) {
-        return;  // 空消息不打印
-    }
-    
-    const char* msg = message.c_str();
-    if (!msg) {
-        return;  // 极端情况保护
+        return;
     }
-    
-#if defined(__OHOS__)
-    // 使用 OH_LOG_Print
-    // 注意：不检查 &OH_LOG_Print != nullptr，因为这个检查总是 true
-    OH_LOG_Print(LOG_APP, LOG_INFO, 0x0000, "QEMU_CORE", "%{public}s", msg);
-    return;
-#endif
-    // 回退：stderr 也会被系统日志采集
-    std::fprintf(stderr, "[QEMU_CORE] %s\n", msg);
+    log_submit(0, kLogHilog, "", message);
 }
 
-static void WriteLog(const std::string& logPath, const std::string& message) {
-    try {
-        std::string dirPath = logPath.substr(0, logPath.find_last_of('/'));
-        CreateDirectories(dirPath);
-        
-        // 格式化日志消息
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::ostringstream oss;
-        oss << "[" << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S") << "] " << message;
-        std::string formattedMessage = oss.str();
-        
-        // 写入文件
-        std::ofstream log(logPath, std::ios::app);
-        if (log) {
-            log << formattedMessage << std::endl;
-        }
-
-        // 添加到内存缓冲区用于实时回传
-        if (!g_current_vm_name.empty()) {
-            std::lock_guard<std::mutex> lock(g_vmLogMutexes[g_current_vm_name]);
-            auto& buffer = g_vmLogBuffers[g_current_vm_name];
-            buffer.push_back(formattedMessage);
-            
-            // 限制缓冲区大小
-            if (buffer.size() > MAX_LOG_BUFFER_SIZE) {
-                buffer.erase(buffer.begin(), buffer.begin() + (buffer.size() - MAX_LOG_BUFFER_SIZE));
-            }
-        }
+// 日志文件 vms/<name>/qemu.log 所属的 VM 名（内存缓冲按它归类）
+static std::string VmNameFromLogPath(const std::string& logPath)
+{
+    const size_t slash = logPath.find_last_of('/');
+    if (slash == std::string::npos || slash == 0) return vm_runtime_inprocess_vm();
+    const size_t prev = logPath.find_last_of('/', slash - 1);
+    return logPath.substr(prev == std::string::npos ? 0 : prev + 1, slash - (prev == std::string::npos ? 0 : prev + 1));
+}
 
-        // 输出到系统日志，便于 on-device 调试
-        HilogPrint(formattedMessage);
-    } catch (...) {
-        // 忽略日志写入错误
+// 日志线程回调：行已写入 log_store，有订阅者时唤起一次推送（已排队则合并）
+static void VmLogTap(const std::string& vmName, std::string_view line)
+{
+    (void)line;
+    std::lock_guard<std::mutex> lock(g_vmLogSubscriberMutex);
+    auto it = g_vmLogSubscribers.find(vmName);
+    if (it == g_vmLogSubscribers.end()) return;
+    VmLogSubscriber* sub = it->second;
+    if (sub->scheduled.exchange(true)) return;
+    if (napi_call_threadsafe_function(sub->tsfn, nullptr, napi_tsfn_nonblocking) != napi_ok) {
+        sub->scheduled.store(false);
     }
 }
 
+static void WriteLog(const std::string& logPath, const std::string& message) {
+    // 同时写文件、内存缓冲与系统日志，便于 on-device 调试
+    log_submit(log_sink(logPath, VmNameFromLogPath(logPath)), kLogFile | kLogTap | kLogHilog | kLogTimestamp, "",
+               message);
+}
+
 // 动态加载 QEMU 核心库并调用其 API
 //
 // 注意：在 OHOS 侧，我们用 dlopen + dlsym 访问 QEMU 核心入口。
@@ -3265,7 +3541,218 @@ static void EnsureQemuCoreLoaded(const std::string& logPath, const std::string&
     }
 }
 
-static int QemuCoreMainOrStub(int argc, char** argv)
+// ----------------------------- 进程内串口会话（补丁 0004 aether-ring chardev） -----------------------------
+// 每个 VM 一个会话：QEMU 把来宾输出写进 SPSC 环并（边沿触发）通知，会话线程读空后交给控制台合并通道；
+// 键盘输入写进反向的环，由 QEMU 主循环按前端流控送入来宾。chardev 尚未创建时 sink 先挂起，打开后生效，
+// 启动早期的输出留在环里，不会丢。
+
+// 与补丁 0004 中的 AetherChardevSink 保持 ABI 一致
+struct QemuChardevSink {
+    void* opaque;
+    void (*notify)(void* opaque);
+    void (*closed)(void* opaque);
+};
+using qemu_hmos_chardev_set_sink_fn = int (*)(const char* id, const QemuChardevSink* sink, uint32_t version);
+using qemu_hmos_chardev_read_fn = ssize_t (*)(const char* id, void* buf, size_t len);
+using qemu_hmos_chardev_write_fn = ssize_t (*)(const char* id, const void* buf, size_t len);
+using qemu_hmos_chardev_dropped_fn = int64_t (*)(const char* id);
+static constexpr uint32_t kQemuChardevSinkVersion = 1;
+
+struct ConsoleSession {
+    std::string vmName;
+    std::string chardevId;
+    qemu_hmos_chardev_set_sink_fn setSink = nullptr;
+    qemu_hmos_chardev_read_fn read = nullptr;
+    qemu_hmos_chardev_write_fn write = nullptr;
+    qemu_hmos_chardev_dropped_fn dropped = nullptr;
+    std::thread reader;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool wake = false;
+    bool stop = false;
+};
+
+static std::map<std::string, std::unique_ptr<ConsoleSession>> g_consoleSessions;
+static std::mutex g_consoleSessionsMutex;
+
+// chardev id 只允许字母数字和 -._，且以字母开头
+static std::string ConsoleChardevId(const std::string& vmName)
+{
+    std::string id = "con-";
+    for (char c : vmName) {
+        id += (std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.') ? c : '_';
+    }
+    return id;
+}
+
+// QEMU 线程（持有环锁）调用：只做唤醒
+static void ConsoleSessionNotify(void* opaque)
+{
+    auto* cs = static_cast<ConsoleSession*>(opaque);
+    {
+        std::lock_guard<std::mutex> lk(cs->mutex);
+        cs->wake = true;
+    }
+    cs->cv.notify_one();
+}
+
+static void ConsoleSessionReader(ConsoleSession* cs)
+{
+    char buf[16 * 1024];
+    int64_t reportedDrops = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(cs->mutex);
+            cs->cv.wait(lk, [cs]() { return cs->wake || cs->stop; });
+            if (cs->stop) return;
+            cs->wake = false;
+        }
+        ssize_t n;
+        while ((n = cs->read(cs->chardevId.c_str(), buf, sizeof(buf))) > 0) {
+            SerialEmitToJs(cs->vmName, buf, static_cast<size_t>(n));
+        }
+        const int64_t drops = cs->dropped ? cs->dropped(cs->chardevId.c_str()) : 0;
+        if (drops > reportedDrops) {
+            SerialEmitToJs(cs->vmName, "\r\n[console: " + std::to_string(drops - reportedDrops) + " bytes dropped in guest ring]\r\n");
+            reportedDrops = drops;
+        }
+    }
+}
+
+// 核心库是否以 --enable-plugins 构建（导出 qemu_plugin_* API）
+static bool PluginApiAvailable()
+{
+    return g_qemu_core_handle && dlsym(g_qemu_core_handle, "qemu_plugin_u64_sum");
+}
+
+// 热点分析插件与本库放在同一目录（libs/arm64-v8a）；不存在返回空
+static std::string HotspotPluginPath()
+{
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&HotspotPluginPath), &info) == 0 || !info.dli_fname) return "";
+    std::string path = info.dli_fname;
+    const size_t slash = path.rfind('/');
+    if (slash == std::string::npos) return "";
+    path = path.substr(0, slash + 1) + AETHER_HOTSPOT_LIB;
+    return access(path.c_str(), R_OK) == 0 ? path : "";
+}
+
+// 核心库是否带 aether-ring chardev（补丁 0004）
+static bool ConsoleRingAvailable()
+{
+    return g_qemu_core_handle && dlsym(g_qemu_core_handle, "qemu_hmos_chardev_set_sink") &&
+           dlsym(g_qemu_core_handle, "qemu_hmos_chardev_read") && dlsym(g_qemu_core_handle, "qemu_hmos_chardev_write");
+}
+
+static void ConsoleSessionStop(const std::string& vmName)
+{
+    std::unique_ptr<ConsoleSession> cs;
+    {
+        std::lock_guard<std::mutex> lk(g_consoleSessionsMutex);
+        auto it = g_consoleSessions.find(vmName);
+        if (it == g_consoleSessions.end()) return;
+        cs = std::move(it->second);
+        g_consoleSessions.erase(it);
+    }
+    // set_sink(NULL) 返回后不会再有 notify 回调
+    cs->setSink(cs->chardevId.c_str(), nullptr, kQemuChardevSinkVersion);
+    {
+        std::lock_guard<std::mutex> lk(cs->mutex);
+        cs->stop = true;
+    }
+    cs->cv.notify_one();
+    if (cs->reader.joinable()) cs->reader.join();
+}
+
+// 在 QEMU 启动前调用（chardev 打开时自动挂上 sink）
+static bool ConsoleSessionStart(const std::string& vmName, const std::string& chardevId)
+{
+    ConsoleSessionStop(vmName);
+    auto cs = std::make_unique<ConsoleSession>();
+    cs->vmName = vmName;
+    cs->chardevId = chardevId;
+    cs->setSink = reinterpret_cast<qemu_hmos_chardev_set_sink_fn>(dlsym(g_qemu_core_handle, "qemu_hmos_chardev_set_sink"));
+    cs->read = reinterpret_cast<qemu_hmos_chardev_read_fn>(dlsym(g_qemu_core_handle, "qemu_hmos_chardev_read"));
+    cs->write = reinterpret_cast<qemu_hmos_chardev_write_fn>(dlsym(g_qemu_core_handle, "qemu_hmos_chardev_write"));
+    cs->dropped = reinterpret_cast<qemu_hmos_chardev_dropped_fn>(dlsym(g_qemu_core_handle, "qemu_hmos_chardev_dropped"));
+    if (!cs->setSink || !cs->read || !cs->write) return false;
+
+    cs->reader = std::thread(ConsoleSessionReader, cs.get());
+    QemuChardevSink sink{};
+    sink.opaque = cs.get();
+    sink.notify = ConsoleSessionNotify;
+    sink.closed = ConsoleSessionNotify;
+    if (cs->setSink(chardevId.c_str(), &sink, kQemuChardevSinkVersion) != 0) {
+        {
+            std::lock_guard<std::mutex> lk(cs->mutex);
+            cs->stop = true;
+        }
+        cs->cv.notify_one();
+        cs->reader.join();
+        return false;
+    }
+    std::lock_guard<std::mutex> lk(g_consoleSessionsMutex);
+    g_consoleSessions[vmName] = std::move(cs);
+    return true;
+}
+
+// 键盘输入写入 VM 串口；返回 false 表示该 VM 没有进程内会话
+static bool ConsoleSessionWrite(const std::string& vmName, const std::string& data)
+{
+    std::lock_guard<std::mutex> lk(g_consoleSessionsMutex);
+    auto it = g_consoleSessions.find(vmName);
+    if (it == g_consoleSessions.end()) return false;
+    ConsoleSession* cs = it->second.get();
+    return cs->write(cs->chardevId.c_str(), data.data(), data.size()) >= 0;
+}
+
+// ----------------------------- 工作进程方式运行 VM（vm_worker） -----------------------------
+// 显示桥 / 串口回调定义在显示桥一节之后
+static VmWorker::Callbacks VmWorkerCallbacks(const std::string& vmName);
+static void DisplayBridgeDetachVm(const std::string& vmName);
+
+// 在 VM 线程中调用：阻塞到工作进程退出，返回 QEMU 退出码
+static int RunVmInWorker(const VMConfig& config, const std::vector<std::string>& args)
+{
+    VmWorkerLaunch launch;
+    launch.vm_name = config.name;
+    launch.vm_dir = config.vmDir;
+    launch.core_lib = GetQemuLibName(config.archType.empty() ? "aarch64" : config.archType);
+    launch.console_chardev = config.consoleChardev;
+    launch.argv = args;
+    std::string err;
+    std::shared_ptr<VmWorker> worker = VmWorker::Spawn(launch, VmWorkerCallbacks(config.name), err);
+    if (!worker) {
+        WriteLog(config.logPath, "[WORKER] Failed to start QEMU worker process: " + err);
+        HilogPrint("QEMU: [WORKER] start failed for '" + config.name + "': " + err);
+        return -1;
+    }
+    vm_runtime_set_pid(config.name, worker->pid());
+    WriteLog(config.logPath, "[WORKER] QEMU running in worker process pid=" + std::to_string(worker->pid()));
+    {
+        std::lock_guard<std::mutex> lk(g_vmWorkersMutex);
+        g_vmWorkers[config.name] = worker;
+    }
+    const int exitCode = worker->Wait();
+    {
+        std::lock_guard<std::mutex> lk(g_vmWorkersMutex);
+        g_vmWorkers.erase(config.name);
+    }
+    DisplayBridgeDetachVm(config.name);
+    return exitCode;
+}
+
+// 与补丁 0002 中的 AetherAudioThreadHook 保持 ABI 一致：OHAudio 回调线程首次回调时调用
+using qemu_hmos_audio_thread_hook_fn = void (*)(const char* role);
+using qemu_hmos_audio_set_thread_hook_fn = int (*)(qemu_hmos_audio_thread_hook_fn hook, uint32_t version);
+static constexpr uint32_t kQemuAudioThreadHookVersion = 1;
+
+static void QemuAudioThreadHook(const char* role)
+{
+    sched_pin_self(SchedRole::Io, role ? role : "audio", vm_runtime_inprocess_vm());
+}
+
+static int QemuCoreMainOrStub(const VMConfig& config, int argc, char** argv)
 {
     // 提取日志路径用于记录
     std::string logPath;
@@ -3278,10 +3765,9 @@ static int QemuCoreMainOrStub(int argc, char** argv)
             }
         }
     }
-    if (logPath.empty()) logPath = g_current_log_path;
+    if (logPath.empty()) logPath = config.logPath;
 
-    // 使用全局变量中保存的架构类型
-    std::string archType = g_current_arch_type.empty() ? "aarch64" : g_current_arch_type;
+    std::string archType = config.archType.empty() ? "aarch64" : config.archType;
     EnsureQemuCoreLoaded(logPath, archType);
     if (g_qemu_core_qemu_init && g_qemu_core_main_loop) {
         WriteLog(logPath, "[QEMU] Core library loaded, initializing QEMU...");
@@ -3293,6 +3779,22 @@ static int QemuCoreMainOrStub(int argc, char** argv)
             HilogPrint("QEMU:   argv[" + std::to_string(i) + "] = " + std::string(argv[i]));
         }
         
+        // 本线程即 QEMU 主循环（I/O）线程：绑到 vCPU 以外的核心；音频回调线程经补丁 0002 的 hook 同样处理
+        pthread_setname_np(pthread_self(), "qemu-main");
+        sched_pin_self(SchedRole::Io, "qemu-main", config.name);
+        auto setAudioHook = reinterpret_cast<qemu_hmos_audio_set_thread_hook_fn>(
+            dlsym(g_qemu_core_handle, "qemu_hmos_audio_set_thread_hook"));
+        if (setAudioHook) setAudioHook(QemuAudioThreadHook, kQemuAudioThreadHookVersion);
+
+        // 热点分析插件的 qemu_plugin_* 未定义符号从 core 解析；core 以 RTLD_LOCAL 打开，加载插件前提升为全局
+        if (!config.hotspotPluginPath.empty()) {
+            Dl_info core;
+            if (dladdr(reinterpret_cast<void*>(g_qemu_core_qemu_init), &core) != 0 && core.dli_fname) {
+                void* global = dlopen(core.dli_fname, RTLD_NOW | RTLD_NOLOAD | RTLD_GLOBAL);
+                if (global) dlclose(global);   // 只为提升可见性，引用计数还回去
+            }
+        }
+
         // 使用新的 QEMU API：先 init，再 main_loop
         HilogPrint("QEMU: Calling qemu_init now...");
         WriteLog(logPath, "[QEMU] Calling qemu_init...");
@@ -3377,6 +3879,13 @@ static int QemuCoreMainOrStub(int argc, char** argv)
             ">>> qemu_init 返回成功！<<<");
         
         g_qemu_initialized = true;
+        SetVmState(config.name, VmState::Running, "qemu_init");
+        {
+            const int vcpus = sched_apply_qemu_threads(0, config.profile == "powersaver");
+            WriteLog(logPath, "[SCHED] pinning=" + std::string(sched_enabled() ? "on" : "off") + ", " +
+                     std::to_string(vcpus) + " vCPU thread(s) on " +
+                     (config.profile == "powersaver" ? "efficiency" : "performance") + " cores");
+        }
         
         HilogPrint("QEMU: qemu_init completed, entering main loop...");
         WriteLog(logPath, "[QEMU] qemu_init completed, entering qemu_main_loop...");
@@ -3394,6 +3903,7 @@ static int QemuCoreMainOrStub(int argc, char** argv)
         }
         g_qemu_initialized = false;
         g_tls_in_qemu = false;
+        sched_unregister_self();
         
         return result;
     }
@@ -3433,7 +3943,10 @@ extern "C" void qemu_system_shutdown_request(int reason) {
         g_qemu_core_shutdown(reason);
         return;
     }
-    WriteLog(g_current_log_path, "[QEMU] 收到关闭请求(Stub)，原因代码: " + std::to_string(reason));
+    VmRuntime rt;
+    if (vm_runtime_get(vm_runtime_inprocess_vm(), rt)) {
+        WriteLog(rt.log_path, "[QEMU] 收到关闭请求(Stub)，原因代码: " + std::to_string(reason));
+    }
     g_qemu_shutdown_requested = true;
 }
 
@@ -3476,6 +3989,68 @@ static napi_value KvmSupported(napi_env env, napi_callback_info info) {
     return out;
 }
 
+// setDeviceInfo(deviceType, model)：ArkTS 侧 deviceInfo 传入（0=unknown, 1=phone, 2=tablet, 3=2in1, 4=pc）
+static napi_value SetDeviceInfo(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    int32_t deviceType = 0;
+    std::string model;
+    if (argc >= 1) napi_get_value_int32(env, argv[0], &deviceType);
+    if (argc >= 2) NapiGetStringUtf8(env, argv[1], model);
+    qemu_set_device_info(deviceType, model.c_str());
+    return nullptr;
+}
+
+// setJitPermission(granted)：ArkTS 侧检查 ohos.permission.kernel.ALLOW_WRITABLE_CODE_MEMORY 的结果，性能模式据此规划
+static napi_value SetJitPermission(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    bool granted = false;
+    if (argc >= 1) napi_get_value_bool(env, argv[0], &granted);
+    qemu_set_jit_permission(granted ? 1 : 0);
+    return nullptr;
+}
+
+// 按性能模式规划 -accel / -icount / -smp / -m，依据写入 VM 日志
+static void ApplyTcgProfile(VMConfig& config)
+{
+    TcgRequest req;
+    tcg_profile_from_string(config.profile, req.profile);
+    req.accel = config.accel;
+    req.cpus = config.cpuExplicit ? config.cpuCount : 0;
+    req.memory_mb = config.memoryExplicit ? config.memoryMB : 0;
+    const TcgHostCaps caps = tcg_probe_host(qemu_has_jit_permission() != 0, kvmSupported());
+    const TcgTuning tuning = tcg_profile_plan(req, caps);
+
+    config.accel = tuning.accel;
+    config.icount = tuning.icount;
+    config.cpuCount = tuning.smp;
+    config.memoryMB = tuning.memory_mb;
+
+    WriteLog(config.logPath, std::string("[PROFILE] ") + tcg_profile_name(tuning.profile) + ": -accel " + tuning.accel +
+             (tuning.icount.empty() ? "" : " -icount " + tuning.icount) + " -smp " + std::to_string(tuning.smp) +
+             " -m " + std::to_string(tuning.memory_mb));
+    WriteLog(config.logPath, "[PROFILE] host: " + std::to_string(caps.cpus) + " cpus (" +
+             std::to_string(caps.big_cpus.size()) + " performance / " + std::to_string(caps.little_cpus.size()) +
+             " efficiency), " + std::to_string(caps.total_mem_mb) + "MB RAM, " +
+             std::to_string(caps.avail_mem_mb) + "MB available, jit=" + (caps.jit ? "yes" : "no") +
+             " kvm=" + (caps.kvm ? "yes" : "no"));
+    for (const auto& why : tuning.rationale) {
+        WriteLog(config.logPath, "[PROFILE]   " + why);
+    }
+
+    std::lock_guard<std::mutex> lk(g_vmProfilesMutex);
+    VmProfileRecord& rec = g_vmProfiles[config.name];
+    rec.tuning = tuning;
+    rec.startMs = VmStateNowMs();
+    rec.bootMs = -1;
+}
+
+// Forward declaration: StartVm() kicks the QMP event stream for subscribed VMs.
+static void QmpEventConnectWhenReady(const std::string& vmName);
+
 static napi_value StartVm(napi_env env, napi_callback_info info) {
     // ============ 诊断：在任何操作之前打印日志 ============
     OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_DOMAIN, "QEMU_START", ">>> StartVm 函数入口 <<<");
@@ -3511,7 +4086,9 @@ static napi_value StartVm(napi_env env, napi_callback_info info) {
         return retBool;
     }
     
-    HilogPrint("QEMU: Starting VM '" + config.name + "' with accel=" + config.accel + " display=" + config.display);
+    ApplyTcgProfile(config);
+    HilogPrint("QEMU: Starting VM '" + config.name + "' with profile=" + config.profile + " accel=" + config.accel +
+               " display=" + config.display);
     
     // 创建VM目录结构
     if (!CreateVMDirectory(config.name)) {
@@ -3537,14 +4114,14 @@ static napi_value StartVm(napi_env env, napi_callback_info info) {
     }
     
     // 更新VM状态为准备中
-    UpdateVMStatus(config.name, "preparing");
+    SetVmState(config.name, VmState::Preparing, "startVm");
     
     // 创建虚拟磁盘
     if (!FileExists(config.diskPath)) {
         WriteLog(config.logPath, "Creating virtual disk: " + config.diskPath);
         if (!CreateVirtualDisk(config.diskPath, config.diskSizeGB)) {
             WriteLog(config.logPath, "Failed to create virtual disk");
-            UpdateVMStatus(config.name, "failed");
+            SetVmState(config.name, VmState::Failed, "create disk failed");
             napi_throw_error(env, nullptr, "Failed to create virtual disk");
             return retBool;
         }
@@ -3556,7 +4133,7 @@ static napi_value StartVm(napi_env env, napi_callback_info info) {
     // - qcow2 disk：必须有有效 refcount table，否则视为损坏（常见于旧版内置 qcow2 伪实现生成的镜像）
     if (FileExists(config.diskPath) && IsQcow2FileQuick(config.diskPath)) {
         if (!PreflightQcow2RefcountTable(config.diskPath)) {
-            UpdateVMStatus(config.name, "failed");
+            SetVmState(config.name, VmState::Failed, "qcow2 refcount table invalid");
             napi_throw_error(env, nullptr,
                              "Disk image is corrupt (qcow2 refcount table invalid). 请到「磁盘空间管理 → 新建/覆盖」重建磁盘后再启动。");
             return retBool;
@@ -3574,6 +4151,103 @@ static napi_value StartVm(napi_env env, napi_callback_info info) {
     WriteLog(config.logPath, "[CONFIG] QEMU Data Dir: " + (config.qemuDataDir.empty() ? "(not set)" : config.qemuDataDir));
     WriteLog(config.logPath, "==========================================");
     
+    // 外部快照：挂载当前活动的 overlay；若有待恢复快照，在其冻结层上新建 overlay 并以 -incoming defer 启动
+    // 挂起状态只有在硬件配置一致、且本次仍启用 fastResume 时才可用
+    const std::string resumeFingerprint = config.fastResume ? VmResumeFingerprint(config) : "";
+    const SnapshotStartPlan snapPlan = snapshot_prepare_start(SnapshotVmFor(config.name), resumeFingerprint);
+    if (snapPlan.disk_path != config.diskPath) {
+        WriteLog(config.logPath, "[SNAPSHOT] Active disk layer: " + snapPlan.disk_path);
+        config.diskPath = snapPlan.disk_path;
+    }
+    config.snapshotRestoreTag = snapPlan.restore_tag;
+    config.snapshotResume = snapPlan.resume;
+    if (!config.snapshotRestoreTag.empty()) {
+        WriteLog(config.logPath, "[SNAPSHOT] Restoring snapshot '" + config.snapshotRestoreTag + "' on start");
+    } else if (config.snapshotResume) {
+        WriteLog(config.logPath, "[SNAPSHOT] Resuming from suspend state");
+    }
+    g_vm_resume_fingerprints[config.name] = resumeFingerprint;
+    
+    // 运行方式：进程内 QEMU 的全局状态只有一份，已被其它 VM 占用时以工作进程方式运行
+    const std::string inProcessVm = vm_runtime_inprocess_vm();
+    config.worker = config.runtime == "worker" || (!inProcessVm.empty() && inProcessVm != config.name);
+    if (config.worker && config.runtime == "inprocess") {
+        SetVmState(config.name, VmState::Failed, "in-process QEMU busy");
+        napi_throw_error(env, nullptr, ("In-process QEMU is in use by VM '" + inProcessVm + "'").c_str());
+        return retBool;
+    }
+
+    std::string archType = config.archType.empty() ? "aarch64" : config.archType;
+    if (!config.worker) {
+        // 启动前确保核心库可用（根据架构加载对应的 .so）；构建参数时要知道它是否带 aether-ring 串口
+        // 工作进程自己加载 core，这里不能切换（可能正被进程内 VM 使用的）core
+        WriteLog(config.logPath, "[QEMU] Loading QEMU core for architecture: " + archType);
+        EnsureQemuCoreLoaded(config.logPath, archType);
+        if (!g_qemu_core_qemu_init || !g_qemu_core_main_loop) {
+            WriteLog(config.logPath, "[QEMU] Core library not loaded. Aborting start.");
+            std::string libName = GetQemuLibName(archType);
+            WriteLog(config.logPath, "[QEMU] Please ensure " + libName + " is properly installed in the app bundle.");
+            SetVmState(config.name, VmState::Failed, libName + " not loaded");
+            napi_throw_error(env, nullptr, (libName + " not found or failed to load. Please check app installation.").c_str());
+            return retBool;
+        }
+    }
+
+    // 登记运行时上下文并分配端口（VM 线程退出时释放）
+    VmRuntime runtime;
+    const VmRuntimeAcquire acquired = vm_runtime_acquire(
+        config.name, config.worker ? VmRuntimeMode::Worker : VmRuntimeMode::InProcess, config.logPath, runtime);
+    if (acquired == VmRuntimeAcquire::InProcessBusy) {
+        const std::string holder = vm_runtime_inprocess_vm();
+        WriteLog(config.logPath, "[RUNTIME] In-process QEMU is busy with VM '" + holder + "'");
+        SetVmState(config.name, VmState::Failed, "in-process slot busy");
+        napi_throw_error(env, nullptr, ("VM '" + holder + "' already runs in-process; "
+                                        "start this VM in worker mode").c_str());
+        return retBool;
+    }
+    if (acquired != VmRuntimeAcquire::Ok) {
+        WriteLog(config.logPath, "[RUNTIME] No free host port block for VM");
+        SetVmState(config.name, VmState::Failed, "no free host ports");
+        napi_throw_error(env, nullptr, "No free host ports for another VM");
+        return retBool;
+    }
+    config.ports = runtime.ports;
+    WriteLog(config.logPath, std::string("[RUNTIME] mode=") + (config.worker ? "worker" : "inprocess") +
+        " rdp=" + std::to_string(config.ports.rdp) + " ssh=" + std::to_string(config.ports.ssh) +
+        " http=" + std::to_string(config.ports.http) + " https=" + std::to_string(config.ports.https) +
+        " vnc=" + std::to_string(config.ports.vnc));
+
+    config.consoleChardev.clear();
+    if (config.worker) {
+        // 工作进程内的 aether-ring 串口经控制通道转发；core 不带补丁 0004 时工作进程改用 null chardev
+        config.consoleChardev = ConsoleChardevId(config.name);
+    } else {
+        // 串口会话先于 QEMU 建立：chardev 打开即挂上 sink，第一字节无需等待
+        if (ConsoleRingAvailable() && ConsoleSessionStart(config.name, ConsoleChardevId(config.name))) {
+            config.consoleChardev = ConsoleChardevId(config.name);
+            SerialStop();
+        } else {
+            WriteLog(config.logPath, "[CONSOLE] Core has no aether-ring chardev, serial falls back to tcp:127.0.0.1:4321");
+        }
+        g_serial_use_tcp.store(config.consoleChardev.empty());
+        if (g_serial_use_tcp.load() && ConsoleHasListener(config.name)) {
+            SerialStart();
+        }
+    }
+    
+    // 热点分析插件只对 TCG 有意义；工作进程在 core 未导出插件 API 时去掉 -plugin
+    config.hotspotPluginPath.clear();
+    if (config.profiler && config.accel.rfind("kvm", 0) != 0) {
+        const std::string plugin = HotspotPluginPath();
+        if (plugin.empty()) {
+            WriteLog(config.logPath, std::string("[PROFILER] ") + AETHER_HOTSPOT_LIB + " not packaged, profiler disabled");
+        } else if (!config.worker && !PluginApiAvailable()) {
+            WriteLog(config.logPath, "[PROFILER] Core built without TCG plugin support, profiler disabled");
+        } else {
+            config.hotspotPluginPath = plugin;
+        }
+    }
+
     // 构建QEMU参数
     std::vector<std::string> args = BuildQemuArgs(config);
     std::string cmdStr = "Starting VM with command: ";
@@ -3588,76 +4262,85 @@ static napi_value StartVm(napi_env env, napi_callback_info info) {
     WriteLog(config.logPath, "Disk path: " + config.diskPath + " (exists: " + (FileExists(config.diskPath) ? "yes" : "no") + ")");
     HilogPrint("QEMU: Disk exists: " + std::string(FileExists(config.diskPath) ? "yes" : "no"));
     
-    // 初始化日志缓冲区
-    g_vmLogBuffers[config.name].clear();
-    // 确保互斥锁存在（map会自动创建）
-    g_vmLogMutexes[config.name];
+    // 初始化日志缓冲区（先让日志线程处理完已提交的记录；序号不回退，增量读取方不受影响）
+    log_flush();
+    log_store_clear(config.name);
     
-    // 设置全局变量供QEMU函数使用
-    g_current_vm_name = config.name;
-    g_current_log_path = config.logPath;
-    g_current_arch_type = config.archType.empty() ? "aarch64" : config.archType;
-    
-    // 启动前确保核心库可用（根据架构加载对应的 .so）
-    std::string archType = config.archType.empty() ? "aarch64" : config.archType;
-    WriteLog(config.logPath, "[QEMU] Loading QEMU core for architecture: " + archType);
-    EnsureQemuCoreLoaded(config.logPath, archType);
-    if (!g_qemu_core_qemu_init || !g_qemu_core_main_loop) {
-        WriteLog(config.logPath, "[QEMU] Core library not loaded. Aborting start.");
-        std::string libName = GetQemuLibName(archType);
-        WriteLog(config.logPath, "[QEMU] Please ensure " + libName + " is properly installed in the app bundle.");
-        UpdateVMStatus(config.name, "failed");
-        napi_throw_error(env, nullptr, (libName + " not found or failed to load. Please check app installation.").c_str());
-        return retBool;
-    }
-
-    // 启动VM线程
-    if (g_vmRunning.find(config.name) == g_vmRunning.end()) {
-        g_vmRunning[config.name] = new std::atomic<bool>(false);
+    // 启动VM线程（g_vmRunning 的条目只增不删，VM 线程直接持有指针，退出时不必再查表）
+    std::atomic<bool>*& runningFlag = g_vmRunning[config.name];
+    if (!runningFlag) {
+        runningFlag = new std::atomic<bool>(false);
     }
-    g_vmRunning[config.name]->store(true);
+    runningFlag->store(true);
+    std::atomic<bool>* running = runningFlag;
     
-    // 更新VM状态为运行中
-    UpdateVMStatus(config.name, "running");
+    // VM 线程已创建：qemu_init 完成、进入主循环后才算 running（见 QemuCoreMainOrStub）
+    SetVmState(config.name, VmState::Starting, "vm thread");
     
     // 保存 vmName 用于在回调中使用
     std::string vmName = config.name;
+    // 先挂内部事件订阅再起线程，STOP/RESUME/SHUTDOWN 一个都不漏
+    VmStateAttachQmp(vmName);
     
-    g_vmThreads[config.name] = std::thread([config, args, vmName]() {
-        std::vector<char*> cargs;
-        for (const auto &s : args) {
-            cargs.push_back(const_cast<char*>(s.c_str()));
-        }
-
-        // 在进入 QEMU 主循环前启动 stdout/stderr/stdin 捕获（并把 stdout/stderr 落盘到 VM 目录）
-        g_logCapture = std::make_unique<CaptureQemuOutput>(config.vmDir);
-
+    g_vmThreads[config.name] = std::thread([config, args, vmName, running]() {
         WriteLog(config.logPath, "VM thread started");
         // 这里也通过 Hilog 打一条，方便在设备上直接看到 VM 主线程已启动
         HilogPrint("QEMU: VM thread started for VM '" + vmName + "'");
-        int exitCode = QemuCoreMainOrStub(static_cast<int>(cargs.size()), cargs.data());
-        WriteLog(config.logPath, "VM exited with code: " + std::to_string(exitCode));
+        int exitCode = -1;
+        if (config.worker) {
+            // 工作进程的 stdout/stderr 各自经管道落盘，不碰本进程的 fd 1/2
+            exitCode = RunVmInWorker(config, args);
+            WriteLog(config.logPath, "VM exited with code: " + std::to_string(exitCode));
+            log_flush();
+        } else {
+            std::vector<char*> cargs;
+            for (const auto &s : args) {
+                cargs.push_back(const_cast<char*>(s.c_str()));
+            }
 
-        // 退出后释放捕获器，恢复文件描述符并释放 JS 回调
-        g_logCapture.reset();
+            // 在进入 QEMU 主循环前启动 stdout/stderr/stdin 捕获（并把 stdout/stderr 落盘到 VM 目录）
+            g_logCapture = std::make_unique<CaptureQemuOutput>(vmName, config.vmDir);
+            exitCode = QemuCoreMainOrStub(config, static_cast<int>(cargs.size()), cargs.data());
+            WriteLog(config.logPath, "VM exited with code: " + std::to_string(exitCode));
+            log_flush();
+
+            // 退出后释放捕获器，恢复文件描述符
+            g_logCapture.reset();
+            ConsoleSessionStop(vmName);
+        }
+        // 释放该 VM 的专属控制台回调（全局回调不动，其它 VM 还在用）
+        ConsoleReleaseCallback(vmName);
+        vm_runtime_release(vmName);
         
-        // 更新VM状态为已停止
-        UpdateVMStatus(config.name, "stopped");
-        g_vmRunning[config.name]->store(false);
+        // 以 qemu_main_loop 返回为准更新状态
+        running->store(false);
+        snapshot_vm_exited(SnapshotVmFor(vmName));
+        if (exitCode == 0) {
+            SetVmState(vmName, VmState::Stopped, "exit code 0");
+        } else {
+            SetVmState(vmName, VmState::Failed, "exit code " + std::to_string(exitCode));
+        }
         
         // 通知 ArkTS 层 VM 已退出
         VmStartError error = (exitCode == 0) ? VmStartError::SUCCESS : VmStartError::LOOP_CRASHED;
         std::string errorMsg = (exitCode == 0) ? "" : "VM exited with code " + std::to_string(exitCode);
         NotifyVmStartResult(vmName, error, exitCode, errorMsg);
     });
+    // socket 就绪后立即建立事件流（状态机依赖它，不等第一次命令调用）
+    QmpEventConnectWhenReady(vmName);
+    if (!config.snapshotRestoreTag.empty() || config.snapshotResume) {
+        const std::string logPath = config.logPath;
+        snapshot_finish_start(SnapshotVmFor(vmName), snapPlan, [logPath](const SnapshotProgress& p) {
+            if (!p.done) return;
+            WriteLog(logPath, "[SNAPSHOT] Restore '" + p.tag + "' " + (p.ok ? "completed" : "failed: " + p.error));
+            HilogPrint("QEMU: [SNAPSHOT] restore '" + p.tag + "' " + (p.ok ? "completed" : "failed: " + p.error));
+        });
+    }
 
     napi_get_boolean(env, true, &retBool);
     return retBool;
 }
 
-// Forward declaration: used by StopVm() background watchdog thread.
-static std::string QueryVmStatusViaQmp(const std::string& vmName);
-
 static napi_value StopVm(napi_env env, napi_callback_info info) {
     size_t argc = 1;
     napi_value argv[1];
@@ -3680,13 +4363,24 @@ static napi_value StopVm(napi_env env, napi_callback_info info) {
     
     if (g_vmRunning.find(vmName) != g_vmRunning.end() && g_vmRunning[vmName]->load()) {
         // 更新VM状态为停止中
-        UpdateVMStatus(vmName, "stopping");
+        SetVmState(vmName, VmState::Stopping, "stopVm");
 
         std::string logPath = "/data/storage/el2/base/haps/entry/files/vms/" + vmName + "/qemu.log";
         WriteLog(logPath, "StopVm requested by user (non-blocking)");
 
-        // 先发“优雅关机”请求（不会阻塞）
-        qemu_system_shutdown_request(SHUTDOWN_CAUSE_HOST);
+        // 先发“优雅关机”请求（不会阻塞）；工作进程 VM 由控制通道转给它自己的 core
+        // 进程内的 QEMU 全局状态只属于进程内 VM：查不到运行时就不能调全局关机，
+        // 否则会关掉此刻占用进程内槽位的另一个 VM；交给下面的 QMP quit / Kill() 看门狗
+        VmRuntime rt;
+        if (!vm_runtime_get(vmName, rt)) {
+            WriteLog(logPath, "[STOP] No runtime entry for this VM, relying on QMP quit / worker kill");
+            HilogPrint("QEMU: [STOP] No runtime entry for " + vmName + ", skipping shutdown request");
+        } else if (rt.mode == VmRuntimeMode::Worker) {
+            std::shared_ptr<VmWorker> worker = FindVmWorker(vmName);
+            if (worker) worker->RequestShutdown();
+        } else if (rt.mode == VmRuntimeMode::InProcess) {
+            qemu_system_shutdown_request(SHUTDOWN_CAUSE_HOST);
+        }
 
         // 关键修复：不要在 NAPI 调用里 join VM 线程（会卡死 UI）
         // 把 join 放到后台线程里做；超时则通过 QMP 发送 quit 强制退出。
@@ -3699,78 +4393,31 @@ static napi_value StopVm(napi_env env, napi_callback_info info) {
 
         // QMP: send {"execute":"quit"} to force exit
         auto sendQmpQuit = [](const std::string& name) -> bool {
-            std::string socketPath = "/data/storage/el2/base/haps/entry/files/vms/" + name + "/qmp.sock";
-            int sock = socket(AF_UNIX, SOCK_STREAM, 0);
-            if (sock < 0) return false;
-
-            struct timeval tv;
-            tv.tv_sec = 2;
-            tv.tv_usec = 0;
-            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-            setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-
-            struct sockaddr_un addr;
-            memset(&addr, 0, sizeof(addr));
-            addr.sun_family = AF_UNIX;
-            strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
-
-            if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-                close(sock);
-                return false;
-            }
-
-            char buffer[4096];
-            ssize_t n = recv(sock, buffer, sizeof(buffer) - 1, 0); // greeting
-            if (n <= 0) {
-                close(sock);
-                return false;
-            }
-            buffer[n] = '\0';
-
-            const char* capCmd = "{\"execute\": \"qmp_capabilities\"}\n";
-            if (send(sock, capCmd, strlen(capCmd), 0) <= 0) {
-                close(sock);
-                return false;
-            }
-            n = recv(sock, buffer, sizeof(buffer) - 1, 0); // capabilities response (ignore content)
-            (void)n;
-
-            const char* quitCmd = "{\"execute\": \"quit\"}\n";
-            (void)send(sock, quitCmd, strlen(quitCmd), 0);
-            close(sock);
-            return true;
+            // quit 的回复可能来不及发出连接就断了：已发出且未被拒绝即视为成功
+            QmpResult r = VmQmpClient(name)->execute("quit", "", 2000);
+            return r.sent;
         };
 
         // 后台等待退出/强制退出
         std::thread([vmName, logPath, vmThread = std::move(vmThread), sendQmpQuit]() mutable {
-            // 等待一小段时间让 guest 自己关机
-            const auto start = std::chrono::steady_clock::now();
-            bool forced = false;
-
-            while (true) {
-                // 这里不加全局锁：仅通过 QMP 看状态（失败则认为仍需等待）
-                std::string st = QueryVmStatusViaQmp(vmName);
-                if (st == "stopped" || st == "shutdown") {
-                    break;
-                }
-
-                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::steady_clock::now() - start).count();
-
-                if (!forced && elapsed >= 5) {
-                    // 超时：强制退出
-                    forced = true;
-                    bool ok = sendQmpQuit(vmName);
-                    WriteLog(logPath, std::string("[STOP] Timeout reached, sent QMP quit: ") + (ok ? "ok" : "failed"));
-                    HilogPrint(std::string("QEMU: [STOP] Timeout, QMP quit sent: ") + (ok ? "ok" : "failed"));
-                }
-
-                if (elapsed >= 12) {
-                    // 再给一点宽限；避免无休止等待
-                    WriteLog(logPath, "[STOP] Force stop watchdog reached 12s, giving up waiting (thread may still exit later)");
-                    break;
+            // 等待 VM 线程报告终态（由 qemu_main_loop 返回驱动，无需轮询 QMP）
+            if (!WaitVmStateFinal(vmName, std::chrono::seconds(5))) {
+                // 超时：强制退出
+                bool ok = sendQmpQuit(vmName);
+                WriteLog(logPath, std::string("[STOP] Timeout reached, sent QMP quit: ") + (ok ? "ok" : "failed"));
+                HilogPrint(std::string("QEMU: [STOP] Timeout, QMP quit sent: ") + (ok ? "ok" : "failed"));
+                if (!WaitVmStateFinal(vmName, std::chrono::seconds(7))) {
+                    std::shared_ptr<VmWorker> worker = FindVmWorker(vmName);
+                    if (worker) {
+                        // 工作进程可以直接结束，VM 线程随控制通道断开返回
+                        WriteLog(logPath, "[STOP] Force stop watchdog reached 12s, killing worker pid=" +
+                            std::to_string(worker->pid()));
+                        worker->Kill();
+                    } else {
+                        // 再给一点宽限；避免无休止等待
+                        WriteLog(logPath, "[STOP] Force stop watchdog reached 12s, giving up waiting (thread may still exit later)");
+                    }
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
             }
 
             if (vmThread.joinable()) {
@@ -3784,7 +4431,8 @@ static napi_value StopVm(napi_env env, napi_callback_info info) {
                     it->second->store(false);
                 }
             }
-            UpdateVMStatus(vmName, "stopped");
+            // 正常情况下 VM 线程已置为 stopped/failed；这里兜底（终态下不会重复通知）
+            SetVmState(vmName, VmState::Stopped, "stopVm");
             WriteLog(logPath, "[STOP] VM stopped (non-blocking stop handler done)");
         }).detach();
     }
@@ -3793,48 +4441,474 @@ static napi_value StopVm(napi_env env, napi_callback_info info) {
     return result;
 }
 
+// getVmRuntime(vmName): 运行中 VM 的运行方式与宿主端口 { vmName, mode, pid, ports: { rdp, ssh, http, https, vnc } }，未运行返回 null
+static napi_value GetVmRuntime(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_null(env, &out);
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName)) return out;
+    VmRuntime rt;
+    if (!vm_runtime_get(vmName, rt)) return out;
+
+    napi_value v;
+    napi_create_object(env, &out);
+    napi_create_string_utf8(env, rt.vm_name.c_str(), rt.vm_name.size(), &v);
+    napi_set_named_property(env, out, "vmName", v);
+    napi_create_string_utf8(env, rt.mode == VmRuntimeMode::Worker ? "worker" : "inprocess", NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, out, "mode", v);
+    napi_create_int32(env, rt.pid, &v);
+    napi_set_named_property(env, out, "pid", v);
+    napi_value ports;
+    napi_create_object(env, &ports);
+    const std::pair<const char*, int> items[] = {
+        { "rdp", rt.ports.rdp }, { "ssh", rt.ports.ssh }, { "http", rt.ports.http },
+        { "https", rt.ports.https }, { "vnc", rt.ports.vnc },
+    };
+    for (const auto& it : items) {
+        napi_create_int32(env, it.second, &v);
+        napi_set_named_property(env, ports, it.first, v);
+    }
+    napi_set_named_property(env, out, "ports", ports);
+    return out;
+}
+
 // ============================================================
-// 磁盘工具：qemu-img 创建/扩容（以及内置 QCOW2 创建兜底）
-// 仅允许在 VM 停止时使用（UI 层也应拦截，但 Native 侧再做一次保护）
+// 性能模式（tcg_profile）：规划预览、最近一次启动的规划、运行中基准测试
 // ============================================================
 
-static bool IsVmRunningLocked(const std::string& vmName) {
-    auto it = g_vmRunning.find(vmName);
-    if (it == g_vmRunning.end() || !it->second) return false;
-    return it->second->load();
+static void SetNamedInt64(napi_env env, napi_value obj, const char* key, int64_t value)
+{
+    napi_value v;
+    napi_create_int64(env, value, &v);
+    napi_set_named_property(env, obj, key, v);
 }
 
-// qemuImgCreateDisk(vmName: string, sizeGB: number, overwrite?: boolean): boolean
-static napi_value QemuImgCreateDisk(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value argv[3];
+static napi_value TcgTuningToJs(napi_env env, const TcgTuning& t)
+{
+    napi_value out;
+    napi_value v;
+    napi_create_object(env, &out);
+    napi_create_string_utf8(env, tcg_profile_name(t.profile), NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, out, "profile", v);
+    napi_create_string_utf8(env, t.accel.c_str(), t.accel.size(), &v);
+    napi_set_named_property(env, out, "accel", v);
+    napi_create_string_utf8(env, t.icount.c_str(), t.icount.size(), &v);
+    napi_set_named_property(env, out, "icount", v);
+    SetNamedInt64(env, out, "smp", t.smp);
+    SetNamedInt64(env, out, "memoryMB", t.memory_mb);
+    SetNamedInt64(env, out, "tbSizeMB", t.tb_size_mb);
+    napi_get_boolean(env, t.mttcg, &v);
+    napi_set_named_property(env, out, "mttcg", v);
+    napi_value list;
+    napi_create_array_with_length(env, t.rationale.size(), &list);
+    for (size_t i = 0; i < t.rationale.size(); i++) {
+        napi_create_string_utf8(env, t.rationale[i].c_str(), t.rationale[i].size(), &v);
+        napi_set_element(env, list, static_cast<uint32_t>(i), v);
+    }
+    napi_set_named_property(env, out, "rationale", list);
+    return out;
+}
+
+// planVmProfile(profile, cpuCount?, memoryMB?, accel?): 不启动 VM，返回该模式在本机上的规划与宿主能力
+static napi_value PlanVmProfile(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value argv[4];
     napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    TcgRequest req;
+    std::string profile;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], profile) || !tcg_profile_from_string(profile, req.profile)) {
+        napi_throw_error(env, nullptr, "profile must be powersaver / balanced / turbo");
+        return nullptr;
+    }
+    int32_t n = 0;
+    if (argc >= 2 && napi_get_value_int32(env, argv[1], &n) == napi_ok && n > 0) req.cpus = n;
+    if (argc >= 3 && napi_get_value_int32(env, argv[2], &n) == napi_ok && n > 0) req.memory_mb = std::max(512, n);
+    if (argc >= 4) NapiGetStringUtf8(env, argv[3], req.accel);
+
+    const TcgHostCaps caps = tcg_probe_host(qemu_has_jit_permission() != 0, kvmSupported());
+    napi_value out = TcgTuningToJs(env, tcg_profile_plan(req, caps));
+    napi_value host;
+    napi_value v;
+    napi_create_object(env, &host);
+    SetNamedInt64(env, host, "cpus", caps.cpus);
+    SetNamedInt64(env, host, "performanceCpus", static_cast<int64_t>(caps.big_cpus.size()));
+    SetNamedInt64(env, host, "efficiencyCpus", static_cast<int64_t>(caps.little_cpus.size()));
+    SetNamedInt64(env, host, "totalMemoryMB", caps.total_mem_mb);
+    SetNamedInt64(env, host, "availableMemoryMB", caps.avail_mem_mb);
+    napi_get_boolean(env, caps.jit, &v);
+    napi_set_named_property(env, host, "jit", v);
+    napi_get_boolean(env, caps.kvm, &v);
+    napi_set_named_property(env, host, "kvm", v);
+    napi_set_named_property(env, out, "host", host);
+    return out;
+}
 
+// getVmProfile(vmName): 最近一次启动采用的规划 + bootMs（尚未进入 running 为 -1）；从未启动返回 null
+static napi_value GetVmProfile(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
     napi_value out;
-    napi_get_boolean(env, false, &out);
-
-    if (argc < 2) return out;
+    napi_get_null(env, &out);
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName)) return out;
+    VmProfileRecord rec;
+    {
+        std::lock_guard<std::mutex> lk(g_vmProfilesMutex);
+        auto it = g_vmProfiles.find(vmName);
+        if (it == g_vmProfiles.end()) return out;
+        rec = it->second;
+    }
+    out = TcgTuningToJs(env, rec.tuning);
+    SetNamedInt64(env, out, "bootMs", rec.bootMs);
+    return out;
+}
 
+struct ProfileBenchWork {
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
     std::string vmName;
-    if (!NapiGetStringUtf8(env, argv[0], vmName) || vmName.empty()) return out;
+    int seconds = 10;
+    std::string error;
+    VmProfileRecord record;
+    int64_t elapsedMs = 0;
+    int64_t cpuMs = -1;
+    TcgJitStats jit0;
+    TcgJitStats jit1;
+};
 
-    int32_t sizeGB = 0;
-    napi_get_value_int32(env, argv[1], &sizeGB);
-    if (sizeGB <= 0) return out;
+static TcgJitStats SampleJitStats(const std::string& vmName)
+{
+    const QmpResult r = VmQmpClient(vmName)->execute_hmp("info jit", 3000);
+    return r.ok ? tcg_parse_jit_stats(r.value) : TcgJitStats{};
+}
 
-    bool overwrite = false;
-    if (argc >= 3) {
-        napi_get_value_bool(env, argv[2], &overwrite);
+static void ExecuteProfileBench(napi_env env, void* data)
+{
+    (void)env;
+    auto* w = static_cast<ProfileBenchWork*>(data);
+    VmRuntime rt;
+    if (!vm_runtime_get(w->vmName, rt) || GetVmStateRecord(w->vmName).state != VmState::Running) {
+        w->error = "VM is not running";
+        return;
     }
+    // 工作进程按其 pid 统计；进程内 VM 统计本进程（QEMU 线程占绝大部分）
+    const int32_t pid = rt.mode == VmRuntimeMode::Worker ? rt.pid : 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    const int64_t cpu0 = tcg_process_cpu_ms(pid);
+    w->jit0 = SampleJitStats(w->vmName);
+    std::this_thread::sleep_for(std::chrono::seconds(w->seconds));
+    w->jit1 = SampleJitStats(w->vmName);
+    const int64_t cpu1 = tcg_process_cpu_ms(pid);
+    w->elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    if (cpu0 >= 0 && cpu1 >= cpu0) w->cpuMs = cpu1 - cpu0;
+    std::lock_guard<std::mutex> lk(g_vmProfilesMutex);
+    auto it = g_vmProfiles.find(w->vmName);
+    if (it != g_vmProfiles.end()) w->record = it->second;
+}
 
-    std::lock_guard<std::mutex> lock(g_vmMutex);
-    if (IsVmRunningLocked(vmName)) {
-        HilogPrint("QEMU: [DISK] Refuse create disk while VM running: " + vmName);
-        return out;
+static void CompleteProfileBench(napi_env env, napi_status status, void* data)
+{
+    auto* w = static_cast<ProfileBenchWork*>(data);
+    if (status != napi_ok || !w->error.empty()) {
+        napi_value err;
+        const std::string text = w->error.empty() ? "benchmark failed" : w->error;
+        napi_create_string_utf8(env, text.c_str(), text.size(), &err);
+        napi_reject_deferred(env, w->deferred, err);
+    } else {
+        napi_value out = TcgTuningToJs(env, w->record.tuning);
+        napi_value v;
+        SetNamedInt64(env, out, "bootMs", w->record.bootMs);
+        SetNamedInt64(env, out, "elapsedMs", w->elapsedMs);
+        SetNamedInt64(env, out, "hostCpuMs", w->cpuMs);
+        // 100 = 占满一个宿主核心
+        napi_create_double(env, w->cpuMs >= 0 && w->elapsedMs > 0 ? w->cpuMs * 100.0 / w->elapsedMs : -1.0, &v);
+        napi_set_named_property(env, out, "hostCpuPercent", v);
+        const bool jit = w->jit0.valid && w->jit1.valid;
+        napi_get_boolean(env, jit, &v);
+        napi_set_named_property(env, out, "jitStats", v);
+        if (jit) {
+            SetNamedInt64(env, out, "tbCount", w->jit1.tb_count);
+            SetNamedInt64(env, out, "tbFlushes", w->jit1.tb_flushes - w->jit0.tb_flushes);
+            SetNamedInt64(env, out, "tbInvalidates", w->jit1.tb_invalidates - w->jit0.tb_invalidates);
+            SetNamedInt64(env, out, "codeUsedBytes", w->jit1.code_used);
+            SetNamedInt64(env, out, "codeTotalBytes", w->jit1.code_total);
+        }
+        napi_resolve_deferred(env, w->deferred, out);
     }
+    napi_delete_async_work(env, w->work);
+    delete w;
+}
 
-    const std::string vmDir = "/data/storage/el2/base/haps/entry/files/vms/" + vmName;
-    const std::string diskPath = vmDir + "/disk.qcow2";
+// benchmarkVmProfile(vmName, seconds?): 运行中采样 seconds 秒（默认 10，1~120），返回当前规划、启动耗时、
+// 宿主 CPU 占用与翻译缓存计数（flush 次数多说明 tb-size 偏小）
+static napi_value BenchmarkVmProfile(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    auto* w = new ProfileBenchWork();
+    napi_value promise;
+    napi_create_promise(env, &w->deferred, &promise);
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], w->vmName)) {
+        w->error = "Missing parameter: vmName";
+    }
+    int32_t seconds = 0;
+    if (argc >= 2 && napi_get_value_int32(env, argv[1], &seconds) == napi_ok && seconds > 0) {
+        w->seconds = std::min(seconds, 120);
+    }
+    napi_value name;
+    napi_create_string_utf8(env, "BenchmarkVmProfile", NAPI_AUTO_LENGTH, &name);
+    napi_create_async_work(env, nullptr, name, [](napi_env e, void* d) {
+        auto* bw = static_cast<ProfileBenchWork*>(d);
+        if (bw->error.empty()) ExecuteProfileBench(e, d);
+    }, CompleteProfileBench, w, &w->work);
+    napi_queue_async_work(env, w->work);
+    return promise;
+}
+
+// ============================================================
+// 线程绑核（vm_sched）：vCPU 线程在性能核，I/O / 渲染 / 音频线程在其余核心
+// ============================================================
+
+static napi_value CpuListToJs(napi_env env, const std::vector<int>& cpus)
+{
+    napi_value arr;
+    napi_create_array_with_length(env, cpus.size(), &arr);
+    for (size_t i = 0; i < cpus.size(); i++) {
+        napi_value v;
+        napi_create_int32(env, cpus[i], &v);
+        napi_set_element(env, arr, static_cast<uint32_t>(i), v);
+    }
+    return arr;
+}
+
+// getThreadStats(vmName): { pinning, performanceCpus, efficiencyCpus, threads: [{ tid, name, role, vm, cpuMs, lastCpu, affinity }] }
+static napi_value GetThreadStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    std::string vmName;
+    if (argc >= 1) NapiGetStringUtf8(env, argv[0], vmName);
+
+    // 工作进程中的 VM 读取该进程的线程；进程内 VM 读取本进程
+    int32_t pid = 0;
+    VmRuntime rt;
+    if (!vmName.empty() && vm_runtime_get(vmName, rt) && rt.mode == VmRuntimeMode::Worker) pid = rt.pid;
+    const std::vector<SchedThreadStat> stats = sched_thread_stats(pid, vmName);
+
+    const SchedTopology& topo = sched_topology();
+    napi_value out;
+    napi_value v;
+    napi_create_object(env, &out);
+    napi_get_boolean(env, sched_enabled(), &v);
+    napi_set_named_property(env, out, "pinning", v);
+    napi_set_named_property(env, out, "performanceCpus", CpuListToJs(env, topo.performance));
+    napi_set_named_property(env, out, "efficiencyCpus", CpuListToJs(env, topo.efficiency));
+
+    napi_value threads;
+    napi_create_array_with_length(env, stats.size(), &threads);
+    for (size_t i = 0; i < stats.size(); i++) {
+        const SchedThreadStat& st = stats[i];
+        napi_value t;
+        napi_create_object(env, &t);
+        napi_create_int32(env, st.tid, &v);
+        napi_set_named_property(env, t, "tid", v);
+        napi_create_string_utf8(env, st.name.c_str(), st.name.size(), &v);
+        napi_set_named_property(env, t, "name", v);
+        napi_create_string_utf8(env, st.role.c_str(), st.role.size(), &v);
+        napi_set_named_property(env, t, "role", v);
+        napi_create_string_utf8(env, st.vm.c_str(), st.vm.size(), &v);
+        napi_set_named_property(env, t, "vm", v);
+        SetNamedInt64(env, t, "cpuMs", st.cpu_ms);
+        napi_create_int32(env, st.last_cpu, &v);
+        napi_set_named_property(env, t, "lastCpu", v);
+        napi_set_named_property(env, t, "affinity", CpuListToJs(env, st.affinity));
+        napi_set_element(env, threads, static_cast<uint32_t>(i), t);
+    }
+    napi_set_named_property(env, out, "threads", threads);
+    return out;
+}
+
+// setCpuPinning(enabled): 开关线程绑核，并对运行中的 VM 立即生效；返回处理的 vCPU 线程数
+static napi_value SetCpuPinning(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    bool enabled = true;
+    if (argc >= 1) napi_get_value_bool(env, argv[0], &enabled);
+
+    sched_set_enabled(enabled);
+    int vcpus = 0;
+    for (const VmRuntime& rt : vm_runtime_list()) {
+        const int32_t pid = rt.mode == VmRuntimeMode::Worker ? rt.pid : 0;
+        if (rt.mode == VmRuntimeMode::Worker && pid <= 0) continue;
+        vcpus += sched_apply_qemu_threads(pid, VmProfileIsPowerSaver(rt.vm_name));
+    }
+    HilogPrint("QEMU: [SCHED] pinning " + std::string(enabled ? "on" : "off") + ", " + std::to_string(vcpus) +
+               " vCPU thread(s) updated");
+    napi_value out;
+    napi_create_int32(env, vcpus, &out);
+    return out;
+}
+
+// getHotspots(vmName, top?, reset?): 热点分析插件（VM 以 profiler: true 启动）的报告；未加载插件返回 null
+// { tbs, execs, insns, helperInsns, memAccesses, mmioAccesses, helperRate, mmioRate,
+//   hotspots: [{ pc, exec, insns, helperInsns, mem, mmio, share, disas }] }，按执行的来宾指令数降序
+static napi_value GetHotspots(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value result;
+    napi_get_null(env, &result);
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName) || vmName.empty()) return result;
+    int32_t top = 20;
+    if (argc >= 2) napi_get_value_int32(env, argv[1], &top);
+    top = std::max(0, std::min<int32_t>(top, AETHER_HOTSPOT_MAX_TOP));
+    bool reset = false;
+    if (argc >= 3) napi_get_value_bool(env, argv[2], &reset);
+
+    AetherHotspotTotals totals {};
+    std::vector<AetherHotspot> spots;
+    VmRuntime rt;
+    if (!vm_runtime_get(vmName, rt)) return result;
+    if (rt.mode == VmRuntimeMode::Worker) {
+        std::shared_ptr<VmWorker> worker = FindVmWorker(vmName);
+        if (!worker || !worker->QueryHotspots(static_cast<uint32_t>(top), reset, 1000, totals, spots)) return result;
+    } else {
+        // 进程内 VM：插件由 qemu_init 加载在本进程，NOLOAD 不会新加载
+        const std::string path = HotspotPluginPath();
+        void* plugin = path.empty() ? nullptr : dlopen(path.c_str(), RTLD_NOW | RTLD_NOLOAD);
+        if (!plugin) return result;
+        auto report = reinterpret_cast<aether_hotspot_report_fn>(dlsym(plugin, AETHER_HOTSPOT_REPORT_SYMBOL));
+        spots.resize(static_cast<size_t>(top));
+        const size_t n = report ? report(AETHER_HOTSPOT_ABI_VERSION, &totals, spots.data(), spots.size(), reset ? 1 : 0) : 0;
+        dlclose(plugin);
+        if (!report) return result;
+        spots.resize(n);
+    }
+
+    napi_value v;
+    napi_create_object(env, &result);
+    SetNamedInt64(env, result, "tbs", static_cast<int64_t>(totals.tbs));
+    SetNamedInt64(env, result, "execs", static_cast<int64_t>(totals.exec));
+    SetNamedInt64(env, result, "insns", static_cast<int64_t>(totals.insns));
+    SetNamedInt64(env, result, "helperInsns", static_cast<int64_t>(totals.helper_insns));
+    SetNamedInt64(env, result, "memAccesses", static_cast<int64_t>(totals.mem));
+    SetNamedInt64(env, result, "mmioAccesses", static_cast<int64_t>(totals.mmio));
+    napi_create_double(env, totals.insns ? static_cast<double>(totals.helper_insns) / totals.insns : 0.0, &v);
+    napi_set_named_property(env, result, "helperRate", v);
+    napi_create_double(env, totals.mem ? static_cast<double>(totals.mmio) / totals.mem : 0.0, &v);
+    napi_set_named_property(env, result, "mmioRate", v);
+
+    napi_value arr;
+    napi_create_array_with_length(env, spots.size(), &arr);
+    for (size_t i = 0; i < spots.size(); i++) {
+        const AetherHotspot& h = spots[i];
+        napi_value o;
+        napi_create_object(env, &o);
+        // 64 位来宾地址超出 JS number 精度，以十六进制字符串给出
+        char pc[24];
+        snprintf(pc, sizeof(pc), "0x%" PRIx64, h.pc);
+        napi_create_string_utf8(env, pc, NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, o, "pc", v);
+        SetNamedInt64(env, o, "exec", static_cast<int64_t>(h.exec));
+        SetNamedInt64(env, o, "insns", h.insns);
+        SetNamedInt64(env, o, "helperInsns", h.helper_insns);
+        SetNamedInt64(env, o, "mem", static_cast<int64_t>(h.mem));
+        SetNamedInt64(env, o, "mmio", static_cast<int64_t>(h.mmio));
+        napi_create_double(env, totals.insns ? static_cast<double>(h.exec) * h.insns / totals.insns : 0.0, &v);
+        napi_set_named_property(env, o, "share", v);
+        napi_create_string_utf8(env, h.disas, strnlen(h.disas, sizeof(h.disas)), &v);
+        napi_set_named_property(env, o, "disas", v);
+        napi_set_element(env, arr, static_cast<uint32_t>(i), o);
+    }
+    napi_set_named_property(env, result, "hotspots", arr);
+    return result;
+}
+
+// getAudioStats(vmName): OHAudio 后端的 xrun 计数（补丁 0002）；VM 未运行或 core 不带该接口返回 null
+// { outUnderruns, outOverruns, inOverruns, inUnderruns, outBytes, inBytes, outRingBytes, inRingBytes }
+static napi_value GetAudioStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value result;
+    napi_get_null(env, &result);
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName) || vmName.empty()) return result;
+
+    worker_proto::AudioStats st {};
+    VmRuntime rt;
+    if (!vm_runtime_get(vmName, rt)) return result;
+    if (rt.mode == VmRuntimeMode::Worker) {
+        std::shared_ptr<VmWorker> worker = FindVmWorker(vmName);
+        if (!worker || !worker->QueryAudioStats(1000, st)) return result;
+    } else {
+        using get_stats_fn = int (*)(worker_proto::AudioStats* out, uint32_t version);
+        auto get = g_qemu_core_handle
+                       ? reinterpret_cast<get_stats_fn>(dlsym(g_qemu_core_handle, "qemu_hmos_audio_get_stats"))
+                       : nullptr;
+        if (!get || get(&st, worker_proto::kAudioStatsVersion) != 0) return result;
+    }
+
+    napi_create_object(env, &result);
+    SetNamedInt64(env, result, "outUnderruns", static_cast<int64_t>(st.out_underruns));
+    SetNamedInt64(env, result, "outOverruns", static_cast<int64_t>(st.out_overruns));
+    SetNamedInt64(env, result, "inOverruns", static_cast<int64_t>(st.in_overruns));
+    SetNamedInt64(env, result, "inUnderruns", static_cast<int64_t>(st.in_underruns));
+    SetNamedInt64(env, result, "outBytes", static_cast<int64_t>(st.out_bytes));
+    SetNamedInt64(env, result, "inBytes", static_cast<int64_t>(st.in_bytes));
+    SetNamedInt64(env, result, "outRingBytes", st.out_ring_bytes);
+    SetNamedInt64(env, result, "inRingBytes", st.in_ring_bytes);
+    return result;
+}
+
+// ============================================================
+// 磁盘工具：qemu-img 创建/扩容（以及内置 QCOW2 创建兜底）
+// 仅允许在 VM 停止时使用（UI 层也应拦截，但 Native 侧再做一次保护）
+// ============================================================
+
+static bool IsVmRunningLocked(const std::string& vmName) {
+    auto it = g_vmRunning.find(vmName);
+    if (it == g_vmRunning.end() || !it->second) return false;
+    return it->second->load();
+}
+
+// qemuImgCreateDisk(vmName: string, sizeGB: number, overwrite?: boolean): boolean
+static napi_value QemuImgCreateDisk(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+
+    if (argc < 2) return out;
+
+    std::string vmName;
+    if (!NapiGetStringUtf8(env, argv[0], vmName) || vmName.empty()) return out;
+
+    int32_t sizeGB = 0;
+    napi_get_value_int32(env, argv[1], &sizeGB);
+    if (sizeGB <= 0) return out;
+
+    bool overwrite = false;
+    if (argc >= 3) {
+        napi_get_value_bool(env, argv[2], &overwrite);
+    }
+
+    std::lock_guard<std::mutex> lock(g_vmMutex);
+    if (IsVmRunningLocked(vmName)) {
+        HilogPrint("QEMU: [DISK] Refuse create disk while VM running: " + vmName);
+        return out;
+    }
+
+    const std::string vmDir = "/data/storage/el2/base/haps/entry/files/vms/" + vmName;
+    const std::string diskPath = vmDir + "/disk.qcow2";
 
     if (!overwrite && FileExists(diskPath)) {
         HilogPrint("QEMU: [DISK] disk already exists, overwrite=false: " + diskPath);
@@ -3952,113 +5026,191 @@ static napi_value GetVmLogs(napi_env env, napi_callback_info info) {
     napi_value result;
     napi_create_array(env, &result);
     
-    // 获取日志缓冲区
-    if (g_vmLogBuffers.find(vmName) != g_vmLogBuffers.end()) {
-        std::lock_guard<std::mutex> lock(g_vmLogMutexes[vmName]);
-        const auto& buffer = g_vmLogBuffers[vmName];
-        
-        // 确保起始行数有效
-        size_t start = std::max(0, std::min(startLine, (int32_t)buffer.size()));
-        
-        for (size_t i = start; i < buffer.size(); i++) {
-            napi_value logEntry;
-            napi_create_string_utf8(env, buffer[i].c_str(), NAPI_AUTO_LENGTH, &logEntry);
-            napi_set_element(env, result, i - start, logEntry);
-        }
-    }
+    // 兼容旧接口：最近 MAX_LOG_BUFFER_SIZE 行，startLine 是其中的下标
+    uint64_t first = 0;
+    uint64_t next = 0;
+    log_store_bounds(vmName, first, next);
+    const uint64_t base = std::max(first, next > MAX_LOG_BUFFER_SIZE ? next - MAX_LOG_BUFFER_SIZE : 0);
+    const uint64_t start = base + static_cast<uint64_t>(std::max<int32_t>(0, startLine));
+    uint32_t index = 0;
+    log_store_visit(vmName, start, MAX_LOG_BUFFER_SIZE, [&](uint64_t, std::string_view line) {
+        napi_value logEntry;
+        napi_create_string_utf8(env, line.data(), line.size(), &logEntry);
+        napi_set_element(env, result, index++, logEntry);
+    });
     
     return result;
 }
 
-// 通过 QMP Unix socket 查询 VM 真实状态
-static std::string QueryVmStatusViaQmp(const std::string& vmName) {
-    std::string socketPath = "/data/storage/el2/base/haps/entry/files/vms/" + vmName + "/qmp.sock";
-    
-    // 创建 Unix socket
-    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sock < 0) {
-        HilogPrint("QMP: Failed to create socket");
-        return "unknown";
-    }
-    
-    // 设置非阻塞超时
-    struct timeval tv;
-    tv.tv_sec = 2;
-    tv.tv_usec = 0;
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-    
-    // 连接到 QMP socket
-    struct sockaddr_un addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
-    
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(sock);
-        HilogPrint("QMP: Failed to connect to " + socketPath);
-        return "stopped";  // 无法连接说明 VM 未运行
+static napi_value VmLogReadToJs(napi_env env, const std::string& vmName, const LogStoreRead& r)
+{
+    napi_value obj;
+    napi_value v;
+    napi_create_object(env, &obj);
+    napi_create_string_utf8(env, vmName.c_str(), NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, obj, "vmName", v);
+    napi_create_string_utf8(env, r.text.data(), r.text.size(), &v);
+    napi_set_named_property(env, obj, "text", v);
+    napi_create_int64(env, static_cast<int64_t>(r.first_seq), &v);
+    napi_set_named_property(env, obj, "firstSeq", v);
+    napi_create_int64(env, static_cast<int64_t>(r.next_seq), &v);
+    napi_set_named_property(env, obj, "nextSeq", v);
+    napi_create_uint32(env, r.lines, &v);
+    napi_set_named_property(env, obj, "lines", v);
+    napi_get_boolean(env, r.gap, &v);
+    napi_set_named_property(env, obj, "gap", v);
+    napi_get_boolean(env, r.more, &v);
+    napi_set_named_property(env, obj, "more", v);
+    return obj;
+}
+
+// getVmLogsSince(vmName, seq, maxBytes?): 只返回序号 >= seq 的新行，拼成一个字符串
+// 返回的 nextSeq 作为下次的 seq；gap 表示中间有行已被环形存储覆盖
+static napi_value GetVmLogsSince(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName)) {
+        napi_throw_error(env, nullptr, "Missing VM name parameter");
+        return nullptr;
     }
-    
-    // 读取 QMP greeting
-    char buffer[4096];
-    ssize_t n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    if (n <= 0) {
-        close(sock);
-        return "unknown";
+    int64_t seq = 0;
+    if (argc >= 2) napi_get_value_int64(env, argv[1], &seq);
+    int64_t maxBytes = 256 * 1024;
+    if (argc >= 3) napi_get_value_int64(env, argv[2], &maxBytes);
+
+    const LogStoreRead r = log_store_read(vmName, static_cast<uint64_t>(std::max<int64_t>(0, seq)),
+                                          static_cast<size_t>(std::max<int64_t>(1, maxBytes)));
+    return VmLogReadToJs(env, vmName, r);
+}
+
+static void VmLogPushJs(napi_env env, napi_value js_cb, void* context, void* data)
+{
+    (void)data;
+    VmLogSubscriber* sub = static_cast<VmLogSubscriber*>(context);
+    if (!env || !js_cb || !sub) return;
+    // 先清标记再读取：读取之后到达的行会重新唤起
+    sub->scheduled.store(false);
+    const LogStoreRead r = log_store_read(sub->vmName, sub->nextSeq, VM_LOG_PUSH_MAX_BYTES);
+    sub->nextSeq = r.next_seq;
+    if (r.more && !sub->scheduled.exchange(true)) {
+        napi_call_threadsafe_function(sub->tsfn, nullptr, napi_tsfn_nonblocking);
+    }
+    if (r.lines == 0 && !r.gap) return;
+    napi_value obj = VmLogReadToJs(env, sub->vmName, r);
+    napi_value undefined;
+    napi_get_undefined(env, &undefined);
+    napi_call_function(env, undefined, js_cb, 1, &obj, nullptr);
+}
+
+static void VmLogSubscriberFinalize(napi_env env, void* finalize_data, void* finalize_hint)
+{
+    (void)env;
+    (void)finalize_hint;
+    delete static_cast<VmLogSubscriber*>(finalize_data);
+}
+
+static void RemoveVmLogSubscriber(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lock(g_vmLogSubscriberMutex);
+    auto it = g_vmLogSubscribers.find(vmName);
+    if (it == g_vmLogSubscribers.end()) return;
+    napi_release_threadsafe_function(it->second->tsfn, napi_tsfn_abort);
+    g_vmLogSubscribers.erase(it);
+}
+
+// setVmLogCallback(vmName, callback, sinceSeq?): 实时推送新行（多行合并为一次回调），每个 VM 一个回调
+// 不传 sinceSeq 时从当前位置开始，只推送之后的新行
+static napi_value SetVmLogCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+
+    std::string vmName;
+    if (argc < 2 || !NapiGetStringUtf8(env, argv[0], vmName)) return out;
+    napi_valuetype type = napi_undefined;
+    napi_typeof(env, argv[1], &type);
+    if (type != napi_function) return out;
+
+    auto* sub = new VmLogSubscriber();
+    sub->vmName = vmName;
+    uint64_t first = 0;
+    uint64_t next = 0;
+    log_store_bounds(vmName, first, next);
+    sub->nextSeq = next;
+    int64_t since = -1;
+    if (argc >= 3 && napi_get_value_int64(env, argv[2], &since) == napi_ok && since >= 0) {
+        sub->nextSeq = std::min(sub->nextSeq, static_cast<uint64_t>(since));
     }
-    buffer[n] = '\0';
-    
-    // 发送 qmp_capabilities 命令进入命令模式
-    const char* capCmd = "{\"execute\": \"qmp_capabilities\"}\n";
-    if (send(sock, capCmd, strlen(capCmd), 0) <= 0) {
-        close(sock);
-        return "unknown";
+
+    napi_value resourceName;
+    napi_create_string_utf8(env, "VmLogCallback", NAPI_AUTO_LENGTH, &resourceName);
+    if (napi_create_threadsafe_function(env, argv[1], nullptr, resourceName, 0, 1, sub, VmLogSubscriberFinalize,
+                                        sub, VmLogPushJs, &sub->tsfn) != napi_ok) {
+        delete sub;
+        return out;
     }
-    
-    // 读取响应
-    n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    if (n <= 0) {
-        close(sock);
-        return "unknown";
+    RemoveVmLogSubscriber(vmName);
+    {
+        std::lock_guard<std::mutex> lock(g_vmLogSubscriberMutex);
+        g_vmLogSubscribers[vmName] = sub;
+        // 指定了更早的起点：立即推送一次已有的行
+        if (sub->nextSeq < next) {
+            sub->scheduled.store(true);
+            napi_call_threadsafe_function(sub->tsfn, nullptr, napi_tsfn_nonblocking);
+        }
     }
-    buffer[n] = '\0';
-    
-    // 发送 query-status 命令
-    const char* statusCmd = "{\"execute\": \"query-status\"}\n";
-    if (send(sock, statusCmd, strlen(statusCmd), 0) <= 0) {
-        close(sock);
-        return "unknown";
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
+static napi_value ClearVmLogCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    std::string vmName;
+    if (argc >= 1 && NapiGetStringUtf8(env, argv[0], vmName)) {
+        RemoveVmLogSubscriber(vmName);
     }
-    
-    // 读取状态响应
-    n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    close(sock);
-    
-    if (n <= 0) {
-        return "unknown";
+    napi_value out;
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
+// 通过 QMP 查询 VM 真实状态：仅在事件流建立时做一次校准（错过的事件、-S/-incoming 启动时的 paused）
+static std::string QueryVmStatusViaQmp(const std::string& vmName) {
+    QmpResult r = VmQmpClient(vmName)->execute("query-status", "", 2000);
+    if (!r.ok) {
+        // 无法连接说明 VM 未运行；连接上但超时/出错则状态未知
+        return r.error_class == "Disconnected" ? "stopped" : "unknown";
     }
-    buffer[n] = '\0';
-    
-    std::string response(buffer);
-    HilogPrint("QMP: Status response: " + response);
     
-    // 简单解析 JSON 响应
     // 响应格式: {"return": {"running": true, "status": "running", ...}}
-    if (response.find("\"running\": true") != std::string::npos || 
-        response.find("\"running\":true") != std::string::npos) {
-        return "running";
-    } else if (response.find("\"status\": \"paused\"") != std::string::npos ||
-               response.find("\"status\":\"paused\"") != std::string::npos) {
-        return "paused";
-    } else if (response.find("\"status\": \"shutdown\"") != std::string::npos ||
-               response.find("\"status\":\"shutdown\"") != std::string::npos) {
-        return "shutdown";
-    } else if (response.find("\"status\": \"prelaunch\"") != std::string::npos) {
-        return "starting";
+    std::string status = "stopped";
+    cJSON* ret = cJSON_Parse(r.value.c_str());
+    if (ret) {
+        const cJSON* running = cJSON_GetObjectItemCaseSensitive(ret, "running");
+        const cJSON* st = cJSON_GetObjectItemCaseSensitive(ret, "status");
+        const std::string s = cJSON_IsString(st) ? st->valuestring : "";
+        if (cJSON_IsTrue(running)) {
+            status = "running";
+        } else if (s == "paused") {
+            status = "paused";
+        } else if (s == "shutdown") {
+            status = "shutdown";
+        } else if (s == "prelaunch") {
+            status = "starting";
+        } else if (s == "inmigrate" || s == "restore-vm" || s == "postmigrate") {
+            // 快照恢复中 / 快照保存后：来宾未运行
+            status = "paused";
+        }
+        cJSON_Delete(ret);
     }
-    
-    return "stopped";
+    return status;
 }
 
 static napi_value GetVmStatus(napi_env env, napi_callback_info info) {
@@ -4078,148 +5230,781 @@ static napi_value GetVmStatus(napi_env env, napi_callback_info info) {
         return nullptr;
     }
     
-    std::string status = "stopped";
-    
-    // 加锁访问 g_vmRunning，避免数据竞争
-    {
-        std::lock_guard<std::mutex> lock(g_vmMutex);
-        // 首先检查本地运行状态标志
-        auto it = g_vmRunning.find(vmName);
-        if (it != g_vmRunning.end() && it->second && it->second->load()) {
-            // VM 线程在运行，尝试通过 QMP 获取真实状态
-            status = QueryVmStatusViaQmp(vmName);
-            
-            // 如果 QMP 查询失败但线程还在运行，返回 running
-            if (status == "stopped" || status == "unknown") {
-                status = "running";
-            }
-        }
-    }
+    // 状态机由事件驱动，这里只读内存，不产生任何 socket 流量
+    const VmStateRecord rec = GetVmStateRecord(vmName);
 
     napi_value result;
-    napi_create_string_utf8(env, status.c_str(), NAPI_AUTO_LENGTH, &result);
+    napi_create_string_utf8(env, VmStateName(rec.state), NAPI_AUTO_LENGTH, &result);
     return result;
 }
 
+// getVmState(vmName): { state, since, reason }
+static napi_value GetVmState(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName)) {
+        napi_throw_error(env, nullptr, "Missing VM name parameter");
+        return nullptr;
+    }
+
+    const VmStateRecord rec = GetVmStateRecord(vmName);
+    napi_value obj;
+    napi_value v;
+    napi_create_object(env, &obj);
+    napi_create_string_utf8(env, VmStateName(rec.state), NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, obj, "state", v);
+    napi_create_int64(env, rec.sinceMs, &v);
+    napi_set_named_property(env, obj, "since", v);
+    napi_create_string_utf8(env, rec.reason.c_str(), NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, obj, "reason", v);
+    return obj;
+}
+
+static void VmStateJsCallback(napi_env env, napi_value js_cb, void* context, void* data)
+{
+    (void)context;
+    VmStateChange* change = static_cast<VmStateChange*>(data);
+    if (!change) return;
+    if (env && js_cb) {
+        napi_value obj;
+        napi_value v;
+        napi_create_object(env, &obj);
+        napi_create_string_utf8(env, change->vmName.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "vmName", v);
+        napi_create_string_utf8(env, VmStateName(change->state), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "state", v);
+        napi_create_string_utf8(env, VmStateName(change->previous), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "previous", v);
+        napi_create_string_utf8(env, change->reason.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "reason", v);
+        napi_create_int64(env, change->timestampMs, &v);
+        napi_set_named_property(env, obj, "timestamp", v);
+        napi_value undefined;
+        napi_get_undefined(env, &undefined);
+        napi_call_function(env, undefined, js_cb, 1, &obj, nullptr);
+    }
+    delete change;
+}
+
+// setVmStateCallback(callback): 全局一个回调，重复调用替换旧回调
+static napi_value SetVmStateCallback(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+    if (argc < 1) return out;
+
+    napi_valuetype type = napi_undefined;
+    napi_typeof(env, argv[0], &type);
+    if (type != napi_function) return out;
+
+    napi_value resourceName;
+    napi_create_string_utf8(env, "VmStateCallback", NAPI_AUTO_LENGTH, &resourceName);
+    napi_threadsafe_function tsfn = nullptr;
+    if (napi_create_threadsafe_function(env, argv[0], nullptr, resourceName, 0, 1, nullptr, nullptr, nullptr,
+                                        VmStateJsCallback, &tsfn) != napi_ok) {
+        return out;
+    }
+    {
+        std::lock_guard<std::mutex> lk(g_vm_state_mutex);
+        if (g_vm_state_tsfn) napi_release_threadsafe_function(g_vm_state_tsfn, napi_tsfn_abort);
+        g_vm_state_tsfn = tsfn;
+    }
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
+static napi_value ClearVmStateCallback(napi_env env, napi_callback_info info) {
+    (void)info;
+    {
+        std::lock_guard<std::mutex> lk(g_vm_state_mutex);
+        if (g_vm_state_tsfn) {
+            napi_release_threadsafe_function(g_vm_state_tsfn, napi_tsfn_abort);
+            g_vm_state_tsfn = nullptr;
+        }
+    }
+    napi_value out;
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
 // ============================================================
 // QMP screendump - 通过 QMP 获取屏幕截图
 // 由于 VNC 后端崩溃，使用 -display none + virtio-gpu + screendump 作为替代方案
 // ============================================================
 
 static bool TakeScreenshotViaQmp(const std::string& vmName, const std::string& outputPath) {
-    std::string socketPath = "/data/storage/el2/base/haps/entry/files/vms/" + vmName + "/qmp.sock";
-    
     HilogPrint("QMP: Taking screenshot for VM: " + vmName);
     HilogPrint("QMP: Output path: " + outputPath);
     
-    // 创建 Unix socket
-    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sock < 0) {
-        HilogPrint("QMP screendump: Failed to create socket");
-        return false;
-    }
-    
-    // 设置超时
-    struct timeval tv;
-    tv.tv_sec = 5;
-    tv.tv_usec = 0;
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-    
-    // 连接到 QMP socket
-    struct sockaddr_un addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
-    
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(sock);
-        HilogPrint("QMP screendump: Failed to connect to socket");
-        return false;
+    // 格式: {"execute": "screendump", "arguments": {"filename": "/path/to/file.ppm"}}
+    QmpResult r = VmQmpClient(vmName)->execute("screendump",
+        "{\"filename\": " + qmp_json_quote(outputPath) + "}", 5000);
+    if (r.ok) {
+        HilogPrint("QMP screendump: Success");
+        return true;
     }
     
-    char buffer[4096];
-    ssize_t n;
-    
-    // 读取 QMP greeting
-    n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    if (n <= 0) {
-        close(sock);
-        HilogPrint("QMP screendump: Failed to read greeting");
-        return false;
-    }
-    buffer[n] = '\0';
-    HilogPrint(std::string("QMP greeting: ") + buffer);
+    HilogPrint("QMP screendump: Failed - " + r.response);
+    return false;
+}
+
+static napi_value TakeScreenshot(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
     
-    // 发送 qmp_capabilities
-    const char* capCmd = "{\"execute\": \"qmp_capabilities\"}\n";
-    if (send(sock, capCmd, strlen(capCmd), 0) <= 0) {
-        close(sock);
-        HilogPrint("QMP screendump: Failed to send qmp_capabilities");
-        return false;
+    if (argc < 2) {
+        napi_throw_error(env, nullptr, "Missing parameters: vmName, outputPath");
+        return nullptr;
     }
     
-    n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    if (n <= 0) {
-        close(sock);
-        HilogPrint("QMP screendump: Failed to read capabilities response");
-        return false;
+    std::string vmName, outputPath;
+    if (!NapiGetStringUtf8(env, argv[0], vmName) || !NapiGetStringUtf8(env, argv[1], outputPath)) {
+        napi_throw_error(env, nullptr, "Failed to get string parameters");
+        return nullptr;
     }
-    buffer[n] = '\0';
-    HilogPrint(std::string("QMP capabilities response: ") + buffer);
     
-    // 发送 screendump 命令
-    // 格式: {"execute": "screendump", "arguments": {"filename": "/path/to/file.ppm"}}
-    std::string screendumpCmd = "{\"execute\": \"screendump\", \"arguments\": {\"filename\": \"" + outputPath + "\"}}\n";
-    HilogPrint("QMP screendump command: " + screendumpCmd);
+    bool success = TakeScreenshotViaQmp(vmName, outputPath);
     
-    if (send(sock, screendumpCmd.c_str(), screendumpCmd.length(), 0) <= 0) {
-        close(sock);
-        HilogPrint("QMP screendump: Failed to send screendump command");
-        return false;
+    napi_value result;
+    napi_get_boolean(env, success, &result);
+    return result;
+}
+
+// ============================================================
+// QMP 长连接：异步命令 + 事件推送（替代 ArkTS 侧轮询 getVmStatus）
+// ============================================================
+
+struct QmpJsEvent {
+    std::string vmName;
+    QmpEvent event;
+};
+
+struct QmpEventSubscription {
+    napi_threadsafe_function tsfn = nullptr;
+    std::shared_ptr<QmpClient> client;
+    uint64_t subId = 0;
+    std::vector<std::string> filter; // 为空表示全部事件；以 '*' 结尾表示前缀匹配（如 BLOCK_JOB_*）
+};
+
+static std::mutex g_qmp_event_mutex;
+static std::map<std::string, QmpEventSubscription> g_qmp_event_subs;
+
+static bool QmpEventMatches(const std::vector<std::string>& filter, const std::string& name)
+{
+    if (filter.empty() || name == "QMP_DISCONNECTED") return true;
+    for (const auto& f : filter) {
+        if (!f.empty() && f.back() == '*') {
+            if (name.compare(0, f.size() - 1, f, 0, f.size() - 1) == 0) return true;
+        } else if (f == name) {
+            return true;
+        }
     }
-    
-    // 等待响应
-    n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    close(sock);
-    
-    if (n <= 0) {
-        HilogPrint("QMP screendump: No response");
-        return false;
+    return false;
+}
+
+static void QmpEventJsCallback(napi_env env, napi_value js_cb, void* context, void* data)
+{
+    (void)context;
+    QmpJsEvent* ev = static_cast<QmpJsEvent*>(data);
+    if (!ev) return;
+    if (env && js_cb) {
+        napi_value obj;
+        napi_create_object(env, &obj);
+        napi_value v;
+        napi_create_string_utf8(env, ev->vmName.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "vmName", v);
+        napi_create_string_utf8(env, ev->event.name.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "event", v);
+        napi_create_string_utf8(env, ev->event.data.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "data", v);
+        napi_create_int64(env, ev->event.seconds, &v);
+        napi_set_named_property(env, obj, "seconds", v);
+        napi_create_int64(env, ev->event.microseconds, &v);
+        napi_set_named_property(env, obj, "microseconds", v);
+        napi_value undefined;
+        napi_get_undefined(env, &undefined);
+        napi_call_function(env, undefined, js_cb, 1, &obj, nullptr);
+    }
+    delete ev;
+}
+
+// 需持有 g_qmp_event_mutex
+static void QmpEventUnsubscribeLocked(const std::string& vmName)
+{
+    auto it = g_qmp_event_subs.find(vmName);
+    if (it == g_qmp_event_subs.end()) return;
+    if (it->second.client) it->second.client->unsubscribe(it->second.subId);
+    if (it->second.tsfn) napi_release_threadsafe_function(it->second.tsfn, napi_tsfn_abort);
+    g_qmp_event_subs.erase(it);
+}
+
+// VM 启动后 QMP socket 才出现：在后台建连，让事件无需等到第一次命令调用就开始推送。
+// 建连成功后用一次 query-status 校准状态机（之后全靠事件，不再轮询）
+static void QmpEventConnectWhenReady(const std::string& vmName)
+{
+    std::thread([vmName]() {
+        std::shared_ptr<QmpClient> client = VmQmpClient(vmName);
+        for (int i = 0; i < 100; i++) {
+            {
+                std::lock_guard<std::mutex> lk(g_vmMutex);
+                auto it = g_vmRunning.find(vmName);
+                if (it == g_vmRunning.end() || !it->second || !it->second->load()) return;
+            }
+            if (client->ensure_connected(1000)) {
+                HilogPrint("QMP: event stream connected for VM " + vmName);
+                const std::string st = QueryVmStatusViaQmp(vmName);
+                if (st == "paused") {
+                    SetVmState(vmName, VmState::Paused, "query-status");
+                } else if (st == "running") {
+                    SetVmState(vmName, VmState::Running, "query-status");
+                }
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+    }).detach();
+}
+
+// qmpSubscribeEvents(vmName, callback, events?: string[]): 每个 VM 一个订阅，重复调用会替换旧回调
+static napi_value QmpSubscribeEvents(napi_env env, napi_callback_info info)
+{
+    size_t argc = 3;
+    napi_value argv[3];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+    if (argc < 2) return out;
+
+    std::string vmName;
+    if (!NapiGetStringUtf8(env, argv[0], vmName) || vmName.empty()) return out;
+
+    QmpEventSubscription sub;
+    if (argc >= 3) {
+        bool isArray = false;
+        napi_is_array(env, argv[2], &isArray);
+        if (isArray) {
+            uint32_t len = 0;
+            napi_get_array_length(env, argv[2], &len);
+            for (uint32_t i = 0; i < len; i++) {
+                napi_value e;
+                std::string name;
+                if (napi_get_element(env, argv[2], i, &e) == napi_ok && NapiGetStringUtf8(env, e, name) && !name.empty()) {
+                    sub.filter.push_back(name);
+                }
+            }
+        }
     }
-    buffer[n] = '\0';
-    HilogPrint(std::string("QMP screendump response: ") + buffer);
-    
-    // 检查响应是否成功
-    std::string response(buffer);
-    if (response.find("\"return\"") != std::string::npos && 
-        response.find("\"error\"") == std::string::npos) {
-        HilogPrint("QMP screendump: Success");
-        return true;
+
+    napi_value resourceName;
+    napi_create_string_utf8(env, "QmpEventCallback", NAPI_AUTO_LENGTH, &resourceName);
+    if (napi_create_threadsafe_function(env, argv[1], nullptr, resourceName, 0, 1, nullptr, nullptr, nullptr,
+                                        QmpEventJsCallback, &sub.tsfn) != napi_ok) {
+        return out;
     }
-    
-    HilogPrint("QMP screendump: Failed - " + response);
-    return false;
+
+    sub.client = VmQmpClient(vmName);
+    const napi_threadsafe_function tsfn = sub.tsfn;
+    const std::vector<std::string> filter = sub.filter;
+    // 回调在 QMP 读线程中执行：只做过滤和投递，不阻塞
+    sub.subId = sub.client->subscribe([vmName, tsfn, filter](const QmpEvent& e) {
+        if (!QmpEventMatches(filter, e.name)) return;
+        auto* ev = new QmpJsEvent{ vmName, e };
+        if (napi_call_threadsafe_function(tsfn, ev, napi_tsfn_nonblocking) != napi_ok) {
+            delete ev;
+        }
+    });
+
+    {
+        std::lock_guard<std::mutex> lk(g_qmp_event_mutex);
+        QmpEventUnsubscribeLocked(vmName);
+        g_qmp_event_subs[vmName] = std::move(sub);
+    }
+    QmpEventConnectWhenReady(vmName);
+
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
+static napi_value QmpUnsubscribeEvents(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+    if (argc < 1) return out;
+    std::string vmName;
+    if (!NapiGetStringUtf8(env, argv[0], vmName)) return out;
+    {
+        std::lock_guard<std::mutex> lk(g_qmp_event_mutex);
+        QmpEventUnsubscribeLocked(vmName);
+    }
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
+struct QmpExecuteCall {
+    napi_deferred deferred = nullptr;
+    napi_threadsafe_function tsfn = nullptr;
+    QmpResult result;
+};
+
+static void QmpExecuteResolveOnJsThread(napi_env env, napi_value js_cb, void* context, void* data)
+{
+    (void)js_cb;
+    (void)context;
+    QmpExecuteCall* call = static_cast<QmpExecuteCall*>(data);
+    if (!call) return;
+    if (env) {
+        const QmpResult& r = call->result;
+        napi_value obj;
+        napi_create_object(env, &obj);
+        napi_value v;
+        napi_get_boolean(env, r.ok, &v);
+        napi_set_named_property(env, obj, "ok", v);
+        if (r.ok) {
+            napi_create_string_utf8(env, r.value.c_str(), r.value.size(), &v);
+            napi_set_named_property(env, obj, "return", v);
+        } else {
+            napi_create_string_utf8(env, r.error_class.c_str(), NAPI_AUTO_LENGTH, &v);
+            napi_set_named_property(env, obj, "errorClass", v);
+            napi_create_string_utf8(env, r.error_desc.c_str(), NAPI_AUTO_LENGTH, &v);
+            napi_set_named_property(env, obj, "errorDesc", v);
+        }
+        napi_resolve_deferred(env, call->deferred, obj);
+    }
+    delete call;
+}
+
+// qmpExecute(vmName, command, argsJson?): Promise<{ ok, return?, errorClass?, errorDesc? }>
+// 多个调用在同一条连接上流水线执行，不阻塞 UI 线程
+static napi_value QmpExecute(napi_env env, napi_callback_info info)
+{
+    size_t argc = 3;
+    napi_value argv[3];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    if (argc < 2) {
+        napi_throw_error(env, nullptr, "Missing parameters: vmName, command");
+        return nullptr;
+    }
+    std::string vmName, command, argsJson;
+    if (!NapiGetStringUtf8(env, argv[0], vmName) || !NapiGetStringUtf8(env, argv[1], command)) {
+        napi_throw_error(env, nullptr, "Failed to get string parameters");
+        return nullptr;
+    }
+    if (argc >= 3) {
+        napi_valuetype t = napi_undefined;
+        napi_typeof(env, argv[2], &t);
+        if (t == napi_string) NapiGetStringUtf8(env, argv[2], argsJson);
+    }
+
+    auto* call = new QmpExecuteCall();
+    napi_value promise;
+    napi_create_promise(env, &call->deferred, &promise);
+    napi_value resourceName;
+    napi_create_string_utf8(env, "QmpExecute", NAPI_AUTO_LENGTH, &resourceName);
+    if (napi_create_threadsafe_function(env, nullptr, nullptr, resourceName, 0, 1, nullptr, nullptr, nullptr,
+                                        QmpExecuteResolveOnJsThread, &call->tsfn) != napi_ok) {
+        napi_value err;
+        napi_create_string_utf8(env, "Failed to create threadsafe function", NAPI_AUTO_LENGTH, &err);
+        napi_reject_deferred(env, call->deferred, err);
+        delete call;
+        return promise;
+    }
+
+    // 建连可能等待握手：放到后台线程，回复由 QMP 读线程投递回 JS 线程
+    std::thread([vmName, command, argsJson, call]() {
+        VmQmpClient(vmName)->execute_async(command, argsJson, [call](const QmpResult& r) {
+            call->result = r;
+            const napi_threadsafe_function tsfn = call->tsfn;
+            napi_call_threadsafe_function(tsfn, call, napi_tsfn_blocking);
+            napi_release_threadsafe_function(tsfn, napi_tsfn_release);
+        });
+    }).detach();
+    return promise;
+}
+
+// ============================================================================
+// 快照（snapshot_manager）：外部快照为默认模式，内部快照走 QMP snapshot-save/load 作业
+// ============================================================================
+
+static bool SnapshotVmActive(const std::string& vmName)
+{
+    const VmState st = GetVmStateRecord(vmName).state;
+    return st == VmState::Running || st == VmState::Paused;
+}
+
+static napi_value SnapshotProgressToJs(napi_env env, const SnapshotProgress& p)
+{
+    napi_value obj;
+    napi_value v;
+    napi_create_object(env, &obj);
+    napi_create_string_utf8(env, p.tag.c_str(), NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, obj, "tag", v);
+    napi_create_string_utf8(env, p.op.c_str(), NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, obj, "op", v);
+    napi_create_string_utf8(env, p.phase.c_str(), NAPI_AUTO_LENGTH, &v);
+    napi_set_named_property(env, obj, "phase", v);
+    napi_create_double(env, p.progress, &v);
+    napi_set_named_property(env, obj, "progress", v);
+    napi_create_double(env, static_cast<double>(p.ram_bytes), &v);
+    napi_set_named_property(env, obj, "ramBytes", v);
+    napi_create_double(env, static_cast<double>(p.stored_bytes), &v);
+    napi_set_named_property(env, obj, "storedBytes", v);
+    napi_get_boolean(env, p.done, &v);
+    napi_set_named_property(env, obj, "done", v);
+    napi_get_boolean(env, p.ok, &v);
+    napi_set_named_property(env, obj, "ok", v);
+    if (!p.error.empty()) {
+        napi_create_string_utf8(env, p.error.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "error", v);
+    }
+    return obj;
+}
+
+// 一次快照调用：Promise + 可选的 onProgress（同一个 tsfn，最后一条 done 消息兑现 Promise）
+struct SnapshotJsCall {
+    napi_deferred deferred = nullptr;
+    napi_threadsafe_function tsfn = nullptr;
+};
+
+static void SnapshotJsOnThread(napi_env env, napi_value js_cb, void* context, void* data)
+{
+    SnapshotJsCall* call = static_cast<SnapshotJsCall*>(context);
+    SnapshotProgress* p = static_cast<SnapshotProgress*>(data);
+    if (!p) return;
+    if (env) {
+        napi_value obj = SnapshotProgressToJs(env, *p);
+        if (js_cb) {
+            napi_value undefined;
+            napi_get_undefined(env, &undefined);
+            napi_call_function(env, undefined, js_cb, 1, &obj, nullptr);
+        }
+        if (p->done && call && call->deferred) {
+            napi_resolve_deferred(env, call->deferred, obj);
+            call->deferred = nullptr;
+        }
+    }
+    delete p;
+}
+
+static void SnapshotJsFinalize(napi_env env, void* finalize_data, void* finalize_hint)
+{
+    (void)env;
+    (void)finalize_hint;
+    delete static_cast<SnapshotJsCall*>(finalize_data);
+}
+
+// 创建 Promise 与投递进度用的 tsfn（onProgress 可为 nullptr）
+static SnapshotJsCall* SnapshotJsCallNew(napi_env env, napi_value onProgress, napi_value& promise)
+{
+    auto* call = new SnapshotJsCall();
+    napi_create_promise(env, &call->deferred, &promise);
+    napi_value resourceName;
+    napi_create_string_utf8(env, "Snapshot", NAPI_AUTO_LENGTH, &resourceName);
+    if (napi_create_threadsafe_function(env, onProgress, nullptr, resourceName, 0, 1, call, SnapshotJsFinalize, call,
+                                        SnapshotJsOnThread, &call->tsfn) != napi_ok) {
+        napi_value err;
+        napi_create_string_utf8(env, "Failed to create threadsafe function", NAPI_AUTO_LENGTH, &err);
+        napi_reject_deferred(env, call->deferred, err);
+        delete call;
+        return nullptr;
+    }
+    return call;
+}
+
+// 解析 (vmName, tag, options?)；options.onProgress 为可选回调
+static SnapshotJsCall* SnapshotJsCallCreate(napi_env env, napi_callback_info info, std::string& vmName,
+                                            std::string& tag, std::string& mode, napi_value& promise)
+{
+    size_t argc = 3;
+    napi_value argv[3];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    if (argc < 2 || !NapiGetStringUtf8(env, argv[0], vmName) || !NapiGetStringUtf8(env, argv[1], tag)) {
+        napi_throw_error(env, nullptr, "Missing parameters: vmName, tag");
+        return nullptr;
+    }
+    napi_value onProgress = nullptr;
+    if (argc >= 3) {
+        napi_valuetype t = napi_undefined;
+        napi_typeof(env, argv[2], &t);
+        if (t == napi_object) {
+            napi_value v;
+            if (napi_get_named_property(env, argv[2], "mode", &v) == napi_ok) NapiGetStringUtf8(env, v, mode);
+            if (napi_get_named_property(env, argv[2], "onProgress", &v) == napi_ok &&
+                napi_typeof(env, v, &t) == napi_ok && t == napi_function) {
+                onProgress = v;
+            }
+        }
+    }
+    return SnapshotJsCallNew(env, onProgress, promise);
+}
+
+// 作业线程上的进度回调：投递到 JS 线程，done 后释放 tsfn
+static SnapshotProgressCallback SnapshotJsForward(SnapshotJsCall* call)
+{
+    const napi_threadsafe_function tsfn = call->tsfn;
+    return [tsfn](const SnapshotProgress& p) {
+        napi_call_threadsafe_function(tsfn, new SnapshotProgress(p), napi_tsfn_blocking);
+        if (p.done) napi_release_threadsafe_function(tsfn, napi_tsfn_release);
+    };
+}
+
+// 作业未能启动：在 JS 线程直接兑现 { ok: false, error }
+static void SnapshotJsFailNow(napi_env env, SnapshotJsCall* call, const std::string& op, const std::string& tag,
+                              const std::string& error)
+{
+    SnapshotProgress p;
+    p.tag = tag;
+    p.op = op;
+    p.phase = "error";
+    p.done = true;
+    p.error = error;
+    napi_resolve_deferred(env, call->deferred, SnapshotProgressToJs(env, p));
+    call->deferred = nullptr;
+    napi_release_threadsafe_function(call->tsfn, napi_tsfn_release);
+}
+
+// snapshotSave(vmName, tag, { mode?: 'external' | 'internal', onProgress? }): Promise<SnapshotResult>
+static napi_value SnapshotSave(napi_env env, napi_callback_info info)
+{
+    std::string vmName, tag, mode;
+    napi_value promise = nullptr;
+    SnapshotJsCall* call = SnapshotJsCallCreate(env, info, vmName, tag, mode, promise);
+    if (!call) return promise;
+    std::string error;
+    if (!SnapshotVmActive(vmName)) {
+        SnapshotJsFailNow(env, call, "save", tag, "VM is not running");
+    } else if (!snapshot_save_async(SnapshotVmFor(vmName), tag,
+                                    mode == "internal" ? SnapshotMode::Internal : SnapshotMode::External,
+                                    SnapshotJsForward(call), error)) {
+        SnapshotJsFailNow(env, call, "save", tag, error);
+    }
+    return promise;
+}
+
+// snapshotLoad(vmName, tag, { onProgress? }): Promise<SnapshotResult>
+// 外部快照返回 phase 'pending'：下次 startVm 时恢复
+static napi_value SnapshotLoad(napi_env env, napi_callback_info info)
+{
+    std::string vmName, tag, mode;
+    napi_value promise = nullptr;
+    SnapshotJsCall* call = SnapshotJsCallCreate(env, info, vmName, tag, mode, promise);
+    if (!call) return promise;
+    std::string error;
+    if (!snapshot_load_async(SnapshotVmFor(vmName), tag, SnapshotVmActive(vmName), SnapshotJsForward(call), error)) {
+        SnapshotJsFailNow(env, call, "load", tag, error);
+    }
+    return promise;
+}
+
+// snapshotDelete(vmName, tag): Promise<SnapshotResult>（内部快照需要等待 QMP 作业）
+static napi_value SnapshotDelete(napi_env env, napi_callback_info info)
+{
+    std::string vmName, tag, mode;
+    napi_value promise = nullptr;
+    SnapshotJsCall* call = SnapshotJsCallCreate(env, info, vmName, tag, mode, promise);
+    if (!call) return promise;
+    const bool running = SnapshotVmActive(vmName);
+    SnapshotProgressCallback done = SnapshotJsForward(call);
+    std::thread([vmName, tag, running, done]() {
+        SnapshotProgress p;
+        p.tag = tag;
+        p.op = "delete";
+        p.ok = snapshot_delete(SnapshotVmFor(vmName), tag, running, p.error);
+        p.phase = p.ok ? "done" : "error";
+        p.progress = p.ok ? 1.0 : 0.0;
+        p.done = true;
+        done(p);
+    }).detach();
+    return promise;
+}
+
+// snapshotList(vmName): SnapshotInfo[]（读 index.json，VM 无需运行）
+static napi_value SnapshotList(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName)) {
+        napi_throw_error(env, nullptr, "Missing VM name parameter");
+        return nullptr;
+    }
+    const std::vector<SnapshotInfo> list = snapshot_list(SnapshotVmFor(vmName));
+    napi_value result;
+    napi_create_array_with_length(env, list.size(), &result);
+    for (size_t i = 0; i < list.size(); i++) {
+        const SnapshotInfo& s = list[i];
+        napi_value obj;
+        napi_value v;
+        napi_create_object(env, &obj);
+        napi_create_string_utf8(env, s.tag.c_str(), NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "tag", v);
+        napi_create_string_utf8(env, s.mode == SnapshotMode::Internal ? "internal" : "external", NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, obj, "mode", v);
+        napi_create_int64(env, s.created_ms, &v);
+        napi_set_named_property(env, obj, "created", v);
+        napi_get_boolean(env, s.was_running, &v);
+        napi_set_named_property(env, obj, "running", v);
+        napi_create_double(env, static_cast<double>(s.ram_bytes), &v);
+        napi_set_named_property(env, obj, "ramBytes", v);
+        napi_create_double(env, static_cast<double>(s.stored_bytes), &v);
+        napi_set_named_property(env, obj, "storedBytes", v);
+        napi_set_element(env, result, i, obj);
+    }
+    return result;
+}
+
+// suspendVm(vmName): Promise<SnapshotResult>
+// 挂起到文件（需以 fastResume 启动）：保存设备状态后退出 QEMU，下次 startVm 自动恢复
+static napi_value SuspendVm(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName)) {
+        napi_throw_error(env, nullptr, "Missing VM name parameter");
+        return nullptr;
+    }
+    napi_value promise = nullptr;
+    SnapshotJsCall* call = SnapshotJsCallNew(env, nullptr, promise);
+    if (!call) return promise;
+    std::string fingerprint;
+    {
+        std::lock_guard<std::mutex> lock(g_vmMutex);
+        auto it = g_vm_resume_fingerprints.find(vmName);
+        if (it != g_vm_resume_fingerprints.end()) fingerprint = it->second;
+    }
+    if (!SnapshotVmActive(vmName)) {
+        SnapshotJsFailNow(env, call, "suspend", vmName, "VM is not running");
+        return promise;
+    }
+    if (fingerprint.empty()) {
+        SnapshotJsFailNow(env, call, "suspend", vmName, "VM was not started with fastResume");
+        return promise;
+    }
+    SnapshotProgressCallback done = SnapshotJsForward(call);
+    std::thread([vmName, fingerprint, done]() {
+        SnapshotProgress p;
+        p.tag = vmName;
+        p.op = "suspend";
+        p.ok = snapshot_suspend(SnapshotVmFor(vmName), fingerprint, p.error);
+        if (p.ok) {
+            // 设备状态已落盘：退出 QEMU，VM 线程返回后状态机进入 stopped
+            SetVmState(vmName, VmState::Stopping, "suspend");
+            VmQmpClient(vmName)->execute("quit", "", 2000);
+        }
+        p.phase = p.ok ? "done" : "error";
+        p.progress = p.ok ? 1.0 : 0.0;
+        p.done = true;
+        done(p);
+    }).detach();
+    return promise;
+}
+
+// hasResumeState(vmName): 是否存在可用于快速恢复的挂起状态
+static napi_value HasResumeState(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    std::string vmName;
+    napi_value out;
+    napi_get_boolean(env, argc >= 1 && NapiGetStringUtf8(env, argv[0], vmName) &&
+                     snapshot_has_resume_state(SnapshotVmFor(vmName)), &out);
+    return out;
+}
+
+// discardResumeState(vmName): 丢弃挂起状态，下次启动走正常引导
+static napi_value DiscardResumeState(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    std::string vmName;
+    napi_value out;
+    if (argc < 1 || !NapiGetStringUtf8(env, argv[0], vmName)) {
+        napi_get_boolean(env, false, &out);
+        return out;
+    }
+    snapshot_discard_resume_state(SnapshotVmFor(vmName));
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
+// 旧接口（createSnapshot / restoreSnapshot / listSnapshots / deleteSnapshot）：改走快照引擎，
+// 返回值表示作业是否已启动，进度与结果请用 snapshotSave / snapshotLoad
+
+static bool GetVmAndSnapshotName(napi_env env, napi_callback_info info, std::string& vmName, std::string& tag)
+{
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 2 || !NapiGetStringUtf8(env, args[0], vmName) || !NapiGetStringUtf8(env, args[1], tag)) {
+        napi_throw_error(env, nullptr, "Missing VM name and snapshot name parameters");
+        return false;
+    }
+    return true;
+}
+
+// 创建快照
+static napi_value CreateSnapshot(napi_env env, napi_callback_info info) {
+    std::string vmName, tag, error;
+    if (!GetVmAndSnapshotName(env, info, vmName, tag)) return nullptr;
+    bool success = SnapshotVmActive(vmName) &&
+                   snapshot_save_async(SnapshotVmFor(vmName), tag, SnapshotMode::External, nullptr, error);
+    if (!error.empty()) HilogPrint("QEMU: [SNAPSHOT] createSnapshot failed: " + error);
+    napi_value result;
+    napi_get_boolean(env, success, &result);
+    return result;
+}
+
+// 恢复快照
+static napi_value RestoreSnapshot(napi_env env, napi_callback_info info) {
+    std::string vmName, tag, error;
+    if (!GetVmAndSnapshotName(env, info, vmName, tag)) return nullptr;
+    bool success = snapshot_load_async(SnapshotVmFor(vmName), tag, SnapshotVmActive(vmName), nullptr, error);
+    if (!error.empty()) HilogPrint("QEMU: [SNAPSHOT] restoreSnapshot failed: " + error);
+    napi_value result;
+    napi_get_boolean(env, success, &result);
+    return result;
 }
 
-static napi_value TakeScreenshot(napi_env env, napi_callback_info info) {
-    size_t argc = 2;
-    napi_value argv[2];
-    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
-    
-    if (argc < 2) {
-        napi_throw_error(env, nullptr, "Missing parameters: vmName, outputPath");
+// 列出快照
+static napi_value ListSnapshots(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    std::string vmName;
+    if (argc < 1 || !NapiGetStringUtf8(env, args[0], vmName)) {
+        napi_throw_error(env, nullptr, "Missing VM name parameter");
         return nullptr;
     }
-    
-    std::string vmName, outputPath;
-    if (!NapiGetStringUtf8(env, argv[0], vmName) || !NapiGetStringUtf8(env, argv[1], outputPath)) {
-        napi_throw_error(env, nullptr, "Failed to get string parameters");
-        return nullptr;
+    const std::vector<SnapshotInfo> list = snapshot_list(SnapshotVmFor(vmName));
+    napi_value result;
+    napi_create_array_with_length(env, list.size(), &result);
+    for (size_t i = 0; i < list.size(); i++) {
+        napi_value snapshot;
+        napi_create_string_utf8(env, list[i].tag.c_str(), NAPI_AUTO_LENGTH, &snapshot);
+        napi_set_element(env, result, i, snapshot);
     }
-    
-    bool success = TakeScreenshotViaQmp(vmName, outputPath);
-    
+    return result;
+}
+
+// 删除快照（同步；内部快照会阻塞到 QMP 作业结束，建议用 snapshotDelete）
+static napi_value DeleteSnapshot(napi_env env, napi_callback_info info) {
+    std::string vmName, tag, error;
+    if (!GetVmAndSnapshotName(env, info, vmName, tag)) return nullptr;
+    bool success = snapshot_delete(SnapshotVmFor(vmName), tag, SnapshotVmActive(vmName), error);
+    if (!error.empty()) HilogPrint("QEMU: [SNAPSHOT] deleteSnapshot failed: " + error);
     napi_value result;
     napi_get_boolean(env, success, &result);
     return result;
@@ -4326,6 +6111,14 @@ static napi_value ConnectRdp(napi_env env, napi_callback_info info) {
         }
     }
     
+    // 用户确认信任的服务器证书指纹（getRdpCertificate 返回的 fingerprint）
+    std::string fingerprintStr;
+    napi_value fingerprint_value;
+    if (napi_get_named_property(env, config, "trustedFingerprint", &fingerprint_value) == napi_ok) {
+        NapiGetStringUtf8(env, fingerprint_value, fingerprintStr);
+        if (!fingerprintStr.empty()) rdp_config.trusted_fingerprint = fingerprintStr.c_str();
+    }
+    
     // 查找客户端
     rdp_client_handle_t client = nullptr;
     {
@@ -4349,6 +6142,58 @@ static napi_value ConnectRdp(napi_env env, napi_callback_info info) {
     return result_value;
 }
 
+// 获取被拒绝的服务器证书（连接因证书不受信任失败时），供 ArkTS 让用户确认后带 trustedFingerprint 重连
+static napi_value GetRdpCertificate(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    
+    napi_value undefined;
+    napi_get_undefined(env, &undefined);
+    
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "Missing client ID parameter");
+        return nullptr;
+    }
+    
+    std::string client_id;
+    if (!NapiGetStringUtf8(env, argv[0], client_id)) {
+        napi_throw_error(env, nullptr, "Failed to get client ID");
+        return nullptr;
+    }
+    
+    rdp_certificate_info_t cert = {};
+    {
+        std::lock_guard<std::mutex> lock(g_rdp_mutex);
+        auto it = g_rdp_clients.find(client_id);
+        if (it == g_rdp_clients.end() || rdp_client_get_pending_certificate(it->second, &cert) != 0) {
+            return undefined;
+        }
+    }
+    
+    napi_value result;
+    napi_create_object(env, &result);
+    auto set_string = [&](const char* name, const char* value) {
+        napi_value v;
+        napi_create_string_utf8(env, value ? value : "", NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, result, name, v);
+    };
+    set_string("host", cert.host);
+    set_string("commonName", cert.common_name);
+    set_string("subject", cert.subject);
+    set_string("issuer", cert.issuer);
+    set_string("fingerprint", cert.fingerprint);
+    napi_value port_value;
+    napi_create_int32(env, cert.port, &port_value);
+    napi_set_named_property(env, result, "port", port_value);
+    napi_value changed_value;
+    napi_get_boolean(env, cert.changed != 0, &changed_value);
+    napi_set_named_property(env, result, "changed", changed_value);
+    
+    rdp_certificate_info_free(&cert);
+    return result;
+}
+
 // 断开RDP连接
 static napi_value DisconnectRdp(napi_env env, napi_callback_info info) {
     size_t argc = 1;
@@ -4472,6 +6317,104 @@ static napi_value RdpSendKey(napi_env env, napi_callback_info info) {
     return result;
 }
 
+// 发送 RDP 鼠标事件：button 0 仅移动，1 左键，2 中键，3 右键，4/5 滚轮上/下
+static napi_value RdpSendMouse(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value argv[5];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+    if (argc < 5) {
+        napi_throw_error(env, nullptr, "Missing parameters: clientId, x, y, button, down");
+        return nullptr;
+    }
+
+    std::string client_id;
+    if (!NapiGetStringUtf8(env, argv[0], client_id)) {
+        napi_throw_error(env, nullptr, "Failed to get client ID");
+        return nullptr;
+    }
+
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t button = 0;
+    bool down = false;
+    napi_get_value_int32(env, argv[1], &x);
+    napi_get_value_int32(env, argv[2], &y);
+    napi_get_value_int32(env, argv[3], &button);
+    napi_get_value_bool(env, argv[4], &down);
+
+    rdp_client_handle_t client = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_rdp_mutex);
+        auto it = g_rdp_clients.find(client_id);
+        if (it != g_rdp_clients.end()) {
+            client = it->second;
+        }
+    }
+
+    if (!client) {
+        napi_throw_error(env, nullptr, "RDP client not found");
+        return nullptr;
+    }
+
+    int ret = rdp_client_send_mouse_event(client, x, y, button, down ? 1 : 0);
+
+    napi_value result;
+    napi_create_int32(env, ret, &result);
+    return result;
+}
+
+// 把 XComponent surface 交给 RDP 客户端：桌面由客户端自己的 render 线程直接写入 NativeWindow
+// rdpSetSurface(clientId, surfaceId, width, height)；rdpClearSurface(clientId) 解绑
+static napi_value RdpSetSurface(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value argv[4];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+    if (argc < 4) return out;
+
+    std::string client_id;
+    std::string surfaceIdStr;
+    if (!NapiGetStringUtf8(env, argv[0], client_id) || !NapiGetStringUtf8(env, argv[1], surfaceIdStr)) return out;
+    int32_t w = 0;
+    int32_t h = 0;
+    napi_get_value_int32(env, argv[2], &w);
+    napi_get_value_int32(env, argv[3], &h);
+    if (w <= 0 || h <= 0) return out;
+
+    unsigned long long surfaceId = 0;
+    try {
+        surfaceId = std::stoull(surfaceIdStr, nullptr, 0);
+    } catch (...) {
+        return out;
+    }
+
+    std::lock_guard<std::mutex> lock(g_rdp_mutex);
+    auto it = g_rdp_clients.find(client_id);
+    if (it == g_rdp_clients.end()) return out;
+    napi_get_boolean(env, rdp_client_set_surface(it->second, surfaceId, w, h) == 0, &out);
+    return out;
+}
+
+static napi_value RdpClearSurface(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+    if (argc < 1) return out;
+
+    std::string client_id;
+    if (!NapiGetStringUtf8(env, argv[0], client_id)) return out;
+
+    std::lock_guard<std::mutex> lock(g_rdp_mutex);
+    auto it = g_rdp_clients.find(client_id);
+    if (it == g_rdp_clients.end()) return out;
+    napi_get_boolean(env, rdp_client_set_surface(it->second, 0, 0, 0) == 0, &out);
+    return out;
+}
+
 // 检测核心库存在性（真实检测，不加载到全局）
 // ============ 诊断工具：追踪 dlopen 崩溃位置 ============
 // 这个函数会详细记录 dlopen 过程中的每一步
@@ -4660,10 +6603,255 @@ static napi_value RdpGetStatusString(napi_env env, napi_callback_info info) {
 #ifdef LIBVNC_HAVE_CLIENT
 #include "third_party/libvncclient/include/rfb/rfbclient.h"
 #endif
+#if !defined(__APPLE__)
+#include <linux/tcp.h> // TCP_INFO: tcpi_bytes_received，用于统计 RFB 接收字节数
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// BGRA -> RGBA（alpha 置 255），用于 ArkTS PixelMap 路径；只对脏区调用
+static void VncBgraToRgba(const uint8_t* src, uint8_t* dst, size_t pixels)
+{
+    size_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t opaque = vdupq_n_u8(255);
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x4_t px = vld4q_u8(src + i * 4);
+        const uint8x16_t b = px.val[0];
+        px.val[0] = px.val[2];
+        px.val[2] = b;
+        px.val[3] = opaque;
+        vst4q_u8(dst + i * 4, px);
+    }
+#elif defined(__SSE2__)
+    const __m128i maskG = _mm_set1_epi32(0x0000FF00);
+    const __m128i maskLo = _mm_set1_epi32(0x000000FF);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+    for (; i + 4 <= pixels; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        const __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), maskLo);
+        const __m128i g = _mm_and_si128(v, maskG);
+        const __m128i b = _mm_slli_epi32(_mm_and_si128(v, maskLo), 16);
+        const __m128i out = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, opaque));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), out);
+    }
+#endif
+    for (; i < pixels; i++) {
+        dst[i * 4 + 0] = src[i * 4 + 2];
+        dst[i * 4 + 1] = src[i * 4 + 1];
+        dst[i * 4 + 2] = src[i * 4 + 0];
+        dst[i * 4 + 3] = 255;
+    }
+}
 
 static std::mutex g_vnc_mutex;
 static int g_vnc_next_id = 1;
 
+// 打包的 libvncclient（OHOS minimal）实际编进来的编码；encodingsString 只允许出现这些名字，
+// 否则 libvncclient 会打 "Unknown encoding" 并可能导致协商异常/黑屏。
+struct VncEncodingInfo {
+    const char* name;
+    bool supported;
+};
+static const VncEncodingInfo kVncEncodings[] = {
+    { "raw", true },
+    { "copyrect", true },
+    { "rre", true },
+    { "corre", true },
+    { "hextile", true },
+#ifdef LIBVNCSERVER_HAVE_LIBZ
+    { "zlib", true },
+    { "zrle", true },
+    { "zywrle", true },
+#else
+    { "zlib", false },
+    { "zrle", false },
+    { "zywrle", false },
+#endif
+#if defined(LIBVNCSERVER_HAVE_LIBZ) && defined(LIBVNCSERVER_HAVE_LIBJPEG)
+    { "tight", true },
+#else
+    { "tight", false },
+#endif
+    { "trle", true },
+    { "ultra", true },
+};
+static constexpr int kVncEncodingCount = (int)(sizeof(kVncEncodings) / sizeof(kVncEncodings[0]));
+static constexpr int kVncEncodingCopyRect = 1;
+
+static int VncEncodingIndex(const std::string& name)
+{
+    for (int i = 0; i < kVncEncodingCount; i++) {
+        if (name == kVncEncodings[i].name) return i;
+    }
+    return -1;
+}
+
+// 每种编码的接收/解码计数（worker 写，ArkTS 通过 vncGetStats 读）
+struct VncEncodingStats {
+    std::atomic<uint64_t> rects{0};
+    std::atomic<uint64_t> pixels{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> decode_us{0};
+};
+
+// 脏矩形集合：把 RFB 的逐块更新合并成少量矩形，只拷贝/提交真正变化的区域。
+// 超过 kMaxRects 或覆盖面积接近整屏时退化为单个整屏矩形，保证开销有上界。
+struct VncDirtyRect {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+struct VncDamage {
+    static constexpr size_t kMaxRects = 16;
+    std::vector<VncDirtyRect> rects;
+
+    bool Empty() const { return rects.empty(); }
+    void Clear() { rects.clear(); }
+
+    void AddFull(int fbW, int fbH)
+    {
+        rects.clear();
+        if (fbW > 0 && fbH > 0) rects.push_back(VncDirtyRect{ 0, 0, fbW, fbH });
+    }
+
+    void Add(int x, int y, int w, int h, int fbW, int fbH)
+    {
+        // 裁剪到帧缓冲范围
+        const int x0 = std::max(0, x);
+        const int y0 = std::max(0, y);
+        const int x1 = std::min(fbW, x + w);
+        const int y1 = std::min(fbH, y + h);
+        if (x1 <= x0 || y1 <= y0) return;
+        VncDirtyRect r{ x0, y0, x1 - x0, y1 - y0 };
+
+        // 与已有矩形合并：相交/相邻，或合并后浪费的面积不超过两者之和的 1/4
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < rects.size(); i++) {
+                const VncDirtyRect& o = rects[i];
+                const int ux0 = std::min(r.x, o.x);
+                const int uy0 = std::min(r.y, o.y);
+                const int ux1 = std::max(r.x + r.w, o.x + o.w);
+                const int uy1 = std::max(r.y + r.h, o.y + o.h);
+                const int64_t unionArea = (int64_t)(ux1 - ux0) * (uy1 - uy0);
+                const int64_t sumArea = (int64_t)r.w * r.h + (int64_t)o.w * o.h;
+                const bool touching = r.x <= o.x + o.w && o.x <= r.x + r.w &&
+                    r.y <= o.y + o.h && o.y <= r.y + r.h;
+                if ((touching && unionArea <= sumArea + sumArea / 2) || unionArea <= sumArea + sumArea / 4) {
+                    r = VncDirtyRect{ ux0, uy0, ux1 - ux0, uy1 - uy0 };
+                    rects[i] = rects.back();
+                    rects.pop_back();
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        rects.push_back(r);
+
+        if (rects.size() > kMaxRects) {
+            // 矩形太多：收敛成包围盒
+            VncDirtyRect b = rects[0];
+            for (const auto& o : rects) {
+                const int bx1 = std::max(b.x + b.w, o.x + o.w);
+                const int by1 = std::max(b.y + b.h, o.y + o.h);
+                b.x = std::min(b.x, o.x);
+                b.y = std::min(b.y, o.y);
+                b.w = bx1 - b.x;
+                b.h = by1 - b.y;
+            }
+            rects.clear();
+            rects.push_back(b);
+        }
+    }
+
+    void Merge(const VncDamage& other, int fbW, int fbH)
+    {
+        for (const auto& r : other.rects) Add(r.x, r.y, r.w, r.h, fbW, fbH);
+    }
+};
+
+// 三缓冲帧环：libvncclient 直接解码进 back，发布时与 middle 原子交换；render 线程从 middle 换出最新帧作为 front。
+// 三个下标始终互不相同，因此生产者写 back 与消费者读 front 之间无需加锁，也没有中间拷贝。
+// 换到新的 back 后，生产者只需把它错过的脏区（missed）从刚发布的帧补齐即可（RFB 增量更新依赖旧内容）。
+struct VncFrameRing {
+    static constexpr int kSlots = 3;
+    static constexpr uint32_t kFresh = 0x4; // middle 上的“新帧尚未被取走”标志
+
+    const int w;
+    const int h;
+    std::vector<uint8_t> pixels[kSlots]; // BGRA，w*h*4，只在创建时分配
+    VncDamage damage[kSlots];            // 随帧发布的脏区（相对消费者上一次取走的帧）
+    uint32_t seq[kSlots] = {};           // 随帧发布的帧序号
+    std::atomic<uint32_t> middle{1};
+
+    // 生产者（VNC worker）私有
+    int back = 0;
+    uint32_t next_seq = 0;
+    VncDamage missed[kSlots];
+    VncDamage unconsumed;
+
+    // 消费者（render 线程）私有
+    int front = 2;
+
+    VncFrameRing(int width, int height) : w(width), h(height)
+    {
+        for (int i = 0; i < kSlots; i++) {
+            pixels[i].assign((size_t)w * (size_t)h * 4, 0);
+            if (i != back) missed[i].AddFull(w, h);
+        }
+        unconsumed.AddFull(w, h);
+    }
+
+    uint8_t* Back() { return pixels[back].data(); }
+    const uint8_t* Front() const { return pixels[front].data(); }
+
+    // 生产者：发布 back（携带本帧脏区 d），换回一个空闲 buffer 并补齐它错过的区域。返回已发布的下标。
+    int Publish(const VncDamage& d)
+    {
+        unconsumed.Merge(d, w, h);
+        damage[back] = unconsumed;
+        seq[back] = ++next_seq;
+        const int published = back;
+        const uint32_t prev = middle.exchange((uint32_t)published | kFresh, std::memory_order_acq_rel);
+        back = (int)(prev & 0x3);
+        // 上一帧已被消费者取走：之后只需报告本帧脏区；否则上一帧被丢弃，脏区继续累积
+        if (!(prev & kFresh)) unconsumed = d;
+
+        for (int i = 0; i < kSlots; i++) {
+            if (i != published) missed[i].Merge(d, w, h);
+        }
+        const size_t row = (size_t)w * 4;
+        const uint8_t* src = pixels[published].data();
+        uint8_t* dst = pixels[back].data();
+        for (const auto& r : missed[back].rects) {
+            const size_t span = (size_t)r.w * 4;
+            for (int yy = r.y; yy < r.y + r.h; yy++) {
+                const size_t off = (size_t)yy * row + (size_t)r.x * 4;
+                std::memcpy(dst + off, src + off, span);
+            }
+        }
+        missed[back].Clear();
+        return published;
+    }
+
+    // 消费者：若有新帧则原子换出为 front，并把其脏区并入 out
+    bool AcquireLatest(VncDamage& out)
+    {
+        if (!(middle.load(std::memory_order_acquire) & kFresh)) return false;
+        const uint32_t prev = middle.exchange((uint32_t)front, std::memory_order_acq_rel);
+        front = (int)(prev & 0x3);
+        out.Merge(damage[front], w, h);
+        return true;
+    }
+};
+
 struct VncSession {
     int id = 0;
 #ifdef LIBVNC_HAVE_CLIENT
@@ -4675,6 +6863,22 @@ struct VncSession {
     // 连接/断开必须避免阻塞 UI 线程：把耗时的 rfbClientConnect/rfbClientInitialise 放到后台线程
     std::atomic<bool> connecting{false};
     std::atomic<uint32_t> connect_seq{0};
+    // 当前 FramebufferUpdate 消息内累积的矩形（只在 VNC worker 线程访问），
+    // 消息结束（FinishedFrameBufferUpdate）时一次性拷贝/唤醒 render/请求下一帧
+    VncDamage fbu_damage;
+    bool fbu_pending = false;
+    // 本条消息内的矩形/CopyRect 计数（worker 私有，消息结束后归入 enc_stats）
+    uint64_t fbu_rects = 0;
+    uint64_t fbu_pixels = 0;
+    uint64_t fbu_copy_rects = 0;
+    uint64_t fbu_copy_pixels = 0;
+    uint64_t fbu_copy_us = 0;
+    // 协商结果：encodingsString 必须在 client 生命周期内保持有效
+    std::string encodings;
+    int primary_encoding = 0; // 除 CopyRect 外优先级最高的编码（非 CopyRect 矩形的字节/耗时归到它）
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> messages{0};
+    VncEncodingStats enc_stats[kVncEncodingCount];
 #endif
 #if defined(__OHOS__)
     // XComponent 直绘：NativeWindow 必须在同一线程内创建/使用/销毁，避免 FlushBuffer 崩溃
@@ -4690,22 +6894,22 @@ struct VncSession {
     int pending_surface_h = 0;
     std::atomic<bool> surface_dirty{false};
 
-    // 由 VNC 回调更新：最新 BGRA 帧（render 线程消费并 flush）
-    std::mutex frame_mtx;
-    int fb_w = 0;
-    int fb_h = 0;
-    std::vector<uint8_t> fb_bgra;
+    // 有新帧发布（render 线程从 ring 取最新帧并 flush）
     std::atomic<bool> frame_dirty{false};
 #endif
+    // libvncclient 的帧缓冲本体（尺寸变化时整体替换；通过 std::atomic_load/store 跨线程交接）
+    std::shared_ptr<VncFrameRing> ring;
+    // ArkTS PixelMap 路径：RGBA8888 三缓冲（ArkTS 可直接 createPixelMap，无需再做 BGRA->RGBA 转换）。
+    // 仅在 ArkTS 首次调用 vncGetFrame 后由 worker 生产；JS 线程作为消费者持有 front 直到下一次 vncGetFrame。
+    std::shared_ptr<VncFrameRing> rgba;
+    std::atomic<bool> rgba_enabled{false};
+    // 以下只在 JS 线程访问：每个 RGBA slot 对应一个常驻的 external ArrayBuffer（避免每帧分配/拷贝）
+    std::shared_ptr<VncFrameRing> js_ring;
+    napi_env js_env = nullptr;
+    napi_ref js_pixels[VncFrameRing::kSlots] = {};
     std::thread worker;
     std::atomic<bool> running;  // 在构造函数中初始化
-    int width = 0;
-    int height = 0;
-    std::vector<uint8_t> frame; // RGBA8888 (ArkTS 可直接 createPixelMap，无需再做 BGRA->RGBA 转换)
-    uint32_t seq = 0;           // frame 序号（每次更新递增）
-    bool dirty = false;         // 是否有新帧
-    std::mutex mtx;
-    
+
     VncSession() : running(false) {}
 };
 
@@ -4725,9 +6929,19 @@ static void VncRenderWorker(VncSession* s)
     int curW = 0;
     int curH = 0;
 
+    // BufferQueue 中每个 buffer 上次写入后累积的脏区（buffer-age）：
+    // 新申请到的 buffer 只需补齐它错过的区域；未见过的 buffer 需要整帧写入。
+    std::map<OHNativeWindowBuffer*, VncDamage> bufDamage;
+    constexpr size_t kMaxTrackedBuffers = 8;
+    // 当前持有的帧环（front 归本线程所有，读取无需加锁）及尚未成功提交的脏区
+    std::shared_ptr<VncFrameRing> ring;
+    VncDamage frameDamage;
+
     s->render_running.store(true);
+    sched_pin_self(SchedRole::Io, "vnc-render");
 
     auto cleanupWindow = [&]() {
+        bufDamage.clear();
         if (window) {
             OH_NativeWindow_DestroyNativeWindow(window);
             window = nullptr;
@@ -4781,6 +6995,8 @@ static void VncRenderWorker(VncSession* s)
                     curH = targetH;
                     HilogPrint("VNC: RenderWorker bound surfaceId=" + std::to_string(curSurfaceId) +
                         " size=" + std::to_string(curW) + "x" + std::to_string(curH));
+                    // 新 surface 没有任何内容：若已有帧则立即整帧补绘一次
+                    s->frame_dirty.store(true);
                 } else {
                     HilogPrint("VNC: RenderWorker failed to create window from surfaceId=" + std::to_string(targetId));
                 }
@@ -4795,22 +7011,31 @@ static void VncRenderWorker(VncSession* s)
         }
 
         if (s->frame_dirty.exchange(false)) {
-            int w = 0;
-            int h = 0;
-            std::vector<uint8_t> bgra;
-            {
-                std::lock_guard<std::mutex> lk(s->frame_mtx);
-                w = s->fb_w;
-                h = s->fb_h;
-                bgra = s->fb_bgra;
+            std::shared_ptr<VncFrameRing> latest = std::atomic_load(&s->ring);
+            if (!latest) {
+                ring.reset();
+                frameDamage.Clear();
+                continue;
             }
-            if (w <= 0 || h <= 0 || bgra.empty()) continue;
+            if (latest != ring) {
+                // 分辨率变化换了新环：旧 buffer 内容全部失效
+                ring = std::move(latest);
+                frameDamage.Clear();
+                bufDamage.clear();
+            }
+            // 取最新完成的帧（无新帧时沿用当前 front，例如新 surface 需要补绘）
+            (void)ring->AcquireLatest(frameDamage);
+            const int w = ring->w;
+            const int h = ring->h;
+            if (w <= 0 || h <= 0) continue;
 
             if (curW != w || curH != h) {
                 (void)OH_NativeWindow_NativeWindowHandleOpt(window, SET_BUFFER_GEOMETRY, w, h);
                 (void)OH_NativeWindow_NativeWindowHandleOpt(window, SET_FORMAT, (int)NATIVEBUFFER_PIXEL_FMT_BGRA_8888);
                 curW = w;
                 curH = h;
+                // 几何变化后旧 buffer 内容全部失效
+                bufDamage.clear();
             }
 
             OHNativeWindowBuffer* wndBuf = nullptr;
@@ -4831,6 +7056,7 @@ static void VncRenderWorker(VncSession* s)
                 fenceFd = -1;
                 if (prc <= 0) {
                     (void)OH_NativeWindow_NativeWindowAbortBuffer(window, wndBuf);
+                    s->frame_dirty.store(true); // frameDamage 保留，下轮重试
                     continue;
                 }
             }
@@ -4858,28 +7084,55 @@ static void VncRenderWorker(VncSession* s)
                 continue;
             }
 
-            const uint8_t* src = bgra.data();
             uint8_t* dst = reinterpret_cast<uint8_t*>(virAddr);
             const int copyW = std::min(w, dstW);
             const int copyH = std::min(h, dstH);
-            const size_t srcRow = (size_t)copyW * 4;
             const size_t dstRow = (size_t)rowStride;
-            if (dstRow < srcRow) {
+            if (dstRow < (size_t)copyW * 4) {
                 // stride 不合理，避免越界写导致系统层崩溃
                 (void)OH_NativeBuffer_Unmap(nb);
                 (void)OH_NativeWindow_NativeWindowAbortBuffer(window, wndBuf);
                 HilogPrint("VNC: RenderWorker invalid stride=" + std::to_string(dstRow) +
-                    " < srcRow=" + std::to_string(srcRow) + ", abort buffer");
+                    " < srcRow=" + std::to_string((size_t)copyW * 4) + ", abort buffer");
                 continue;
             }
-            for (int yy = 0; yy < copyH; yy++) {
-                std::memcpy(dst + (size_t)yy * dstRow, src + (size_t)yy * (size_t)w * 4, srcRow);
+
+            // 只拷贝该 buffer 缺失的区域；front 归本线程所有，直接从帧环读取
+            for (auto& kv : bufDamage) kv.second.Merge(frameDamage, copyW, copyH);
+            auto bit = bufDamage.find(wndBuf);
+            if (bit == bufDamage.end()) {
+                if (bufDamage.size() >= kMaxTrackedBuffers) bufDamage.clear();
+                bit = bufDamage.emplace(wndBuf, VncDamage{}).first;
+                bit->second.AddFull(copyW, copyH);
+            }
+            const uint8_t* src = ring->Front();
+            const size_t srcRow = (size_t)w * 4;
+            for (const auto& r : bit->second.rects) {
+                const size_t span = (size_t)r.w * 4;
+                for (int yy = r.y; yy < r.y + r.h; yy++) {
+                    std::memcpy(dst + (size_t)yy * dstRow + (size_t)r.x * 4,
+                        src + (size_t)yy * srcRow + (size_t)r.x * 4, span);
+                }
             }
+            bit->second.Clear();
             (void)OH_NativeBuffer_Unmap(nb);
 
-            Region::Rect rect{ 0, 0, (uint32_t)copyW, (uint32_t)copyH };
-            Region region{ &rect, 1 };
+            // 只把本帧变化的区域提交给合成器（frameDamage 为空说明只是补齐旧 buffer，按整屏提交）
+            std::vector<Region::Rect> flushRects;
+            flushRects.reserve(frameDamage.rects.size());
+            for (const auto& r : frameDamage.rects) {
+                const int rw = std::min(r.x + r.w, copyW) - r.x;
+                const int rh = std::min(r.y + r.h, copyH) - r.y;
+                if (rw > 0 && rh > 0) {
+                    flushRects.push_back(Region::Rect{ r.x, r.y, (uint32_t)rw, (uint32_t)rh });
+                }
+            }
+            if (flushRects.empty()) {
+                flushRects.push_back(Region::Rect{ 0, 0, (uint32_t)copyW, (uint32_t)copyH });
+            }
+            Region region{ flushRects.data(), (int32_t)flushRects.size() };
             const int flushRc = OH_NativeWindow_NativeWindowFlushBuffer(window, wndBuf, -1, region);
+            frameDamage.Clear();
             if (flushRc != 0) {
                 HilogPrint("VNC: RenderWorker FlushBuffer rc=" + std::to_string(flushRc) + ", drop surface");
                 cleanupWindow();
@@ -4890,6 +7143,7 @@ static void VncRenderWorker(VncSession* s)
     }
 
     cleanupWindow();
+    sched_unregister_self();
     s->render_running.store(false);
 }
 #endif
@@ -4915,6 +7169,44 @@ static napi_value VncCreate(napi_env env, napi_callback_info info) {
     napi_value out; napi_create_int32(env, id, &out); return out;
 }
 
+// 生产者：发布帧环的 back（脏区 d），唤醒 render 线程，并按需生产 ArkTS PixelMap 用的 RGBA 帧。
+// 调用方需保证同一 session 只有一个生产者线程（VNC worker 或 QEMU 主循环）。
+static void VncPublishFrame(VncSession* s, VncFrameRing& ring, const VncDamage& fd)
+{
+    const int published = ring.Publish(fd);
+#if defined(__OHOS__)
+    // 通知 render 线程取最新帧（NativeWindow 的 create/flush 必须在同一线程内完成）
+    s->frame_dirty.store(true);
+    s->render_cv.notify_one();
+#endif
+    if (!s->rgba_enabled.load(std::memory_order_relaxed)) return;
+
+    // ArkTS PixelMap 路径：只转换脏区到 RGBA 环的 back，再发布
+    std::shared_ptr<VncFrameRing> rgba = std::atomic_load(&s->rgba);
+    VncDamage d = fd;
+    if (!rgba || rgba->w != ring.w || rgba->h != ring.h) {
+        try {
+            rgba = std::make_shared<VncFrameRing>(ring.w, ring.h);
+        } catch (...) {
+            rgba.reset();
+        }
+        std::atomic_store(&s->rgba, rgba);
+        d.AddFull(ring.w, ring.h);
+    }
+    if (rgba) {
+        const size_t row = (size_t)ring.w * 4;
+        const uint8_t* src = ring.pixels[published].data();
+        uint8_t* dst = rgba->Back();
+        for (const auto& r : d.rects) {
+            for (int yy = r.y; yy < r.y + r.h; yy++) {
+                const size_t off = (size_t)yy * row + (size_t)r.x * 4;
+                VncBgraToRgba(src + off, dst + off, (size_t)r.w);
+            }
+        }
+        (void)rgba->Publish(d);
+    }
+}
+
 #ifdef LIBVNC_HAVE_CLIENT
 static rfbBool VncMallocFB(rfbClient* cl)
 {
@@ -4929,66 +7221,145 @@ static rfbBool VncMallocFB(rfbClient* cl)
 
     const int w = cl->width;
     const int h = cl->height;
-    const size_t bytes = (size_t)w * (size_t)h * 4;
-    if (cl->frameBuffer) free(cl->frameBuffer);
-    cl->frameBuffer = (uint8_t*)malloc(bytes);
-    if (!cl->frameBuffer) return false;
+    if (w <= 0 || h <= 0) return false;
 
     // 通过 clientData 直接拿到 session（避免全局 map 扫描 & 线程竞争）
     VncSession* s = reinterpret_cast<VncSession*>(rfbClientGetClientData(cl, &g_vnc_clientdata_tag));
+    if (!s) return false;
+
+    // 帧缓冲由 session 的三缓冲环持有：libvncclient 直接解码进 back buffer。
+    // 旧环（如果 render 线程仍在读）随最后一个 shared_ptr 释放，绝不能 free(cl->frameBuffer)。
+    std::shared_ptr<VncFrameRing> ring;
+    try {
+        ring = std::make_shared<VncFrameRing>(w, h);
+    } catch (...) {
+        cl->frameBuffer = nullptr;
+        return false;
+    }
+    cl->frameBuffer = ring->Back();
+    std::atomic_store(&s->ring, ring);
+    return true;
+}
+
+// 释放 rfbClient：frameBuffer 属于帧环，先摘掉避免被 libvncclient 释放
+static void VncClientCleanup(rfbClient* cl)
+{
+    if (!cl) return;
+    cl->frameBuffer = nullptr;
+    rfbClientCleanup(cl);
+}
+
+static void VncGotUpdate(rfbClient* cl, int x, int y, int w, int h)
+{
+    if (!cl || !cl->frameBuffer) return;
+    VncSession* s = reinterpret_cast<VncSession*>(rfbClientGetClientData(cl, &g_vnc_clientdata_tag));
+    if (!s) return;
+    s->fbu_damage.Add(x, y, w, h, cl->width, cl->height);
+    s->fbu_pending = true;
+    s->fbu_rects++;
+    s->fbu_pixels += (uint64_t)std::max(0, w) * (uint64_t)std::max(0, h);
+}
+
+// CopyRect：在当前解码缓冲内搬移（支持重叠），并单独计数
+static void VncGotCopyRect(rfbClient* cl, int src_x, int src_y, int w, int h, int dest_x, int dest_y)
+{
+    if (!cl || !cl->frameBuffer) return;
+    VncSession* s = reinterpret_cast<VncSession*>(rfbClientGetClientData(cl, &g_vnc_clientdata_tag));
+    const auto t0 = std::chrono::steady_clock::now();
+    const int fbW = cl->width;
+    const int fbH = cl->height;
+    if (w <= 0 || h <= 0 || src_x < 0 || src_y < 0 || dest_x < 0 || dest_y < 0 ||
+        src_x + w > fbW || dest_x + w > fbW || src_y + h > fbH || dest_y + h > fbH) {
+        return;
+    }
+    const size_t row = (size_t)fbW * 4;
+    const size_t span = (size_t)w * 4;
+    uint8_t* fb = reinterpret_cast<uint8_t*>(cl->frameBuffer);
+    if (dest_y > src_y) {
+        for (int yy = h - 1; yy >= 0; yy--) {
+            std::memmove(fb + (size_t)(dest_y + yy) * row + (size_t)dest_x * 4,
+                fb + (size_t)(src_y + yy) * row + (size_t)src_x * 4, span);
+        }
+    } else {
+        for (int yy = 0; yy < h; yy++) {
+            std::memmove(fb + (size_t)(dest_y + yy) * row + (size_t)dest_x * 4,
+                fb + (size_t)(src_y + yy) * row + (size_t)src_x * 4, span);
+        }
+    }
     if (s) {
-        std::lock_guard<std::mutex> lk(s->mtx);
-        s->width = w;
-        s->height = h;
-        s->frame.resize(bytes);
+        s->fbu_copy_rects++;
+        s->fbu_copy_pixels += (uint64_t)w * (uint64_t)h;
+        s->fbu_copy_us += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
+}
+
+// 整条 FramebufferUpdate 消息处理完：把并集脏区作为一帧提交（一次拷贝、一次唤醒、一次增量请求）
+static void VncFinishedUpdate(rfbClient* cl)
+{
+    if (!cl) return;
+    VncSession* s = reinterpret_cast<VncSession*>(rfbClientGetClientData(cl, &g_vnc_clientdata_tag));
+    if (!s) return;
+    s->fbu_pending = false;
+
+    std::shared_ptr<VncFrameRing> ring = std::atomic_load(&s->ring);
+    if (ring && cl->frameBuffer == ring->Back() && !s->fbu_damage.Empty()) {
+        // 发布 back 并换入下一个 buffer 继续解码（libvncclient 后续直接写新的 back）
+        VncPublishFrame(s, *ring, s->fbu_damage);
+        cl->frameBuffer = ring->Back();
     }
-    return true;
+    s->fbu_damage.Clear();
+
+    // 关键：继续请求下一帧（增量更新）。否则很多 VNC 服务端不会主动推送后续帧，
+    // Viewer 会一直停在 "Display Output Is Not Active"。
+    // 每条 FramebufferUpdate 消息只请求一次（而不是每个矩形一次）。
+    SendFramebufferUpdateRequest(cl, 0, 0, cl->width, cl->height, TRUE);
 }
 
-static void VncGotUpdate(rfbClient* cl, int x, int y, int w, int h)
+// 内核累计接收字节数（TCP_INFO）；libvncclient 自己缓冲读取，没有公开的字节计数
+static uint64_t VncSocketBytesReceived(rfbClient* cl)
 {
-    (void)x; (void)y; (void)w; (void)h; // unused parameters
-    if (!cl || !cl->frameBuffer) return;
-    VncSession* s = reinterpret_cast<VncSession*>(rfbClientGetClientData(cl, &g_vnc_clientdata_tag));
-    if (!s) return;
-            // 把 BGRA 帧投递给 render 线程（NativeWindow 的 create/flush 必须在同一线程内完成）
-#if defined(__OHOS__)
-            {
-                std::lock_guard<std::mutex> lk2(s->frame_mtx);
-                const int ww = cl->width;
-                const int hh = cl->height;
-                const size_t bytes = (size_t)ww * (size_t)hh * 4;
-                s->fb_w = ww;
-                s->fb_h = hh;
-                s->fb_bgra.resize(bytes);
-                std::memcpy(s->fb_bgra.data(), cl->frameBuffer, bytes);
-                s->frame_dirty.store(true);
-            }
-            s->render_cv.notify_one();
+#if !defined(__APPLE__)
+    struct tcp_info ti {};
+    socklen_t len = sizeof(ti);
+    if (cl && cl->sock >= 0 && getsockopt(cl->sock, IPPROTO_TCP, TCP_INFO, &ti, &len) == 0 &&
+        len >= offsetof(struct tcp_info, tcpi_bytes_received) + sizeof(ti.tcpi_bytes_received)) {
+        return ti.tcpi_bytes_received;
+    }
 #else
-            std::lock_guard<std::mutex> lk(s->mtx);
-            if (s->width != cl->width || s->height != cl->height) {
-                s->width = cl->width; s->height = cl->height; s->frame.resize((size_t)s->width * s->height * 4);
-            }
-            const int ww = cl->width;
-            const int hh = cl->height;
-            const size_t bytes = (size_t)ww * (size_t)hh * 4;
-            if (s->frame.size() >= bytes) {
-                const uint8_t* src = reinterpret_cast<const uint8_t*>(cl->frameBuffer);
-                uint8_t* dst = s->frame.data();
-                for (size_t i = 0; i < bytes; i += 4) {
-                    dst[i + 0] = src[i + 2];
-                    dst[i + 1] = src[i + 1];
-                    dst[i + 2] = src[i + 0];
-                    dst[i + 3] = 255;
-                }
-                s->seq++;
-                s->dirty = true;
-            }
+    (void)cl;
 #endif
-            // 关键：继续请求下一帧（增量更新）。否则很多 VNC 服务端不会主动推送后续帧，
-            // Viewer 会一直停在 "Display Output Is Not Active"。
-            SendFramebufferUpdateRequest(cl, 0, 0, cl->width, cl->height, TRUE);
+    return 0;
+}
+
+// 一条服务端消息处理完：CopyRect 单独记账，其余矩形的字节/耗时归到主编码
+static void VncAccountMessage(VncSession* s, uint64_t bytes, uint64_t us)
+{
+    s->messages.fetch_add(1, std::memory_order_relaxed);
+    s->bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+    if (s->fbu_copy_rects > 0) {
+        VncEncodingStats& cr = s->enc_stats[kVncEncodingCopyRect];
+        cr.rects.fetch_add(s->fbu_copy_rects, std::memory_order_relaxed);
+        cr.pixels.fetch_add(s->fbu_copy_pixels, std::memory_order_relaxed);
+        cr.decode_us.fetch_add(s->fbu_copy_us, std::memory_order_relaxed);
+        // CopyRect 每个矩形 12 字节头 + 4 字节源坐标
+        cr.bytes.fetch_add(s->fbu_copy_rects * 16, std::memory_order_relaxed);
+    }
+    const uint64_t rects = s->fbu_rects > s->fbu_copy_rects ? s->fbu_rects - s->fbu_copy_rects : 0;
+    if (rects > 0) {
+        VncEncodingStats& st = s->enc_stats[s->primary_encoding];
+        st.rects.fetch_add(rects, std::memory_order_relaxed);
+        st.pixels.fetch_add(s->fbu_pixels > s->fbu_copy_pixels ? s->fbu_pixels - s->fbu_copy_pixels : 0,
+            std::memory_order_relaxed);
+        const uint64_t copyBytes = s->fbu_copy_rects * 16;
+        st.bytes.fetch_add(bytes > copyBytes ? bytes - copyBytes : 0, std::memory_order_relaxed);
+        st.decode_us.fetch_add(us > s->fbu_copy_us ? us - s->fbu_copy_us : 0, std::memory_order_relaxed);
+    }
+    s->fbu_rects = 0;
+    s->fbu_pixels = 0;
+    s->fbu_copy_rects = 0;
+    s->fbu_copy_pixels = 0;
+    s->fbu_copy_us = 0;
 }
 
 static void VncWorker(VncSession* s)
@@ -5002,19 +7373,39 @@ static void VncWorker(VncSession* s)
     return;
 #endif
     s->running.store(true);
+    uint64_t lastTcpBytes = VncSocketBytesReceived(cl);
     while (s->running.load()) {
         int ret = WaitForMessage(cl, 100000); // 100ms
         if (ret < 0) break;
         if (ret > 0) {
+            const auto t0 = std::chrono::steady_clock::now();
             if (!HandleRFBServerMessage(cl)) {
                 break;
             }
+            // 兜底：若 libvncclient 未回调 FinishedFrameBufferUpdate，则按“每条消息一帧”在这里提交
+            if (s->fbu_pending) {
+                VncFinishedUpdate(cl);
+            }
+            const uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+            const uint64_t tcpBytes = VncSocketBytesReceived(cl);
+            const uint64_t bytes = (tcpBytes >= lastTcpBytes) ? (tcpBytes - lastTcpBytes) : 0;
+            lastTcpBytes = tcpBytes;
+            VncAccountMessage(s, bytes, us);
         }
     }
     s->running.store(false);
 }
 #endif
 
+// VncConnect 的可选参数（ArkTS: { profile?: 'auto'|'loopback'|'remote', encodings?: string, quality?: number, compress?: number }）
+struct VncConnectOptions {
+    std::string profile = "auto";
+    std::string encodings;  // 为空则按 profile 选择
+    int quality = -1;       // 0-9，-1 表示按 profile
+    int compress = -1;      // 0-9，-1 表示按 profile
+};
+
 // 断开并清理（后台线程调用）：保证不阻塞 UI 线程
 #ifdef LIBVNC_HAVE_CLIENT
 static void VncStopAndCleanupAsync(VncSession* s)
@@ -5050,8 +7441,17 @@ static void VncStopAndCleanupAsync(VncSession* s)
     if (tRender.joinable()) tRender.join();
 #endif
     if (oldClient) {
-        rfbClientCleanup(oldClient);
-    }
+        VncClientCleanup(oldClient);
+    }
+    std::atomic_store(&s->ring, std::shared_ptr<VncFrameRing>());
+    // worker 已退出，可安全重置其私有的消息级脏区
+    s->fbu_damage.Clear();
+    s->fbu_pending = false;
+    s->fbu_rects = 0;
+    s->fbu_pixels = 0;
+    s->fbu_copy_rects = 0;
+    s->fbu_copy_pixels = 0;
+    s->fbu_copy_us = 0;
 
 #if defined(__OHOS__)
     {
@@ -5061,26 +7461,104 @@ static void VncStopAndCleanupAsync(VncSession* s)
         s->pending_surface_h = 0;
         s->surface_dirty.store(false);
     }
-    {
-        std::lock_guard<std::mutex> lk2(s->frame_mtx);
-        s->fb_w = 0;
-        s->fb_h = 0;
-        s->fb_bgra.clear();
-        s->frame_dirty.store(false);
+    s->frame_dirty.store(false);
+#endif
+    std::atomic_store(&s->rgba, std::shared_ptr<VncFrameRing>());
+}
+
+static bool VncIsLoopbackHost(const std::string& host)
+{
+    return host == "localhost" || host == "::1" || host.rfind("127.", 0) == 0;
+}
+
+// 规范化/校验编码列表：分隔符统一为空格（libvncclient 只认空格，逗号会被当成一个未知编码），
+// 过滤掉未编进库的编码，去重，并保证以 raw 兜底。
+static std::string VncNormalizeEncodings(const std::string& requested)
+{
+    std::vector<std::string> out;
+    std::string token;
+    auto flush = [&]() {
+        if (token.empty()) return;
+        const int idx = VncEncodingIndex(token);
+        if (idx < 0 || !kVncEncodings[idx].supported) {
+            HilogPrint("VNC: dropping unsupported encoding '" + token + "'");
+        } else if (std::find(out.begin(), out.end(), token) == out.end()) {
+            out.push_back(token);
+        }
+        token.clear();
+    };
+    for (char c : requested) {
+        if (c == ' ' || c == ',' || c == ';' || c == '\t') {
+            flush();
+        } else {
+            token.push_back((char)std::tolower((unsigned char)c));
+        }
+    }
+    flush();
+    if (std::find(out.begin(), out.end(), "raw") == out.end()) out.push_back("raw");
+
+    std::string joined;
+    for (const auto& e : out) {
+        if (!joined.empty()) joined.push_back(' ');
+        joined += e;
+    }
+    return joined;
+}
+
+// 按 profile 选择编码策略：
+// - loopback：CPU 才是瓶颈，用解码最便宜的 raw + CopyRect（拖动/滚动只传坐标）
+// - remote：带宽是瓶颈，用 ZRLE/Tight(JPEG) 等压缩编码
+// DesktopSize 伪编码由 canHandleNewFBSize 自动声明。
+static void VncApplyEncodingPolicy(VncSession* s, rfbClient* cl, const std::string& host, const VncConnectOptions& opt)
+{
+    bool loopback = VncIsLoopbackHost(host);
+    if (opt.profile == "loopback") loopback = true;
+    if (opt.profile == "remote") loopback = false;
+
+    std::string requested = opt.encodings;
+    if (requested.empty()) {
+        requested = loopback ? "copyrect raw" : "tight zrle zlib hextile copyrect raw";
+    }
+    s->encodings = VncNormalizeEncodings(requested);
+
+    s->primary_encoding = 0;
+    std::istringstream iss(s->encodings);
+    std::string e;
+    while (iss >> e) {
+        const int idx = VncEncodingIndex(e);
+        if (idx >= 0 && idx != kVncEncodingCopyRect) {
+            s->primary_encoding = idx;
+            break;
+        }
     }
+
+    const int quality = (opt.quality >= 0) ? std::min(opt.quality, 9) : (loopback ? 9 : 6);
+    const int compress = (opt.compress >= 0) ? std::min(opt.compress, 9) : (loopback ? 1 : 6);
+    cl->appData.encodingsString = s->encodings.c_str();
+    cl->appData.qualityLevel = quality;
+    cl->appData.compressLevel = compress;
+#if defined(LIBVNCSERVER_HAVE_LIBJPEG)
+    cl->appData.enableJPEG = loopback ? FALSE : TRUE;
+#else
+    cl->appData.enableJPEG = FALSE;
 #endif
+    HilogPrint(std::string("VNC: encodings='") + s->encodings + "' profile=" + (loopback ? "loopback" : "remote") +
+        " quality=" + std::to_string(quality) + " compress=" + std::to_string(compress));
+}
 
-    {
-        std::lock_guard<std::mutex> lk(s->mtx);
-        s->width = 0;
-        s->height = 0;
-        s->frame.clear();
-        s->seq = 0;
-        s->dirty = false;
+static void VncResetStats(VncSession* s)
+{
+    s->bytes_received.store(0);
+    s->messages.store(0);
+    for (auto& st : s->enc_stats) {
+        st.rects.store(0);
+        st.pixels.store(0);
+        st.bytes.store(0);
+        st.decode_us.store(0);
     }
 }
 
-static void VncConnectAsync(VncSession* s, uint32_t seq, std::string host, int port)
+static void VncConnectAsync(VncSession* s, uint32_t seq, std::string host, int port, VncConnectOptions opt)
 {
     if (!s) return;
 
@@ -5101,26 +7579,24 @@ static void VncConnectAsync(VncSession* s, uint32_t seq, std::string host, int p
     rfbClientSetClientData(cl, &g_vnc_clientdata_tag, s);
     cl->MallocFrameBuffer = VncMallocFB;
     cl->GotFrameBufferUpdate = VncGotUpdate;
+    cl->FinishedFrameBufferUpdate = VncFinishedUpdate;
+    cl->GotCopyRect = VncGotCopyRect;
     cl->canHandleNewFBSize = 1;
     cl->appData.shareDesktop = TRUE;
-    // Some HarmonyOS builds/packaged libvncclient variants may not fully support "tight"
-    // and can log "Unknown encoding 'tight'" during negotiation, causing unstable/blank
-    // rendering. Force a conservative, widely-supported encoding set.
-    //
-    // Note: we've observed libvncclient logging "Unknown encoding '<full string>'" when
-    // a list is supplied, so we keep it to the most compatible baseline first.
-    cl->appData.encodingsString = "raw";
-    HilogPrint(std::string("VNC: forcing encodingsString=") + cl->appData.encodingsString);
+    // 打包的 libvncclient 没有编进 tight（无 libjpeg），且编码列表必须用空格分隔：
+    // 之前 "Unknown encoding '<full string>'" 就是整串被当成一个编码。这里统一校验/规范化。
+    VncResetStats(s);
+    VncApplyEncodingPolicy(s, cl, host, opt);
     cl->serverHost = strdup(host.c_str());
     cl->serverPort = port;
 
     if (!rfbClientConnect(cl)) {
-        rfbClientCleanup(cl);
+        VncClientCleanup(cl);
         s->connecting.store(false);
         return;
     }
     if (!rfbClientInitialise(cl)) {
-        rfbClientCleanup(cl);
+        VncClientCleanup(cl);
         s->connecting.store(false);
         return;
     }
@@ -5129,7 +7605,7 @@ static void VncConnectAsync(VncSession* s, uint32_t seq, std::string host, int p
     SendFramebufferUpdateRequest(cl, 0, 0, cl->width, cl->height, FALSE);
 
     if (seq != s->connect_seq.load()) {
-        rfbClientCleanup(cl);
+        VncClientCleanup(cl);
         s->connecting.store(false);
         return;
     }
@@ -5145,14 +7621,14 @@ static void VncConnectAsync(VncSession* s, uint32_t seq, std::string host, int p
             cl = nullptr; // ownership moved to session
         }
     }
-    if (cl) rfbClientCleanup(cl);
+    if (cl) VncClientCleanup(cl);
 
     s->connecting.store(false);
 }
 #endif
 
 static napi_value VncConnect(napi_env env, napi_callback_info info) {
-    size_t argc = 3; napi_value argv[3];
+    size_t argc = 4; napi_value argv[4];
     napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
     napi_value out; napi_get_boolean(env, false, &out);
     if (argc < 3) return out;
@@ -5160,6 +7636,29 @@ static napi_value VncConnect(napi_env env, napi_callback_info info) {
     std::string host; if (!NapiGetStringUtf8(env, argv[1], host)) return out;
     int32_t port = 0; napi_get_value_int32(env, argv[2], &port);
 
+    VncConnectOptions opt;
+    napi_valuetype optType = napi_undefined;
+    if (argc >= 4 && napi_typeof(env, argv[3], &optType) == napi_ok && optType == napi_object) {
+        napi_value v;
+        napi_valuetype t = napi_undefined;
+        if (napi_get_named_property(env, argv[3], "profile", &v) == napi_ok &&
+            napi_typeof(env, v, &t) == napi_ok && t == napi_string) {
+            NapiGetStringUtf8(env, v, opt.profile);
+        }
+        if (napi_get_named_property(env, argv[3], "encodings", &v) == napi_ok &&
+            napi_typeof(env, v, &t) == napi_ok && t == napi_string) {
+            NapiGetStringUtf8(env, v, opt.encodings);
+        }
+        if (napi_get_named_property(env, argv[3], "quality", &v) == napi_ok &&
+            napi_typeof(env, v, &t) == napi_ok && t == napi_number) {
+            napi_get_value_int32(env, v, &opt.quality);
+        }
+        if (napi_get_named_property(env, argv[3], "compress", &v) == napi_ok &&
+            napi_typeof(env, v, &t) == napi_ok && t == napi_number) {
+            napi_get_value_int32(env, v, &opt.compress);
+        }
+    }
+
     VncSession* s = nullptr; // unused placeholder
     {
         std::lock_guard<std::mutex> lock(g_vnc_mutex);
@@ -5189,14 +7688,14 @@ static napi_value VncConnect(napi_env env, napi_callback_info info) {
     const uint32_t seq = s->connect_seq.fetch_add(1) + 1;
     HilogPrint("VNC: async connect requested id=" + std::to_string(id) + " " + host + ":" + std::to_string(port));
     try {
-        std::thread([s, seq, host, port]() mutable {
-            VncConnectAsync(s, seq, std::move(host), port);
+        std::thread([s, seq, host, port, opt]() mutable {
+            VncConnectAsync(s, seq, std::move(host), port, std::move(opt));
         }).detach();
     } catch (...) {
         s->connecting.store(false);
     }
 #else
-    (void)host; (void)port;
+    (void)host; (void)port; (void)opt;
     // Client lib not available
 #endif
     return out;
@@ -5332,34 +7831,97 @@ static napi_value VncClearSurface(napi_env env, napi_callback_info info) {
     return out;
 }
 
+// external ArrayBuffer 的 finalize：释放对 RGBA 环的引用（ArrayBuffer 直接指向环内存）
+static void VncFrameRingFinalize(napi_env env, void* data, void* hint)
+{
+    (void)env;
+    (void)data;
+    delete reinterpret_cast<std::shared_ptr<VncFrameRing>*>(hint);
+}
+
+// 取 RGBA 环某个 slot 对应的常驻 ArrayBuffer（每个环每个 slot 只创建一次，之后复用同一对象）
+static napi_value VncGetSlotBuffer(napi_env env, VncSession* s, const std::shared_ptr<VncFrameRing>& rgba, int slot)
+{
+    if (s->js_ring != rgba || s->js_env != env) {
+        for (auto& ref : s->js_pixels) {
+            if (ref && s->js_env) napi_delete_reference(s->js_env, ref);
+            ref = nullptr;
+        }
+        s->js_ring = rgba;
+        s->js_env = env;
+    }
+    napi_value ab = nullptr;
+    if (s->js_pixels[slot] && napi_get_reference_value(env, s->js_pixels[slot], &ab) == napi_ok && ab) {
+        return ab;
+    }
+    auto* hold = new std::shared_ptr<VncFrameRing>(rgba);
+    std::vector<uint8_t>& px = rgba->pixels[slot];
+    if (napi_create_external_arraybuffer(env, px.data(), px.size(), VncFrameRingFinalize, hold, &ab) != napi_ok) {
+        delete hold;
+        return nullptr;
+    }
+    napi_create_reference(env, ab, 1, &s->js_pixels[slot]);
+    return ab;
+}
+
+// 返回 { width, height, seq, pixels, dirtyRects } 或 null（无新帧）。
+// pixels 是常驻的 external ArrayBuffer（RGBA8888），在下一次 vncGetFrame 调用前保持不变；
+// dirtyRects 为相对上一次返回帧的脏区 [x, y, w, h, ...]。全程不与 VNC worker 争锁、不分配像素内存。
 static napi_value VncGetFrame(napi_env env, napi_callback_info info) {
     size_t argc = 1; napi_value argv[1];
     napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
     napi_value outNull; napi_get_null(env, &outNull);
     if (argc < 1) return outNull;
     int32_t id = 0; napi_get_value_int32(env, argv[0], &id);
-    std::lock_guard<std::mutex> lock(g_vnc_mutex);
-    auto it = g_vnc_sessions.find(id);
-    if (it == g_vnc_sessions.end()) return outNull;
-    auto& s = it->second;
-    std::lock_guard<std::mutex> lk(s->mtx);
-    if (s->width <= 0 || s->height <= 0 || s->frame.empty()) return outNull;
+    VncSession* s = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_vnc_mutex);
+        auto it = g_vnc_sessions.find(id);
+        if (it == g_vnc_sessions.end()) return outNull;
+        s = it->second.get();
+    }
+    if (!s) return outNull;
+
+#ifdef LIBVNC_HAVE_CLIENT
+    if (!s->rgba_enabled.exchange(true)) {
+        // 首次启用 PixelMap 路径：请求一次全量帧，让 worker 立即生产 RGBA 帧
+        std::lock_guard<std::mutex> lk(s->lifecycle_mtx);
+        if (s->client) {
+            SendFramebufferUpdateRequest(s->client, 0, 0, s->client->width, s->client->height, FALSE);
+        }
+    }
+#endif
+    std::shared_ptr<VncFrameRing> rgba = std::atomic_load(&s->rgba);
+    if (!rgba) return outNull;
     // 没有新帧就返回 null，避免 ArkTS 侧空转渲染
-    if (!s->dirty) return outNull;
-    s->dirty = false;
+    VncDamage damage;
+    if (s->js_ring != rgba) damage.AddFull(rgba->w, rgba->h);
+    if (!rgba->AcquireLatest(damage)) return outNull;
+    const int slot = rgba->front;
+
+    napi_value ab = VncGetSlotBuffer(env, s, rgba, slot);
+    if (!ab) return outNull;
 
     napi_value obj; napi_create_object(env, &obj);
-    napi_value w, h; napi_create_int32(env, s->width, &w); napi_create_int32(env, s->height, &h);
+    napi_value w, h; napi_create_int32(env, rgba->w, &w); napi_create_int32(env, rgba->h, &h);
     napi_set_named_property(env, obj, "width", w);
     napi_set_named_property(env, obj, "height", h);
-    napi_value seq; napi_create_uint32(env, s->seq, &seq);
+    napi_value seq; napi_create_uint32(env, rgba->seq[slot], &seq);
     napi_set_named_property(env, obj, "seq", seq);
-
-    void* data = nullptr; size_t len = s->frame.size();
-    napi_value ab;
-    napi_create_arraybuffer(env, len, &data, &ab);
-    if (data && len) std::memcpy(data, s->frame.data(), len);
     napi_set_named_property(env, obj, "pixels", ab);
+
+    napi_value rects;
+    napi_create_array_with_length(env, damage.rects.size() * 4, &rects);
+    uint32_t idx = 0;
+    for (const auto& r : damage.rects) {
+        const int32_t vals[4] = { r.x, r.y, r.w, r.h };
+        for (int32_t v : vals) {
+            napi_value nv;
+            napi_create_int32(env, v, &nv);
+            napi_set_element(env, rects, idx++, nv);
+        }
+    }
+    napi_set_named_property(env, obj, "dirtyRects", rects);
     return obj;
 }
 // --------------------------------------------------------------------------------------------
@@ -5406,16 +7968,20 @@ static napi_value VncGetInfo(napi_env env, napi_callback_info info) {
     }
 #endif
 #if defined(__OHOS__)
-    {
-        std::lock_guard<std::mutex> lk(s->frame_mtx);
-        if (w <= 0) w = s->fb_w;
-        if (h <= 0) h = s->fb_h;
+    if (w <= 0 || h <= 0) {
+        std::shared_ptr<VncFrameRing> ring = std::atomic_load(&s->ring);
+        if (ring) {
+            w = ring->w;
+            h = ring->h;
+        }
     }
 #else
     {
-        std::lock_guard<std::mutex> lk(s->mtx);
-        w = s->width;
-        h = s->height;
+        std::shared_ptr<VncFrameRing> ring = std::atomic_load(&s->ring);
+        if (ring) {
+            w = ring->w;
+            h = ring->h;
+        }
     }
 #endif
 
@@ -5436,6 +8002,338 @@ static napi_value VncGetInfo(napi_env env, napi_callback_info info) {
     return obj;
 }
 
+// 返回 { encodings, bytesReceived, messages, perEncoding: [{ name, rects, pixels, bytes, decodeUs }] }
+static napi_value VncGetStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value outNull; napi_get_null(env, &outNull);
+    if (argc < 1) return outNull;
+    int32_t id = 0;
+    napi_get_value_int32(env, argv[0], &id);
+
+#ifdef LIBVNC_HAVE_CLIENT
+    VncSession* s = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_vnc_mutex);
+        auto it = g_vnc_sessions.find(id);
+        if (it == g_vnc_sessions.end()) return outNull;
+        s = it->second.get();
+    }
+    if (!s) return outNull;
+
+    napi_value obj;
+    napi_create_object(env, &obj);
+    std::string encodings;
+    {
+        std::lock_guard<std::mutex> lk(s->lifecycle_mtx);
+        if (s->client) encodings = s->encodings;
+    }
+    napi_value v;
+    napi_create_string_utf8(env, encodings.c_str(), encodings.size(), &v);
+    napi_set_named_property(env, obj, "encodings", v);
+    napi_create_int64(env, (int64_t)s->bytes_received.load(), &v);
+    napi_set_named_property(env, obj, "bytesReceived", v);
+    napi_create_int64(env, (int64_t)s->messages.load(), &v);
+    napi_set_named_property(env, obj, "messages", v);
+
+    napi_value arr;
+    napi_create_array(env, &arr);
+    uint32_t n = 0;
+    for (int i = 0; i < kVncEncodingCount; i++) {
+        const VncEncodingStats& st = s->enc_stats[i];
+        if (st.rects.load() == 0) continue;
+        napi_value e;
+        napi_create_object(env, &e);
+        napi_create_string_utf8(env, kVncEncodings[i].name, NAPI_AUTO_LENGTH, &v);
+        napi_set_named_property(env, e, "name", v);
+        napi_create_int64(env, (int64_t)st.rects.load(), &v);
+        napi_set_named_property(env, e, "rects", v);
+        napi_create_int64(env, (int64_t)st.pixels.load(), &v);
+        napi_set_named_property(env, e, "pixels", v);
+        napi_create_int64(env, (int64_t)st.bytes.load(), &v);
+        napi_set_named_property(env, e, "bytes", v);
+        napi_create_int64(env, (int64_t)st.decode_us.load(), &v);
+        napi_set_named_property(env, e, "decodeUs", v);
+        napi_set_element(env, arr, n++, e);
+    }
+    napi_set_named_property(env, obj, "perEncoding", arr);
+    return obj;
+#else
+    (void)id;
+    return outNull;
+#endif
+}
+
+// ----------------------------- In-process display bridge (QEMU -> XComponent) -----------------------------
+// QEMU 以 libqemu_full.so 形式运行在本进程内：补丁 0003 的 aether-xcomponent 显示后端把
+// dpy_gfx_switch/dpy_gfx_update/dpy_refresh 直接转给这里，省掉 VNC 编码 + 回环 TCP + libvncclient 解码。
+// 复用 VncSession 的帧环 / render 线程 / vncGetFrame：ArkTS 侧 vncCreate + vncSetSurface 后调用 displayAttach(id)。
+// 工作进程 VM（displayAttach(id, vmName)）：同样的回调由 vm_worker 读取线程驱动，像素来自共享 memfd surface。
+
+// 与补丁 0003 中的 AetherDisplaySink 保持 ABI 一致（版本号不同则 core 拒绝安装）
+struct QemuDisplaySink {
+    void* opaque;
+    void (*gfx_switch)(void* opaque, const void* data, int width, int height, int stride, uint32_t format);
+    void (*gfx_update)(void* opaque, int x, int y, int w, int h);
+    void (*refresh)(void* opaque);
+};
+using qemu_hmos_display_set_sink_fn = int (*)(const QemuDisplaySink* sink, uint32_t version);
+static constexpr uint32_t kQemuDisplaySinkVersion = 1;
+// pixman 格式码：内存序均为 B,G,R,A/X，与 NativeWindow BGRA_8888 / 帧环格式一致
+static constexpr uint32_t kPixmanX8R8G8B8 = 0x20020888;
+static constexpr uint32_t kPixmanA8R8G8B8 = 0x20028888;
+
+struct DisplayBridge {
+    VncSession* s = nullptr;     // session 从不删除，指针长期有效
+    std::string vmName;          // 工作进程 VM；为空表示进程内 QEMU
+    void* core_handle = nullptr; // 安装 sink 时的 core so；换库后旧 sink 随旧 QEMU 一起失效
+    qemu_hmos_display_set_sink_fn set_sink = nullptr;
+    // 以下只在 QEMU 主循环线程（sink 回调）/ 工作进程读取线程（持 g_display_mutex）中访问
+    const uint8_t* src = nullptr; // DisplaySurface 像素，下一次 gfx_switch 前有效
+    int stride = 0;
+    std::shared_ptr<VncFrameRing> ring;
+    VncDamage damage;
+};
+
+static std::mutex g_display_mutex;
+// key：工作进程 VM 名；进程内 QEMU 只有一份，key 为空
+static std::map<std::string, std::unique_ptr<DisplayBridge>> g_display_bridges;
+
+static void DisplayBridgeSwitch(void* opaque, const void* data, int width, int height, int stride, uint32_t format)
+{
+    DisplayBridge* b = static_cast<DisplayBridge*>(opaque);
+    b->damage.Clear();
+    const bool ok = data && width > 0 && height > 0 && stride >= width * 4 &&
+        (format == kPixmanX8R8G8B8 || format == kPixmanA8R8G8B8);
+    if (!ok) {
+        if (data) {
+            HilogPrint("DISPLAY: unsupported surface format=" + std::to_string(format) +
+                " size=" + std::to_string(width) + "x" + std::to_string(height));
+        }
+        b->src = nullptr;
+        b->stride = 0;
+        b->ring.reset();
+        std::atomic_store(&b->s->ring, std::shared_ptr<VncFrameRing>());
+        return;
+    }
+    b->src = static_cast<const uint8_t*>(data);
+    b->stride = stride;
+    if (!b->ring || b->ring->w != width || b->ring->h != height) {
+        try {
+            b->ring = std::make_shared<VncFrameRing>(width, height);
+        } catch (...) {
+            b->ring.reset();
+        }
+        std::atomic_store(&b->s->ring, b->ring);
+        HilogPrint("DISPLAY: surface " + std::to_string(width) + "x" + std::to_string(height));
+    }
+}
+
+static void DisplayBridgeUpdate(void* opaque, int x, int y, int w, int h)
+{
+    DisplayBridge* b = static_cast<DisplayBridge*>(opaque);
+    if (!b->ring) return;
+    b->damage.Add(x, y, w, h, b->ring->w, b->ring->h);
+}
+
+// 每个刷新周期一次：把本周期的脏区从 surface 拷进帧环并作为一帧发布（tick 内合并，render 线程只被唤醒一次）
+static void DisplayBridgeRefresh(void* opaque)
+{
+    DisplayBridge* b = static_cast<DisplayBridge*>(opaque);
+    if (!b->ring || !b->src) return;
+    VncFrameRing& ring = *b->ring;
+    // ArkTS 刚开启 PixelMap 路径而画面静止：补一帧全量，让 RGBA 环立即有内容
+    if (b->s->rgba_enabled.load(std::memory_order_relaxed) && !std::atomic_load(&b->s->rgba)) {
+        b->damage.AddFull(ring.w, ring.h);
+    }
+    if (b->damage.Empty()) return;
+
+    const size_t row = (size_t)ring.w * 4;
+    uint8_t* dst = ring.Back();
+    for (const auto& r : b->damage.rects) {
+        const size_t span = (size_t)r.w * 4;
+        for (int yy = r.y; yy < r.y + r.h; yy++) {
+            std::memcpy(dst + (size_t)yy * row + (size_t)r.x * 4,
+                b->src + (size_t)yy * (size_t)b->stride + (size_t)r.x * 4, span);
+        }
+    }
+    VncPublishFrame(b->s, ring, b->damage);
+    b->damage.Clear();
+}
+
+// 需持有 g_display_mutex。卸下 sink 后 core 保证不会再有回调，bridge 可直接释放；
+// 工作进程的回调也在该锁下执行，同样不会再触及 bridge。
+static void DisplayBridgeDetachLocked(const std::string& key)
+{
+    auto it = g_display_bridges.find(key);
+    if (it == g_display_bridges.end()) return;
+    DisplayBridge* b = it->second.get();
+    if (b->vmName.empty() && b->core_handle == g_qemu_core_handle && b->set_sink) {
+        (void)b->set_sink(nullptr, 0);
+    }
+    std::shared_ptr<VncFrameRing> ring = std::atomic_load(&b->s->ring);
+    if (ring && ring == b->ring) {
+        std::atomic_store(&b->s->ring, std::shared_ptr<VncFrameRing>());
+    }
+    HilogPrint("DISPLAY: detached from session id=" + std::to_string(b->s->id) +
+        (b->vmName.empty() ? "" : " (worker VM '" + b->vmName + "')"));
+    g_display_bridges.erase(it);
+}
+
+// 帧环只允许一个生产者：session 换绑前先拆掉它原来的 bridge
+static void DisplayBridgeDetachSessionLocked(const VncSession* s)
+{
+    std::vector<std::string> keys;
+    for (const auto& kv : g_display_bridges) {
+        if (kv.second->s == s) keys.push_back(kv.first);
+    }
+    for (const auto& key : keys) DisplayBridgeDetachLocked(key);
+}
+
+static void DisplayBridgeDetachVm(const std::string& vmName)
+{
+    std::lock_guard<std::mutex> lock(g_display_mutex);
+    DisplayBridgeDetachLocked(vmName);
+}
+
+// 工作进程读取线程中执行：surface / 脏区交给该 VM 的 bridge（没有 attach 时丢弃，vm_worker 照常确认）
+static VmWorker::Callbacks VmWorkerCallbacks(const std::string& vmName)
+{
+    VmWorker::Callbacks cb;
+    cb.on_running = [vmName]() {
+        SetVmState(vmName, VmState::Running, "worker qemu_init");
+        // 工作进程的 QEMU 线程此时已创建完毕，从这里按线程名绑核
+        VmRuntime rt;
+        if (vm_runtime_get(vmName, rt) && rt.pid > 0) {
+            sched_apply_qemu_threads(rt.pid, VmProfileIsPowerSaver(vmName));
+        }
+    };
+    cb.on_surface = [vmName](const uint8_t* pixels, int width, int height, int stride, uint32_t format) {
+        std::lock_guard<std::mutex> lock(g_display_mutex);
+        auto it = g_display_bridges.find(vmName);
+        if (it != g_display_bridges.end()) DisplayBridgeSwitch(it->second.get(), pixels, width, height, stride, format);
+    };
+    cb.on_frame = [vmName](const worker_proto::Rect* rects, uint32_t count) {
+        std::lock_guard<std::mutex> lock(g_display_mutex);
+        auto it = g_display_bridges.find(vmName);
+        if (it == g_display_bridges.end()) return;
+        DisplayBridge* b = it->second.get();
+        for (uint32_t i = 0; i < count; i++) DisplayBridgeUpdate(b, rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+        DisplayBridgeRefresh(b);
+    };
+    cb.on_console = [vmName](const char* data, size_t len) {
+        SerialEmitToJs(vmName, data, len);
+    };
+    return cb;
+}
+
+// displayAttach(sessionId, vmName?): 把 QEMU 控制台直接接到该 session（需 QEMU 以 -display aether-xcomponent 启动）
+// vmName 指向工作进程 VM 时接它的共享 surface，否则接进程内 QEMU
+static napi_value DisplayAttach(napi_env env, napi_callback_info info)
+{
+    size_t argc = 2;
+    napi_value argv[2];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    napi_value out;
+    napi_get_boolean(env, false, &out);
+    if (argc < 1) return out;
+    int32_t id = 0;
+    napi_get_value_int32(env, argv[0], &id);
+    std::string vmName;
+    if (argc >= 2) NapiGetStringUtf8(env, argv[1], vmName);
+    std::shared_ptr<VmWorker> worker = vmName.empty() ? nullptr : FindVmWorker(vmName);
+    if (!vmName.empty() && !worker && vmName != vm_runtime_inprocess_vm()) {
+        HilogPrint("DISPLAY: attach failed, VM '" + vmName + "' is not running");
+        return out;
+    }
+
+    VncSession* s = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_vnc_mutex);
+        auto it = g_vnc_sessions.find(id);
+        if (it == g_vnc_sessions.end()) return out;
+        s = it->second.get();
+    }
+    if (!s) return out;
+#ifdef LIBVNC_HAVE_CLIENT
+    {
+        // 帧环只允许一个生产者：已连接 VNC 的 session 不能再接显示桥
+        std::lock_guard<std::mutex> lk(s->lifecycle_mtx);
+        if (s->client || s->connecting.load()) {
+            HilogPrint("DISPLAY: attach rejected, session id=" + std::to_string(id) + " has a VNC client");
+            return out;
+        }
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(g_display_mutex);
+    DisplayBridgeDetachSessionLocked(s);
+    if (worker) {
+        DisplayBridgeDetachLocked(vmName);
+        auto b = std::make_unique<DisplayBridge>();
+        b->s = s;
+        b->vmName = vmName;
+        DisplayBridge* raw = b.get();
+        worker->WithSurface([raw](const uint8_t* pixels, int width, int height, int stride, uint32_t format) {
+            DisplayBridgeSwitch(raw, pixels, width, height, stride, format);
+        });
+        g_display_bridges[vmName] = std::move(b);
+        worker->RequestFullFrame();
+        HilogPrint("DISPLAY: attached to session id=" + std::to_string(id) + " (worker VM '" + vmName + "')");
+        napi_get_boolean(env, true, &out);
+        return out;
+    }
+    DisplayBridgeDetachLocked("");
+    if (!g_qemu_core_handle) {
+        HilogPrint("DISPLAY: attach failed, QEMU core not loaded");
+        return out;
+    }
+    auto setSink = reinterpret_cast<qemu_hmos_display_set_sink_fn>(
+        dlsym(g_qemu_core_handle, "qemu_hmos_display_set_sink"));
+    if (!setSink) {
+        HilogPrint("DISPLAY: attach failed, core has no qemu_hmos_display_set_sink (patch 0003 missing?)");
+        return out;
+    }
+
+    auto b = std::make_unique<DisplayBridge>();
+    b->s = s;
+    b->core_handle = g_qemu_core_handle;
+    b->set_sink = setSink;
+    QemuDisplaySink sink{};
+    sink.opaque = b.get();
+    sink.gfx_switch = DisplayBridgeSwitch;
+    sink.gfx_update = DisplayBridgeUpdate;
+    sink.refresh = DisplayBridgeRefresh;
+    const int rc = setSink(&sink, kQemuDisplaySinkVersion);
+    if (rc != 0) {
+        HilogPrint("DISPLAY: set_sink rc=" + std::to_string(rc));
+        return out;
+    }
+    g_display_bridges[""] = std::move(b);
+    HilogPrint("DISPLAY: attached to session id=" + std::to_string(id));
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
+// displayDetach(vmName?): 不传 vmName 时拆进程内 QEMU 的显示桥
+static napi_value DisplayDetach(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    std::string vmName;
+    if (argc >= 1) NapiGetStringUtf8(env, argv[0], vmName);
+    if (!vmName.empty() && vmName == vm_runtime_inprocess_vm()) vmName.clear();
+    {
+        std::lock_guard<std::mutex> lock(g_display_mutex);
+        DisplayBridgeDetachLocked(vmName);
+    }
+    napi_value out;
+    napi_get_boolean(env, true, &out);
+    return out;
+}
+
 static napi_value VncSendPointer(napi_env env, napi_callback_info info) {
     size_t argc = 4; napi_value argv[4];
     napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
@@ -5689,10 +8587,10 @@ static napi_value EnableSecureBoot(napi_env env, napi_callback_info info) {
     return result;
 }
 
-// 写入 VM 控制台
+// 写入 VM 控制台：writeToVmConsole(data, vmName?)，不传 vmName 时写当前 VM
 static napi_value WriteToVmConsole(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1];
+    size_t argc = 2;
+    napi_value args[2];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
 
     if (argc < 1) {
@@ -5703,8 +8601,26 @@ static napi_value WriteToVmConsole(napi_env env, napi_callback_info info) {
     size_t len;
     napi_get_value_string_utf8(env, args[0], buffer, sizeof(buffer), &len);
 
-    if (g_logCapture) {
-        // 添加换行符如果需要
+    std::string vmName = vm_runtime_inprocess_vm();
+    if (argc >= 2) {
+        NapiGetStringUtf8(env, args[1], vmName);
+    } else if (vmName.empty()) {
+        std::vector<VmRuntime> running = vm_runtime_list();
+        if (running.size() == 1) vmName = running[0].vm_name;
+    }
+    // 进程内串口会话（aether-ring）
+    if (ConsoleSessionWrite(vmName, std::string(buffer, len))) {
+        return nullptr;
+    }
+    // 工作进程 VM：经控制通道写入它的 aether-ring
+    if (std::shared_ptr<VmWorker> worker = FindVmWorker(vmName)) {
+        worker->WriteConsole(buffer, len);
+        return nullptr;
+    }
+
+    // 旧 core 的 TCP 串口 / stdin 管道只属于进程内 VM，别的 VM 的输入不能落到这里
+    const std::string inprocessVm = vm_runtime_inprocess_vm();
+    if (g_logCapture && !inprocessVm.empty() && vmName == inprocessVm) {
         std::string data(buffer, len);
         // 优先写入 TCP 串口（-serial tcp:...），否则回退到 stdin pipe
         bool sent = false;
@@ -5724,31 +8640,107 @@ static napi_value WriteToVmConsole(napi_env env, napi_callback_info info) {
     return nullptr;
 }
 
-// 设置控制台回调
+// 设置控制台回调：setConsoleCallback(callback, vmName?)
+// 传 vmName 只接收该 VM 的输出；不传则接收所有没有专属回调的 VM；callback 不是函数时注销
 static napi_value SetConsoleCallback(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1];
+    size_t argc = 2;
+    napi_value args[2];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
     
     if (argc < 1) return nullptr;
-    
-    napi_value resourceName;
-    napi_create_string_utf8(env, "ConsoleCallback", NAPI_AUTO_LENGTH, &resourceName);
-    
-    // 如果已有回调，先释放
-    if (g_consoleCallback) {
+
+    std::string vmName;
+    if (argc >= 2) {
+        NapiGetStringUtf8(env, args[1], vmName);
+    }
+    napi_valuetype cbType = napi_undefined;
+    napi_typeof(env, args[0], &cbType);
+
+    // 旧 core 的串口桥接只服务进程内 VM：换的是它的回调才需要重连
+    const std::string inprocessVm = vm_runtime_inprocess_vm();
+    const bool touchesSerial = vmName.empty() || vmName == inprocessVm;
+    if (touchesSerial) {
         // 停掉串口桥接（避免旧回调继续收数据）
         SerialStop();
-        napi_release_threadsafe_function(g_consoleCallback, napi_tsfn_abort);
     }
-    
-    napi_create_threadsafe_function(env, args[0], nullptr, resourceName, 0, 1, nullptr, nullptr, nullptr, ConsoleJsCallback, &g_consoleCallback);
-    // 启动串口桥接：自动连接 tcp:127.0.0.1:4321 并把数据推到 JS
-    SerialStart();
+    {
+        std::lock_guard<std::mutex> lk(g_consoleMutex);
+        if (!vmName.empty()) {
+            auto it = g_vmConsoleCallbacks.find(vmName);
+            if (it != g_vmConsoleCallbacks.end()) {
+                napi_release_threadsafe_function(it->second, napi_tsfn_abort);
+                g_vmConsoleCallbacks.erase(it);
+            }
+        } else if (g_consoleCallback) {
+            napi_release_threadsafe_function(g_consoleCallback, napi_tsfn_abort);
+            g_consoleCallback = nullptr;
+        }
+        if (cbType == napi_function) {
+            napi_value resourceName;
+            napi_create_string_utf8(env, "ConsoleCallback", NAPI_AUTO_LENGTH, &resourceName);
+            napi_threadsafe_function tsfn = nullptr;
+            if (napi_create_threadsafe_function(env, args[0], nullptr, resourceName, 0, 1, nullptr, nullptr, nullptr,
+                                                ConsoleJsCallback, &tsfn) == napi_ok) {
+                if (vmName.empty()) {
+                    g_consoleCallback = tsfn;
+                } else {
+                    g_vmConsoleCallbacks[vmName] = tsfn;
+                }
+            }
+        }
+    }
+    // 旧回调上未确认的批次不会再确认
+    ConsoleResetInFlight(vmName);
+    // 旧 core 才需要串口桥接：自动连接 tcp:127.0.0.1:4321 并把数据推到 JS（aether-ring 会话直接推送）
+    if (touchesSerial && g_serial_use_tcp.load() && !inprocessVm.empty() && ConsoleHasListener(inprocessVm)) {
+        SerialStart();
+    }
     
     return nullptr;
 }
 
+// 控制台通道统计：getConsoleStats(vmName?)，不传 vmName 时汇总所有 VM
+static napi_value GetConsoleStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    std::string vmName;
+    if (argc >= 1) {
+        NapiGetStringUtf8(env, args[0], vmName);
+    }
+
+    ConsoleChannel::Stats st;
+    {
+        std::lock_guard<std::mutex> lk(g_consoleChannelsMutex);
+        for (auto& kv : ConsoleChannels()) {
+            if (!vmName.empty() && kv.first != vmName) continue;
+            const ConsoleChannel::Stats cs = kv.second->GetStats();
+            st.bytes_in += cs.bytes_in;
+            st.bytes_out += cs.bytes_out;
+            st.batches += cs.batches;
+            st.dropped_bytes += cs.dropped_bytes;
+            st.buffered += cs.buffered;
+            st.in_flight += cs.in_flight;
+        }
+    }
+    napi_value obj;
+    napi_value v;
+    napi_create_object(env, &obj);
+    napi_create_int64(env, static_cast<int64_t>(st.bytes_in), &v);
+    napi_set_named_property(env, obj, "bytesIn", v);
+    napi_create_int64(env, static_cast<int64_t>(st.bytes_out), &v);
+    napi_set_named_property(env, obj, "bytesOut", v);
+    napi_create_int64(env, static_cast<int64_t>(st.batches), &v);
+    napi_set_named_property(env, obj, "batches", v);
+    napi_create_int64(env, static_cast<int64_t>(st.dropped_bytes), &v);
+    napi_set_named_property(env, obj, "droppedBytes", v);
+    napi_create_int64(env, static_cast<int64_t>(st.buffered), &v);
+    napi_set_named_property(env, obj, "buffered", v);
+    napi_create_uint32(env, st.in_flight, &v);
+    napi_set_named_property(env, obj, "inFlight", v);
+    return obj;
+}
+
 /**
  * 生成 Windows 11 优化的 QEMU 命令参数
  * 参数: vmName (string), memoryMb (number), diskPath (string), isoPath (string)
@@ -5852,6 +8844,7 @@ static napi_value GetModuleInfo(napi_env env, napi_callback_info info) {
 EXTERN_C_START
 // Keep exports stable; ArkTS depends on these names.
 static napi_value Init(napi_env env, napi_value exports) {
+    log_set_tap(VmLogTap);
     HilogPrint("QEMU: ========================================");
     HilogPrint("QEMU: NAPI Init function called!");
     HilogPrint("QEMU: Environment pointer: " + std::to_string(reinterpret_cast<uintptr_t>(env)));
@@ -5863,10 +8856,18 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "version", 0, GetVersion, 0, 0, 0, napi_default, 0 },
         { "enableJit", 0, EnableJit, 0, 0, 0, napi_default, 0 },
         { "kvmSupported", 0, KvmSupported, 0, 0, 0, napi_default, 0 },
+        { "setDeviceInfo", 0, SetDeviceInfo, 0, 0, 0, napi_default, 0 },
+        { "setJitPermission", 0, SetJitPermission, 0, 0, 0, napi_default, 0 },
         { "startVm", 0, StartVm, 0, 0, 0, napi_default, 0 },
         { "stopVm", 0, StopVm, 0, 0, 0, napi_default, 0 },
         { "getVmLogs", 0, GetVmLogs, 0, 0, 0, napi_default, 0 },
         { "getVmStatus", 0, GetVmStatus, 0, 0, 0, napi_default, 0 },
+        { "getVmState", 0, GetVmState, 0, 0, 0, napi_default, 0 },
+        { "getVmLogsSince", 0, GetVmLogsSince, 0, 0, 0, napi_default, 0 },
+        { "setVmLogCallback", 0, SetVmLogCallback, 0, 0, 0, napi_default, 0 },
+        { "clearVmLogCallback", 0, ClearVmLogCallback, 0, 0, 0, napi_default, 0 },
+        { "setVmStateCallback", 0, SetVmStateCallback, 0, 0, 0, napi_default, 0 },
+        { "clearVmStateCallback", 0, ClearVmStateCallback, 0, 0, 0, napi_default, 0 },
         { "checkCoreLib", 0, CheckCoreLib, 0, 0, 0, napi_default, 0 },
         { "getDeviceCapabilities", 0, GetDeviceCapabilities, 0, 0, 0, napi_default, 0 },
         { "getSupportedDevices", 0, GetSupportedDevices, 0, 0, 0, napi_default, 0 },
@@ -5880,12 +8881,23 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "restoreSnapshot", 0, RestoreSnapshot, 0, 0, 0, napi_default, 0 },
         { "listSnapshots", 0, ListSnapshots, 0, 0, 0, napi_default, 0 },
         { "deleteSnapshot", 0, DeleteSnapshot, 0, 0, 0, napi_default, 0 },
+        { "snapshotSave", 0, SnapshotSave, 0, 0, 0, napi_default, 0 },
+        { "snapshotLoad", 0, SnapshotLoad, 0, 0, 0, napi_default, 0 },
+        { "snapshotDelete", 0, SnapshotDelete, 0, 0, 0, napi_default, 0 },
+        { "snapshotList", 0, SnapshotList, 0, 0, 0, napi_default, 0 },
+        { "suspendVm", 0, SuspendVm, 0, 0, 0, napi_default, 0 },
+        { "hasResumeState", 0, HasResumeState, 0, 0, 0, napi_default, 0 },
+        { "discardResumeState", 0, DiscardResumeState, 0, 0, 0, napi_default, 0 },
         { "createRdpClient", 0, CreateRdpClient, 0, 0, 0, napi_default, 0 },
         { "connectRdp", 0, ConnectRdp, 0, 0, 0, napi_default, 0 },
         { "disconnectRdp", 0, DisconnectRdp, 0, 0, 0, napi_default, 0 },
         { "getRdpStatus", 0, GetRdpStatus, 0, 0, 0, napi_default, 0 },
+        { "getRdpCertificate", 0, GetRdpCertificate, 0, 0, 0, napi_default, 0 },
         { "destroyRdpClient", 0, DestroyRdpClient, 0, 0, 0, napi_default, 0 },
         { "rdpSendKey", 0, RdpSendKey, 0, 0, 0, napi_default, 0 },
+        { "rdpSendMouse", 0, RdpSendMouse, 0, 0, 0, napi_default, 0 },
+        { "rdpSetSurface", 0, RdpSetSurface, 0, 0, 0, napi_default, 0 },
+        { "rdpClearSurface", 0, RdpClearSurface, 0, 0, 0, napi_default, 0 },
         // RDP 超时处理
         { "rdpCheckTimeout", 0, RdpCheckTimeout, 0, 0, 0, napi_default, 0 },
         { "rdpSetTimeout", 0, RdpSetTimeout, 0, 0, 0, napi_default, 0 },
@@ -5899,10 +8911,16 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "vncDisconnect", 0, VncDisconnect, 0, 0, 0, napi_default, 0 },
         { "vncGetFrame", 0, VncGetFrame, 0, 0, 0, napi_default, 0 },
         { "vncGetInfo", 0, VncGetInfo, 0, 0, 0, napi_default, 0 },
+        { "vncGetStats", 0, VncGetStats, 0, 0, 0, napi_default, 0 },
         { "vncSendPointer", 0, VncSendPointer, 0, 0, 0, napi_default, 0 },
         { "vncSendKey", 0, VncSendKey, 0, 0, 0, napi_default, 0 },
         { "vncSetSurface", 0, VncSetSurface, 0, 0, 0, napi_default, 0 },
         { "vncClearSurface", 0, VncClearSurface, 0, 0, 0, napi_default, 0 },
+        { "qmpExecute", 0, QmpExecute, 0, 0, 0, napi_default, 0 },
+        { "qmpSubscribeEvents", 0, QmpSubscribeEvents, 0, 0, 0, napi_default, 0 },
+        { "qmpUnsubscribeEvents", 0, QmpUnsubscribeEvents, 0, 0, 0, napi_default, 0 },
+        { "displayAttach", 0, DisplayAttach, 0, 0, 0, napi_default, 0 },
+        { "displayDetach", 0, DisplayDetach, 0, 0, 0, napi_default, 0 },
         // Windows 11 配置相关
         { "setupTpm", 0, SetupTpm, 0, 0, 0, napi_default, 0 },
         { "setupUefi", 0, SetupUefi, 0, 0, 0, napi_default, 0 },
@@ -5915,6 +8933,15 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "getModuleInfo", 0, GetModuleInfo, 0, 0, 0, napi_default, 0 },
         { "writeToVmConsole", 0, WriteToVmConsole, 0, 0, 0, napi_default, 0 },
         { "setConsoleCallback", 0, SetConsoleCallback, 0, 0, 0, napi_default, 0 },
+        { "getConsoleStats", 0, GetConsoleStats, 0, 0, 0, napi_default, 0 },
+        { "getVmRuntime", 0, GetVmRuntime, 0, 0, 0, napi_default, 0 },
+        { "planVmProfile", 0, PlanVmProfile, 0, 0, 0, napi_default, 0 },
+        { "getVmProfile", 0, GetVmProfile, 0, 0, 0, napi_default, 0 },
+        { "benchmarkVmProfile", 0, BenchmarkVmProfile, 0, 0, 0, napi_default, 0 },
+        { "getThreadStats", 0, GetThreadStats, 0, 0, 0, napi_default, 0 },
+        { "setCpuPinning", 0, SetCpuPinning, 0, 0, 0, napi_default, 0 },
+        { "getHotspots", 0, GetHotspots, 0, 0, 0, napi_default, 0 },
+        { "getAudioStats", 0, GetAudioStats, 0, 0, 0, napi_default, 0 },
         // QMP screendump（VNC 替代方案）
         { "takeScreenshot", 0, TakeScreenshot, 0, 0, 0, napi_default, 0 },
         // Disk tools (qemu-img / built-in qcow2 create)
@@ -5926,17 +8953,29 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "version", GetVersion, 0 },
         { "enableJit", EnableJit, 0 },
         { "kvmSupported", KvmSupported, 0 },
+        { "setDeviceInfo", SetDeviceInfo, 0 },
+        { "setJitPermission", SetJitPermission, 0 },
         { "startVm", StartVm, 0 },
         { "stopVm", StopVm, 0 },
         { "getVmLogs", GetVmLogs, 0 },
         { "getVmStatus", GetVmStatus, 0 },
+        { "getVmState", GetVmState, 0 },
+        { "getVmLogsSince", GetVmLogsSince, 0 },
+        { "setVmLogCallback", SetVmLogCallback, 0 },
+        { "clearVmLogCallback", ClearVmLogCallback, 0 },
+        { "setVmStateCallback", SetVmStateCallback, 0 },
+        { "clearVmStateCallback", ClearVmStateCallback, 0 },
         { "checkCoreLib", CheckCoreLib, 0 },
         { "createRdpClient", CreateRdpClient, 0 },
         { "connectRdp", ConnectRdp, 0 },
         { "disconnectRdp", DisconnectRdp, 0 },
         { "getRdpStatus", GetRdpStatus, 0 },
+        { "getRdpCertificate", GetRdpCertificate, 0 },
         { "destroyRdpClient", DestroyRdpClient, 0 },
         { "rdpSendKey", RdpSendKey, 0 },
+        { "rdpSendMouse", RdpSendMouse, 0 },
+        { "rdpSetSurface", RdpSetSurface, 0 },
+        { "rdpClearSurface", RdpClearSurface, 0 },
         // RDP 超时处理
         { "rdpCheckTimeout", RdpCheckTimeout, 0 },
         { "rdpSetTimeout", RdpSetTimeout, 0 },
@@ -5950,10 +8989,23 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "vncDisconnect", VncDisconnect, 0 },
         { "vncGetFrame", VncGetFrame, 0 },
         { "vncGetInfo", VncGetInfo, 0 },
+        { "vncGetStats", VncGetStats, 0 },
         { "vncSendPointer", VncSendPointer, 0 },
         { "vncSendKey", VncSendKey, 0 },
         { "vncSetSurface", VncSetSurface, 0 },
         { "vncClearSurface", VncClearSurface, 0 },
+        { "qmpExecute", QmpExecute, 0 },
+        { "qmpSubscribeEvents", QmpSubscribeEvents, 0 },
+        { "qmpUnsubscribeEvents", QmpUnsubscribeEvents, 0 },
+        { "snapshotSave", SnapshotSave, 0 },
+        { "snapshotLoad", SnapshotLoad, 0 },
+        { "snapshotDelete", SnapshotDelete, 0 },
+        { "snapshotList", SnapshotList, 0 },
+        { "suspendVm", SuspendVm, 0 },
+        { "hasResumeState", HasResumeState, 0 },
+        { "discardResumeState", DiscardResumeState, 0 },
+        { "displayAttach", DisplayAttach, 0 },
+        { "displayDetach", DisplayDetach, 0 },
         // Windows 11 配置相关
         { "setupTpm", SetupTpm, 0 },
         { "setupUefi", SetupUefi, 0 },
@@ -5966,6 +9018,15 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "getModuleInfo", GetModuleInfo, 0 },
         { "writeToVmConsole", WriteToVmConsole, 0 },
         { "setConsoleCallback", SetConsoleCallback, 0 },
+        { "getConsoleStats", GetConsoleStats, 0 },
+        { "getVmRuntime", GetVmRuntime, 0 },
+        { "planVmProfile", PlanVmProfile, 0 },
+        { "getVmProfile", GetVmProfile, 0 },
+        { "benchmarkVmProfile", BenchmarkVmProfile, 0 },
+        { "getThreadStats", GetThreadStats, 0 },
+        { "setCpuPinning", SetCpuPinning, 0 },
+        { "getHotspots", GetHotspots, 0 },
+        { "getAudioStats", GetAudioStats, 0 },
         // QMP screendump（VNC 替代方案）
         { "takeScreenshot", TakeScreenshot, 0 },
         // Disk tools (qemu-img / built-in qcow2 create)
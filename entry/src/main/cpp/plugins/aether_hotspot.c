@@ -0,0 +1,337 @@
+/**
+ * TCG 热点分析插件：来宾在 TCG 下为什么慢
+ *
+ * 用法：-plugin /path/libaether_hotspot.so[,mmio=off]
+ *
+ * 每个 TB（按来宾 PC 与指令数区分）统计：
+ * - 执行次数：翻译时插入内联计数，vCPU 线程各自累加到自己的 scoreboard 槽位，无锁
+ * - 访存次数：同样是按 vCPU 的内联计数
+ * - MMIO 访存：每次访存回调里查询是否落在 I/O 区域（这类访问总是走 softmmu 慢路径）；
+ *   插件 API 不暴露 TLB 缺失事件，MMIO 比例是能观测到的最接近的慢路径指标。开销较大，mmio=off 关闭
+ * - helper 指令：翻译时按反汇编分类，系统寄存器、缓存/TLB 维护、异常与浮点（softfloat）
+ *   在 TCG 中经 helper 调用执行，TB 执行次数 × 其中 helper 指令数即 helper 调用频率
+ *
+ * 报告通过 aether_hotspot_report（见 aether_hotspot.h）导出给宿主；退出时把前 10 个热点写入 QEMU 日志。
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <qemu-plugin.h>
+
+#include "aether_hotspot.h"
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+typedef struct TbCounters {
+    uint64_t exec;
+    uint64_t mem;
+    uint64_t mmio;
+} TbCounters;
+
+typedef struct TbStat {
+    uint64_t pc;
+    uint32_t insns;
+    uint32_t helper_insns;
+    char disas[AETHER_HOTSPOT_DISAS_LEN];
+    struct qemu_plugin_scoreboard *score;
+    qemu_plugin_u64 exec;
+    qemu_plugin_u64 mem;
+    qemu_plugin_u64 mmio;
+} TbStat;
+
+/* 开放寻址哈希表（键为 pc 与指令数），只在翻译与读取报告时持锁访问 */
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static TbStat **g_table;
+static size_t g_capacity;
+static size_t g_count;
+
+static bool g_mmio = true;
+static bool g_x86;
+
+static uint64_t tb_key_hash(uint64_t pc, uint32_t insns)
+{
+    uint64_t h = pc ^ ((uint64_t)insns << 56);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static bool table_grow(void)
+{
+    const size_t capacity = g_capacity ? g_capacity * 2 : 4096;
+    TbStat **table = calloc(capacity, sizeof(*table));
+    size_t i;
+
+    if (!table) {
+        return false;
+    }
+    for (i = 0; i < g_capacity; i++) {
+        TbStat *s = g_table[i];
+        size_t slot;
+        if (!s) {
+            continue;
+        }
+        slot = tb_key_hash(s->pc, s->insns) & (capacity - 1);
+        while (table[slot]) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table[slot] = s;
+    }
+    free(g_table);
+    g_table = table;
+    g_capacity = capacity;
+    return true;
+}
+
+/* 调用方持 g_lock；首次见到该 TB 时新建，*created 置 true */
+static TbStat *table_get(uint64_t pc, uint32_t insns, bool *created)
+{
+    size_t slot;
+    TbStat *s;
+
+    *created = false;
+    if ((g_count + 1) * 10 > g_capacity * 7 && !table_grow()) {
+        return NULL;
+    }
+    slot = tb_key_hash(pc, insns) & (g_capacity - 1);
+    while ((s = g_table[slot]) != NULL) {
+        if (s->pc == pc && s->insns == insns) {
+            return s;
+        }
+        slot = (slot + 1) & (g_capacity - 1);
+    }
+    s = calloc(1, sizeof(*s));
+    if (!s) {
+        return NULL;
+    }
+    s->pc = pc;
+    s->insns = insns;
+    s->score = qemu_plugin_scoreboard_new(sizeof(TbCounters));
+    s->exec = qemu_plugin_scoreboard_u64_in_struct(s->score, TbCounters, exec);
+    s->mem = qemu_plugin_scoreboard_u64_in_struct(s->score, TbCounters, mem);
+    s->mmio = qemu_plugin_scoreboard_u64_in_struct(s->score, TbCounters, mmio);
+    g_table[slot] = s;
+    g_count++;
+    *created = true;
+    return s;
+}
+
+static bool has_prefix(const char *s, const char *prefix)
+{
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+/* 按助记符判断 TCG 是否经 helper 执行该指令（近似：不同 QEMU 版本内联的范围略有差异） */
+static bool insn_uses_helper(const char *disas)
+{
+    static const char *const arm[] = {
+        "mrs", "msr", "sys", "dc ", "ic ", "tlbi", "at ", "svc", "hvc", "smc", "eret",
+        "wfi", "wfe", "brk", "hlt", "ldxr", "stxr", "ldaxr", "stlxr", "cas", "ldadd", "swp",
+    };
+    static const char *const x86[] = {
+        "cpuid", "rdtsc", "rdmsr", "wrmsr", "in ", "out", "ins", "outs", "int ", "int3",
+        "syscall", "sysenter", "sysexit", "sysret", "iret", "hlt", "invlpg", "lgdt", "lidt",
+        "ltr", "lldt", "mov cr", "mov dr", "xsave", "xrstor", "fxsave", "fxrstor", "pause",
+    };
+    const char *const *list = g_x86 ? x86 : arm;
+    const size_t n = g_x86 ? sizeof(x86) / sizeof(x86[0]) : sizeof(arm) / sizeof(arm[0]);
+    size_t i;
+
+    while (*disas == ' ' || *disas == '\t') {
+        disas++;
+    }
+    /* 浮点：softfloat helper（arm 的 fmov 与 x86 的 SSE 整数搬移除外） */
+    if (disas[0] == 'f' && !has_prefix(disas, "fmov")) {
+        return true;
+    }
+    if (g_x86 && (strstr(disas, "ss ") || strstr(disas, "sd ") || strstr(disas, "ps ") || strstr(disas, "pd "))) {
+        return !has_prefix(disas, "mov");
+    }
+    for (i = 0; i < n; i++) {
+        if (has_prefix(disas, list[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void vcpu_mem(unsigned int vcpu_index, qemu_plugin_meminfo_t info, uint64_t vaddr, void *udata)
+{
+    TbStat *s = udata;
+    struct qemu_plugin_hwaddr *hw = qemu_plugin_get_hwaddr(info, vaddr);
+
+    if (hw && qemu_plugin_hwaddr_is_io(hw)) {
+        qemu_plugin_u64_add(s->mmio, vcpu_index, 1);
+    }
+}
+
+static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
+{
+    const size_t n = qemu_plugin_tb_n_insns(tb);
+    const uint64_t pc = qemu_plugin_tb_vaddr(tb);
+    bool created = false;
+    TbStat *s;
+    size_t i;
+
+    (void)id;
+    pthread_mutex_lock(&g_lock);
+    s = table_get(pc, (uint32_t)n, &created);
+    pthread_mutex_unlock(&g_lock);
+    if (!s) {
+        return;
+    }
+
+    qemu_plugin_register_vcpu_tb_exec_inline_per_vcpu(tb, QEMU_PLUGIN_INLINE_ADD_U64, s->exec, 1);
+    for (i = 0; i < n; i++) {
+        struct qemu_plugin_insn *insn = qemu_plugin_tb_get_insn(tb, i);
+        qemu_plugin_register_vcpu_mem_inline_per_vcpu(insn, QEMU_PLUGIN_MEM_RW, QEMU_PLUGIN_INLINE_ADD_U64, s->mem, 1);
+        if (g_mmio) {
+            qemu_plugin_register_vcpu_mem_cb(insn, vcpu_mem, QEMU_PLUGIN_CB_NO_REGS, QEMU_PLUGIN_MEM_RW, s);
+        }
+    }
+
+    /* 同一 TB 重新翻译（flush 或标志变化）时沿用首次的分类 */
+    if (created) {
+        uint32_t helper = 0;
+        for (i = 0; i < n; i++) {
+            char *d = qemu_plugin_insn_disas(qemu_plugin_tb_get_insn(tb, i));
+            if (!d) {
+                continue;
+            }
+            if (i == 0) {
+                snprintf(s->disas, sizeof(s->disas), "%s", d);
+            }
+            helper += insn_uses_helper(d) ? 1 : 0;
+            free(d);
+        }
+        s->helper_insns = helper;
+    }
+}
+
+static void counters_reset(const TbStat *s, int vcpus)
+{
+    int v;
+
+    for (v = 0; v < vcpus; v++) {
+        qemu_plugin_u64_set(s->exec, v, 0);
+        qemu_plugin_u64_set(s->mem, v, 0);
+        qemu_plugin_u64_set(s->mmio, v, 0);
+    }
+}
+
+QEMU_PLUGIN_EXPORT size_t aether_hotspot_report(uint32_t version, AetherHotspotTotals *totals,
+                                                AetherHotspot *out, size_t max, int reset)
+{
+    const int vcpus = qemu_plugin_num_vcpus();
+    uint64_t weight[AETHER_HOTSPOT_MAX_TOP];
+    size_t filled = 0;
+    size_t i;
+
+    if (version != AETHER_HOTSPOT_ABI_VERSION || !totals) {
+        return 0;
+    }
+    if (max > AETHER_HOTSPOT_MAX_TOP) {
+        max = AETHER_HOTSPOT_MAX_TOP;
+    }
+    memset(totals, 0, sizeof(*totals));
+
+    pthread_mutex_lock(&g_lock);
+    totals->tbs = g_count;
+    for (i = 0; i < g_capacity; i++) {
+        const TbStat *s = g_table[i];
+        uint64_t exec, w;
+        size_t pos;
+
+        if (!s) {
+            continue;
+        }
+        exec = qemu_plugin_u64_sum(s->exec);
+        if (exec == 0) {
+            continue;
+        }
+        w = exec * s->insns;
+        totals->exec += exec;
+        totals->insns += w;
+        totals->helper_insns += exec * s->helper_insns;
+        totals->mem += qemu_plugin_u64_sum(s->mem);
+        totals->mmio += qemu_plugin_u64_sum(s->mmio);
+
+        /* 插入排序维护前 max 名（max 很小） */
+        if (!out || max == 0 || (filled == max && w <= weight[filled - 1])) {
+            continue;
+        }
+        pos = filled < max ? filled++ : filled - 1;
+        while (pos > 0 && weight[pos - 1] < w) {
+            weight[pos] = weight[pos - 1];
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        weight[pos] = w;
+        out[pos].pc = s->pc;
+        out[pos].exec = exec;
+        out[pos].mem = qemu_plugin_u64_sum(s->mem);
+        out[pos].mmio = qemu_plugin_u64_sum(s->mmio);
+        out[pos].insns = s->insns;
+        out[pos].helper_insns = s->helper_insns;
+        memcpy(out[pos].disas, s->disas, sizeof(out[pos].disas));
+    }
+    if (reset) {
+        for (i = 0; i < g_capacity; i++) {
+            if (g_table[i]) {
+                counters_reset(g_table[i], vcpus);
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return filled;
+}
+
+static void plugin_exit(qemu_plugin_id_t id, void *udata)
+{
+    AetherHotspotTotals totals;
+    AetherHotspot top[10];
+    const size_t n = aether_hotspot_report(AETHER_HOTSPOT_ABI_VERSION, &totals, top, 10, 0);
+    char line[256];
+    size_t i;
+
+    (void)id;
+    (void)udata;
+    snprintf(line, sizeof(line),
+             "aether-hotspot: %llu TBs, %llu guest insns, helper %.1f%%, mmio %.2f%% of %llu accesses\n",
+             (unsigned long long)totals.tbs, (unsigned long long)totals.insns,
+             totals.insns ? 100.0 * totals.helper_insns / totals.insns : 0.0,
+             totals.mem ? 100.0 * totals.mmio / totals.mem : 0.0, (unsigned long long)totals.mem);
+    qemu_plugin_outs(line);
+    for (i = 0; i < n; i++) {
+        snprintf(line, sizeof(line), "aether-hotspot:   0x%016llx %5.1f%% exec=%llu insns=%u helper=%u  %s\n",
+                 (unsigned long long)top[i].pc,
+                 totals.insns ? 100.0 * top[i].exec * top[i].insns / totals.insns : 0.0,
+                 (unsigned long long)top[i].exec, top[i].insns, top[i].helper_insns, top[i].disas);
+        qemu_plugin_outs(line);
+    }
+}
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info, int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        char *eq = strchr(argv[i], '=');
+        if (eq && strncmp(argv[i], "mmio", (size_t)(eq - argv[i])) == 0 &&
+            qemu_plugin_bool_parse("mmio", eq + 1, &g_mmio)) {
+            continue;
+        }
+        fprintf(stderr, "aether-hotspot: unknown option %s\n", argv[i]);
+        return -1;
+    }
+    g_x86 = info->target_name && (strcmp(info->target_name, "x86_64") == 0 || strcmp(info->target_name, "i386") == 0);
+
+    qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
+    qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+    return 0;
+}
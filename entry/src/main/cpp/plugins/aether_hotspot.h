@@ -0,0 +1,56 @@
+/**
+ * TCG 热点分析插件（libaether_hotspot.so）的报告 ABI
+ *
+ * 插件由 QEMU 以 -plugin 加载，运行在 QEMU 所在的进程里（进程内 VM 为应用进程，
+ * 并行 VM 为工作进程）；宿主侧用 dlopen(RTLD_NOLOAD) + dlsym 取报告函数。
+ * 本头文件同时被插件（C）与 napi_init.cpp / qemu_worker.cpp（C++）包含。
+ */
+
+#ifndef AETHER_HOTSPOT_H
+#define AETHER_HOTSPOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AETHER_HOTSPOT_ABI_VERSION 1
+#define AETHER_HOTSPOT_REPORT_SYMBOL "aether_hotspot_report"
+#define AETHER_HOTSPOT_LIB "libaether_hotspot.so"
+#define AETHER_HOTSPOT_DISAS_LEN 48
+#define AETHER_HOTSPOT_MAX_TOP 64
+
+typedef struct AetherHotspotTotals {
+    uint64_t tbs;           /* 已翻译的不同 TB（按来宾 PC 与指令数区分） */
+    uint64_t exec;          /* TB 执行次数 */
+    uint64_t insns;         /* 执行的来宾指令数 */
+    uint64_t helper_insns;  /* 其中经 helper 执行的指令（系统寄存器、缓存/TLB 维护、浮点、异常） */
+    uint64_t mem;           /* 来宾访存次数 */
+    uint64_t mmio;          /* 其中落在 MMIO 上的访存（总是走 softmmu 慢路径）；mmio=off 时为 0 */
+} AetherHotspotTotals;
+
+typedef struct AetherHotspot {
+    uint64_t pc;
+    uint64_t exec;
+    uint64_t mem;
+    uint64_t mmio;
+    uint32_t insns;         /* TB 内指令数 */
+    uint32_t helper_insns;  /* TB 内经 helper 执行的指令数 */
+    char disas[AETHER_HOTSPOT_DISAS_LEN];   /* 第一条指令的反汇编 */
+} AetherHotspot;
+
+/*
+ * 按执行的来宾指令数（exec × insns）降序取前 max 个 TB 写入 out，返回写入条数。
+ * reset 非 0 时读取后把计数清零，开始新的采样窗口。version 不匹配时返回 0 且不写 totals。
+ * 计数在 vCPU 线程上按 vCPU 分别累加（无锁），读取与清零不与 vCPU 同步，结果是近似值。
+ */
+typedef size_t (*aether_hotspot_report_fn)(uint32_t version, AetherHotspotTotals *totals,
+                                           AetherHotspot *out, size_t max, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AETHER_HOTSPOT_H */
@@ -0,0 +1,538 @@
+// QEMU 工作进程入口（libqemu_worker.so:Main），由主进程通过 OH_Ability_StartNativeChildProcess 拉起
+// 每个工作进程加载一份 libqemu_{arch}.so 运行一个 VM，QEMU 的全局状态与其它 VM 互不干扰：
+// - stdout/stderr 接到主进程的管道，按 VM 落盘
+// - 显示：aether-xcomponent 的脏区拷进 memfd 共享 surface，经控制通道通知主进程，确认前不再写
+// - 串口：aether-ring chardev 的输出 / 输入经控制通道转发
+
+#include <AbilityKit/native_child_process.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <mutex>
+#include <poll.h>
+#include <pthread.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "vm_sched.h"
+#include "worker_protocol.h"
+#include "third_party/cjson/cJSON.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+namespace {
+
+using namespace worker_proto;
+
+// 与 napi_init.cpp 中的 core 导出声明保持一致
+using qemu_init_fn = void (*)(int argc, char** argv);
+using qemu_main_loop_fn = int (*)(void);
+using qemu_cleanup_fn = void (*)(int status);
+using qemu_shutdown_fn = void (*)(int reason);
+using qemu_hmos_get_last_exit_code_fn = int (*)(void);
+using qemu_hmos_clear_last_exit_code_fn = void (*)(void);
+constexpr int kShutdownCauseHost = 0;
+
+// 补丁 0003 AetherDisplaySink
+struct QemuDisplaySink {
+    void* opaque;
+    void (*gfx_switch)(void* opaque, const void* data, int width, int height, int stride, uint32_t format);
+    void (*gfx_update)(void* opaque, int x, int y, int w, int h);
+    void (*refresh)(void* opaque);
+};
+using qemu_hmos_display_set_sink_fn = int (*)(const QemuDisplaySink* sink, uint32_t version);
+constexpr uint32_t kQemuDisplaySinkVersion = 1;
+constexpr uint32_t kPixmanX8R8G8B8 = 0x20020888;
+constexpr uint32_t kPixmanA8R8G8B8 = 0x20028888;
+
+// 补丁 0004 AetherChardevSink
+struct QemuChardevSink {
+    void* opaque;
+    void (*notify)(void* opaque);
+    void (*closed)(void* opaque);
+};
+using qemu_hmos_chardev_set_sink_fn = int (*)(const char* id, const QemuChardevSink* sink, uint32_t version);
+using qemu_hmos_chardev_read_fn = ssize_t (*)(const char* id, void* buf, size_t len);
+using qemu_hmos_chardev_write_fn = ssize_t (*)(const char* id, const void* buf, size_t len);
+using qemu_hmos_chardev_dropped_fn = int64_t (*)(const char* id);
+constexpr uint32_t kQemuChardevSinkVersion = 1;
+
+// 补丁 0002 AetherAudioStats（布局见 worker_protocol.h 的 AudioStats）
+using qemu_hmos_audio_get_stats_fn = int (*)(AudioStats* out, uint32_t version);
+
+struct Worker {
+    int ctl = -1;
+    std::mutex send_mutex;
+
+    qemu_shutdown_fn shutdown = nullptr;
+
+    // 串口
+    std::string console;
+    int event_fd = -1;
+    qemu_hmos_chardev_read_fn chr_read = nullptr;
+    qemu_hmos_chardev_write_fn chr_write = nullptr;
+    qemu_hmos_chardev_dropped_fn chr_dropped = nullptr;
+    int64_t reported_drops = 0;
+
+    // 显示：以下只在 QEMU 主循环线程访问
+    int memfd = -1;
+    uint8_t* shm = nullptr;
+    size_t shm_size = 0;
+    const uint8_t* src = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    std::vector<Rect> damage;
+    // 跨线程：控制线程收到确认 / 整帧请求
+    std::atomic<bool> frame_in_flight { false };
+    std::atomic<bool> want_full { false };
+
+    // 热点分析插件的报告函数（qemu_init 之后设置，控制线程读取）
+    std::atomic<aether_hotspot_report_fn> hotspot_report { nullptr };
+    std::atomic<qemu_hmos_audio_get_stats_fn> audio_stats { nullptr };
+
+    std::atomic<bool> stop { false };
+
+    bool Send(uint32_t type, const void* payload, size_t len, int fd = -1)
+    {
+        std::lock_guard<std::mutex> lk(send_mutex);
+        return SendMsg(ctl, type, payload, len, fd);
+    }
+};
+
+Worker g_worker;
+
+void Log(const char* fmt, ...)
+{
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "[worker %d] %s\n", static_cast<int>(getpid()), buf);
+}
+
+// ----------------------------- 显示（QEMU 主循环线程） -----------------------------
+
+void ReleaseSurface(Worker& w)
+{
+    if (w.shm) munmap(w.shm, w.shm_size);
+    if (w.memfd >= 0) close(w.memfd);
+    w.shm = nullptr;
+    w.shm_size = 0;
+    w.memfd = -1;
+    w.width = w.height = 0;
+}
+
+void DisplaySwitch(void* opaque, const void* data, int width, int height, int stride, uint32_t format)
+{
+    Worker& w = *static_cast<Worker*>(opaque);
+    w.damage.clear();
+    const bool ok = data && width > 0 && height > 0 && stride >= width * 4 &&
+        (format == kPixmanX8R8G8B8 || format == kPixmanA8R8G8B8);
+    if (!ok) {
+        w.src = nullptr;
+        ReleaseSurface(w);
+        SwitchMsg m { 0, 0, format };
+        w.Send(kMsgSwitch, &m, sizeof(m));
+        return;
+    }
+    w.src = static_cast<const uint8_t*>(data);
+    w.stride = stride;
+    if (!w.shm || w.width != width || w.height != height) {
+        ReleaseSurface(w);
+        const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+        const int fd = static_cast<int>(syscall(SYS_memfd_create, "qemu-surface", MFD_CLOEXEC));
+        void* p = MAP_FAILED;
+        if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (p == MAP_FAILED) {
+            Log("surface %dx%d: memfd/mmap failed: %s", width, height, strerror(errno));
+            if (fd >= 0) close(fd);
+            w.src = nullptr;
+            SwitchMsg m { 0, 0, format };
+            w.Send(kMsgSwitch, &m, sizeof(m));
+            return;
+        }
+        w.memfd = fd;
+        w.shm = static_cast<uint8_t*>(p);
+        w.shm_size = size;
+        w.width = width;
+        w.height = height;
+        SwitchMsg m { width, height, format };
+        w.Send(kMsgSwitch, &m, sizeof(m), fd);
+    }
+    w.damage.push_back(Rect { 0, 0, width, height });
+}
+
+void DisplayUpdate(void* opaque, int x, int y, int width, int height)
+{
+    Worker& w = *static_cast<Worker*>(opaque);
+    if (!w.shm) return;
+    const int x0 = std::max(0, x);
+    const int y0 = std::max(0, y);
+    const int x1 = std::min(w.width, x + width);
+    const int y1 = std::min(w.height, y + height);
+    if (x1 <= x0 || y1 <= y0) return;
+    if (w.damage.size() >= kMaxFrameRects) {
+        // 合并为外接矩形
+        Rect box = w.damage[0];
+        int bx1 = box.x + box.w;
+        int by1 = box.y + box.h;
+        for (const Rect& r : w.damage) {
+            box.x = std::min(box.x, r.x);
+            box.y = std::min(box.y, r.y);
+            bx1 = std::max(bx1, r.x + r.w);
+            by1 = std::max(by1, r.y + r.h);
+        }
+        box.w = bx1 - box.x;
+        box.h = by1 - box.y;
+        w.damage.assign(1, box);
+    }
+    w.damage.push_back(Rect { x0, y0, x1 - x0, y1 - y0 });
+}
+
+// 每个刷新周期一次：上一帧主进程尚未拷走时只累积脏区，不阻塞主循环
+void DisplayRefresh(void* opaque)
+{
+    Worker& w = *static_cast<Worker*>(opaque);
+    if (!w.shm || !w.src) return;
+    if (w.want_full.exchange(false)) w.damage.assign(1, Rect { 0, 0, w.width, w.height });
+    if (w.damage.empty() || w.frame_in_flight.load()) return;
+
+    FrameMsg m {};
+    const size_t row = static_cast<size_t>(w.width) * 4;
+    for (const Rect& r : w.damage) {
+        const size_t span = static_cast<size_t>(r.w) * 4;
+        for (int yy = r.y; yy < r.y + r.h; yy++) {
+            memcpy(w.shm + static_cast<size_t>(yy) * row + static_cast<size_t>(r.x) * 4,
+                   w.src + static_cast<size_t>(yy) * static_cast<size_t>(w.stride) + static_cast<size_t>(r.x) * 4,
+                   span);
+        }
+        m.rects[m.count++] = r;
+    }
+    w.damage.clear();
+    w.frame_in_flight.store(true);
+    if (!w.Send(kMsgFrame, &m, sizeof(m))) w.frame_in_flight.store(false);
+}
+
+// ----------------------------- 串口 / 控制通道（控制线程） -----------------------------
+
+// QEMU 线程（持有环锁）调用：只做唤醒
+void ConsoleNotify(void* opaque)
+{
+    Worker& w = *static_cast<Worker*>(opaque);
+    const uint64_t one = 1;
+    (void)!write(w.event_fd, &one, sizeof(one));
+}
+
+void ConsolePump(Worker& w)
+{
+    if (!w.chr_read) return;
+    char buf[kMaxConsolePayload];
+    ssize_t n;
+    while ((n = w.chr_read(w.console.c_str(), buf, sizeof(buf))) > 0) {
+        w.Send(kMsgConsole, buf, static_cast<size_t>(n));
+    }
+    const int64_t drops = w.chr_dropped ? w.chr_dropped(w.console.c_str()) : 0;
+    if (drops > w.reported_drops) {
+        const std::string note = "\r\n[console: " + std::to_string(drops - w.reported_drops) +
+            " bytes dropped in guest ring]\r\n";
+        w.Send(kMsgConsole, note.data(), note.size());
+        w.reported_drops = drops;
+    }
+}
+
+void SendHotspots(Worker& w, const HotspotQuery& q)
+{
+    std::vector<char> msg(sizeof(HotspotReply) + AETHER_HOTSPOT_MAX_TOP * sizeof(AetherHotspot));
+    HotspotReply r {};
+    r.seq = q.seq;
+    if (aether_hotspot_report_fn report = w.hotspot_report.load()) {
+        auto* entries = reinterpret_cast<AetherHotspot*>(msg.data() + sizeof(r));
+        r.loaded = 1;
+        r.count = static_cast<uint32_t>(report(AETHER_HOTSPOT_ABI_VERSION, &r.totals, entries,
+                                               std::min<uint32_t>(q.top, AETHER_HOTSPOT_MAX_TOP), q.reset ? 1 : 0));
+    }
+    memcpy(msg.data(), &r, sizeof(r));
+    w.Send(kMsgHotspots, msg.data(), sizeof(r) + r.count * sizeof(AetherHotspot));
+}
+
+void SendAudioStats(Worker& w, const AudioStatsQuery& q)
+{
+    AudioStatsReply r {};
+    r.seq = q.seq;
+    qemu_hmos_audio_get_stats_fn get = w.audio_stats.load();
+    r.available = get && get(&r.stats, kAudioStatsVersion) == 0 ? 1 : 0;
+    w.Send(kMsgAudioStats, &r, sizeof(r));
+}
+
+void ControlThread(Worker& w)
+{
+    std::vector<char> buf(kMaxMsgBytes);
+    while (!w.stop.load()) {
+        pollfd pfd[2] = { { w.ctl, POLLIN, 0 }, { w.event_fd, POLLIN, 0 } };
+        if (poll(pfd, 2, 200) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pfd[1].revents & POLLIN) {
+            uint64_t v;
+            (void)!read(w.event_fd, &v, sizeof(v));
+            ConsolePump(w);
+        }
+        bool parentGone = (pfd[0].revents & (POLLHUP | POLLERR | POLLNVAL)) && !(pfd[0].revents & POLLIN);
+        if (pfd[0].revents & POLLIN) {
+            int fd = -1;
+            const ssize_t n = RecvMsg(w.ctl, buf.data(), buf.size(), fd);
+            if (fd >= 0) close(fd);
+            if (n == 0 || (n < 0 && errno != EPROTO)) {
+                parentGone = true;
+            } else if (n > 0) {
+                const auto* hdr = reinterpret_cast<const MsgHeader*>(buf.data());
+                const char* payload = buf.data() + sizeof(MsgHeader);
+                switch (hdr->type) {
+                case kMsgFrameAck:
+                    w.frame_in_flight.store(false);
+                    break;
+                case kMsgFullFrame:
+                    w.want_full.store(true);
+                    break;
+                case kMsgConsoleIn:
+                    if (w.chr_write) w.chr_write(w.console.c_str(), payload, hdr->len);
+                    break;
+                case kMsgShutdown:
+                    if (w.shutdown) w.shutdown(kShutdownCauseHost);
+                    break;
+                case kMsgHotspotQuery: {
+                    HotspotQuery q {};
+                    memcpy(&q, payload, std::min<size_t>(hdr->len, sizeof(q)));
+                    SendHotspots(w, q);
+                    break;
+                }
+                case kMsgAudioStatsQuery: {
+                    AudioStatsQuery q {};
+                    memcpy(&q, payload, std::min<size_t>(hdr->len, sizeof(q)));
+                    SendAudioStats(w, q);
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+        }
+        if (parentGone) {
+            // 主进程退出或放弃了这个 VM：关机，避免留下无人管理的 QEMU
+            Log("control channel closed, shutting down");
+            if (w.shutdown) w.shutdown(kShutdownCauseHost);
+            break;
+        }
+    }
+}
+
+// ----------------------------- QEMU -----------------------------
+
+// 补丁 0002：OHAudio 回调线程首次回调时调用，绑到 I/O 核心（vCPU 线程由主进程按线程名绑核）
+using qemu_hmos_audio_thread_hook_fn = void (*)(const char* role);
+using qemu_hmos_audio_set_thread_hook_fn = int (*)(qemu_hmos_audio_thread_hook_fn hook, uint32_t version);
+constexpr uint32_t kQemuAudioThreadHookVersion = 1;
+
+void AudioThreadHook(const char* role)
+{
+    sched_pin_self(SchedRole::Io, role ? role : "audio");
+}
+
+template <typename T>
+T CoreSym(void* core, const char* hmosName, const char* name)
+{
+    void* p = hmosName ? dlsym(core, hmosName) : nullptr;
+    if (!p && name) p = dlsym(core, name);
+    return reinterpret_cast<T>(p);
+}
+
+// -plugin 参数中的插件路径（QEMU 选项语法：',,' 表示路径中的逗号，单个 ',' 之后是插件参数）
+std::string PluginPathFromArg(const std::string& arg)
+{
+    std::string path;
+    for (size_t i = 0; i < arg.size(); i++) {
+        if (arg[i] == ',') {
+            if (i + 1 >= arg.size() || arg[i + 1] != ',') break;
+            i++;
+        }
+        path.push_back(arg[i]);
+    }
+    return path;
+}
+
+int RunQemu(Worker& w, const std::string& lib, std::vector<std::string>& args)
+{
+    // 热点分析插件的 qemu_plugin_* 未定义符号从 core 解析，带 -plugin 时 core 须全局可见
+    const bool wantPlugin = std::find(args.begin(), args.end(), "-plugin") != args.end();
+    const int flags = RTLD_NOW | (wantPlugin ? RTLD_GLOBAL : 0);
+    void* core = dlopen(lib.c_str(), flags);
+    if (!core && lib != "libqemu_full.so") core = dlopen("libqemu_full.so", flags);
+    if (!core) {
+        const char* e = dlerror();
+        Log("dlopen %s failed: %s", lib.c_str(), e ? e : "unknown");
+        return -1;
+    }
+    auto init = CoreSym<qemu_init_fn>(core, "qemu_hmos_qemu_init", "qemu_init");
+    auto mainLoop = CoreSym<qemu_main_loop_fn>(core, "qemu_hmos_qemu_main_loop", "qemu_main_loop");
+    auto cleanup = CoreSym<qemu_cleanup_fn>(core, "qemu_hmos_qemu_cleanup", "qemu_cleanup");
+    auto getExit = CoreSym<qemu_hmos_get_last_exit_code_fn>(core, "qemu_hmos_get_last_exit_code", nullptr);
+    auto clearExit = CoreSym<qemu_hmos_clear_last_exit_code_fn>(core, "qemu_hmos_clear_last_exit_code", nullptr);
+    w.shutdown = CoreSym<qemu_shutdown_fn>(core, "qemu_hmos_qemu_system_shutdown_request", "qemu_system_shutdown_request");
+    if (!init || !mainLoop) {
+        Log("%s has no qemu_init/qemu_main_loop", lib.c_str());
+        return -1;
+    }
+
+    // 串口：core 不带 aether-ring（无补丁 0004）时改用 null chardev，来宾照常启动
+    if (!w.console.empty()) {
+        auto setSink = CoreSym<qemu_hmos_chardev_set_sink_fn>(core, "qemu_hmos_chardev_set_sink", nullptr);
+        w.chr_read = CoreSym<qemu_hmos_chardev_read_fn>(core, "qemu_hmos_chardev_read", nullptr);
+        w.chr_write = CoreSym<qemu_hmos_chardev_write_fn>(core, "qemu_hmos_chardev_write", nullptr);
+        w.chr_dropped = CoreSym<qemu_hmos_chardev_dropped_fn>(core, "qemu_hmos_chardev_dropped", nullptr);
+        QemuChardevSink sink { &w, ConsoleNotify, ConsoleNotify };
+        if (!setSink || !w.chr_read || !w.chr_write ||
+            setSink(w.console.c_str(), &sink, kQemuChardevSinkVersion) != 0) {
+            Log("core has no aether-ring chardev, serial console disabled");
+            const std::string prefix = "aether-ring,id=" + w.console + ",";
+            for (auto& a : args) {
+                if (a.rfind(prefix, 0) == 0) a = "null,id=" + w.console;
+            }
+            w.chr_read = nullptr;
+            w.chr_write = nullptr;
+        }
+    }
+
+    // 热点分析：core 以 --disable-plugins 构建时去掉 -plugin
+    std::string pluginPath;
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        if (args[i] != "-plugin") continue;
+        if (CoreSym<void*>(core, "qemu_plugin_u64_sum", nullptr)) {
+            pluginPath = PluginPathFromArg(args[i + 1]);
+        } else {
+            Log("core built without TCG plugin support, profiler disabled");
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        }
+        break;
+    }
+
+    auto setDisplaySink = CoreSym<qemu_hmos_display_set_sink_fn>(core, "qemu_hmos_display_set_sink", nullptr);
+    if (setDisplaySink) {
+        QemuDisplaySink sink { &w, DisplaySwitch, DisplayUpdate, DisplayRefresh };
+        const int rc = setDisplaySink(&sink, kQemuDisplaySinkVersion);
+        if (rc != 0) Log("display set_sink rc=%d", rc);
+    }
+
+    auto setAudioHook = CoreSym<qemu_hmos_audio_set_thread_hook_fn>(core, "qemu_hmos_audio_set_thread_hook", nullptr);
+    if (setAudioHook) setAudioHook(AudioThreadHook, kQemuAudioThreadHookVersion);
+    w.audio_stats.store(CoreSym<qemu_hmos_audio_get_stats_fn>(core, "qemu_hmos_audio_get_stats", nullptr));
+    pthread_setname_np(pthread_self(), "qemu-main");
+
+    bool hasAudiodev = false;
+    for (const auto& a : args) hasAudiodev = hasAudiodev || a == "-audiodev";
+    if (!hasAudiodev) setenv("QEMU_AUDIO_DRV", "none", 1);
+    setenv("DISPLAY", "", 1);
+
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    // 独立进程里 QEMU 直接 exit() 只会结束本进程，主进程从控制通道 EOF 得知
+    if (clearExit) clearExit();
+    init(static_cast<int>(args.size()), argv.data());
+    if (getExit) {
+        const int code = getExit();
+        if (code != 0) {
+            Log("qemu_init requested exit(%d)", code);
+            return code;
+        }
+    }
+    if (!pluginPath.empty()) {
+        // 插件已由 qemu_init 加载，这里只取报告函数
+        void* plugin = dlopen(pluginPath.c_str(), RTLD_NOW | RTLD_NOLOAD);
+        if (plugin) {
+            w.hotspot_report.store(reinterpret_cast<aether_hotspot_report_fn>(dlsym(plugin, AETHER_HOTSPOT_REPORT_SYMBOL)));
+        } else {
+            Log("profiler plugin %s not loaded", pluginPath.c_str());
+        }
+    }
+    w.Send(kMsgRunning, nullptr, 0);
+    const int result = mainLoop();
+    Log("qemu_main_loop returned %d", result);
+    if (cleanup) cleanup(result);
+    return result;
+}
+
+} // namespace
+
+extern "C" void Main(NativeChildProcess_Args args)
+{
+    Worker& w = g_worker;
+    int out = -1;
+    int err = -1;
+    for (NativeChildProcess_Fd* f = args.fdList.head; f; f = f->next) {
+        if (!f->fdName) continue;
+        if (strcmp(f->fdName, kFdCtl) == 0) w.ctl = f->fd;
+        else if (strcmp(f->fdName, kFdStdout) == 0) out = f->fd;
+        else if (strcmp(f->fdName, kFdStderr) == 0) err = f->fd;
+    }
+    if (out >= 0 && dup2(out, STDOUT_FILENO) >= 0) close(out);
+    if (err >= 0 && dup2(err, STDERR_FILENO) >= 0) close(err);
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    setvbuf(stderr, nullptr, _IONBF, 0);
+    if (w.ctl < 0) {
+        Log("missing control channel");
+        return;
+    }
+
+    std::string vmName;
+    std::string lib = "libqemu_full.so";
+    std::vector<std::string> qemuArgs;
+    cJSON* root = cJSON_Parse(args.entryParams ? args.entryParams : "");
+    const cJSON* v = cJSON_GetObjectItemCaseSensitive(root, "v");
+    if (!cJSON_IsNumber(v) || static_cast<uint32_t>(v->valueint) != kVersion) {
+        Log("bad or mismatched launch parameters");
+        cJSON_Delete(root);
+        ExitMsg m { -1 };
+        w.Send(kMsgExit, &m, sizeof(m));
+        return;
+    }
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(root, "vm");
+    if (cJSON_IsString(item)) vmName = item->valuestring;
+    item = cJSON_GetObjectItemCaseSensitive(root, "lib");
+    if (cJSON_IsString(item) && item->valuestring[0]) lib = item->valuestring;
+    item = cJSON_GetObjectItemCaseSensitive(root, "console");
+    if (cJSON_IsString(item)) w.console = item->valuestring;
+    const cJSON* arr = cJSON_GetObjectItemCaseSensitive(root, "argv");
+    const cJSON* a = nullptr;
+    cJSON_ArrayForEach(a, arr) {
+        if (cJSON_IsString(a)) qemuArgs.emplace_back(a->valuestring);
+    }
+    cJSON_Delete(root);
+    Log("VM '%s' starting, core %s, %zu args", vmName.c_str(), lib.c_str(), qemuArgs.size());
+
+    w.event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    std::thread control(ControlThread, std::ref(w));
+
+    ExitMsg m { RunQemu(w, lib, qemuArgs) };
+    fflush(stdout);
+    w.Send(kMsgExit, &m, sizeof(m));
+    w.stop.store(true);
+    control.join();
+    Log("VM '%s' exited with code %d", vmName.c_str(), m.code);
+}
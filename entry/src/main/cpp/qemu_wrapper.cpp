@@ -1,5 +1,10 @@
 #include "qemu_wrapper.h"
 #include "rdp_client.h"
+#include "qmp_client.h"
+#include "snapshot_manager.h"
+#include "log_pipeline.h"
+#include "log_store.h"
+#include "tcg_profile.h"
 #include <cstring>
 #include <cstdlib>
 #include <string>
@@ -47,17 +52,18 @@ static qemu_cleanup_func_t g_qemu_cleanup_func = nullptr;
 // QEMU 虚拟机实例结构（无 fork 版本）
 struct QemuVmInstance {
     qemu_vm_config_t config;
-    qemu_vm_state_t state;
+    std::atomic<qemu_vm_state_t> state;  // VM 线程、QMP 事件和 API 调用方都会写，必须原子
     std::thread qemu_thread;           // QEMU 运行线程（替代 fork）
     std::atomic<bool> should_stop;
     std::atomic<bool> is_paused;
     std::string log_file;
     std::string monitor_socket_path;   // QEMU Monitor Unix socket
     std::vector<std::string> snapshots;
-    int qemu_exit_code;
+    std::atomic<int> qemu_exit_code;
+    uint64_t qmp_event_sub;            // STOP/RESUME 事件订阅 id（0 表示未订阅）
     
     QemuVmInstance() : state(QEMU_VM_STOPPED), should_stop(false), 
-                       is_paused(false), qemu_exit_code(0) {
+                       is_paused(false), qemu_exit_code(0), qmp_event_sub(0) {
         memset(&config, 0, sizeof(config));
     }
 };
@@ -128,156 +134,38 @@ static void unload_qemu_library() {
 // QEMU Monitor 通信（真正实现暂停/恢复/快照）
 // ============================================================================
 
-/**
- * 连接到 QEMU Monitor Unix socket
- * @param socket_path socket 文件路径
- * @return socket fd，失败返回 -1
- */
-static int connect_to_monitor(const std::string& socket_path) {
-    if (socket_path.empty()) {
-        return -1;
-    }
-    
-    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sock < 0) {
-        std::cerr << "[QEMU Monitor] Failed to create socket: " << strerror(errno) << std::endl;
-        return -1;
-    }
-    
-    struct sockaddr_un addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
-    
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        std::cerr << "[QEMU Monitor] Failed to connect: " << strerror(errno) << std::endl;
-        close(sock);
-        return -1;
-    }
-    
-    return sock;
-}
-
-/**
- * 初始化 QMP 会话（发送 qmp_capabilities）
- */
-static bool init_qmp_session(int sock) {
-    char buffer[4096];
-    
-    // 读取 QMP 欢迎消息
-    ssize_t n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    if (n <= 0) {
-        return false;
-    }
-    buffer[n] = '\0';
-    
-    // 发送 qmp_capabilities
-    const char* init_cmd = "{\"execute\": \"qmp_capabilities\"}\n";
-    if (send(sock, init_cmd, strlen(init_cmd), 0) < 0) {
-        return false;
-    }
-    
-    // 读取响应
-    n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    if (n <= 0) {
-        return false;
-    }
-    buffer[n] = '\0';
-    
-    return strstr(buffer, "\"return\"") != nullptr;
-}
-
 /**
  * 向 QEMU Monitor 发送 QMP 命令
+ * 复用每个 socket 的长连接（qmp_client.cpp）：握手只在建连时做一次，断开后自动重连
  * @param socket_path Monitor socket 路径
  * @param command QMP 命令（不含 execute 包装）
- * @return 响应字符串
+ * @return 完整响应 JSON，连接失败返回空串
  */
 static std::string send_qmp_command(const std::string& socket_path, const std::string& command) {
-    int sock = connect_to_monitor(socket_path);
-    if (sock < 0) {
-        return "";
-    }
-    
-    if (!init_qmp_session(sock)) {
-        close(sock);
+    if (socket_path.empty()) {
         return "";
     }
-    
-    // 发送命令
-    std::string cmd_json = "{\"execute\": \"" + command + "\"}\n";
-    if (send(sock, cmd_json.c_str(), cmd_json.length(), 0) < 0) {
-        close(sock);
+    QmpResult r = qmp_client_for(socket_path)->execute(command, "", 2000);
+    if (!r.ok && r.error_class == "Disconnected") {
+        std::cerr << "[QEMU Monitor] " << r.error_desc << std::endl;
         return "";
     }
-    
-    // 读取响应
-    char buffer[8192];
-    std::string response;
-    
-    struct pollfd pfd;
-    pfd.fd = sock;
-    pfd.events = POLLIN;
-    
-    while (poll(&pfd, 1, 2000) > 0) {
-        ssize_t n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-        if (n <= 0) break;
-        buffer[n] = '\0';
-        response += buffer;
-        if (response.find("\"return\"") != std::string::npos ||
-            response.find("\"error\"") != std::string::npos) {
-            break;
-        }
-    }
-    
-    close(sock);
-    return response;
+    return r.response;
 }
 
 /**
- * 发送 HMP 命令（人类可读格式，用于快照等）
+ * 内部快照作业（QMP snapshot-save/load/delete，作业在后台运行，不阻塞 QEMU 主循环）
  */
-static std::string send_hmp_command(const std::string& socket_path, const std::string& command) {
-    int sock = connect_to_monitor(socket_path);
-    if (sock < 0) {
-        return "";
+static bool run_snapshot_job(const std::string& socket_path, const std::string& command, const std::string& name) {
+    if (socket_path.empty()) {
+        return false;
     }
-    
-    if (!init_qmp_session(sock)) {
-        close(sock);
-        return "";
+    std::string error;
+    bool ok = snapshot_internal_job(*qmp_client_for(socket_path), command, name, "hd0", 30 * 60 * 1000, error);
+    if (!ok) {
+        std::cerr << "[QEMU Monitor] " << error << std::endl;
     }
-    
-    // 构建 QMP 包装的 HMP 命令
-    std::string cmd_json = "{\"execute\": \"human-monitor-command\", "
-                           "\"arguments\": {\"command-line\": \"" + command + "\"}}\n";
-    
-    if (send(sock, cmd_json.c_str(), cmd_json.length(), 0) < 0) {
-        close(sock);
-        return "";
-    }
-    
-    // 读取响应
-    char buffer[8192];
-    std::string response;
-    
-    struct pollfd pfd;
-    pfd.fd = sock;
-    pfd.events = POLLIN;
-    
-    while (poll(&pfd, 1, 5000) > 0) {
-        ssize_t n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-        if (n <= 0) break;
-        buffer[n] = '\0';
-        response += buffer;
-        if (response.find("\"return\"") != std::string::npos ||
-            response.find("\"error\"") != std::string::npos) {
-            break;
-        }
-    }
-    
-    close(sock);
-    return response;
+    return ok;
 }
 
 // ============================================================================
@@ -301,66 +189,34 @@ bool qemu_resume_vm_real(const std::string& monitor_socket) {
 }
 
 /**
- * 创建快照（通过 HMP savevm 命令）
+ * 创建快照（QMP snapshot-save 作业，替代 HMP savevm）
  */
 bool qemu_create_snapshot_real(const std::string& monitor_socket, const std::string& name) {
-    std::string response = send_hmp_command(monitor_socket, "savevm " + name);
-    // savevm 成功时返回空字符串
-    return response.find("\"error\"") == std::string::npos;
+    return run_snapshot_job(monitor_socket, "snapshot-save", name);
 }
 
 /**
- * 恢复快照（通过 HMP loadvm 命令）
+ * 恢复快照（QMP snapshot-load 作业，替代 HMP loadvm）
  */
 bool qemu_restore_snapshot_real(const std::string& monitor_socket, const std::string& name) {
-    std::string response = send_hmp_command(monitor_socket, "loadvm " + name);
-    return response.find("\"error\"") == std::string::npos;
+    return run_snapshot_job(monitor_socket, "snapshot-load", name);
 }
 
 /**
- * 删除快照（通过 HMP delvm 命令）
+ * 删除快照（QMP snapshot-delete 作业，替代 HMP delvm）
  */
 bool qemu_delete_snapshot_real(const std::string& monitor_socket, const std::string& name) {
-    std::string response = send_hmp_command(monitor_socket, "delvm " + name);
-    return response.find("\"error\"") == std::string::npos;
+    return run_snapshot_job(monitor_socket, "snapshot-delete", name);
 }
 
 /**
- * 列出快照（通过 HMP info snapshots 命令）
+ * 列出快照（QMP query-block 中镜像的内部快照列表）
  */
 std::vector<std::string> qemu_list_snapshots_real(const std::string& monitor_socket) {
-    std::vector<std::string> snapshots;
-    
-    std::string response = send_hmp_command(monitor_socket, "info snapshots");
-    
-    // 解析响应，提取快照名称
-    // 格式类似：
-    // ID        TAG               VM SIZE                DATE     VM CLOCK
-    // 1         snapshot1         256M 2024-01-01 12:00:00 00:01:23.456
-    
-    std::istringstream iss(response);
-    std::string line;
-    bool header_passed = false;
-    
-    while (std::getline(iss, line)) {
-        if (line.find("ID") != std::string::npos && line.find("TAG") != std::string::npos) {
-            header_passed = true;
-            continue;
-        }
-        
-        if (header_passed && !line.empty() && line[0] != '{') {
-            // 提取 TAG（第二列）
-            std::istringstream line_stream(line);
-            std::string id, tag;
-            if (line_stream >> id >> tag) {
-                if (!tag.empty() && tag != "--" && tag != "return") {
-                    snapshots.push_back(tag);
-                }
-            }
-        }
+    if (monitor_socket.empty()) {
+        return {};
     }
-    
-    return snapshots;
+    return snapshot_internal_list(*qmp_client_for(monitor_socket), "hd0");
 }
 
 /**
@@ -667,36 +523,28 @@ static std::string build_qemu_command(const qemu_vm_config_t* config) {
     cmd += " -machine " + machine_type;
     cmd += " -cpu " + cpu_type;
     
-    // 内存配置（默认6GB，最大16GB）
-    int memory_mb = config->memory_mb > 0 ? config->memory_mb : 6144;
-    memory_mb = std::min(memory_mb, 16384); // 限制最大16GB
-    cmd += " -m " + std::to_string(memory_mb);
-    
-    // CPU配置（默认4核，最大8核）
-    int cpu_count = config->cpu_count > 0 ? config->cpu_count : 4;
-    cpu_count = std::min(cpu_count, 8); // 限制最大8核
-    cmd += " -smp " + std::to_string(cpu_count);
-    
     // ============================================================
-    // 加速模式 - 智能选择
+    // 性能模式：按宿主核心 / 内存 / JIT 规划 -smp、-m 与加速器（见 tcg_profile）
     // ============================================================
-    if (config->accel_mode && strcmp(config->accel_mode, "kvm") == 0) {
-        // 用户请求 KVM，检查是否可用
-        if (check_kvm_available()) {
-            cmd += " -accel kvm";
-            std::cerr << "[QEMU] ✅ Using KVM hardware acceleration" << std::endl;
-        } else {
-            // KVM 不可用，降级到 TCG
-            cmd += " -accel tcg,thread=multi,tb-size=256";
-            std::cerr << "[QEMU] ⚠️ KVM requested but unavailable (华为没给权限), falling back to TCG" << std::endl;
-        }
-    } else if (config->accel_mode && strcmp(config->accel_mode, "hvf") == 0) {
+    TcgRequest req;
+    if (config->perf_profile) tcg_profile_from_string(config->perf_profile, req.profile);
+    req.accel = config->accel_mode ? config->accel_mode : "";
+    req.cpus = std::min(config->cpu_count, 8);          // 限制最大8核
+    req.memory_mb = std::min(config->memory_mb, 16384); // 限制最大16GB
+    const TcgTuning tuning = tcg_profile_plan(req, tcg_probe_host(g_has_jit_permission, check_kvm_available()));
+    cmd += " -m " + std::to_string(tuning.memory_mb);
+    cmd += " -smp " + std::to_string(tuning.smp);
+
+    if (config->accel_mode && strcmp(config->accel_mode, "hvf") == 0) {
         cmd += " -accel hvf";
         std::cerr << "[QEMU] Using HVF acceleration (macOS)" << std::endl;
     } else {
-        // 默认使用 TCG（多线程，增大翻译缓存）
-        cmd += " -accel tcg,thread=multi,tb-size=256";
-        std::cerr << "[QEMU] Using TCG software emulation" << std::endl;
+        cmd += " -accel " + tuning.accel;
+        if (!tuning.icount.empty()) cmd += " -icount " + tuning.icount;
+        std::cerr << "[QEMU] Profile " << tcg_profile_name(tuning.profile) << ": -accel " << tuning.accel << std::endl;
+        for (const auto& why : tuning.rationale) {
+            std::cerr << "[QEMU]   " << why << std::endl;
+        }
     }
     
     // ============================================================
@@ -784,6 +632,40 @@ static std::string build_qemu_command(const qemu_vm_config_t* config) {
     return cmd;
 }
 
+// ============================================================================
+// QMP 事件 -> 实例状态（guest 或其他 QMP 客户端发起的 stop/cont 也能反映到 qemu_vm_get_state）
+// ============================================================================
+
+static void attach_qmp_state_events(QemuVmInstance* instance) {
+    if (instance->monitor_socket_path.empty() || instance->qmp_event_sub) {
+        return;
+    }
+    instance->qmp_event_sub = qmp_client_for(instance->monitor_socket_path)->subscribe(
+        [instance](const QmpEvent& e) {
+            qemu_vm_state_t expected;
+            if (e.name == "STOP") {
+                expected = QEMU_VM_RUNNING;
+                if (instance->state.compare_exchange_strong(expected, QEMU_VM_PAUSED)) {
+                    instance->is_paused = true;
+                }
+            } else if (e.name == "RESUME") {
+                expected = QEMU_VM_PAUSED;
+                if (instance->state.compare_exchange_strong(expected, QEMU_VM_RUNNING)) {
+                    instance->is_paused = false;
+                }
+            }
+        });
+}
+
+// 实例销毁前必须调用：订阅回调持有裸指针
+static void detach_qmp_state_events(QemuVmInstance* instance) {
+    if (!instance->qmp_event_sub) {
+        return;
+    }
+    qmp_client_for(instance->monitor_socket_path)->unsubscribe(instance->qmp_event_sub);
+    instance->qmp_event_sub = 0;
+}
+
 // ============================================================================
 // QEMU 运行线程（替代 fork/exec，在 HarmonyOS 上运行）
 // ============================================================================
@@ -931,6 +813,9 @@ qemu_vm_handle_t qemu_vm_create(const qemu_vm_config_t* config) {
     if (config->display_mode) {
         instance->config.display_mode = strdup(config->display_mode);
     }
+    if (config->perf_profile) {
+        instance->config.perf_profile = strdup(config->perf_profile);
+    }
 
     qemu_vm_handle_t handle = instance.get();
     g_vm_instances[handle] = std::move(instance);
@@ -1056,6 +941,7 @@ int qemu_vm_start(qemu_vm_handle_t handle) {
         
     // 在新线程中启动 QEMU（替代 fork/exec）
     instance->qemu_thread = std::thread(qemu_run_thread, instance.get(), args);
+    attach_qmp_state_events(instance.get());
         
     // 等待一小段时间确认启动
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -1105,8 +991,10 @@ int qemu_vm_stop(qemu_vm_handle_t handle) {
         instance->qemu_thread.join();
     }
     
-    // 清理 Monitor socket 文件
+    // 清理 Monitor socket 文件（先断开复用的 QMP 长连接）
+    detach_qmp_state_events(instance.get());
     if (!instance->monitor_socket_path.empty()) {
+        qmp_client_release(instance->monitor_socket_path);
         unlink(instance->monitor_socket_path.c_str());
     }
     
@@ -1213,6 +1101,11 @@ void qemu_vm_destroy(qemu_vm_handle_t handle) {
     }
 
     // 等待 QEMU 线程结束（monitor 功能已集成到主线程）
+    // VM 自行退出时不会经过 qemu_vm_stop：这里同样退订并断开，确保读线程不再回调到即将释放的实例
+    detach_qmp_state_events(instance.get());
+    if (!instance->monitor_socket_path.empty()) {
+        qmp_client_release(instance->monitor_socket_path);
+    }
 
     // 释放配置字符串
     if (instance->config.name) {
@@ -1245,6 +1138,9 @@ void qemu_vm_destroy(qemu_vm_handle_t handle) {
     if (instance->config.display_mode) {
         free(const_cast<char*>(instance->config.display_mode));
     }
+    if (instance->config.perf_profile) {
+        free(const_cast<char*>(instance->config.perf_profile));
+    }
 
     g_vm_instances.erase(it);
 }
@@ -1730,6 +1626,20 @@ int qemu_get_vm_logs(const char* vm_name, char** logs, int* line_count) {
     
     *line_count = 0;
     
+    // 优先从内存环形存储取最近的行，不读文件
+    log_flush();
+    uint64_t first = 0;
+    uint64_t next = 0;
+    log_store_bounds(vm_name, first, next);
+    if (next > first) {
+        const uint64_t start = std::max<uint64_t>(first, next > MAX_LOG_LINES ? next - MAX_LOG_LINES : 0);
+        log_store_visit(vm_name, start, MAX_LOG_LINES, [&](uint64_t, std::string_view line) {
+            logs[(*line_count)++] = strndup(line.data(), line.size());
+        });
+        return 0;
+    }
+    
+    // 存储为空（如应用重启后）：回退到日志文件
     // 查找日志文件路径
     std::string log_path;
     auto it = g_vm_log_files.find(vm_name);
@@ -1780,13 +1690,13 @@ int qemu_clear_vm_logs(const char* vm_name) {
         log_path = "/data/storage/el2/base/files/qemu/logs/" + std::string(vm_name) + ".log";
     }
     
-    // 清空日志文件
-    std::ofstream file(log_path, std::ios::trunc);
-    if (!file.is_open()) {
+    // 清空日志文件：经日志管线截断，常驻的追加 fd 与轮转计数一并重置
+    const bool truncated = log_truncate(log_path);
+    log_store_clear(vm_name);
+    if (!truncated) {
         std::cerr << "[QEMU] Cannot open log file for clearing: " << log_path << std::endl;
         return -1;
     }
-    file.close();
     
     std::cerr << "[QEMU] Cleared log file for VM: " << vm_name << std::endl;
     return 0;
@@ -1806,22 +1716,8 @@ void qemu_append_log(const char* vm_name, const char* message) {
         log_path = "/data/storage/el2/base/files/qemu/logs/" + std::string(vm_name) + ".log";
     }
     
-    // 确保目录存在
-    std::string dir = log_path.substr(0, log_path.find_last_of('/'));
-    mkdir(dir.c_str(), 0755);
-    
-    // 追加日志
-    std::ofstream file(log_path, std::ios::app);
-    if (file.is_open()) {
-        // 添加时间戳
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        char timestamp[32];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&time));
-        
-        file << "[" << timestamp << "] " << message << std::endl;
-        file.close();
-    }
+    // 追加日志：带时间戳提交到日志环，目录创建与写入由日志线程完成；同时进入该 VM 的 log_store
+    log_submit(log_sink(log_path, vm_name), kLogFile | kLogTap | kLogTimestamp, "", message);
 }
 
 // RDP客户端管理接口
@@ -1852,6 +1748,7 @@ int qemu_rdp_client_connect(rdp_client_handle_t handle, const rdp_connection_con
     rdp_config.enable_clipboard = config->enable_clipboard != 0;
     rdp_config.enable_file_sharing = config->enable_file_sharing != 0;
     rdp_config.shared_folder = config->shared_folder ? config->shared_folder : "";
+    rdp_config.trusted_fingerprint = config->trusted_fingerprint ? config->trusted_fingerprint : "";
     
     return client->connect(rdp_config) ? 0 : -1;
 }
@@ -1893,6 +1790,45 @@ rdp_connection_state_t rdp_client_get_state(rdp_client_handle_t handle) {
     }
 }
 
+static char* rdp_strdup(const std::string& s) {
+    char* out = new char[s.length() + 1];
+    strcpy(out, s.c_str());
+    return out;
+}
+
+int rdp_client_get_pending_certificate(rdp_client_handle_t handle, rdp_certificate_info_t* info) {
+    if (!handle || !info) {
+        return -1;
+    }
+
+    auto* client = static_cast<RdpClient*>(handle);
+    RdpCertificateInfo cert;
+    if (!client->get_pending_certificate(cert)) {
+        return -1;
+    }
+
+    info->host = rdp_strdup(cert.host);
+    info->port = cert.port;
+    info->common_name = rdp_strdup(cert.common_name);
+    info->subject = rdp_strdup(cert.subject);
+    info->issuer = rdp_strdup(cert.issuer);
+    info->fingerprint = rdp_strdup(cert.fingerprint);
+    info->changed = cert.changed ? 1 : 0;
+    return 0;
+}
+
+void rdp_certificate_info_free(rdp_certificate_info_t* info) {
+    if (!info) {
+        return;
+    }
+    delete[] info->host;
+    delete[] info->common_name;
+    delete[] info->subject;
+    delete[] info->issuer;
+    delete[] info->fingerprint;
+    *info = rdp_certificate_info_t{};
+}
+
 // RDP显示控制
 int rdp_client_set_resolution(rdp_client_handle_t handle, int width, int height) {
     if (!handle) {
@@ -1921,6 +1857,15 @@ int rdp_client_enable_fullscreen(rdp_client_handle_t handle, int enable) {
     return client->enable_fullscreen(enable != 0) ? 0 : -1;
 }
 
+int rdp_client_set_surface(rdp_client_handle_t handle, unsigned long long surface_id, int width, int height) {
+    if (!handle) {
+        return -1;
+    }
+    
+    auto* client = static_cast<RdpClient*>(handle);
+    return client->set_surface(static_cast<uint64_t>(surface_id), width, height) ? 0 : -1;
+}
+
 // RDP输入控制
 int rdp_client_send_mouse_event(rdp_client_handle_t handle, int x, int y, int button, int pressed) {
     if (!handle) {
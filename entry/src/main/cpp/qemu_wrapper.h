@@ -35,8 +35,20 @@ typedef struct {
     int enable_clipboard;               // 是否启用剪贴板共享
     int enable_file_sharing;            // 是否启用文件共享
     const char* shared_folder;          // 共享文件夹路径
+    const char* trusted_fingerprint;    // 用户确认信任的服务器证书指纹（可为空）
 } rdp_connection_config_t;
 
+// 因未受信任被拒绝的服务器证书（字符串由 rdp_certificate_info_free 释放）
+typedef struct {
+    char* host;
+    int port;
+    char* common_name;
+    char* subject;
+    char* issuer;
+    char* fingerprint;
+    int changed;                        // 与已记录的证书不一致
+} rdp_certificate_info_t;
+
 // QEMU 虚拟机配置
 typedef struct {
     const char* name;                    // 虚拟机名称
@@ -55,6 +67,7 @@ typedef struct {
     const char* network_mode;            // 网络模式：user, bridge, none
     const char* accel_mode;              // 加速模式：kvm, tcg, hvf
     const char* display_mode;            // 显示模式：vnc, sdl, gtk, none
+    const char* perf_profile;            // 性能模式：powersaver, balanced（默认）, turbo
 } qemu_vm_config_t;
 
 // QEMU 虚拟机实例句柄
@@ -95,6 +108,9 @@ int qemu_rdp_client_connect(rdp_client_handle_t handle, const rdp_connection_con
 void qemu_rdp_client_disconnect(rdp_client_handle_t handle);
 int rdp_client_is_connected(rdp_client_handle_t handle);
 rdp_connection_state_t rdp_client_get_state(rdp_client_handle_t handle);
+// 最近一次连接被拒绝的证书：有则填充 info 并返回 0，没有返回 -1
+int rdp_client_get_pending_certificate(rdp_client_handle_t handle, rdp_certificate_info_t* info);
+void rdp_certificate_info_free(rdp_certificate_info_t* info);
 
 // RDP 超时检测和强制清理接口
 int rdp_check_timeout(void);           // 检查是否超时，返回超时秒数，0表示未超时
@@ -108,6 +124,8 @@ const char* rdp_get_status_string(void); // 获取状态字符串
 int rdp_client_set_resolution(rdp_client_handle_t handle, int width, int height);
 int rdp_client_set_color_depth(rdp_client_handle_t handle, int depth);
 int rdp_client_enable_fullscreen(rdp_client_handle_t handle, int enable);
+// XComponent 直绘：surface_id 为 0 表示解绑；需要 FreeRDP 构建，否则返回 -1
+int rdp_client_set_surface(rdp_client_handle_t handle, unsigned long long surface_id, int width, int height);
 
 // RDP输入控制
 int rdp_client_send_mouse_event(rdp_client_handle_t handle, int x, int y, int button, int pressed);
@@ -0,0 +1,591 @@
+#include "qmp_client.h"
+#include "third_party/cjson/cJSON.h"
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// ============================================================================
+// JSON 流切分：QMP 是一条 socket 上连续的 JSON 对象（通常以 \r\n 分隔，但不保证一次 recv 恰好一条）。
+// 按花括号深度切出完整的顶层对象，正确跳过字符串内的括号和转义；扫描位置跨 recv 保留，不重复扫描。
+// ============================================================================
+namespace {
+
+class QmpJsonSplitter {
+public:
+    void feed(const char* data, size_t len) { buf_.append(data, len); }
+
+    bool next(std::string& out)
+    {
+        for (; pos_ < buf_.size(); pos_++) {
+            const char c = buf_[pos_];
+            if (in_str_) {
+                if (esc_) {
+                    esc_ = false;
+                } else if (c == '\\') {
+                    esc_ = true;
+                } else if (c == '"') {
+                    in_str_ = false;
+                }
+                continue;
+            }
+            if (c == '"') {
+                if (depth_ > 0) in_str_ = true;
+            } else if (c == '{') {
+                if (depth_++ == 0) start_ = pos_;
+            } else if (c == '}') {
+                if (depth_ > 0 && --depth_ == 0) {
+                    out.assign(buf_, start_, pos_ + 1 - start_);
+                    buf_.erase(0, pos_ + 1);
+                    pos_ = 0;
+                    start_ = std::string::npos;
+                    return true;
+                }
+            }
+        }
+        // 没有完整对象：丢弃对象外的空白，保留未完成的部分
+        if (depth_ == 0) {
+            buf_.clear();
+            pos_ = 0;
+        } else if (start_ > 0 && start_ != std::string::npos) {
+            buf_.erase(0, start_);
+            pos_ -= start_;
+            start_ = 0;
+        }
+        return false;
+    }
+
+private:
+    std::string buf_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+    bool in_str_ = false;
+    bool esc_ = false;
+    size_t start_ = std::string::npos;
+};
+
+bool qmp_send_all(int fd, const std::string& data)
+{
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += (size_t)n;
+    }
+    return true;
+}
+
+std::string qmp_print(const cJSON* item)
+{
+    if (!item) return std::string();
+    char* s = cJSON_PrintUnformatted(item);
+    if (!s) return std::string();
+    std::string out(s);
+    cJSON_free(s);
+    return out;
+}
+
+QmpResult qmp_local_error(const char* cls, const std::string& desc)
+{
+    QmpResult r;
+    r.error_class = cls;
+    r.error_desc = desc;
+    r.response = "{\"error\": {\"class\": " + qmp_json_quote(cls) + ", \"desc\": " + qmp_json_quote(desc) + "}}";
+    return r;
+}
+
+} // namespace
+
+std::string qmp_json_quote(const std::string& s)
+{
+    std::string out;
+    out.reserve(s.size() + 2);
+    out.push_back('"');
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char tmp[8];
+                snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+                out += tmp;
+            } else {
+                out.push_back((char)c);
+            }
+        }
+    }
+    out.push_back('"');
+    return out;
+}
+
+// ============================================================================
+// QmpClient 实现
+// ============================================================================
+
+struct QmpPending {
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    QmpResult result;
+    QmpResultCallback callback; // 非空表示异步请求
+};
+
+// 一次连接的全部状态。读线程与 Impl 各持一份引用，fd 在最后一个持有者释放时关闭：
+// 从回调内断开时读线程只能 detach，它仍只访问自己这条连接，不会碰到重连后的新 fd。
+struct QmpConn {
+    int fd = -1;
+    int wake_pipe[2] = { -1, -1 };
+    QmpJsonSplitter splitter;          // 握手在调用线程，之后只在读线程中使用
+    // 以下由 Impl::pending_mtx 保护
+    bool open = true;
+    std::map<uint64_t, std::shared_ptr<QmpPending>> pending;
+
+    ~QmpConn()
+    {
+        if (fd >= 0) close(fd);
+        for (int p : wake_pipe) {
+            if (p >= 0) close(p);
+        }
+    }
+};
+
+struct QmpClient::Impl : std::enable_shared_from_this<QmpClient::Impl> {
+    std::string path;
+
+    // 建连/断开串行化（握手在调用线程内同步完成，之后交给读线程）
+    std::mutex conn_mtx;
+    std::thread reader;
+
+    std::mutex write_mtx;
+
+    // 当前连接；“open 由真变假”与其 pending 的清空在同一把锁下完成，保证不会有请求漏掉失败通知
+    std::mutex pending_mtx;
+    std::shared_ptr<QmpConn> conn;
+    std::atomic<uint64_t> next_id{1};
+
+    std::mutex sub_mtx;
+    std::map<uint64_t, QmpEventCallback> subs;
+    uint64_t next_sub = 1;
+
+    explicit Impl(const std::string& p) : path(p) {}
+
+    static bool read_message(QmpConn& c, std::string& out, std::chrono::steady_clock::time_point deadline)
+    {
+        char buf[4096];
+        while (!c.splitter.next(out)) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) return false;
+            struct pollfd pfd;
+            pfd.fd = c.fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            const int prc = poll(&pfd, 1, (int)left);
+            if (prc < 0 && errno == EINTR) continue;
+            if (prc <= 0) return false;
+            ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            c.splitter.feed(buf, (size_t)n);
+        }
+        return true;
+    }
+
+    std::shared_ptr<QmpConn> current()
+    {
+        std::lock_guard<std::mutex> lk(pending_mtx);
+        return conn;
+    }
+
+    // 需持有 conn_mtx：摘下当前连接并让读线程退出。fd 由最后一个持有者关闭，
+    // 在途请求的失败通知和 QMP_DISCONNECTED 由读线程在退出时发出。
+    void teardown_locked()
+    {
+        std::shared_ptr<QmpConn> c;
+        {
+            std::lock_guard<std::mutex> lk(pending_mtx);
+            c.swap(conn);
+        }
+        if (c && c->wake_pipe[1] >= 0) {
+            const char b = 1;
+            (void)write(c->wake_pipe[1], &b, 1);
+        }
+        if (reader.joinable()) {
+            if (reader.get_id() == std::this_thread::get_id()) {
+                reader.detach();
+            } else {
+                reader.join();
+            }
+        }
+    }
+
+    bool connect_locked(int timeout_ms)
+    {
+        int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (s < 0) return false;
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(s);
+            return false;
+        }
+        auto c = std::make_shared<QmpConn>();
+        c->fd = s;
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        std::string msg;
+        if (!read_message(*c, msg, deadline) || msg.find("\"QMP\"") == std::string::npos) {
+            std::cerr << "[QMP] No greeting from " << path << std::endl;
+            return false;
+        }
+        if (!qmp_send_all(c->fd, "{\"execute\": \"qmp_capabilities\"}\n")) {
+            return false;
+        }
+        // 进入命令模式前不会有事件；第一条 return/error 即握手结果
+        if (!read_message(*c, msg, deadline) || msg.find("\"return\"") == std::string::npos) {
+            std::cerr << "[QMP] qmp_capabilities failed on " << path << ": " << msg << std::endl;
+            return false;
+        }
+
+        if (pipe2(c->wake_pipe, O_CLOEXEC) != 0) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lk(pending_mtx);
+            conn = c;
+        }
+        // 读线程持有 Impl 和连接的引用：即使从回调内断开（只能 detach），也不会访问已释放的对象
+        reader = std::thread([self = shared_from_this(), c]() { self->reader_loop(c); });
+        return true;
+    }
+
+    void complete(const std::shared_ptr<QmpPending>& p, QmpResult&& r)
+    {
+        if (p->callback) {
+            p->callback(r);
+            return;
+        }
+        std::lock_guard<std::mutex> lk(p->m);
+        p->result = std::move(r);
+        p->done = true;
+        p->cv.notify_all();
+    }
+
+    void dispatch_event(const QmpEvent& ev)
+    {
+        std::vector<QmpEventCallback> cbs;
+        {
+            std::lock_guard<std::mutex> lk(sub_mtx);
+            cbs.reserve(subs.size());
+            for (const auto& kv : subs) cbs.push_back(kv.second);
+        }
+        for (const auto& cb : cbs) {
+            if (cb) cb(ev);
+        }
+    }
+
+    void handle_message(QmpConn& c, const std::string& text)
+    {
+        cJSON* root = cJSON_ParseWithLength(text.data(), text.size());
+        if (!root) {
+            std::cerr << "[QMP] Unparsable message: " << text << std::endl;
+            return;
+        }
+        const cJSON* event = cJSON_GetObjectItemCaseSensitive(root, "event");
+        if (cJSON_IsString(event)) {
+            QmpEvent ev;
+            ev.name = event->valuestring;
+            const cJSON* data = cJSON_GetObjectItemCaseSensitive(root, "data");
+            ev.data = data ? qmp_print(data) : std::string("{}");
+            const cJSON* ts = cJSON_GetObjectItemCaseSensitive(root, "timestamp");
+            const cJSON* sec = ts ? cJSON_GetObjectItemCaseSensitive(ts, "seconds") : nullptr;
+            const cJSON* usec = ts ? cJSON_GetObjectItemCaseSensitive(ts, "microseconds") : nullptr;
+            if (cJSON_IsNumber(sec)) ev.seconds = (int64_t)sec->valuedouble;
+            if (cJSON_IsNumber(usec)) ev.microseconds = (int64_t)usec->valuedouble;
+            cJSON_Delete(root);
+            dispatch_event(ev);
+            return;
+        }
+
+        const cJSON* id = cJSON_GetObjectItemCaseSensitive(root, "id");
+        if (!cJSON_IsNumber(id)) {
+            cJSON_Delete(root);
+            return;
+        }
+        std::shared_ptr<QmpPending> p;
+        {
+            std::lock_guard<std::mutex> lk(pending_mtx);
+            auto it = c.pending.find((uint64_t)id->valuedouble);
+            if (it != c.pending.end()) {
+                p = std::move(it->second);
+                c.pending.erase(it);
+            }
+        }
+        if (!p) {
+            cJSON_Delete(root); // 已超时放弃的请求
+            return;
+        }
+
+        QmpResult r;
+        r.response = text;
+        const cJSON* ret = cJSON_GetObjectItemCaseSensitive(root, "return");
+        const cJSON* err = cJSON_GetObjectItemCaseSensitive(root, "error");
+        if (ret) {
+            r.ok = true;
+            r.value = cJSON_IsString(ret) ? std::string(ret->valuestring) : qmp_print(ret);
+        } else if (err) {
+            const cJSON* cls = cJSON_GetObjectItemCaseSensitive(err, "class");
+            const cJSON* desc = cJSON_GetObjectItemCaseSensitive(err, "desc");
+            if (cJSON_IsString(cls)) r.error_class = cls->valuestring;
+            if (cJSON_IsString(desc)) r.error_desc = desc->valuestring;
+        }
+        cJSON_Delete(root);
+        complete(p, std::move(r));
+    }
+
+    // 只使用启动时拿到的连接 c：回调内断开后 conn 可能已换成新连接
+    void reader_loop(const std::shared_ptr<QmpConn>& c)
+    {
+        char buf[8192];
+        std::string msg;
+        while (true) {
+            struct pollfd pfds[2];
+            pfds[0].fd = c->fd;
+            pfds[0].events = POLLIN;
+            pfds[0].revents = 0;
+            pfds[1].fd = c->wake_pipe[0];
+            pfds[1].events = POLLIN;
+            pfds[1].revents = 0;
+            const int prc = poll(pfds, 2, -1);
+            if (prc < 0 && errno == EINTR) continue;
+            if (prc < 0 || (pfds[1].revents & (POLLIN | POLLNVAL)) || (pfds[0].revents & POLLNVAL)) break;
+            if (!(pfds[0].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            c->splitter.feed(buf, (size_t)n);
+            while (c->splitter.next(msg)) {
+                handle_message(*c, msg);
+                // 回调内断开：剩余的已缓冲消息不再分发
+                if (current() != c) break;
+            }
+            if (current() != c) break;
+        }
+
+        // 连接结束：所有在途请求立即失败，并通知订阅者
+        std::map<uint64_t, std::shared_ptr<QmpPending>> orphans;
+        {
+            std::lock_guard<std::mutex> lk(pending_mtx);
+            c->open = false;
+            orphans.swap(c->pending);
+        }
+        for (auto& kv : orphans) {
+            complete(kv.second, qmp_local_error("Disconnected", "QMP connection closed"));
+        }
+        QmpEvent ev;
+        ev.name = "QMP_DISCONNECTED";
+        ev.data = "{}";
+        dispatch_event(ev);
+    }
+
+    bool is_connected()
+    {
+        std::lock_guard<std::mutex> lk(pending_mtx);
+        return conn && conn->open;
+    }
+
+    // 登记一个在途请求；连接不可用时返回 nullptr
+    std::shared_ptr<QmpConn> add_pending(uint64_t id, const std::shared_ptr<QmpPending>& p)
+    {
+        std::lock_guard<std::mutex> lk(pending_mtx);
+        if (!conn || !conn->open) return nullptr;
+        conn->pending[id] = p;
+        return conn;
+    }
+
+    std::shared_ptr<QmpPending> take_pending(QmpConn& c, uint64_t id)
+    {
+        std::lock_guard<std::mutex> lk(pending_mtx);
+        auto it = c.pending.find(id);
+        if (it == c.pending.end()) return nullptr;
+        std::shared_ptr<QmpPending> p = std::move(it->second);
+        c.pending.erase(it);
+        return p;
+    }
+
+    bool send(QmpConn& c, const std::string& req)
+    {
+        std::lock_guard<std::mutex> lk(write_mtx);
+        return qmp_send_all(c.fd, req);
+    }
+};
+
+QmpClient::QmpClient(const std::string& socket_path) : impl_(std::make_shared<Impl>(socket_path)) {}
+
+QmpClient::~QmpClient()
+{
+    disconnect();
+}
+
+bool QmpClient::ensure_connected(int timeout_ms)
+{
+    std::lock_guard<std::mutex> lk(impl_->conn_mtx);
+    if (impl_->is_connected()) return true;
+    // 读线程已因断开退出（或握手失败未启动）：先回收，再重连
+    impl_->teardown_locked();
+    return impl_->connect_locked(timeout_ms);
+}
+
+bool QmpClient::is_connected() const
+{
+    return impl_->is_connected();
+}
+
+void QmpClient::disconnect()
+{
+    std::lock_guard<std::mutex> lk(impl_->conn_mtx);
+    impl_->teardown_locked();
+}
+
+const std::string& QmpClient::socket_path() const
+{
+    return impl_->path;
+}
+
+uint64_t QmpClient::execute_async(const std::string& command, const std::string& args_json, QmpResultCallback done)
+{
+    auto p = std::make_shared<QmpPending>();
+    p->callback = std::move(done);
+    if (!ensure_connected()) {
+        impl_->complete(p, qmp_local_error("Disconnected", "QMP socket not available: " + impl_->path));
+        return 0;
+    }
+
+    const uint64_t id = impl_->next_id.fetch_add(1);
+    // 回调可能重入本客户端，complete() 一律在锁外调用
+    std::shared_ptr<QmpConn> c = impl_->add_pending(id, p);
+    if (!c) {
+        impl_->complete(p, qmp_local_error("Disconnected", "QMP connection closed"));
+        return 0;
+    }
+
+    std::string req = "{\"execute\": " + qmp_json_quote(command);
+    if (!args_json.empty()) req += ", \"arguments\": " + args_json;
+    req += ", \"id\": " + std::to_string(id) + "}\n";
+
+    if (!impl_->send(*c, req)) {
+        // 读线程可能已经以 Disconnected 完成了它
+        std::shared_ptr<QmpPending> mine = impl_->take_pending(*c, id);
+        if (mine) impl_->complete(mine, qmp_local_error("SendFailed", "failed to write QMP request"));
+        return 0;
+    }
+    return id;
+}
+
+QmpResult QmpClient::execute(const std::string& command, const std::string& args_json, int timeout_ms)
+{
+    auto p = std::make_shared<QmpPending>();
+    if (!ensure_connected()) {
+        return qmp_local_error("Disconnected", "QMP socket not available: " + impl_->path);
+    }
+
+    const uint64_t id = impl_->next_id.fetch_add(1);
+    std::shared_ptr<QmpConn> c = impl_->add_pending(id, p);
+    if (!c) return qmp_local_error("Disconnected", "QMP connection closed");
+
+    std::string req = "{\"execute\": " + qmp_json_quote(command);
+    if (!args_json.empty()) req += ", \"arguments\": " + args_json;
+    req += ", \"id\": " + std::to_string(id) + "}\n";
+
+    const bool sent = impl_->send(*c, req);
+
+    QmpResult r;
+    std::unique_lock<std::mutex> lk(p->m);
+    if (sent) {
+        p->cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&]() { return p->done; });
+    }
+    if (!p->done) {
+        lk.unlock();
+        // 超时或发送失败：撤销等待（迟到的响应会被读线程丢弃）
+        (void)impl_->take_pending(*c, id);
+        lk.lock();
+    }
+    if (p->done) {
+        r = std::move(p->result);
+    } else {
+        r = sent ? qmp_local_error("Timeout", "QMP command timed out: " + command)
+                 : qmp_local_error("SendFailed", "failed to write QMP request");
+    }
+    r.sent = sent;
+    return r;
+}
+
+QmpResult QmpClient::execute_hmp(const std::string& command_line, int timeout_ms)
+{
+    return execute("human-monitor-command", "{\"command-line\": " + qmp_json_quote(command_line) + "}", timeout_ms);
+}
+
+uint64_t QmpClient::subscribe(QmpEventCallback callback)
+{
+    std::lock_guard<std::mutex> lk(impl_->sub_mtx);
+    const uint64_t id = impl_->next_sub++;
+    impl_->subs[id] = std::move(callback);
+    return id;
+}
+
+void QmpClient::unsubscribe(uint64_t subscription_id)
+{
+    std::lock_guard<std::mutex> lk(impl_->sub_mtx);
+    impl_->subs.erase(subscription_id);
+}
+
+// ============================================================================
+// 每个 VM 一条共享连接
+// ============================================================================
+
+static std::mutex g_qmp_clients_mutex;
+static std::map<std::string, std::shared_ptr<QmpClient>> g_qmp_clients;
+
+std::shared_ptr<QmpClient> qmp_client_for(const std::string& socket_path)
+{
+    std::lock_guard<std::mutex> lk(g_qmp_clients_mutex);
+    auto& c = g_qmp_clients[socket_path];
+    if (!c) c = std::make_shared<QmpClient>(socket_path);
+    return c;
+}
+
+void qmp_client_release(const std::string& socket_path)
+{
+    std::shared_ptr<QmpClient> c;
+    {
+        std::lock_guard<std::mutex> lk(g_qmp_clients_mutex);
+        auto it = g_qmp_clients.find(socket_path);
+        if (it == g_qmp_clients.end()) return;
+        c = std::move(it->second);
+        g_qmp_clients.erase(it);
+    }
+    c->disconnect();
+}
@@ -0,0 +1,73 @@
+#ifndef QMP_CLIENT_H
+#define QMP_CLIENT_H
+
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <memory>
+
+// QMP 命令结果
+struct QmpResult {
+    bool ok = false;           // 收到 "return"
+    bool sent = false;         // 请求已写入 socket（execute 设置；用于 quit 这类可能收不到回复的命令）
+    std::string response;      // 完整响应 JSON（兼容按字符串匹配 "return"/"error" 的旧调用方）
+    std::string value;         // "return" 的 JSON 文本（字符串类型的返回值为解码后的原文，如 HMP 输出）
+    std::string error_class;   // "error.class"；本地错误为 "Disconnected" / "Timeout" / "SendFailed"
+    std::string error_desc;    // "error.desc"
+};
+
+// QMP 异步事件（STOP/RESUME/SHUTDOWN/BLOCK_JOB_* 等）。
+// 连接断开时会额外派发一次本地事件 "QMP_DISCONNECTED"。
+struct QmpEvent {
+    std::string name;
+    std::string data;          // "data" 的 JSON 文本（无则为 "{}"）
+    int64_t seconds = 0;
+    int64_t microseconds = 0;
+};
+
+using QmpEventCallback = std::function<void(const QmpEvent& event)>;
+using QmpResultCallback = std::function<void(const QmpResult& result)>;
+
+// 长连接 QMP 会话：
+// - 握手（greeting + qmp_capabilities）只在建连时做一次，断开后下一次调用自动重连
+// - 后台读线程按 "id" 把响应分发给等待者，多个命令可同时在途（流水线）
+// - 事件推送给订阅者（在读线程中回调，回调内不要阻塞或再同步调用 execute）
+class QmpClient {
+public:
+    explicit QmpClient(const std::string& socket_path);
+    ~QmpClient();
+
+    QmpClient(const QmpClient&) = delete;
+    QmpClient& operator=(const QmpClient&) = delete;
+
+    // 连接管理
+    bool ensure_connected(int timeout_ms = 2000);
+    bool is_connected() const;
+    void disconnect();
+    const std::string& socket_path() const;
+
+    // 执行命令。args_json 为 "arguments" 对象的 JSON 文本（可为空）
+    QmpResult execute(const std::string& command, const std::string& args_json = "", int timeout_ms = 5000);
+    // 异步执行：done 在读线程（或发送失败时在调用线程）中回调；返回请求 id，0 表示未发送
+    uint64_t execute_async(const std::string& command, const std::string& args_json, QmpResultCallback done);
+    // 便捷封装：human-monitor-command
+    QmpResult execute_hmp(const std::string& command_line, int timeout_ms = 5000);
+
+    // 事件订阅：返回订阅 id（>0）
+    uint64_t subscribe(QmpEventCallback callback);
+    void unsubscribe(uint64_t subscription_id);
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> impl_;
+};
+
+// 进程内按 socket 路径共享的 QMP 会话（每个 VM 一条长连接）
+std::shared_ptr<QmpClient> qmp_client_for(const std::string& socket_path);
+// VM 退出后释放会话（断开连接并从注册表移除）
+void qmp_client_release(const std::string& socket_path);
+
+// 把字符串编码为 JSON 字符串字面量（含引号），用于拼接 arguments
+std::string qmp_json_quote(const std::string& s);
+
+#endif // QMP_CLIENT_H
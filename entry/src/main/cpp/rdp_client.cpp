@@ -5,6 +5,7 @@
 #include <condition_variable>
 #include <chrono>
 #include <cstring>
+#include <cctype>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -12,9 +13,37 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <signal.h>
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <algorithm>
+#include <map>
+#include <set>
+
+#ifdef HAVE_FREERDP
+// 完整的 RDP 会话（TLS/CredSSP/MCS/许可证/图形通道）由 libfreerdp 完成；
+// 图形走 RDPGFX 动态通道，由 libfreerdp/gdi/gfx.c 合成到 gdi 主缓冲
+#include <freerdp/freerdp.h>
+#include <freerdp/client.h>
+#include <freerdp/client/channels.h>
+#include <freerdp/client/rdpgfx.h>
+#include <freerdp/channels/rdpgfx.h>
+#include <freerdp/event.h>
+#include <freerdp/gdi/gdi.h>
+#include <freerdp/gdi/gfx.h>
+#include <freerdp/input.h>
+#include <freerdp/update.h>
+#include <winpr/input.h>
+#include <winpr/synch.h>
+#include "rdp_h264_decoder.h"
+#endif
+
+#if defined(HAVE_FREERDP) && defined(__OHOS__)
+#include <native_window/external_window.h>
+#include <native_buffer/native_buffer.h>
+#include "vm_sched.h"
+#endif
 
 // RDP 协议常量
 #define RDP_DEFAULT_PORT 3389
@@ -33,6 +62,19 @@ static pthread_t g_rdp_worker_thread = 0;
 // 注意：上面使用简单的 volatile 全局变量替代了 std::atomic
 // 这样可以完全避免 C++ 原子操作可能导致的 SIGILL 问题
 
+#ifdef HAVE_FREERDP
+// 正在运行的 FreeRDP 会话：取消/强制清理时对它们 abort（freerdp_connect 阻塞期间也能打断）
+static std::mutex g_rdp_sessions_mtx;
+static std::set<rdpContext*> g_rdp_sessions;
+
+static void rdp_abort_sessions() {
+    std::lock_guard<std::mutex> lock(g_rdp_sessions_mtx);
+    for (rdpContext* ctx : g_rdp_sessions) {
+        freerdp_abort_connect_context(ctx);
+    }
+}
+#endif
+
 // 更新活动时间戳
 static void rdp_update_activity() {
     auto now = std::chrono::steady_clock::now();
@@ -73,6 +115,9 @@ extern "C" void rdp_set_timeout(int seconds) {
 // 请求取消连接
 extern "C" void rdp_request_cancel() {
     g_rdp_cancel_requested = true;
+#ifdef HAVE_FREERDP
+    rdp_abort_sessions();
+#endif
     
     // 发送信号中断阻塞的线程
     if (g_rdp_worker_thread != 0) {
@@ -89,6 +134,9 @@ extern "C" int rdp_is_cancel_requested() {
 extern "C" void rdp_force_cleanup() {
     // 标记取消
     g_rdp_cancel_requested = true;
+#ifdef HAVE_FREERDP
+    rdp_abort_sessions();
+#endif
     
     // 发送信号
     if (g_rdp_worker_thread != 0) {
@@ -132,15 +180,813 @@ extern "C" const char* rdp_get_status_string() {
     return "disconnected";  // 未连接
 }
 
+#ifdef HAVE_FREERDP
+// 桌面脏区（矩形列表，过多时收敛为包围盒）
+struct RdpDirtyRect {
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
+struct RdpDamage {
+    static constexpr size_t kMaxRects = 16;
+    std::vector<RdpDirtyRect> rects;
+
+    bool Empty() const { return rects.empty(); }
+    void Clear() { rects.clear(); }
+
+    void AddFull(int fbW, int fbH)
+    {
+        rects.clear();
+        if (fbW > 0 && fbH > 0) rects.push_back(RdpDirtyRect{ 0, 0, fbW, fbH });
+    }
+
+    void Add(int x, int y, int w, int h, int fbW, int fbH)
+    {
+        const int x0 = std::max(0, x);
+        const int y0 = std::max(0, y);
+        const int x1 = std::min(fbW, x + w);
+        const int y1 = std::min(fbH, y + h);
+        if (x1 <= x0 || y1 <= y0) return;
+        // 被已有矩形完全覆盖的不再重复记录
+        for (const auto& o : rects) {
+            if (x0 >= o.x && y0 >= o.y && x1 <= o.x + o.w && y1 <= o.y + o.h) return;
+        }
+        rects.push_back(RdpDirtyRect{ x0, y0, x1 - x0, y1 - y0 });
+        if (rects.size() > kMaxRects) {
+            RdpDirtyRect b = rects[0];
+            for (const auto& o : rects) {
+                const int bx1 = std::max(b.x + b.w, o.x + o.w);
+                const int by1 = std::max(b.y + b.h, o.y + o.h);
+                b.x = std::min(b.x, o.x);
+                b.y = std::min(b.y, o.y);
+                b.w = bx1 - b.x;
+                b.h = by1 - b.y;
+            }
+            rects.clear();
+            rects.push_back(b);
+        }
+    }
+
+    void Merge(const RdpDamage& o, int fbW, int fbH)
+    {
+        for (const auto& r : o.rects) Add(r.x, r.y, r.w, r.h, fbW, fbH);
+    }
+};
+
+// X11 keysym -> Windows 虚拟键码（再由 WinPR 换算成 RDP 扫描码）；
+// 返回 0 表示没有对应的物理键，调用方改发 Unicode 键盘事件
+static DWORD rdp_vk_from_keysym(uint32_t ks)
+{
+    if (ks >= 'a' && ks <= 'z') return VK_KEY_A + (ks - 'a');
+    if (ks >= 'A' && ks <= 'Z') return VK_KEY_A + (ks - 'A');  // X11 约定：Shift 已单独按下
+    if (ks >= '0' && ks <= '9') return VK_KEY_0 + (ks - '0');
+    if (ks >= 0xFFBE && ks <= 0xFFC9) return VK_F1 + (ks - 0xFFBE);  // F1..F12
+    switch (ks) {
+        case 0x0020: return VK_SPACE;
+        // US 布局下不需要 Shift 的标点：走物理键，保证 Ctrl+/ 之类的快捷键可用
+        case '-': return VK_OEM_MINUS;
+        case '=': return VK_OEM_PLUS;
+        case '[': return VK_OEM_4;
+        case ']': return VK_OEM_6;
+        case '\\': return VK_OEM_5;
+        case ';': return VK_OEM_1;
+        case '\'': return VK_OEM_7;
+        case '`': return VK_OEM_3;
+        case ',': return VK_OEM_COMMA;
+        case '.': return VK_OEM_PERIOD;
+        case '/': return VK_OEM_2;
+        case 0xFF08: return VK_BACK;
+        case 0xFF09: return VK_TAB;
+        case 0xFF0D: return VK_RETURN;
+        case 0xFF13: return VK_PAUSE;
+        case 0xFF14: return VK_SCROLL;
+        case 0xFF1B: return VK_ESCAPE;
+        case 0xFF50: return VK_HOME;
+        case 0xFF51: return VK_LEFT;
+        case 0xFF52: return VK_UP;
+        case 0xFF53: return VK_RIGHT;
+        case 0xFF54: return VK_DOWN;
+        case 0xFF55: return VK_PRIOR;
+        case 0xFF56: return VK_NEXT;
+        case 0xFF57: return VK_END;
+        case 0xFF61: return VK_SNAPSHOT;
+        case 0xFF63: return VK_INSERT;
+        case 0xFF67: return VK_APPS;
+        case 0xFF7F: return VK_NUMLOCK;
+        case 0xFFE1: return VK_LSHIFT;
+        case 0xFFE2: return VK_RSHIFT;
+        case 0xFFE3: return VK_LCONTROL;
+        case 0xFFE4: return VK_RCONTROL;
+        case 0xFFE5: return VK_CAPITAL;
+        case 0xFFE7: // Meta_L
+        case 0xFFE9: return VK_LMENU;
+        case 0xFFE8: // Meta_R
+        case 0xFFEA: return VK_RMENU;
+        case 0xFFEB: return VK_LWIN;
+        case 0xFFEC: return VK_RWIN;
+        case 0xFFFF: return VK_DELETE;
+        default: return 0;
+    }
+}
+
+// 没有物理键的 keysym 对应的 Unicode 码点（Latin-1 与 0x01xxxxxx 形式的 Unicode keysym），0 表示无法发送
+static uint32_t rdp_unicode_from_keysym(uint32_t ks)
+{
+    if ((ks >= 0x20 && ks <= 0x7E) || (ks >= 0xA0 && ks <= 0xFF)) return ks;
+    if ((ks & 0xFF000000u) == 0x01000000u) return ks & 0x00FFFFFFu;
+    return 0;
+}
+
+// UTF-8 -> UTF-16 码元（非法字节按 U+FFFD 处理）
+static std::vector<uint16_t> rdp_utf8_to_utf16(const std::string& text)
+{
+    std::vector<uint16_t> out;
+    out.reserve(text.size());
+    size_t i = 0;
+    while (i < text.size()) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        uint32_t cp = 0xFFFD;
+        size_t len = 1;
+        if (c < 0x80) {
+            cp = c;
+        } else if ((c & 0xE0) == 0xC0) {
+            len = 2;
+        } else if ((c & 0xF0) == 0xE0) {
+            len = 3;
+        } else if ((c & 0xF8) == 0xF0) {
+            len = 4;
+        }
+        if (len > 1) {
+            if (i + len > text.size()) break;
+            cp = c & (0x7F >> len);
+            for (size_t k = 1; k < len; k++) {
+                const unsigned char cc = static_cast<unsigned char>(text[i + k]);
+                if ((cc & 0xC0) != 0x80) {
+                    cp = 0xFFFD;
+                    len = k;
+                    break;
+                }
+                cp = (cp << 6) | (cc & 0x3F);
+            }
+        }
+        i += len;
+        if (cp >= 0x10000 && cp <= 0x10FFFF) {
+            cp -= 0x10000;
+            out.push_back(static_cast<uint16_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<uint16_t>(0xDC00 + (cp & 0x3FF)));
+        } else {
+            out.push_back(static_cast<uint16_t>(cp > 0xFFFF ? 0xFFFD : cp));
+        }
+    }
+    return out;
+}
+
+// 本机回环地址（VM 的 hostfwd 端口）：证书是客户机自签的，直接忽略校验
+static bool rdp_is_loopback_host(const std::string& host)
+{
+    return host == "localhost" || host == "::1" || host.rfind("127.", 0) == 0;
+}
+#endif
+
 // RDP 客户端实现 - 带有真正的网络连接
 class RdpClient::Impl {
 public:
     Impl() : socket_fd(-1), state(RdpConnectionState::DISCONNECTED), connected(false) {}
-    
+
     ~Impl() {
         disconnect();
+#ifdef HAVE_FREERDP
+        set_surface(0, 0, 0);
+#if defined(__OHOS__)
+        stop_render();
+#endif
+        free_context();
+#endif
     }
-    
+
+#ifdef HAVE_FREERDP
+    // FreeRDP 上下文：rdpClientContext 必须是第一个成员（freerdp_client_context_new 按 ContextSize 分配）
+    struct Context {
+        rdpClientContext common;
+        Impl* impl;
+    };
+
+    static Impl* from(rdpContext* ctx) {
+        return ctx ? reinterpret_cast<Context*>(ctx)->impl : nullptr;
+    }
+
+    static BOOL client_new(freerdp* instance, rdpContext* context) {
+        (void)context;
+        // 覆盖 client/common 默认的命令行交互回调（会阻塞读 stdin）
+        instance->PreConnect = on_pre_connect;
+        instance->PostConnect = on_post_connect;
+        instance->PostDisconnect = on_post_disconnect;
+        instance->AuthenticateEx = on_authenticate;
+        instance->VerifyCertificateEx = on_verify_certificate;
+        instance->VerifyChangedCertificateEx = on_verify_changed_certificate;
+        return TRUE;
+    }
+
+    static BOOL on_pre_connect(freerdp* instance) {
+        rdpContext* ctx = instance->context;
+        if (!freerdp_settings_set_uint32(ctx->settings, FreeRDP_OsMajorType, OSMAJORTYPE_UNIX)) {
+            return FALSE;
+        }
+        // 通道加载（含 SupportGraphicsPipeline 对应的 rdpgfx）由 client/common 的 LoadChannels 完成
+        PubSub_SubscribeChannelConnected(ctx->pubSub, on_channel_connected);
+        PubSub_SubscribeChannelDisconnected(ctx->pubSub, on_channel_disconnected);
+        return TRUE;
+    }
+
+    static BOOL on_post_connect(freerdp* instance) {
+        Impl* self = from(instance->context);
+        // 与 NativeWindow 的 NATIVEBUFFER_PIXEL_FMT_BGRA_8888 字节序一致，render 线程可直接 memcpy
+        if (!self || !gdi_init(instance, PIXEL_FORMAT_BGRA32)) {
+            return FALSE;
+        }
+        rdpUpdate* update = instance->context->update;
+        update->EndPaint = on_end_paint;
+        update->DesktopResize = on_desktop_resize;
+
+        rdpGdi* gdi = instance->context->gdi;
+        {
+            std::lock_guard<std::mutex> lk(self->gdi_mtx);
+            self->gdi_ready = true;
+        }
+        rdp_update_lock(update);
+        self->damage.AddFull(gdi->width, gdi->height);
+        rdp_update_unlock(update);
+        self->publish_frame(gdi->width, gdi->height);
+        self->log("[RDP] Desktop " + std::to_string(gdi->width) + "x" + std::to_string(gdi->height));
+        return TRUE;
+    }
+
+    static void on_post_disconnect(freerdp* instance) {
+        rdpContext* ctx = instance->context;
+        Impl* self = from(ctx);
+        PubSub_UnsubscribeChannelConnected(ctx->pubSub, on_channel_connected);
+        PubSub_UnsubscribeChannelDisconnected(ctx->pubSub, on_channel_disconnected);
+        if (self) {
+            // render 线程只在 gdi_ready 下读主缓冲：释放前先摘掉
+            std::lock_guard<std::mutex> lk(self->gdi_mtx);
+            self->gdi_ready = false;
+            gdi_free(instance);
+        } else {
+            gdi_free(instance);
+        }
+    }
+
+    static void on_channel_connected(void* context, const ChannelConnectedEventArgs* e) {
+        auto* cctx = static_cast<rdpClientContext*>(context);
+        if (strcmp(e->name, RDPGFX_DVC_CHANNEL_NAME) == 0) {
+            // RDPGFX：表面命令（RemoteFX/Progressive/Planar/ClearCodec 等）由 gdi/gfx.c 解码后输出到主缓冲
+            gdi_graphics_pipeline_init(cctx->context.gdi, static_cast<RdpgfxClientContext*>(e->pInterface));
+            Impl* self = from(&cctx->context);
+            if (self) self->log("[RDP] Graphics pipeline (RDPGFX) connected");
+            return;
+        }
+        freerdp_client_OnChannelConnectedEventHandler(context, e);
+    }
+
+    static void on_channel_disconnected(void* context, const ChannelDisconnectedEventArgs* e) {
+        auto* cctx = static_cast<rdpClientContext*>(context);
+        if (strcmp(e->name, RDPGFX_DVC_CHANNEL_NAME) == 0) {
+            gdi_graphics_pipeline_uninit(cctx->context.gdi, static_cast<RdpgfxClientContext*>(e->pInterface));
+            return;
+        }
+        freerdp_client_OnChannelDisconnectedEventHandler(context, e);
+    }
+
+    // update_end_paint 持有 update 锁调用：只记录脏区并唤醒 render 线程，拷贝在 render 线程完成
+    static BOOL on_end_paint(rdpContext* ctx) {
+        Impl* self = from(ctx);
+        rdpGdi* gdi = ctx->gdi;
+        if (!self || !gdi || gdi->suppressOutput || !gdi->primary) return TRUE;
+        HGDI_WND hwnd = gdi->primary->hdc->hwnd;
+        if (!hwnd || hwnd->ninvalid < 1) return TRUE;
+        for (INT32 i = 0; i < hwnd->ninvalid; i++) {
+            const GDI_RGN& rgn = hwnd->cinvalid[i];
+            self->damage.Add(rgn.x, rgn.y, rgn.w, rgn.h, gdi->width, gdi->height);
+        }
+        self->publish_frame(gdi->width, gdi->height);
+        return TRUE;
+    }
+
+    static BOOL on_desktop_resize(rdpContext* ctx) {
+        Impl* self = from(ctx);
+        rdpGdi* gdi = ctx->gdi;
+        if (!self || !gdi) return FALSE;
+        const UINT32 w = freerdp_settings_get_uint32(ctx->settings, FreeRDP_DesktopWidth);
+        const UINT32 h = freerdp_settings_get_uint32(ctx->settings, FreeRDP_DesktopHeight);
+        // 主缓冲会被重新分配：与 render 线程的读取互斥
+        rdp_update_lock(ctx->update);
+        const BOOL ok = gdi_resize(gdi, w, h);
+        self->damage.AddFull(gdi->width, gdi->height);
+        rdp_update_unlock(ctx->update);
+        self->publish_frame(gdi->width, gdi->height);
+        self->log("[RDP] Desktop resized to " + std::to_string(w) + "x" + std::to_string(h));
+        return ok;
+    }
+
+    // 非交互：凭据在连接前已写入 settings，缺省时按空凭据继续（由服务器决定是否显示登录界面）
+    static BOOL on_authenticate(freerdp* instance, char** username, char** password, char** domain,
+        rdp_auth_reason reason) {
+        (void)instance;
+        (void)username;
+        (void)password;
+        (void)domain;
+        (void)reason;
+        return TRUE;
+    }
+
+    static bool rdp_fingerprint_equal(const std::string& a, const char* b) {
+        if (!b || a.empty() || a.size() != strlen(b)) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i]))) return false;
+        }
+        return true;
+    }
+
+    // 回环地址（hostfwd）已设置 IgnoreCertificate，不会走到这里。其它主机只接受用户明确信任的指纹：
+    // 开启 NLA/CredSSP 时凭据在 TLS 之上发送，盲目接受证书等于把密码交给中间人
+    DWORD verify_certificate(const char* host, UINT16 port, const char* common_name, const char* subject,
+        const char* issuer, const char* fingerprint, bool changed) {
+        RdpCertificateInfo cert;
+        cert.host = host ? host : "";
+        cert.port = port;
+        cert.common_name = common_name ? common_name : "";
+        cert.subject = subject ? subject : "";
+        cert.issuer = issuer ? issuer : "";
+        cert.fingerprint = fingerprint ? fingerprint : "";
+        cert.changed = changed;
+
+        bool trusted = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            trusted = rdp_fingerprint_equal(connection_config.trusted_fingerprint, fingerprint);
+            if (trusted) {
+                has_pending_cert = false;
+            } else {
+                pending_cert = cert;
+                has_pending_cert = true;
+                last_error = changed ? "Server certificate changed, user confirmation required"
+                                     : "Server certificate not trusted, user confirmation required";
+            }
+        }
+        if (trusted) {
+            // 仅本次会话接受（不写 known_hosts），信任关系由 ArkTS 保存
+            log("[RDP] Accepting trusted certificate for " + cert.host + ":" + std::to_string(port));
+            return 2;
+        }
+        log("[RDP] Rejecting " + std::string(changed ? "changed" : "unknown") + " certificate for " + cert.host +
+            ":" + std::to_string(port) + " issuer " + cert.issuer + " fingerprint " + cert.fingerprint);
+        return 0;
+    }
+
+    static DWORD on_verify_certificate(freerdp* instance, const char* host, UINT16 port,
+        const char* common_name, const char* subject, const char* issuer, const char* fingerprint, DWORD flags) {
+        (void)flags;
+        Impl* self = from(instance->context);
+        if (!self) return 0;
+        return self->verify_certificate(host, port, common_name, subject, issuer, fingerprint, false);
+    }
+
+    static DWORD on_verify_changed_certificate(freerdp* instance, const char* host, UINT16 port,
+        const char* common_name, const char* subject, const char* issuer, const char* new_fingerprint,
+        const char* old_subject, const char* old_issuer, const char* old_fingerprint, DWORD flags) {
+        (void)old_subject;
+        (void)old_issuer;
+        (void)old_fingerprint;
+        (void)flags;
+        Impl* self = from(instance->context);
+        if (!self) return 0;
+        return self->verify_certificate(host, port, common_name, subject, issuer, new_fingerprint, true);
+    }
+
+    bool create_context(const RdpConnectionConfig& config) {
+        RDP_CLIENT_ENTRY_POINTS ep;
+        memset(&ep, 0, sizeof(ep));
+        ep.Version = RDP_CLIENT_INTERFACE_VERSION;
+        ep.Size = sizeof(RDP_CLIENT_ENTRY_POINTS_V1);
+        ep.ContextSize = sizeof(Context);
+        ep.ClientNew = client_new;
+        rdpContext* ctx = freerdp_client_context_new(&ep);
+        if (!ctx) {
+            last_error = "freerdp_client_context_new failed";
+            return false;
+        }
+        reinterpret_cast<Context*>(ctx)->impl = this;
+
+        rdpSettings* s = ctx->settings;
+        const UINT32 width = config.width > 0 ? static_cast<UINT32>(config.width) : 1280;
+        const UINT32 height = config.height > 0 ? static_cast<UINT32>(config.height) : 720;
+        // H.264：优先 OH_VideoDecoder，其次内置 OpenH264；都没有时不协商 AVC420/AVC444
+        rdp_h264_register_platform_decoder();
+        const BOOL h264 = rdp_h264_decoder_available() ? TRUE : FALSE;
+        bool ok = freerdp_settings_set_string(s, FreeRDP_ServerHostname, config.host.c_str()) &&
+            freerdp_settings_set_uint32(s, FreeRDP_ServerPort, static_cast<UINT32>(config.port)) &&
+            freerdp_settings_set_uint32(s, FreeRDP_DesktopWidth, width) &&
+            freerdp_settings_set_uint32(s, FreeRDP_DesktopHeight, height) &&
+            freerdp_settings_set_uint32(s, FreeRDP_ColorDepth, 32) &&
+            freerdp_settings_set_bool(s, FreeRDP_SoftwareGdi, TRUE) &&
+            // 图形管线：RemoteFX/Progressive 由 gdi/gfx.c 软件解码；AVC420/AVC444 由 H.264 后端解码，YUV->RGB 走 yuv.c
+            freerdp_settings_set_bool(s, FreeRDP_SupportGraphicsPipeline, TRUE) &&
+            freerdp_settings_set_bool(s, FreeRDP_GfxProgressive, TRUE) &&
+            freerdp_settings_set_bool(s, FreeRDP_GfxH264, h264) &&
+            freerdp_settings_set_bool(s, FreeRDP_GfxAVC444, h264) &&
+            freerdp_settings_set_bool(s, FreeRDP_GfxAVC444v2, h264) &&
+            freerdp_settings_set_bool(s, FreeRDP_RemoteFxCodec, TRUE) &&
+            freerdp_settings_set_bool(s, FreeRDP_IgnoreCertificate, rdp_is_loopback_host(config.host) ? TRUE : FALSE);
+        if (ok && !config.username.empty()) {
+            ok = freerdp_settings_set_string(s, FreeRDP_Username, config.username.c_str()) &&
+                freerdp_settings_set_string(s, FreeRDP_Password, config.password.c_str()) &&
+                (config.domain.empty() || freerdp_settings_set_string(s, FreeRDP_Domain, config.domain.c_str()));
+        }
+        if (!ok) {
+            freerdp_client_context_free(ctx);
+            last_error = "Failed to apply FreeRDP settings";
+            return false;
+        }
+        rdp = ctx;
+        return true;
+    }
+
+    void free_context() {
+        if (rdp) {
+            freerdp_client_context_free(rdp);
+            rdp = nullptr;
+        }
+    }
+
+    void log(const std::string& message) {
+        std::function<void(const std::string&)> cb;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cb = callbacks.on_log_message;
+        }
+        if (cb) cb(message);
+    }
+
+    // 会话线程的状态变更：回调在锁外触发，回调里可以再调用本对象
+    void set_state(RdpConnectionState s, const std::string& err = std::string()) {
+        std::function<void(RdpConnectionState)> cb;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            state = s;
+            connected = (s == RdpConnectionState::CONNECTED);
+            if (!err.empty()) last_error = err;
+            cb = callbacks.on_state_changed;
+        }
+        g_rdp_connecting = (s == RdpConnectionState::CONNECTING);
+        g_rdp_connected = (s == RdpConnectionState::CONNECTED);
+        if (cb) cb(s);
+    }
+
+    // 有新的脏区（调用方已在 update 锁内写入 damage）
+    void publish_frame(int w, int h) {
+        fb_w.store(w);
+        fb_h.store(h);
+        frames.fetch_add(1, std::memory_order_relaxed);
+#if defined(__OHOS__)
+        frame_dirty.store(true);
+        render_cv.notify_one();
+#endif
+    }
+
+    // 连接在会话线程里进行（TLS/CredSSP 可能耗时数秒），调用方通过 get_connection_state 轮询结果
+    bool start_session(const RdpConnectionConfig& config) {
+        if (config.host.empty() || config.port <= 0) {
+            set_state(RdpConnectionState::ERROR, "Invalid host or port");
+            return false;
+        }
+        std::thread old;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (state == RdpConnectionState::CONNECTING || state == RdpConnectionState::CONNECTED) {
+                last_error = "Already connected";
+                return false;
+            }
+            old = std::move(session);
+        }
+        if (old.joinable()) old.join();
+        free_context();
+
+        if (!create_context(config)) {
+            set_state(RdpConnectionState::ERROR);
+            log("[RDP] " + last_error);
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            connection_config = config;
+            has_pending_cert = false;
+        }
+        g_rdp_cancel_requested = false;
+        rdp_update_activity();
+        set_state(RdpConnectionState::CONNECTING);
+        log("[RDP] Connecting to " + config.host + ":" + std::to_string(config.port) + " (FreeRDP, RDPGFX)");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            session = std::thread(&Impl::session_main, this);
+        }
+        return true;
+    }
+
+    void session_main() {
+        rdpContext* ctx = rdp;
+        freerdp* instance = ctx->instance;
+        {
+            std::lock_guard<std::mutex> lock(g_rdp_sessions_mtx);
+            g_rdp_sessions.insert(ctx);
+        }
+
+        std::string error;
+        if (!freerdp_connect(instance)) {
+            const UINT32 code = freerdp_get_last_error(ctx);
+            if (code != FREERDP_ERROR_CONNECT_CANCELLED) {
+                error = std::string("Connection failed: ") + freerdp_get_last_error_string(code);
+            }
+            // 证书被拒绝时保留可操作的原因，ArkTS 据此读取 getRdpCertificate 询问用户
+            std::lock_guard<std::mutex> lock(mutex);
+            if (has_pending_cert) error = last_error;
+        } else {
+            set_state(RdpConnectionState::CONNECTED);
+            log("[RDP] Connection established to " + std::string(
+                freerdp_settings_get_string(ctx->settings, FreeRDP_ServerHostname)));
+            HANDLE handles[MAXIMUM_WAIT_OBJECTS] = {};
+            while (!freerdp_shall_disconnect_context(ctx) && !g_rdp_cancel_requested) {
+                const DWORD count = freerdp_get_event_handles(ctx, handles, MAXIMUM_WAIT_OBJECTS);
+                if (count == 0) {
+                    error = "freerdp_get_event_handles failed";
+                    break;
+                }
+                // 有界等待：空闲会话也能定期刷新活动时间
+                if (WaitForMultipleObjects(count, handles, FALSE, 1000) == WAIT_FAILED) {
+                    error = "WaitForMultipleObjects failed";
+                    break;
+                }
+                if (!freerdp_check_event_handles(ctx)) {
+                    const UINT32 code = freerdp_get_last_error(ctx);
+                    // 主动断开（abort）不算错误
+                    if (code != FREERDP_ERROR_SUCCESS && code != FREERDP_ERROR_CONNECT_CANCELLED) {
+                        error = std::string("Session error: ") + freerdp_get_last_error_string(code);
+                    }
+                    break;
+                }
+                rdp_update_activity();
+            }
+        }
+        freerdp_disconnect(instance);
+
+        {
+            std::lock_guard<std::mutex> lock(g_rdp_sessions_mtx);
+            g_rdp_sessions.erase(ctx);
+        }
+        if (error.empty()) {
+            set_state(RdpConnectionState::DISCONNECTED);
+        } else {
+            set_state(RdpConnectionState::ERROR, error);
+            log("[RDP] " + error);
+        }
+    }
+
+    void stop_session() {
+        std::thread t;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            t = std::move(session);
+        }
+        if (!t.joinable()) return;
+        log("[RDP] Disconnecting...");
+        freerdp_abort_connect_context(rdp);
+        t.join();
+        log("[RDP] Disconnected");
+    }
+
+    // 会话建立后的输入通道；未连接时返回 nullptr
+    rdpInput* active_input() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!connected || !rdp) {
+            last_error = "Not connected";
+            return nullptr;
+        }
+        return rdp->input;
+    }
+
+    bool set_surface(uint64_t surface_id, int width, int height) {
+#if defined(__OHOS__)
+        {
+            std::lock_guard<std::mutex> lk(surface_mtx);
+            pending_surface_id = surface_id;
+            pending_surface_w = width;
+            pending_surface_h = height;
+            surface_dirty.store(true);
+        }
+        if (surface_id != 0 && !render_running.load()) {
+            if (render_worker.joinable()) render_worker.join();
+            render_running.store(true);
+            render_worker = std::thread(&Impl::render_main, this);
+        }
+        render_cv.notify_one();
+        return true;
+#else
+        (void)surface_id;
+        (void)width;
+        (void)height;
+        return false;
+#endif
+    }
+
+#if defined(__OHOS__)
+    void stop_render() {
+        render_running.store(false);
+        render_cv.notify_one();
+        if (render_worker.joinable()) render_worker.join();
+    }
+
+    // XComponent 直绘：NativeWindow 在本线程内创建/使用/销毁；像素在 update 锁内从 gdi 主缓冲直接拷进 window buffer
+    void render_main() {
+        OHNativeWindow* window = nullptr;
+        int curW = 0;
+        int curH = 0;
+        // BufferQueue 中每个 buffer 错过的脏区（buffer-age），未见过的 buffer 整帧写入
+        std::map<OHNativeWindowBuffer*, RdpDamage> bufDamage;
+        constexpr size_t kMaxTrackedBuffers = 8;
+
+        sched_pin_self(SchedRole::Io, "rdp-render");
+
+        auto cleanupWindow = [&]() {
+            bufDamage.clear();
+            if (window) {
+                OH_NativeWindow_DestroyNativeWindow(window);
+                window = nullptr;
+                curW = 0;
+                curH = 0;
+            }
+        };
+
+        while (render_running.load()) {
+            {
+                std::unique_lock<std::mutex> lk(render_cv_mtx);
+                render_cv.wait_for(lk, std::chrono::milliseconds(50), [&]() {
+                    return !render_running.load() || surface_dirty.load() || frame_dirty.load();
+                });
+            }
+            if (!render_running.load()) break;
+
+            if (surface_dirty.exchange(false)) {
+                uint64_t targetId = 0;
+                int targetW = 0;
+                int targetH = 0;
+                {
+                    std::lock_guard<std::mutex> lk(surface_mtx);
+                    targetId = pending_surface_id;
+                    targetW = pending_surface_w;
+                    targetH = pending_surface_h;
+                }
+                cleanupWindow();
+                if (targetId != 0) {
+                    OHNativeWindow* win = nullptr;
+                    if (OH_NativeWindow_CreateNativeWindowFromSurfaceId(targetId, &win) == 0 && win) {
+                        (void)OH_NativeWindow_NativeWindowHandleOpt(win, SET_BUFFER_GEOMETRY, targetW, targetH);
+                        (void)OH_NativeWindow_NativeWindowHandleOpt(win, SET_FORMAT, (int)NATIVEBUFFER_PIXEL_FMT_BGRA_8888);
+                        const uint64_t usage = (uint64_t)(
+                            NATIVEBUFFER_USAGE_CPU_READ |
+                            NATIVEBUFFER_USAGE_CPU_WRITE |
+                            NATIVEBUFFER_USAGE_CPU_READ_OFTEN |
+                            NATIVEBUFFER_USAGE_MEM_DMA
+                        );
+                        (void)OH_NativeWindow_NativeWindowHandleOpt(win, SET_USAGE, usage);
+                        window = win;
+                        curW = targetW;
+                        curH = targetH;
+                        log("[RDP] Render bound surfaceId=" + std::to_string(targetId));
+                        frame_dirty.store(true);
+                    } else {
+                        log("[RDP] Render failed to create window from surfaceId=" + std::to_string(targetId));
+                    }
+                }
+            }
+
+            if (!window) {
+                frame_dirty.store(false);
+                continue;
+            }
+            if (!frame_dirty.exchange(false)) continue;
+
+            const int w = fb_w.load();
+            const int h = fb_h.load();
+            if (w <= 0 || h <= 0) continue;
+            if (curW != w || curH != h) {
+                (void)OH_NativeWindow_NativeWindowHandleOpt(window, SET_BUFFER_GEOMETRY, w, h);
+                (void)OH_NativeWindow_NativeWindowHandleOpt(window, SET_FORMAT, (int)NATIVEBUFFER_PIXEL_FMT_BGRA_8888);
+                curW = w;
+                curH = h;
+                bufDamage.clear();
+            }
+
+            OHNativeWindowBuffer* wndBuf = nullptr;
+            int fenceFd = -1;
+            if (OH_NativeWindow_NativeWindowRequestBuffer(window, &wndBuf, &fenceFd) != 0 || !wndBuf) {
+                log("[RDP] Render RequestBuffer failed, drop surface");
+                cleanupWindow();
+                continue;
+            }
+            if (fenceFd >= 0) {
+                struct pollfd pfd;
+                pfd.fd = fenceFd;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                const int prc = poll(&pfd, 1, 200);
+                close(fenceFd);
+                if (prc <= 0) {
+                    (void)OH_NativeWindow_NativeWindowAbortBuffer(window, wndBuf);
+                    frame_dirty.store(true);  // 脏区仍留在 damage 里，下轮重试
+                    continue;
+                }
+            }
+
+            OH_NativeBuffer* nb = nullptr;
+            void* virAddr = nullptr;
+            if (OH_NativeBuffer_FromNativeWindowBuffer(wndBuf, &nb) != 0 || !nb ||
+                OH_NativeBuffer_Map(nb, &virAddr) != 0 || !virAddr) {
+                (void)OH_NativeWindow_NativeWindowAbortBuffer(window, wndBuf);
+                continue;
+            }
+            OH_NativeBuffer_Config cfg{};
+            OH_NativeBuffer_GetConfig(nb, &cfg);
+            const int dstW = (cfg.width > 0) ? cfg.width : w;
+            const int dstH = (cfg.height > 0) ? cfg.height : h;
+            const size_t dstRow = (cfg.stride > 0) ? (size_t)cfg.stride : (size_t)dstW * 4;
+            uint8_t* dst = reinterpret_cast<uint8_t*>(virAddr);
+
+            RdpDamage frameDamage;
+            bool copied = false;
+            {
+                std::lock_guard<std::mutex> gl(gdi_mtx);
+                rdpGdi* gdi = (gdi_ready && rdp) ? rdp->gdi : nullptr;
+                if (gdi && gdi->width == w && gdi->height == h) {
+                    rdp_update_lock(rdp->update);
+                    const int copyW = std::min(w, dstW);
+                    const int copyH = std::min(h, dstH);
+                    if (dstRow >= (size_t)copyW * 4) {
+                        frameDamage.rects.swap(damage.rects);
+                        for (auto& kv : bufDamage) kv.second.Merge(frameDamage, copyW, copyH);
+                        auto bit = bufDamage.find(wndBuf);
+                        if (bit == bufDamage.end()) {
+                            if (bufDamage.size() >= kMaxTrackedBuffers) bufDamage.clear();
+                            bit = bufDamage.emplace(wndBuf, RdpDamage{}).first;
+                            bit->second.AddFull(copyW, copyH);
+                        }
+                        const uint8_t* src = gdi->primary_buffer;
+                        const size_t srcRow = gdi->stride;
+                        for (const auto& r : bit->second.rects) {
+                            const size_t span = (size_t)r.w * 4;
+                            for (int yy = r.y; yy < r.y + r.h; yy++) {
+                                std::memcpy(dst + (size_t)yy * dstRow + (size_t)r.x * 4,
+                                    src + (size_t)yy * srcRow + (size_t)r.x * 4, span);
+                            }
+                        }
+                        bit->second.Clear();
+                        copied = true;
+                    }
+                    rdp_update_unlock(rdp->update);
+                }
+            }
+            (void)OH_NativeBuffer_Unmap(nb);
+            if (!copied) {
+                // 会话未就绪或分辨率刚变化（下一次 publish 会带上新尺寸）
+                (void)OH_NativeWindow_NativeWindowAbortBuffer(window, wndBuf);
+                continue;
+            }
+
+            std::vector<Region::Rect> flushRects;
+            flushRects.reserve(frameDamage.rects.size());
+            for (const auto& r : frameDamage.rects) {
+                flushRects.push_back(Region::Rect{ r.x, r.y, (uint32_t)r.w, (uint32_t)r.h });
+            }
+            if (flushRects.empty()) {
+                flushRects.push_back(Region::Rect{ 0, 0, (uint32_t)std::min(w, dstW), (uint32_t)std::min(h, dstH) });
+            }
+            Region region{ flushRects.data(), (int32_t)flushRects.size() };
+            if (OH_NativeWindow_NativeWindowFlushBuffer(window, wndBuf, -1, region) != 0) {
+                log("[RDP] Render FlushBuffer failed, drop surface");
+                cleanupWindow();
+            }
+        }
+
+        cleanupWindow();
+        sched_unregister_self();
+        render_running.store(false);
+    }
+#endif
+#endif
+
+#ifndef HAVE_FREERDP
+    // 没有 libfreerdp 时的退化实现：只探测 TCP 连通性并完成 X.224 协商
+
     // 尝试建立 TCP 连接
     bool establish_tcp_connection(const std::string& host, int port) {
         struct addrinfo hints, *result, *rp;
@@ -271,7 +1117,7 @@ public:
         return true;
     }
     
-    bool connect(const RdpConnectionConfig& config) {
+    bool probe_connect(const RdpConnectionConfig& config) {
         std::lock_guard<std::mutex> lock(mutex);
         
         if (connected) {
@@ -354,20 +1200,26 @@ public:
                 callbacks.on_state_changed(state);
             }
         
-        // NOTE: 完整的 RDP 会话需要实现:
-        // - TLS/SSL 握手
-        // - NTLM/CredSSP 认证  
-        // - MCS 通道建立
-        // - 许可证协商
-        // - 图形通道初始化
-        // 这些需要完整的 FreeRDP 库支持
+        // NOTE: 这里只确认了服务端可达；TLS/CredSSP/MCS/许可证/图形通道需要 libfreerdp（HAVE_FREERDP）
             
             return true;
     }
+#endif
+
+    bool connect(const RdpConnectionConfig& config) {
+#ifdef HAVE_FREERDP
+        return start_session(config);
+#else
+        return probe_connect(config);
+#endif
+    }
     
     int socket_fd;
     
     void disconnect() {
+#ifdef HAVE_FREERDP
+        stop_session();
+#else
         std::lock_guard<std::mutex> lock(mutex);
         
         if (!connected) {
@@ -394,6 +1246,7 @@ public:
         if (callbacks.on_log_message) {
             callbacks.on_log_message("[RDP] Disconnected");
         }
+#endif
     }
     
     bool is_connected() const {
@@ -442,6 +1295,41 @@ public:
     }
     
     bool send_mouse_event(int x, int y, int button, bool pressed) {
+#ifdef HAVE_FREERDP
+        rdpInput* input = active_input();
+        if (!input) return false;
+
+        UINT16 flags = 0;
+        switch (button) {
+            case 0: flags = PTR_FLAGS_MOVE; break;
+            case 1: flags = PTR_FLAGS_BUTTON1; break;
+            case 2: flags = PTR_FLAGS_BUTTON3; break;  // 中键
+            case 3: flags = PTR_FLAGS_BUTTON2; break;  // 右键
+            case 4:
+            case 5:
+                // 滚轮只在“按下”时发一格（±120）
+                if (!pressed) return true;
+                flags = (button == 4) ? (PTR_FLAGS_WHEEL | 0x0078) : (PTR_FLAGS_WHEEL | PTR_FLAGS_WHEEL_NEGATIVE | 0x0088);
+                break;
+            default: {
+                std::lock_guard<std::mutex> lock(mutex);
+                last_error = "Unsupported mouse button " + std::to_string(button);
+                return false;
+            }
+        }
+        if (button >= 1 && button <= 3 && pressed) flags |= PTR_FLAGS_DOWN;
+        const UINT16 px = static_cast<UINT16>(std::min(std::max(x, 0), 0xFFFF));
+        const UINT16 py = static_cast<UINT16>(std::min(std::max(y, 0), 0xFFFF));
+        if (!freerdp_input_send_mouse_event(input, flags, px, py)) return false;
+
+        std::function<void(int, int, int, bool)> cb;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cb = callbacks.on_mouse_event;
+        }
+        if (cb) cb(x, y, button, pressed);
+        return true;
+#else
         std::lock_guard<std::mutex> lock(mutex);
         
         if (!connected) {
@@ -454,9 +1342,39 @@ public:
         }
         
         return true;
+#endif
     }
     
     bool send_keyboard_event(int key, bool pressed) {
+#ifdef HAVE_FREERDP
+        rdpInput* input = active_input();
+        if (!input) return false;
+
+        const uint32_t keysym = static_cast<uint32_t>(key);
+        bool ok = false;
+        const DWORD vk = rdp_vk_from_keysym(keysym);
+        if (vk != 0) {
+            const DWORD scancode = GetVirtualScanCodeFromVirtualKeyCode(vk, WINPR_KBD_TYPE_IBM_ENHANCED);
+            ok = freerdp_input_send_keyboard_event_ex(input, pressed ? TRUE : FALSE, FALSE, scancode);
+        } else {
+            const uint32_t cp = rdp_unicode_from_keysym(keysym);
+            if (cp == 0 || cp > 0xFFFF) {
+                std::lock_guard<std::mutex> lock(mutex);
+                last_error = "Unsupported keysym " + std::to_string(keysym);
+                return false;
+            }
+            ok = freerdp_input_send_unicode_keyboard_event(input, pressed ? 0 : KBD_FLAGS_RELEASE, static_cast<UINT16>(cp));
+        }
+        if (!ok) return false;
+
+        std::function<void(int, bool)> cb;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cb = callbacks.on_keyboard_event;
+        }
+        if (cb) cb(key, pressed);
+        return true;
+#else
         std::lock_guard<std::mutex> lock(mutex);
         
         if (!connected) {
@@ -469,9 +1387,22 @@ public:
         }
         
         return true;
+#endif
     }
     
     bool send_text_input(const std::string& text) {
+#ifdef HAVE_FREERDP
+        rdpInput* input = active_input();
+        if (!input) return false;
+        // 逐个 UTF-16 码元发送 Unicode 键盘事件（与键盘布局无关）
+        for (uint16_t unit : rdp_utf8_to_utf16(text)) {
+            if (!freerdp_input_send_unicode_keyboard_event(input, 0, unit) ||
+                !freerdp_input_send_unicode_keyboard_event(input, KBD_FLAGS_RELEASE, unit)) {
+                return false;
+            }
+        }
+        return true;
+#else
         std::lock_guard<std::mutex> lock(mutex);
         
         if (!connected) {
@@ -484,6 +1415,7 @@ public:
         }
         
         return true;
+#endif
     }
     
     bool enable_clipboard_sharing(bool enable) {
@@ -617,6 +1549,13 @@ public:
         std::lock_guard<std::mutex> lock(mutex);
         return last_error;
     }
+
+    bool get_pending_certificate(RdpCertificateInfo& info) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!has_pending_cert) return false;
+        info = pending_cert;
+        return true;
+    }
     
 private:
     mutable std::mutex mutex;
@@ -625,8 +1564,36 @@ private:
     RdpConnectionConfig connection_config;
     RdpCallbacks callbacks;
     std::string last_error;
+    RdpCertificateInfo pending_cert;
+    bool has_pending_cert = false;
     std::string clipboard_text;
     int audio_volume = 50;
+#ifdef HAVE_FREERDP
+    // 当前会话的 FreeRDP 上下文（只在没有会话线程时创建/释放）及其事件循环线程
+    rdpContext* rdp = nullptr;
+    std::thread session;
+    // gdi 主缓冲的生命周期：gdi_ready 为真时 render 线程才可在 update 锁内读取
+    std::mutex gdi_mtx;
+    bool gdi_ready = false;
+    // 自上次提交以来的脏区（由 update 锁保护：EndPaint 在锁内写，render 线程在锁内取走）
+    RdpDamage damage;
+    std::atomic<int> fb_w{0};
+    std::atomic<int> fb_h{0};
+    std::atomic<uint64_t> frames{0};
+#if defined(__OHOS__)
+    std::thread render_worker;
+    std::atomic<bool> render_running{false};
+    std::condition_variable render_cv;
+    std::mutex render_cv_mtx;
+    // 由 NAPI 更新“期望的 surface”，render 线程负责创建/销毁 window
+    std::mutex surface_mtx;
+    uint64_t pending_surface_id = 0;
+    int pending_surface_w = 0;
+    int pending_surface_h = 0;
+    std::atomic<bool> surface_dirty{false};
+    std::atomic<bool> frame_dirty{false};
+#endif
+#endif
 };
 
 // RdpClient实现
@@ -660,6 +1627,17 @@ bool RdpClient::set_color_depth(int depth) {
     return pImpl->set_color_depth(depth);
 }
 
+bool RdpClient::set_surface(uint64_t surface_id, int width, int height) {
+#ifdef HAVE_FREERDP
+    return pImpl->set_surface(surface_id, width, height);
+#else
+    (void)surface_id;
+    (void)width;
+    (void)height;
+    return false;
+#endif
+}
+
 bool RdpClient::enable_fullscreen(bool enable) {
     // 实现全屏功能
     (void)enable;  // 暂未实现，避免未使用参数警告
@@ -722,6 +1700,10 @@ std::string RdpClient::get_last_error() const {
     return pImpl->get_last_error();
 }
 
+bool RdpClient::get_pending_certificate(RdpCertificateInfo& info) const {
+    return pImpl->get_pending_certificate(info);
+}
+
 // RdpManager实现
 RdpManager& RdpManager::getInstance() {
     static RdpManager instance;
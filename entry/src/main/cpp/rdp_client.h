@@ -1,6 +1,7 @@
 #ifndef RDP_CLIENT_H
 #define RDP_CLIENT_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <functional>
@@ -28,6 +29,20 @@ struct RdpConnectionConfig {
     bool enable_clipboard;
     bool enable_file_sharing;
     std::string shared_folder;
+    // 用户在 ArkTS 中明确信任过的服务器证书指纹（FreeRDP 格式，如 "sha256:AB:CD:..."）；
+    // 非回环主机的证书与之不符时拒绝连接
+    std::string trusted_fingerprint;
+};
+
+// 因未受信任而被拒绝的服务器证书，交给 ArkTS 让用户确认后带 trusted_fingerprint 重连
+struct RdpCertificateInfo {
+    std::string host;
+    int port = 0;
+    std::string common_name;
+    std::string subject;
+    std::string issuer;
+    std::string fingerprint;
+    bool changed = false; // 与 known_hosts 中记录的证书不一致
 };
 
 // RDP事件回调
@@ -55,8 +70,12 @@ public:
     bool set_resolution(int width, int height);
     bool set_color_depth(int depth);
     bool enable_fullscreen(bool enable);
+    // 绑定 XComponent surface（surface_id 为 0 表示解绑）：FreeRDP 合成好的桌面由独立 render 线程
+    // 按脏区直接写入 NativeWindow buffer；仅在 OHOS + FreeRDP 构建下可用
+    bool set_surface(uint64_t surface_id, int width, int height);
 
     // 输入控制
+    // button: 0 仅移动，1 左键，2 中键，3 右键，4/5 滚轮上/下（X11 编号）；key 为 X11 keysym
     bool send_mouse_event(int x, int y, int button, bool pressed);
     bool send_keyboard_event(int key, bool pressed);
     bool send_text_input(const std::string& text);
@@ -82,6 +101,9 @@ public:
     // 获取错误信息
     std::string get_last_error() const;
 
+    // 最近一次连接中被拒绝的服务器证书；没有时返回 false
+    bool get_pending_certificate(RdpCertificateInfo& info) const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> pImpl;
@@ -0,0 +1,367 @@
+#include "rdp_h264_decoder.h"
+
+#ifdef HAVE_FREERDP
+#include <freerdp/codec/h264.h>
+#include <winpr/crt.h>
+#endif
+
+#if defined(HAVE_FREERDP) && defined(__OHOS__)
+#include <multimedia/player_framework/native_avbuffer.h>
+#include <multimedia/player_framework/native_avcapability.h>
+#include <multimedia/player_framework/native_avcodec_base.h>
+#include <multimedia/player_framework/native_avcodec_videodecoder.h>
+#include <multimedia/player_framework/native_avformat.h>
+#include <hilog/log.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+constexpr const char* kBackendName = "OH_VideoDecoder";
+constexpr unsigned int kLogDomain = 0x0000;
+constexpr const char* kLogTag = "RDP_H264";
+
+// 分辨率未知（探测用的上下文）时按 1080p 配置，码流里的 SPS 变化由 onStreamChanged 通知
+constexpr int32_t kDefaultWidth = 1920;
+constexpr int32_t kDefaultHeight = 1080;
+
+// RDPGFX 每个 surface command 都要立即出图：OH_VideoDecoder 是异步的，送入一帧后在这里同步等待
+constexpr auto kInputTimeout = std::chrono::milliseconds(100);
+constexpr auto kOutputTimeout = std::chrono::milliseconds(100);
+
+struct OhBuffer {
+    uint32_t index;
+    OH_AVBuffer* buffer;
+};
+
+struct OhH264Decoder {
+    OH_AVCodec* codec = nullptr;
+    int32_t width = kDefaultWidth;
+    int32_t height = kDefaultHeight;
+    int64_t pts = 0;
+
+    // 解码器回调线程与 FreeRDP 解码线程之间只交换 buffer 索引
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<OhBuffer> inputs;
+    std::deque<OhBuffer> outputs;
+    bool failed = false;
+    bool format_dirty = true;
+
+    // 输出格式：NV12，Y 平面 stride * slice_h 之后紧跟交错的 UV
+    int32_t pic_w = 0;
+    int32_t pic_h = 0;
+    int32_t stride = 0;
+    int32_t slice_h = 0;
+
+    // Y 平面直接引用输出 buffer，FreeRDP 用完（下一次调用）之前不归还
+    bool held = false;
+    uint32_t held_index = 0;
+
+    // UV 拆成 I420 的 U、V 平面（16 字节对齐，yuv.c 的 SIMD 路径按行读取）
+    BYTE* planes[2] = { nullptr, nullptr };
+    UINT32 chroma_stride = 0;
+    size_t chroma_size = 0;
+};
+
+void oh_on_error(OH_AVCodec* codec, int32_t errorCode, void* userData) {
+    (void)codec;
+    auto* dec = static_cast<OhH264Decoder*>(userData);
+    OH_LOG_Print(LOG_APP, LOG_ERROR, kLogDomain, kLogTag, "OH_VideoDecoder error %{public}d", errorCode);
+    {
+        std::lock_guard<std::mutex> lk(dec->mtx);
+        dec->failed = true;
+    }
+    dec->cv.notify_all();
+}
+
+void oh_on_stream_changed(OH_AVCodec* codec, OH_AVFormat* format, void* userData) {
+    (void)codec;
+    (void)format;
+    auto* dec = static_cast<OhH264Decoder*>(userData);
+    std::lock_guard<std::mutex> lk(dec->mtx);
+    dec->format_dirty = true;
+}
+
+void oh_on_need_input(OH_AVCodec* codec, uint32_t index, OH_AVBuffer* buffer, void* userData) {
+    (void)codec;
+    auto* dec = static_cast<OhH264Decoder*>(userData);
+    {
+        std::lock_guard<std::mutex> lk(dec->mtx);
+        dec->inputs.push_back({ index, buffer });
+    }
+    dec->cv.notify_all();
+}
+
+void oh_on_new_output(OH_AVCodec* codec, uint32_t index, OH_AVBuffer* buffer, void* userData) {
+    (void)codec;
+    auto* dec = static_cast<OhH264Decoder*>(userData);
+    {
+        std::lock_guard<std::mutex> lk(dec->mtx);
+        dec->outputs.push_back({ index, buffer });
+    }
+    dec->cv.notify_all();
+}
+
+void oh_release_held(OhH264Decoder* dec) {
+    if (dec->held) {
+        OH_VideoDecoder_FreeOutputBuffer(dec->codec, dec->held_index);
+        dec->held = false;
+    }
+}
+
+bool oh_create_codec(OhH264Decoder* dec) {
+    OH_AVCodec* codec = OH_VideoDecoder_CreateByMime(OH_AVCODEC_MIMETYPE_VIDEO_AVC);
+    if (!codec) {
+        OH_LOG_Print(LOG_APP, LOG_WARN, kLogDomain, kLogTag, "no AVC decoder available");
+        return false;
+    }
+
+    OH_AVCodecCallback cb = { oh_on_error, oh_on_stream_changed, oh_on_need_input, oh_on_new_output };
+    OH_AVFormat* fmt = OH_AVFormat_Create();
+    bool ok = fmt && OH_VideoDecoder_RegisterCallback(codec, cb, dec) == AV_ERR_OK;
+    if (ok) {
+        OH_AVFormat_SetIntValue(fmt, OH_MD_KEY_WIDTH, dec->width);
+        OH_AVFormat_SetIntValue(fmt, OH_MD_KEY_HEIGHT, dec->height);
+        OH_AVFormat_SetIntValue(fmt, OH_MD_KEY_PIXEL_FORMAT, AV_PIXEL_FORMAT_NV12);
+        // 不做帧重排缓存：RDP 服务端只发 I/P 帧，每个输入都应立刻产出一帧
+        OH_AVFormat_SetIntValue(fmt, OH_MD_KEY_VIDEO_ENABLE_LOW_LATENCY, 1);
+        ok = OH_VideoDecoder_Configure(codec, fmt) == AV_ERR_OK &&
+            OH_VideoDecoder_Prepare(codec) == AV_ERR_OK &&
+            OH_VideoDecoder_Start(codec) == AV_ERR_OK;
+    }
+    if (fmt) OH_AVFormat_Destroy(fmt);
+    if (!ok) {
+        OH_LOG_Print(LOG_APP, LOG_WARN, kLogDomain, kLogTag, "failed to start AVC decoder %{public}dx%{public}d",
+            dec->width, dec->height);
+        OH_VideoDecoder_Destroy(codec);
+        return false;
+    }
+    dec->codec = codec;
+    return true;
+}
+
+void oh_update_format(OhH264Decoder* dec) {
+    OH_AVFormat* fmt = OH_VideoDecoder_GetOutputDescription(dec->codec);
+    int32_t w = dec->width;
+    int32_t h = dec->height;
+    int32_t stride = 0;
+    int32_t slice = 0;
+    if (fmt) {
+        if (!OH_AVFormat_GetIntValue(fmt, OH_MD_KEY_VIDEO_PIC_WIDTH, &w))
+            OH_AVFormat_GetIntValue(fmt, OH_MD_KEY_WIDTH, &w);
+        if (!OH_AVFormat_GetIntValue(fmt, OH_MD_KEY_VIDEO_PIC_HEIGHT, &h))
+            OH_AVFormat_GetIntValue(fmt, OH_MD_KEY_HEIGHT, &h);
+        OH_AVFormat_GetIntValue(fmt, OH_MD_KEY_VIDEO_STRIDE, &stride);
+        OH_AVFormat_GetIntValue(fmt, OH_MD_KEY_VIDEO_SLICE_HEIGHT, &slice);
+        OH_AVFormat_Destroy(fmt);
+    }
+    dec->pic_w = w;
+    dec->pic_h = h;
+    dec->stride = stride >= w ? stride : w;
+    dec->slice_h = slice >= h ? slice : h;
+}
+
+bool oh_ensure_chroma(OhH264Decoder* dec) {
+    UINT32 cw = static_cast<UINT32>(dec->pic_w + 1) / 2;
+    const UINT32 ch = static_cast<UINT32>(dec->pic_h + 1) / 2;
+    cw = (cw + 15) & ~15u;
+    const size_t size = static_cast<size_t>(cw) * ch;
+    if (dec->planes[0] && dec->chroma_size == size && dec->chroma_stride == cw) return true;
+
+    for (auto& plane : dec->planes) {
+        winpr_aligned_free(plane);
+        plane = static_cast<BYTE*>(winpr_aligned_malloc(size, 16));
+        if (!plane) return false;
+    }
+    dec->chroma_stride = cw;
+    dec->chroma_size = size;
+    return true;
+}
+
+// NV12 的交错 UV 拆成两个平面（编译器会向量化成 ld2/st1）
+void oh_split_uv(const uint8_t* uv, size_t uvStride, BYTE* u, BYTE* v, UINT32 dstStride, UINT32 w, UINT32 h) {
+    for (UINT32 y = 0; y < h; y++) {
+        const uint8_t* src = uv + y * uvStride;
+        BYTE* du = u + static_cast<size_t>(y) * dstStride;
+        BYTE* dv = v + static_cast<size_t>(y) * dstStride;
+        for (UINT32 x = 0; x < w; x++) {
+            du[x] = src[2 * x];
+            dv[x] = src[2 * x + 1];
+        }
+    }
+}
+
+void* oh_backend_new(void* userdata, UINT32 width, UINT32 height) {
+    (void)userdata;
+    if (!OH_AVCodec_GetCapability(OH_AVCODEC_MIMETYPE_VIDEO_AVC, false)) return nullptr;
+
+    auto* dec = new (std::nothrow) OhH264Decoder();
+    if (!dec) return nullptr;
+
+    // 尺寸未知的上下文（FreeRDP 创建后再 reset、能力探测）不占用硬件实例，首帧时再创建
+    if (width == 0 || height == 0) return dec;
+
+    dec->width = static_cast<int32_t>(width);
+    dec->height = static_cast<int32_t>(height);
+    if (!oh_create_codec(dec)) {
+        delete dec;
+        return nullptr; // 交给下一个后端（OpenH264）
+    }
+    return dec;
+}
+
+void oh_backend_free(void* handle) {
+    auto* dec = static_cast<OhH264Decoder*>(handle);
+    if (!dec) return;
+    if (dec->codec) {
+        oh_release_held(dec);
+        OH_VideoDecoder_Stop(dec->codec);
+        OH_VideoDecoder_Destroy(dec->codec);
+        dec->codec = nullptr;
+    }
+    for (auto& plane : dec->planes) winpr_aligned_free(plane);
+    delete dec;
+}
+
+INT32 oh_backend_decode(void* handle, const BYTE* pSrcData, UINT32 SrcSize, BYTE* pYUVData[3], UINT32 iStride[3]) {
+    auto* dec = static_cast<OhH264Decoder*>(handle);
+    if (!dec) return -1;
+
+    oh_release_held(dec);
+    if (!dec->codec && !oh_create_codec(dec)) return -1;
+
+    OhBuffer in = {};
+    {
+        std::unique_lock<std::mutex> lk(dec->mtx);
+        if (!dec->cv.wait_for(lk, kInputTimeout, [dec]() { return dec->failed || !dec->inputs.empty(); })) {
+            OH_LOG_Print(LOG_APP, LOG_WARN, kLogDomain, kLogTag, "timeout waiting for an input buffer");
+            return -2;
+        }
+        if (dec->failed) return -3;
+        in = dec->inputs.front();
+        dec->inputs.pop_front();
+    }
+
+    uint8_t* addr = OH_AVBuffer_GetAddr(in.buffer);
+    const int32_t capacity = OH_AVBuffer_GetCapacity(in.buffer);
+    const int64_t pts = dec->pts++;
+    OH_AVCodecBufferAttr attr = { pts, 0, 0, AVCODEC_BUFFER_FLAGS_NONE };
+    const bool fits = addr && capacity >= 0 && SrcSize <= static_cast<UINT32>(capacity);
+    if (fits) {
+        memcpy(addr, pSrcData, SrcSize);
+        attr.size = static_cast<int32_t>(SrcSize);
+    }
+    // 放不下时送一个空 buffer 把索引还给解码器
+    OH_AVBuffer_SetBufferAttr(in.buffer, &attr);
+    if (OH_VideoDecoder_PushInputBuffer(dec->codec, in.index) != AV_ERR_OK) return -4;
+    if (!fits) {
+        OH_LOG_Print(LOG_APP, LOG_WARN, kLogDomain, kLogTag, "access unit of %{public}u bytes exceeds input buffer",
+            SrcSize);
+        return -5;
+    }
+
+    // 按 pts 认领本次送入的帧：之前超时迟到的旧帧直接归还，绝不当作这一帧的画面
+    std::vector<uint32_t> stale;
+    OhBuffer out = {};
+    bool found = false;
+    bool failed = false;
+    bool formatDirty = false;
+    {
+        std::unique_lock<std::mutex> lk(dec->mtx);
+        const auto deadline = std::chrono::steady_clock::now() + kOutputTimeout;
+        while (!found && !dec->failed) {
+            while (!dec->outputs.empty()) {
+                const OhBuffer next = dec->outputs.front();
+                dec->outputs.pop_front();
+                OH_AVCodecBufferAttr outAttr = {};
+                if (OH_AVBuffer_GetBufferAttr(next.buffer, &outAttr) == AV_ERR_OK && outAttr.pts >= pts) {
+                    out = next;
+                    found = true;
+                    break;
+                }
+                stale.push_back(next.index);
+            }
+            if (found || !dec->cv.wait_until(lk, deadline, [dec]() { return dec->failed || !dec->outputs.empty(); })) {
+                break;
+            }
+        }
+        failed = dec->failed;
+        formatDirty = dec->format_dirty;
+        if (found) dec->format_dirty = false;
+    }
+    for (uint32_t index : stale) OH_VideoDecoder_FreeOutputBuffer(dec->codec, index);
+    if (!found) {
+        if (failed) return -3;
+        OH_LOG_Print(LOG_APP, LOG_WARN, kLogDomain, kLogTag, "no picture for access unit %{public}lld",
+            static_cast<long long>(pts));
+        return -7;
+    }
+
+    if (formatDirty) oh_update_format(dec);
+
+    uint8_t* frame = OH_AVBuffer_GetAddr(out.buffer);
+    OH_AVCodecBufferAttr outAttr = {};
+    OH_AVBuffer_GetBufferAttr(out.buffer, &outAttr);
+    const size_t lumaSize = static_cast<size_t>(dec->stride) * dec->slice_h;
+    const size_t needed = lumaSize + static_cast<size_t>(dec->stride) * ((dec->pic_h + 1) / 2);
+    if (!frame || outAttr.size < 0 || static_cast<size_t>(outAttr.offset) + needed > static_cast<size_t>(
+        OH_AVBuffer_GetCapacity(out.buffer)) || !oh_ensure_chroma(dec)) {
+        OH_VideoDecoder_FreeOutputBuffer(dec->codec, out.index);
+        return -6;
+    }
+    frame += outAttr.offset;
+
+    oh_split_uv(frame + lumaSize, static_cast<size_t>(dec->stride), dec->planes[0], dec->planes[1],
+        dec->chroma_stride, static_cast<UINT32>(dec->pic_w + 1) / 2, static_cast<UINT32>(dec->pic_h + 1) / 2);
+
+    dec->held = true;
+    dec->held_index = out.index;
+    pYUVData[0] = frame;
+    pYUVData[1] = dec->planes[0];
+    pYUVData[2] = dec->planes[1];
+    iStride[0] = static_cast<UINT32>(dec->stride);
+    iStride[1] = dec->chroma_stride;
+    iStride[2] = dec->chroma_stride;
+    return 1;
+}
+
+} // namespace
+
+bool rdp_h264_register_platform_decoder() {
+    static std::once_flag once;
+    static bool registered = false;
+    std::call_once(once, []() {
+        H264_DECODER_BACKEND backend = {};
+        backend.name = kBackendName;
+        backend.New = oh_backend_new;
+        backend.Free = oh_backend_free;
+        backend.Decode = oh_backend_decode;
+        registered = h264_register_decoder_backend(&backend) == TRUE;
+        OH_LOG_Print(LOG_APP, LOG_INFO, kLogDomain, kLogTag, "register %{public}s: %{public}s", kBackendName,
+            registered ? "ok" : "failed");
+    });
+    return registered;
+}
+#else
+bool rdp_h264_register_platform_decoder() {
+    return false;
+}
+#endif
+
+bool rdp_h264_decoder_available() {
+#ifdef HAVE_FREERDP
+    H264_CONTEXT* h264 = h264_context_new(FALSE);
+    if (!h264) return false;
+    h264_context_free(h264);
+    return true;
+#else
+    return false;
+#endif
+}
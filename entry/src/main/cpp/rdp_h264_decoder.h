@@ -0,0 +1,14 @@
+#ifndef RDP_H264_DECODER_H
+#define RDP_H264_DECODER_H
+
+// RDPGFX AVC420/AVC444 的平台解码后端：OH_VideoDecoder（硬件优先）把 H.264 解成 NV12，
+// 这里拆成 I420 交给 FreeRDP，YUV->RGB 仍走 libfreerdp/codec/yuv.c 的多线程路径。
+// 平台解码器不可用时 FreeRDP 自动回落到内置的 OpenH264（若编译进来）。
+
+// 向 FreeRDP 注册 OH_VideoDecoder 后端（重复调用无副作用）；非 OHOS 构建返回 false
+bool rdp_h264_register_platform_decoder();
+
+// 当前进程能否创建 H.264 解码上下文（平台后端或内置软件解码），决定是否协商 GfxH264/AVC444
+bool rdp_h264_decoder_available();
+
+#endif // RDP_H264_DECODER_H
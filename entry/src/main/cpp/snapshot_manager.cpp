@@ -0,0 +1,1510 @@
+#include "snapshot_manager.h"
+#include "qmp_client.h"
+#include "third_party/cjson/cJSON.h"
+#include <zlib.h>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <map>
+#include <set>
+#include <unordered_set>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// ============================================================================
+// 目录布局（每个 VM）：
+//   snapshots/index.json              快照列表、活动磁盘层、磁盘层的 backing 关系、待恢复标记
+//   snapshots/layers/<tag>-<ms>.qcow2 外部快照产生的 qcow2 overlay
+//   snapshots/ram/<tag>-<ms>.manifest RAM 状态流的块清单
+//   snapshots/chunks/xx/<hash>        内容寻址的块（zlib 压缩），所有快照共享
+//
+// RAM 状态通过 QEMU 迁移流（migrate 到本进程监听的 unix socket）获得：零页在流里只占几个字节，
+// 其余内容按内容定义分块（gear 滚动哈希）后去重，空闲来宾连续两次快照绝大部分块都已存在，只写差异。
+// ============================================================================
+
+namespace {
+
+constexpr size_t kChunkMin = 16 * 1024;
+constexpr size_t kChunkMax = 256 * 1024;
+constexpr uint64_t kChunkCutMask = 0xFFFF000000000000ULL;   // 平均 64KB
+constexpr uint64_t kProgressStep = 64ULL * 1024 * 1024;
+constexpr char kManifestMagic[8] = { 'A', 'E', 'S', 'N', 'A', 'P', '0', '2' };   // 02：块 id 为 SHA-256
+
+int64_t NowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool PathExists(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+void MakeDirs(const std::string& path)
+{
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+        if (pos == std::string::npos) break;
+    }
+}
+
+bool WriteAll(int fd, const void* data, size_t len)
+{
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool SendAll(int fd, const void* data, size_t len)
+{
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 先写临时文件再 rename，保证崩溃后不会留下半个文件
+bool WriteFileAtomic(const std::string& path, const void* data, size_t len)
+{
+    const std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = WriteAll(fd, data, len) && fsync(fd) == 0;
+    close(fd);
+    if (ok) ok = rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) unlink(tmp.c_str());
+    return ok;
+}
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>& out)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    out.resize(static_cast<size_t>(st.st_size));
+    size_t got = 0;
+    while (got < out.size()) {
+        ssize_t n = read(fd, out.data() + got, out.size() - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += static_cast<size_t>(n);
+    }
+    close(fd);
+    return got == out.size();
+}
+
+std::string SafeTag(const std::string& tag)
+{
+    std::string s;
+    for (char c : tag) {
+        s += (isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_') ? c : '_';
+    }
+    return s.empty() ? "snap" : s.substr(0, 64);
+}
+
+// ----------------------------------------------------------------------------
+// 块 id：SHA-256。块内容来自来宾内存，来宾可以故意构造数据；非密码学哈希（Murmur 等）
+// 能被构造出碰撞，两个不同的块就会在增量快照里共用一个块文件。这里必须抗碰撞。
+// ----------------------------------------------------------------------------
+
+struct ChunkId {
+    uint8_t d[32] = { 0 };
+
+    bool operator==(const ChunkId& o) const { return memcmp(d, o.d, sizeof(d)) == 0; }
+
+    std::string hex() const
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(sizeof(d) * 2, '0');
+        for (size_t i = 0; i < sizeof(d); i++) {
+            out[i * 2] = digits[d[i] >> 4];
+            out[i * 2 + 1] = digits[d[i] & 15];
+        }
+        return out;
+    }
+};
+
+inline uint32_t Rotr32(uint32_t x, int r)
+{
+    return (x >> r) | (x << (32 - r));
+}
+
+void Sha256Block(uint32_t st[8], const uint8_t* p)
+{
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t(p[i * 4]) << 24) | (uint32_t(p[i * 4 + 1]) << 16) | (uint32_t(p[i * 4 + 2]) << 8) |
+               uint32_t(p[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        const uint32_t s0 = Rotr32(w[i - 15], 7) ^ Rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = Rotr32(w[i - 2], 17) ^ Rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = st[0], b = st[1], c = st[2], d = st[3], e = st[4], f = st[5], g = st[6], h = st[7];
+    for (int i = 0; i < 64; i++) {
+        const uint32_t t1 = h + (Rotr32(e, 6) ^ Rotr32(e, 11) ^ Rotr32(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+        const uint32_t t2 = (Rotr32(a, 2) ^ Rotr32(a, 13) ^ Rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    st[0] += a; st[1] += b; st[2] += c; st[3] += d;
+    st[4] += e; st[5] += f; st[6] += g; st[7] += h;
+}
+
+ChunkId HashChunk(const uint8_t* data, size_t len)
+{
+    uint32_t st[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                       0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    const size_t nblocks = len / 64;
+    for (size_t i = 0; i < nblocks; i++) Sha256Block(st, data + i * 64);
+
+    // 末尾补 0x80、0 和 64 位大端比特长度
+    uint8_t tail[128] = { 0 };
+    const size_t rem = len & 63;
+    memcpy(tail, data + nblocks * 64, rem);
+    tail[rem] = 0x80;
+    const size_t tailLen = rem < 56 ? 64 : 128;
+    const uint64_t bits = static_cast<uint64_t>(len) * 8;
+    for (int i = 0; i < 8; i++) tail[tailLen - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+    Sha256Block(st, tail);
+    if (tailLen == 128) Sha256Block(st, tail + 64);
+
+    ChunkId id;
+    for (int i = 0; i < 8; i++) {
+        id.d[i * 4] = static_cast<uint8_t>(st[i] >> 24);
+        id.d[i * 4 + 1] = static_cast<uint8_t>(st[i] >> 16);
+        id.d[i * 4 + 2] = static_cast<uint8_t>(st[i] >> 8);
+        id.d[i * 4 + 3] = static_cast<uint8_t>(st[i]);
+    }
+    return id;
+}
+
+// gear 滚动哈希表：固定种子生成，保证不同次快照切出相同的块边界
+const uint64_t* GearTable()
+{
+    static uint64_t table[256];
+    static std::once_flag once;
+    std::call_once(once, []() {
+        uint64_t x = 0x9E3779B97F4A7C15ULL;
+        for (auto& t : table) {
+            x += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            t = z ^ (z >> 31);
+        }
+    });
+    return table;
+}
+
+// ----------------------------------------------------------------------------
+// 块存储
+// ----------------------------------------------------------------------------
+
+struct ManifestEntry {
+    ChunkId id;
+    uint32_t len = 0;
+};
+
+class ChunkStore {
+public:
+    explicit ChunkStore(const std::string& dir) : dir_(dir) {}
+
+    std::string path_of(const ChunkId& id) const
+    {
+        const std::string hex = id.hex();
+        return dir_ + "/" + hex.substr(0, 2) + "/" + hex;
+    }
+
+    // 返回写入的字节数（已存在则为 0），失败返回 -1
+    int64_t put(const ChunkId& id, const uint8_t* data, size_t len)
+    {
+        const std::string path = path_of(id);
+        if (PathExists(path)) return 0;
+        MakeDirs(path.substr(0, path.rfind('/')));
+
+        uLongf zlen = compressBound(static_cast<uLong>(len));
+        zbuf_.resize(zlen + 1);
+        // 1 字节头：'Z' zlib / 'R' 原样（压不动的块不白费解压时间）
+        if (compress2(zbuf_.data() + 1, &zlen, data, static_cast<uLong>(len), 1) == Z_OK && zlen < len) {
+            zbuf_[0] = 'Z';
+        } else {
+            zbuf_[0] = 'R';
+            zlen = static_cast<uLongf>(len);
+            memcpy(zbuf_.data() + 1, data, len);
+        }
+        if (!WriteFileAtomic(path, zbuf_.data(), zlen + 1)) return -1;
+        return static_cast<int64_t>(zlen) + 1;
+    }
+
+    bool get(const ManifestEntry& e, std::vector<uint8_t>& out)
+    {
+        if (!ReadFile(path_of(e.id), zbuf_) || zbuf_.empty()) return false;
+        out.resize(e.len);
+        if (zbuf_[0] == 'R') {
+            if (zbuf_.size() - 1 != e.len) return false;
+            memcpy(out.data(), zbuf_.data() + 1, e.len);
+        } else {
+            uLongf outLen = e.len;
+            if (uncompress(out.data(), &outLen, zbuf_.data() + 1, static_cast<uLong>(zbuf_.size() - 1)) != Z_OK ||
+                outLen != e.len) {
+                return false;
+            }
+        }
+        return HashChunk(out.data(), out.size()) == e.id;
+    }
+
+private:
+    std::string dir_;
+    std::vector<uint8_t> zbuf_;
+};
+
+// 把 RAM 状态流切块写入块存储
+class RamStreamWriter {
+public:
+    explicit RamStreamWriter(ChunkStore& store) : store_(store), gear_(GearTable())
+    {
+        cur_.reserve(kChunkMax);
+    }
+
+    bool feed(const uint8_t* data, size_t len)
+    {
+        for (size_t i = 0; i < len; i++) {
+            cur_.push_back(data[i]);
+            hash_ = (hash_ << 1) + gear_[data[i]];
+            if ((cur_.size() >= kChunkMin && (hash_ & kChunkCutMask) == 0) || cur_.size() >= kChunkMax) {
+                if (!emit()) return false;
+            }
+        }
+        raw_bytes_ += len;
+        return true;
+    }
+
+    bool finish() { return cur_.empty() || emit(); }
+
+    const std::vector<ManifestEntry>& entries() const { return entries_; }
+    uint64_t raw_bytes() const { return raw_bytes_; }
+    uint64_t stored_bytes() const { return stored_bytes_; }
+
+private:
+    bool emit()
+    {
+        ManifestEntry e;
+        e.id = HashChunk(cur_.data(), cur_.size());
+        e.len = static_cast<uint32_t>(cur_.size());
+        const int64_t written = store_.put(e.id, cur_.data(), cur_.size());
+        if (written < 0) return false;
+        stored_bytes_ += static_cast<uint64_t>(written);
+        entries_.push_back(e);
+        cur_.clear();
+        hash_ = 0;
+        return true;
+    }
+
+    ChunkStore& store_;
+    const uint64_t* gear_;
+    std::vector<uint8_t> cur_;
+    uint64_t hash_ = 0;
+    std::vector<ManifestEntry> entries_;
+    uint64_t raw_bytes_ = 0;
+    uint64_t stored_bytes_ = 0;
+};
+
+constexpr size_t kManifestEntrySize = sizeof(ChunkId::d) + 4;
+
+bool WriteManifest(const std::string& path, const std::vector<ManifestEntry>& entries)
+{
+    std::vector<uint8_t> buf(sizeof(kManifestMagic) + 8 + entries.size() * kManifestEntrySize);
+    uint8_t* p = buf.data();
+    memcpy(p, kManifestMagic, sizeof(kManifestMagic));
+    p += sizeof(kManifestMagic);
+    const uint64_t count = entries.size();
+    memcpy(p, &count, 8);
+    p += 8;
+    for (const auto& e : entries) {
+        memcpy(p, e.id.d, sizeof(e.id.d));
+        memcpy(p + sizeof(e.id.d), &e.len, 4);
+        p += kManifestEntrySize;
+    }
+    return WriteFileAtomic(path, buf.data(), buf.size());
+}
+
+bool ReadManifest(const std::string& path, std::vector<ManifestEntry>& entries)
+{
+    std::vector<uint8_t> buf;
+    if (!ReadFile(path, buf) || buf.size() < sizeof(kManifestMagic) + 8 ||
+        memcmp(buf.data(), kManifestMagic, sizeof(kManifestMagic)) != 0) {
+        return false;
+    }
+    uint64_t count = 0;
+    memcpy(&count, buf.data() + sizeof(kManifestMagic), 8);
+    if (count > (buf.size() - sizeof(kManifestMagic) - 8) / kManifestEntrySize ||
+        buf.size() != sizeof(kManifestMagic) + 8 + count * kManifestEntrySize) {
+        return false;
+    }
+    entries.resize(count);
+    const uint8_t* p = buf.data() + sizeof(kManifestMagic) + 8;
+    for (auto& e : entries) {
+        memcpy(e.id.d, p, sizeof(e.id.d));
+        memcpy(&e.len, p + sizeof(e.id.d), 4);
+        p += kManifestEntrySize;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// index.json
+// ----------------------------------------------------------------------------
+
+struct SnapshotRecord {
+    SnapshotInfo info;
+    std::string manifest;     // 外部快照的 RAM 清单
+};
+
+struct SnapshotIndex {
+    std::string active_disk;                    // 空表示原始磁盘
+    std::string pending_restore;
+    std::map<std::string, std::string> layers;  // overlay -> backing
+    std::vector<SnapshotRecord> snapshots;
+
+    SnapshotRecord* find(const std::string& tag)
+    {
+        for (auto& s : snapshots) {
+            if (s.info.tag == tag) return &s;
+        }
+        return nullptr;
+    }
+};
+
+std::mutex g_index_mutex;
+
+std::string SnapDir(const SnapshotVm& vm) { return vm.dir + "/snapshots"; }
+std::string IndexPath(const SnapshotVm& vm) { return SnapDir(vm) + "/index.json"; }
+
+std::string JsonString(const cJSON* obj, const char* key)
+{
+    const cJSON* v = cJSON_GetObjectItemCaseSensitive(obj, key);
+    return cJSON_IsString(v) ? v->valuestring : "";
+}
+
+double JsonNumber(const cJSON* obj, const char* key)
+{
+    const cJSON* v = cJSON_GetObjectItemCaseSensitive(obj, key);
+    return cJSON_IsNumber(v) ? v->valuedouble : 0.0;
+}
+
+// 需持有 g_index_mutex
+SnapshotIndex LoadIndexLocked(const SnapshotVm& vm)
+{
+    SnapshotIndex idx;
+    std::vector<uint8_t> buf;
+    if (!ReadFile(IndexPath(vm), buf)) return idx;
+    cJSON* root = cJSON_ParseWithLength(reinterpret_cast<const char*>(buf.data()), buf.size());
+    if (!root) return idx;
+    idx.active_disk = JsonString(root, "activeDisk");
+    idx.pending_restore = JsonString(root, "pendingRestore");
+    const cJSON* layers = cJSON_GetObjectItemCaseSensitive(root, "layers");
+    const cJSON* it = nullptr;
+    cJSON_ArrayForEach(it, layers) {
+        if (cJSON_IsString(it) && it->string) idx.layers[it->string] = it->valuestring;
+    }
+    const cJSON* snaps = cJSON_GetObjectItemCaseSensitive(root, "snapshots");
+    cJSON_ArrayForEach(it, snaps) {
+        SnapshotRecord r;
+        r.info.tag = JsonString(it, "tag");
+        r.info.mode = JsonString(it, "mode") == "internal" ? SnapshotMode::Internal : SnapshotMode::External;
+        r.info.created_ms = static_cast<int64_t>(JsonNumber(it, "created"));
+        r.info.was_running = cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(it, "running"));
+        r.info.ram_bytes = static_cast<uint64_t>(JsonNumber(it, "ramBytes"));
+        r.info.stored_bytes = static_cast<uint64_t>(JsonNumber(it, "storedBytes"));
+        r.info.disk_layer = JsonString(it, "diskLayer");
+        r.manifest = JsonString(it, "manifest");
+        if (!r.info.tag.empty()) idx.snapshots.push_back(r);
+    }
+    cJSON_Delete(root);
+    return idx;
+}
+
+// 需持有 g_index_mutex
+bool SaveIndexLocked(const SnapshotVm& vm, const SnapshotIndex& idx)
+{
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "version", 1);
+    if (!idx.active_disk.empty()) cJSON_AddStringToObject(root, "activeDisk", idx.active_disk.c_str());
+    if (!idx.pending_restore.empty()) cJSON_AddStringToObject(root, "pendingRestore", idx.pending_restore.c_str());
+    cJSON* layers = cJSON_AddObjectToObject(root, "layers");
+    for (const auto& kv : idx.layers) {
+        cJSON_AddStringToObject(layers, kv.first.c_str(), kv.second.c_str());
+    }
+    cJSON* snaps = cJSON_AddArrayToObject(root, "snapshots");
+    for (const auto& r : idx.snapshots) {
+        cJSON* s = cJSON_CreateObject();
+        cJSON_AddStringToObject(s, "tag", r.info.tag.c_str());
+        cJSON_AddStringToObject(s, "mode", r.info.mode == SnapshotMode::Internal ? "internal" : "external");
+        cJSON_AddNumberToObject(s, "created", static_cast<double>(r.info.created_ms));
+        cJSON_AddBoolToObject(s, "running", r.info.was_running);
+        cJSON_AddNumberToObject(s, "ramBytes", static_cast<double>(r.info.ram_bytes));
+        cJSON_AddNumberToObject(s, "storedBytes", static_cast<double>(r.info.stored_bytes));
+        if (!r.info.disk_layer.empty()) cJSON_AddStringToObject(s, "diskLayer", r.info.disk_layer.c_str());
+        if (!r.manifest.empty()) cJSON_AddStringToObject(s, "manifest", r.manifest.c_str());
+        cJSON_AddItemToArray(snaps, s);
+    }
+    char* text = cJSON_Print(root);
+    cJSON_Delete(root);
+    if (!text) return false;
+    MakeDirs(SnapDir(vm));
+    const bool ok = WriteFileAtomic(IndexPath(vm), text, strlen(text));
+    cJSON_free(text);
+    return ok;
+}
+
+// 删除不再被需要的 overlay：活动层与各快照冻结层沿 backing 链可达的层保留，其余删除
+void GcLayersLocked(SnapshotIndex& idx)
+{
+    std::set<std::string> needed;
+    std::vector<std::string> roots;
+    if (!idx.active_disk.empty()) roots.push_back(idx.active_disk);
+    for (const auto& r : idx.snapshots) {
+        if (!r.info.disk_layer.empty()) roots.push_back(r.info.disk_layer);
+    }
+    for (std::string layer : roots) {
+        while (!layer.empty() && needed.insert(layer).second) {
+            auto it = idx.layers.find(layer);
+            layer = it == idx.layers.end() ? "" : it->second;
+        }
+    }
+    for (auto it = idx.layers.begin(); it != idx.layers.end();) {
+        if (needed.count(it->first)) {
+            ++it;
+            continue;
+        }
+        std::cerr << "[Snapshot] Removing unreferenced layer " << it->first << std::endl;
+        unlink(it->first.c_str());
+        it = idx.layers.erase(it);
+    }
+}
+
+// 删除没有任何清单引用的块
+void GcChunks(const SnapshotVm& vm, const SnapshotIndex& idx)
+{
+    std::unordered_set<std::string> live;
+    for (const auto& r : idx.snapshots) {
+        if (r.manifest.empty() || !PathExists(r.manifest)) continue;
+        std::vector<ManifestEntry> entries;
+        if (!ReadManifest(r.manifest, entries)) {
+            // 读不出的清单（损坏或旧格式）不知道引用了哪些块：这次不回收
+            std::cerr << "[Snapshot] Chunk GC skipped, unreadable manifest " << r.manifest << std::endl;
+            return;
+        }
+        for (const auto& e : entries) live.insert(e.id.hex());
+    }
+    const std::string chunks = SnapDir(vm) + "/chunks";
+    DIR* top = opendir(chunks.c_str());
+    if (!top) return;
+    uint64_t removed = 0;
+    while (struct dirent* d = readdir(top)) {
+        if (d->d_name[0] == '.') continue;
+        const std::string sub = chunks + "/" + d->d_name;
+        DIR* dir = opendir(sub.c_str());
+        if (!dir) continue;
+        while (struct dirent* f = readdir(dir)) {
+            if (f->d_name[0] == '.' || live.count(f->d_name)) continue;
+            if (unlink((sub + "/" + f->d_name).c_str()) == 0) removed++;
+        }
+        closedir(dir);
+    }
+    closedir(top);
+    std::cerr << "[Snapshot] Chunk GC removed " << removed << " chunks" << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+// qcow2 overlay（恢复时在冻结层上新建，QEMU 未启动无法用 blockdev-snapshot-sync）
+// ----------------------------------------------------------------------------
+
+void PutBe16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+void PutBe32(uint8_t* p, uint32_t v)
+{
+    for (int i = 3; i >= 0; i--, v >>= 8) p[i] = static_cast<uint8_t>(v);
+}
+
+void PutBe64(uint8_t* p, uint64_t v)
+{
+    for (int i = 7; i >= 0; i--, v >>= 8) p[i] = static_cast<uint8_t>(v);
+}
+
+bool ImageInfo(const std::string& path, bool& is_qcow2, uint64_t& virtual_size)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    uint8_t hdr[32] = { 0 };
+    const ssize_t n = read(fd, hdr, sizeof(hdr));
+    struct stat st;
+    const bool statOk = fstat(fd, &st) == 0;
+    close(fd);
+    is_qcow2 = n == static_cast<ssize_t>(sizeof(hdr)) && hdr[0] == 'Q' && hdr[1] == 'F' && hdr[2] == 'I' && hdr[3] == 0xFB;
+    if (is_qcow2) {
+        virtual_size = 0;
+        for (int i = 24; i < 32; i++) virtual_size = (virtual_size << 8) | hdr[i];
+    } else {
+        if (!statOk) return false;
+        virtual_size = static_cast<uint64_t>(st.st_size);
+    }
+    return virtual_size > 0;
+}
+
+// 64KB cluster：0=header+扩展+backing 名, 1=refcount table, 2=refcount block, 3..=L1
+bool CreateQcow2Overlay(const std::string& path, const std::string& backing, std::string& error)
+{
+    bool backingQcow2 = false;
+    uint64_t size = 0;
+    if (!ImageInfo(backing, backingQcow2, size)) {
+        error = "cannot read backing image " + backing;
+        return false;
+    }
+    const char* fmt = backingQcow2 ? "qcow2" : "raw";
+    const uint64_t cs = 64 * 1024;
+    const uint64_t l1Size = (size + cs * (cs / 8) - 1) / (cs * (cs / 8));
+    const uint64_t l1Clusters = (l1Size * 8 + cs - 1) / cs;
+    const uint64_t clusters = 3 + l1Clusters;
+    const size_t fmtLen = strlen(fmt);
+    const uint64_t backingOffset = 104 + 8 + ((fmtLen + 7) & ~7ULL) + 8;
+    if (backingOffset + backing.size() > cs || backing.size() > 1023) {
+        error = "backing path too long";
+        return false;
+    }
+
+    std::vector<uint8_t> img(clusters * cs, 0);
+    uint8_t* h = img.data();
+    PutBe32(h + 0, 0x514649fb);
+    PutBe32(h + 4, 3);
+    PutBe64(h + 8, backingOffset);
+    PutBe32(h + 16, static_cast<uint32_t>(backing.size()));
+    PutBe32(h + 20, 16);
+    PutBe64(h + 24, size);
+    PutBe32(h + 36, static_cast<uint32_t>(l1Size));
+    PutBe64(h + 40, 3 * cs);
+    PutBe64(h + 48, cs);
+    PutBe32(h + 56, 1);
+    PutBe32(h + 96, 4);
+    PutBe32(h + 100, 104);
+    // backing format 扩展 + 结束标记
+    PutBe32(h + 104, 0xE2792ACA);
+    PutBe32(h + 108, static_cast<uint32_t>(fmtLen));
+    memcpy(h + 112, fmt, fmtLen);
+    memcpy(h + backingOffset, backing.data(), backing.size());
+
+    PutBe64(img.data() + cs, 2 * cs);
+    for (uint64_t i = 0; i < clusters; i++) {
+        PutBe16(img.data() + 2 * cs + i * 2, 1);
+    }
+    if (!WriteFileAtomic(path, img.data(), img.size())) {
+        error = "failed to write overlay " + path;
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// QMP 辅助
+// ----------------------------------------------------------------------------
+
+bool QmpCall(QmpClient& c, const std::string& cmd, const std::string& args, std::string& error,
+             std::string* value = nullptr, int timeout_ms = 10000)
+{
+    QmpResult r = c.execute(cmd, args, timeout_ms);
+    if (!r.ok) {
+        error = cmd + ": " + r.error_class + (r.error_desc.empty() ? "" : " - " + r.error_desc);
+        return false;
+    }
+    if (value) *value = r.value;
+    return true;
+}
+
+bool QueryRunning(QmpClient& c)
+{
+    std::string value, err;
+    if (!QmpCall(c, "query-status", "", err, &value)) return false;
+    cJSON* root = cJSON_Parse(value.c_str());
+    const bool running = root && cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(root, "running"));
+    cJSON_Delete(root);
+    return running;
+}
+
+uint64_t QueryRamSize(QmpClient& c)
+{
+    std::string value, err;
+    if (!QmpCall(c, "query-memory-size-summary", "", err, &value)) return 0;
+    cJSON* root = cJSON_Parse(value.c_str());
+    const uint64_t size = root ? static_cast<uint64_t>(JsonNumber(root, "base-memory")) : 0;
+    cJSON_Delete(root);
+    return size;
+}
+
+// 轮询迁移最终状态（流已结束，通常立即返回）
+bool WaitMigration(QmpClient& c, int timeout_ms, std::string& error)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::string value;
+        if (!QmpCall(c, "query-migrate", "", error, &value)) return false;
+        cJSON* root = cJSON_Parse(value.c_str());
+        const std::string status = root ? JsonString(root, "status") : "";
+        const std::string desc = root ? JsonString(root, "error-desc") : "";
+        cJSON_Delete(root);
+        if (status == "completed") return true;
+        if (status == "failed" || status == "cancelled") {
+            error = "migration " + status + (desc.empty() ? "" : ": " + desc);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    error = "migration did not complete in time";
+    return false;
+}
+
+// 找到 drive 当前的顶层 qcow2 节点
+std::string FindDriveNode(QmpClient& c, const std::string& drive_id, std::string& error)
+{
+    std::string value;
+    if (!QmpCall(c, "query-block", "", error, &value)) return "";
+    cJSON* root = cJSON_Parse(value.c_str());
+    std::string node, fallback;
+    const cJSON* dev = nullptr;
+    cJSON_ArrayForEach(dev, root) {
+        const cJSON* ins = cJSON_GetObjectItemCaseSensitive(dev, "inserted");
+        if (!ins || cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(ins, "ro")) || JsonString(ins, "drv") != "qcow2") {
+            continue;
+        }
+        if (JsonString(dev, "device") == drive_id) {
+            node = JsonString(ins, "node-name");
+            break;
+        }
+        if (fallback.empty()) fallback = JsonString(ins, "node-name");
+    }
+    cJSON_Delete(root);
+    if (node.empty()) node = fallback;
+    if (node.empty()) error = "no writable qcow2 disk (internal snapshots need a qcow2 image)";
+    return node;
+}
+
+// ----------------------------------------------------------------------------
+// unix socket（迁移流）
+// ----------------------------------------------------------------------------
+
+bool FillSockAddr(const std::string& path, sockaddr_un& addr, std::string& error)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error = "socket path too long: " + path;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int ListenUnix(const std::string& path, std::string& error)
+{
+    sockaddr_un addr;
+    if (!FillSockAddr(path, addr, error)) return -1;
+    unlink(path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+        error = std::string("listen on migration socket failed: ") + strerror(errno);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int AcceptWithTimeout(int listen_fd, int timeout_ms)
+{
+    pollfd pfd = { listen_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, timeout_ms) <= 0) return -1;
+    return accept(listen_fd, nullptr, nullptr);
+}
+
+int ConnectUnixRetry(const std::string& path, int timeout_ms, std::string& error)
+{
+    sockaddr_un addr;
+    if (!FillSockAddr(path, addr, error)) return -1;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    do {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+        if (fd >= 0) close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    } while (std::chrono::steady_clock::now() < deadline);
+    error = "cannot connect to incoming migration socket " + path;
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+// 作业
+// ----------------------------------------------------------------------------
+
+std::mutex g_busy_mutex;
+std::set<std::string> g_busy;
+
+bool AcquireBusy(const SnapshotVm& vm, std::string& error)
+{
+    std::lock_guard<std::mutex> lk(g_busy_mutex);
+    if (!g_busy.insert(vm.dir).second) {
+        error = "another snapshot operation is in progress for " + vm.name;
+        return false;
+    }
+    return true;
+}
+
+void ReleaseBusy(const SnapshotVm& vm)
+{
+    std::lock_guard<std::mutex> lk(g_busy_mutex);
+    g_busy.erase(vm.dir);
+}
+
+struct Reporter {
+    SnapshotProgressCallback cb;
+    SnapshotProgress p;
+
+    void step(const char* phase, double progress)
+    {
+        p.phase = phase;
+        p.progress = progress;
+        if (cb) cb(p);
+    }
+
+    void finish(bool ok, const std::string& error)
+    {
+        p.done = true;
+        p.ok = ok;
+        p.error = error;
+        p.phase = ok ? "done" : "error";
+        if (ok) p.progress = 1.0;
+        if (!ok) std::cerr << "[Snapshot] " << p.op << " '" << p.tag << "' failed: " << error << std::endl;
+        if (cb) cb(p);
+    }
+};
+
+std::string ResumeDir(const SnapshotVm& vm) { return SnapDir(vm) + "/resume"; }
+std::string ResumeStatePath(const SnapshotVm& vm) { return ResumeDir(vm) + "/state"; }
+std::string ResumeMetaPath(const SnapshotVm& vm) { return ResumeDir(vm) + "/resume.json"; }
+std::string ResumeInflightPath(const SnapshotVm& vm) { return ResumeMetaPath(vm) + ".inflight"; }
+
+// x-ignore-shared：share=on 的 RAM 块不进迁移流（内容已在 RAM 文件里）
+bool SetIgnoreShared(QmpClient& c, bool on, std::string& error)
+{
+    return QmpCall(c, "migrate-set-capabilities",
+                   std::string("{\"capabilities\": [{\"capability\": \"x-ignore-shared\", \"state\": ") +
+                   (on ? "true" : "false") + "}]}", error);
+}
+
+// 来宾已暂停：磁盘切到新 overlay，RAM 迁移流写入块存储
+bool SaveExternalPaused(QmpClient& c, const SnapshotVm& vm, SnapshotRecord& rec, Reporter& rep, std::string& error)
+{
+    const int64_t stamp = NowMs();
+    const std::string base = SnapDir(vm);
+    const std::string name = SafeTag(rec.info.tag) + "-" + std::to_string(stamp);
+    const std::string overlay = base + "/layers/" + name + ".qcow2";
+    MakeDirs(base + "/layers");
+    MakeDirs(base + "/ram");
+
+    std::string frozen;
+    {
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        const SnapshotIndex idx = LoadIndexLocked(vm);
+        frozen = idx.active_disk.empty() ? vm.base_disk : idx.active_disk;
+    }
+    rep.step("disk", 0.0);
+    if (!QmpCall(c, "blockdev-snapshot-sync",
+                 "{\"device\": " + qmp_json_quote(vm.drive_id) + ", \"snapshot-file\": " + qmp_json_quote(overlay) +
+                 ", \"format\": \"qcow2\"}", error)) {
+        return false;
+    }
+    {
+        // 活动层立即落盘：之后即使 RAM 部分失败，下次启动也会挂载正确的顶层
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        SnapshotIndex idx = LoadIndexLocked(vm);
+        idx.layers[overlay] = frozen;
+        idx.active_disk = overlay;
+        SaveIndexLocked(vm, idx);
+    }
+    rec.info.disk_layer = frozen;
+
+    const uint64_t ramTotal = QueryRamSize(c);
+    std::string ignored;
+    QmpCall(c, "migrate-set-parameters", "{\"max-bandwidth\": 68719476736}", ignored);
+    SetIgnoreShared(c, false, ignored);
+
+    const std::string sockPath = vm.dir + "/snap.sock";
+    int lfd = ListenUnix(sockPath, error);
+    if (lfd < 0) return false;
+    if (!QmpCall(c, "migrate", "{\"uri\": " + qmp_json_quote("unix:" + sockPath) + "}", error)) {
+        close(lfd);
+        unlink(sockPath.c_str());
+        return false;
+    }
+    int fd = AcceptWithTimeout(lfd, 10000);
+    close(lfd);
+    unlink(sockPath.c_str());
+    if (fd < 0) {
+        error = "QEMU did not connect to the migration socket";
+        QmpCall(c, "migrate_cancel", "", ignored);
+        return false;
+    }
+
+    ChunkStore store(base + "/chunks");
+    RamStreamWriter writer(store);
+    std::vector<uint8_t> buf(1024 * 1024);
+    uint64_t nextReport = kProgressStep;
+    bool ok = true;
+    while (true) {
+        ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            error = std::string("read migration stream: ") + strerror(errno);
+            ok = false;
+            break;
+        }
+        if (n == 0) break;
+        if (!writer.feed(buf.data(), static_cast<size_t>(n))) {
+            error = "failed to write chunk store";
+            ok = false;
+            break;
+        }
+        if (writer.raw_bytes() >= nextReport) {
+            nextReport += kProgressStep;
+            rep.p.ram_bytes = writer.raw_bytes();
+            rep.p.stored_bytes = writer.stored_bytes();
+            rep.step("ram", ramTotal ? std::min(0.99, static_cast<double>(writer.raw_bytes()) / ramTotal) : 0.5);
+        }
+    }
+    close(fd);
+    if (!ok) {
+        QmpCall(c, "migrate_cancel", "", ignored);
+        return false;
+    }
+    if (!writer.finish() || !WaitMigration(c, 10000, error)) {
+        if (error.empty()) error = "failed to write chunk store";
+        return false;
+    }
+
+    rec.manifest = base + "/ram/" + name + ".manifest";
+    if (!WriteManifest(rec.manifest, writer.entries())) {
+        error = "failed to write RAM manifest";
+        return false;
+    }
+    rec.info.ram_bytes = writer.raw_bytes();
+    rec.info.stored_bytes = writer.stored_bytes();
+    rep.p.ram_bytes = rec.info.ram_bytes;
+    rep.p.stored_bytes = rec.info.stored_bytes;
+    std::cerr << "[Snapshot] RAM stream " << rec.info.ram_bytes << " bytes, " << writer.entries().size()
+              << " chunks, " << rec.info.stored_bytes << " bytes newly stored" << std::endl;
+    return true;
+}
+
+void RecordSnapshot(const SnapshotVm& vm, const SnapshotRecord& rec)
+{
+    std::lock_guard<std::mutex> lk(g_index_mutex);
+    SnapshotIndex idx = LoadIndexLocked(vm);
+    // 同名覆盖：旧清单随后由块 GC 回收
+    std::string oldManifest;
+    for (auto it = idx.snapshots.begin(); it != idx.snapshots.end(); ++it) {
+        if (it->info.tag == rec.info.tag) {
+            oldManifest = it->manifest;
+            idx.snapshots.erase(it);
+            break;
+        }
+    }
+    idx.snapshots.push_back(rec);
+    GcLayersLocked(idx);
+    SaveIndexLocked(vm, idx);
+    if (!oldManifest.empty() && oldManifest != rec.manifest) {
+        unlink(oldManifest.c_str());
+        GcChunks(vm, idx);
+    }
+}
+
+void SaveJob(SnapshotVm vm, std::string tag, SnapshotMode mode, Reporter rep)
+{
+    std::string error;
+    bool ok = false;
+    SnapshotRecord rec;
+    rec.info.tag = tag;
+    rec.info.mode = mode;
+    rec.info.created_ms = NowMs();
+
+    std::shared_ptr<QmpClient> c = qmp_client_for(vm.qmp_socket);
+    if (!c->ensure_connected(2000)) {
+        error = "QMP not connected (is the VM running?)";
+    } else if (mode == SnapshotMode::Internal) {
+        rec.info.was_running = QueryRunning(*c);
+        ok = snapshot_internal_job(*c, "snapshot-save", tag, vm.drive_id, 30 * 60 * 1000, error,
+                                   [&rep](double p) { rep.step("job", p); });
+    } else {
+        rec.info.was_running = QueryRunning(*c);
+        if (!rec.info.was_running || QmpCall(*c, "stop", "", error)) {
+            ok = SaveExternalPaused(*c, vm, rec, rep, error);
+            std::string contErr;
+            if (rec.info.was_running && !QmpCall(*c, "cont", "", contErr)) {
+                std::cerr << "[Snapshot] Failed to resume guest: " << contErr << std::endl;
+            }
+        }
+    }
+    if (ok) RecordSnapshot(vm, rec);
+    ReleaseBusy(vm);
+    rep.finish(ok, error);
+}
+
+void LoadInternalJob(SnapshotVm vm, std::string tag, Reporter rep)
+{
+    std::string error;
+    std::shared_ptr<QmpClient> c = qmp_client_for(vm.qmp_socket);
+    bool ok = c->ensure_connected(2000) &&
+              snapshot_internal_job(*c, "snapshot-load", tag, vm.drive_id, 30 * 60 * 1000, error,
+                                    [&rep](double p) { rep.step("job", p); });
+    if (!ok && error.empty()) error = "QMP not connected (is the VM running?)";
+    ReleaseBusy(vm);
+    rep.finish(ok, error);
+}
+
+// 在 -incoming defer 的 QEMU 上启动 migrate-incoming，并把 producer 产生的流写进去
+bool StreamIncoming(QmpClient& c, const SnapshotVm& vm, const std::function<bool(int fd, std::string& error)>& producer,
+                    std::string& error)
+{
+    const std::string sockPath = vm.dir + "/snap.sock";
+    if (!QmpCall(c, "migrate-incoming", "{\"uri\": " + qmp_json_quote("unix:" + sockPath) + "}", error)) {
+        return false;
+    }
+    int fd = ConnectUnixRetry(sockPath, 5000, error);
+    if (fd < 0) return false;
+    bool ok = producer(fd, error);
+    shutdown(fd, SHUT_WR);
+    close(fd);
+    unlink(sockPath.c_str());
+    return ok && WaitMigration(c, 60000, error);
+}
+
+// QMP socket 在 qemu_init 期间才出现
+bool WaitQmp(QmpClient& c)
+{
+    for (int i = 0; i < 60; i++) {
+        if (c.ensure_connected(1000)) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    return false;
+}
+
+void FinishStartJob(SnapshotVm vm, std::string tag, Reporter rep)
+{
+    std::string error;
+    bool ok = false;
+    SnapshotRecord rec;
+    {
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        SnapshotIndex idx = LoadIndexLocked(vm);
+        if (SnapshotRecord* r = idx.find(tag)) rec = *r;
+    }
+    std::vector<ManifestEntry> entries;
+    std::shared_ptr<QmpClient> c = qmp_client_for(vm.qmp_socket);
+    if (rec.manifest.empty() || !ReadManifest(rec.manifest, entries)) {
+        error = "RAM manifest missing for snapshot " + tag;
+    } else if (!WaitQmp(*c)) {
+        error = "QMP not reachable for incoming migration";
+    } else {
+        ok = StreamIncoming(*c, vm, [&](int fd, std::string& err) {
+            ChunkStore store(SnapDir(vm) + "/chunks");
+            std::vector<uint8_t> chunk;
+            uint64_t sent = 0;
+            uint64_t nextReport = kProgressStep;
+            for (const auto& e : entries) {
+                if (!store.get(e, chunk)) {
+                    err = "chunk " + e.id.hex() + " missing or corrupt";
+                    return false;
+                }
+                if (!SendAll(fd, chunk.data(), chunk.size())) {
+                    err = std::string("write migration stream: ") + strerror(errno);
+                    return false;
+                }
+                sent += chunk.size();
+                if (sent >= nextReport) {
+                    nextReport += kProgressStep;
+                    rep.p.ram_bytes = sent;
+                    rep.step("ram", rec.info.ram_bytes ? static_cast<double>(sent) / rec.info.ram_bytes : 0.5);
+                }
+            }
+            return true;
+        }, error);
+        // -incoming 完成后 QEMU 自动运行；拍摄时是暂停的就保持暂停
+        if (ok && !rec.info.was_running) QmpCall(*c, "stop", "", error);
+    }
+    rep.p.ram_bytes = rec.info.ram_bytes;
+    ReleaseBusy(vm);
+    rep.finish(ok, error);
+}
+
+// 快速恢复：RAM 文件由 QEMU 直接映射（缺页时才读盘），这里只回灌几百 KB 的设备状态
+void ResumeJob(SnapshotVm vm, Reporter rep)
+{
+    std::string error;
+    bool ok = false;
+    bool was_running = true;
+    std::vector<uint8_t> state;
+    if (ReadFile(ResumeInflightPath(vm), state)) {
+        cJSON* meta = cJSON_ParseWithLength(reinterpret_cast<const char*>(state.data()), state.size());
+        was_running = !meta || !cJSON_IsFalse(cJSON_GetObjectItemCaseSensitive(meta, "running"));
+        cJSON_Delete(meta);
+    }
+    std::shared_ptr<QmpClient> c = qmp_client_for(vm.qmp_socket);
+    if (!ReadFile(ResumeStatePath(vm), state) || state.empty()) {
+        error = "resume state missing";
+    } else if (!WaitQmp(*c)) {
+        error = "QMP not reachable for incoming migration";
+    } else if (SetIgnoreShared(*c, true, error)) {
+        rep.step("ram", 0.0);
+        ok = StreamIncoming(*c, vm, [&state](int fd, std::string& err) {
+            if (SendAll(fd, state.data(), state.size())) return true;
+            err = std::string("write migration stream: ") + strerror(errno);
+            return false;
+        }, error);
+        // 之后的外部快照需要把 RAM 写进流里
+        std::string ignored;
+        SetIgnoreShared(*c, false, ignored);
+        if (ok && !was_running) QmpCall(*c, "stop", "", error);
+    }
+    // 状态已被消费：来宾一旦运行，RAM 文件内容就和它不再对应
+    unlink(ResumeStatePath(vm).c_str());
+    unlink(ResumeInflightPath(vm).c_str());
+    rep.p.ram_bytes = state.size();
+    ReleaseBusy(vm);
+    rep.finish(ok, error);
+}
+
+// 需持有 g_index_mutex
+void DiscardResumeLocked(const SnapshotVm& vm)
+{
+    unlink(ResumeMetaPath(vm).c_str());
+    unlink(ResumeInflightPath(vm).c_str());
+    unlink(ResumeStatePath(vm).c_str());
+    // 清空而不是删除：正在运行的 QEMU 可能仍映射着它；长度 0 也让下次启动重新按 -m 分配
+    truncate(snapshot_ram_file(vm).c_str(), 0);
+}
+
+} // namespace
+
+// ============================================================================
+// 对外接口
+// ============================================================================
+
+bool snapshot_internal_job(QmpClient& client, const std::string& command, const std::string& tag,
+                           const std::string& drive_id, int timeout_ms, std::string& error,
+                           const std::function<void(double)>& on_progress)
+{
+    const std::string node = FindDriveNode(client, drive_id, error);
+    if (node.empty()) return false;
+
+    const std::string jobId = "aether-" + command + "-" + std::to_string(NowMs());
+    std::string args = "{\"job-id\": " + qmp_json_quote(jobId) + ", \"tag\": " + qmp_json_quote(tag) +
+                       ", \"devices\": [" + qmp_json_quote(node) + "]";
+    if (command != "snapshot-delete") args += ", \"vmstate\": " + qmp_json_quote(node);
+    args += "}";
+    if (!QmpCall(client, command, args, error)) return false;
+
+    // 作业期间查询 query-jobs 取进度；作业结束后 dismiss
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::string status, jobError;
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::string value;
+        if (!QmpCall(client, "query-jobs", "", error, &value)) return false;
+        cJSON* root = cJSON_Parse(value.c_str());
+        const cJSON* job = nullptr;
+        bool found = false;
+        cJSON_ArrayForEach(job, root) {
+            if (JsonString(job, "id") != jobId) continue;
+            found = true;
+            status = JsonString(job, "status");
+            jobError = JsonString(job, "error");
+            const double total = JsonNumber(job, "total-progress");
+            if (on_progress && total > 0) on_progress(JsonNumber(job, "current-progress") / total);
+        }
+        cJSON_Delete(root);
+        if (!found || status == "concluded" || status == "null") break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+    std::string ignored;
+    QmpCall(client, "job-dismiss", "{\"id\": " + qmp_json_quote(jobId) + "}", ignored);
+    if (status != "concluded") {
+        error = command + " job did not finish (status " + (status.empty() ? "unknown" : status) + ")";
+        return false;
+    }
+    if (!jobError.empty()) {
+        error = command + ": " + jobError;
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> snapshot_internal_list(QmpClient& client, const std::string& drive_id)
+{
+    std::vector<std::string> names;
+    std::string value, error;
+    if (!QmpCall(client, "query-block", "", error, &value)) return names;
+    cJSON* root = cJSON_Parse(value.c_str());
+    const cJSON* dev = nullptr;
+    cJSON_ArrayForEach(dev, root) {
+        const cJSON* ins = cJSON_GetObjectItemCaseSensitive(dev, "inserted");
+        if (!ins || (!drive_id.empty() && JsonString(dev, "device") != drive_id)) continue;
+        const cJSON* image = cJSON_GetObjectItemCaseSensitive(ins, "image");
+        const cJSON* snap = nullptr;
+        cJSON_ArrayForEach(snap, cJSON_GetObjectItemCaseSensitive(image, "snapshots")) {
+            const std::string name = JsonString(snap, "name");
+            if (!name.empty()) names.push_back(name);
+        }
+        if (!drive_id.empty()) break;
+    }
+    cJSON_Delete(root);
+    return names;
+}
+
+bool snapshot_save_async(const SnapshotVm& vm, const std::string& tag, SnapshotMode mode,
+                         SnapshotProgressCallback callback, std::string& error)
+{
+    if (tag.empty()) {
+        error = "snapshot tag is empty";
+        return false;
+    }
+    if (!AcquireBusy(vm, error)) return false;
+    Reporter rep{ std::move(callback), {} };
+    rep.p.tag = tag;
+    rep.p.op = "save";
+    std::thread(SaveJob, vm, tag, mode, std::move(rep)).detach();
+    return true;
+}
+
+bool snapshot_load_async(const SnapshotVm& vm, const std::string& tag, bool vm_running,
+                         SnapshotProgressCallback callback, std::string& error)
+{
+    SnapshotRecord rec;
+    {
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        SnapshotIndex idx = LoadIndexLocked(vm);
+        SnapshotRecord* r = idx.find(tag);
+        if (!r) {
+            error = "snapshot not found: " + tag;
+            return false;
+        }
+        rec = *r;
+    }
+    Reporter rep{ std::move(callback), {} };
+    rep.p.tag = tag;
+    rep.p.op = "load";
+
+    if (rec.info.mode == SnapshotMode::Internal) {
+        if (!vm_running) {
+            error = "internal snapshots can only be loaded while the VM is running";
+            return false;
+        }
+        if (!AcquireBusy(vm, error)) return false;
+        std::thread(LoadInternalJob, vm, tag, std::move(rep)).detach();
+        return true;
+    }
+
+    // 外部快照：RAM 只能灌给新启动的 QEMU（-incoming），登记后在下次启动时恢复
+    {
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        SnapshotIndex idx = LoadIndexLocked(vm);
+        idx.pending_restore = tag;
+        if (!SaveIndexLocked(vm, idx)) {
+            error = "failed to write snapshot index";
+            return false;
+        }
+    }
+    rep.p.done = true;
+    rep.p.ok = true;
+    rep.step("pending", 0.0);
+    return true;
+}
+
+bool snapshot_delete(const SnapshotVm& vm, const std::string& tag, bool vm_running, std::string& error)
+{
+    SnapshotRecord rec;
+    {
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        SnapshotIndex idx = LoadIndexLocked(vm);
+        SnapshotRecord* r = idx.find(tag);
+        if (!r) {
+            error = "snapshot not found: " + tag;
+            return false;
+        }
+        rec = *r;
+    }
+    if (!AcquireBusy(vm, error)) return false;
+
+    bool ok = true;
+    if (rec.info.mode == SnapshotMode::Internal) {
+        if (!vm_running) {
+            error = "internal snapshots can only be deleted while the VM is running";
+            ok = false;
+        } else {
+            std::shared_ptr<QmpClient> c = qmp_client_for(vm.qmp_socket);
+            ok = c->ensure_connected(2000) &&
+                 snapshot_internal_job(*c, "snapshot-delete", tag, vm.drive_id, 10 * 60 * 1000, error);
+            if (!ok && error.empty()) error = "QMP not connected";
+        }
+    }
+    if (ok) {
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        SnapshotIndex idx = LoadIndexLocked(vm);
+        for (auto it = idx.snapshots.begin(); it != idx.snapshots.end(); ++it) {
+            if (it->info.tag == tag) {
+                idx.snapshots.erase(it);
+                break;
+            }
+        }
+        if (idx.pending_restore == tag) idx.pending_restore.clear();
+        GcLayersLocked(idx);
+        SaveIndexLocked(vm, idx);
+        if (!rec.manifest.empty()) {
+            unlink(rec.manifest.c_str());
+            GcChunks(vm, idx);
+        }
+    }
+    ReleaseBusy(vm);
+    return ok;
+}
+
+std::vector<SnapshotInfo> snapshot_list(const SnapshotVm& vm)
+{
+    std::lock_guard<std::mutex> lk(g_index_mutex);
+    std::vector<SnapshotInfo> out;
+    for (const auto& r : LoadIndexLocked(vm).snapshots) out.push_back(r.info);
+    return out;
+}
+
+SnapshotStartPlan snapshot_prepare_start(const SnapshotVm& vm, const std::string& fingerprint)
+{
+    SnapshotStartPlan plan;
+    std::lock_guard<std::mutex> lk(g_index_mutex);
+    SnapshotIndex idx = LoadIndexLocked(vm);
+    plan.disk_path = (!idx.active_disk.empty() && PathExists(idx.active_disk)) ? idx.active_disk : vm.base_disk;
+    if (idx.pending_restore.empty()) {
+        // 快速恢复：硬件配置与活动磁盘都必须和挂起时一致
+        std::vector<uint8_t> buf;
+        cJSON* meta = nullptr;
+        if (ReadFile(ResumeMetaPath(vm), buf)) {
+            meta = cJSON_ParseWithLength(reinterpret_cast<const char*>(buf.data()), buf.size());
+        }
+        if (meta && JsonString(meta, "fingerprint") == fingerprint && JsonString(meta, "disk") == plan.disk_path &&
+            PathExists(ResumeStatePath(vm)) && PathExists(snapshot_ram_file(vm))) {
+            plan.resume = true;
+            // 先消费元数据：恢复中途崩溃时下次启动走正常引导，而不是反复尝试
+            rename(ResumeMetaPath(vm).c_str(), ResumeInflightPath(vm).c_str());
+            std::cerr << "[Snapshot] Resuming " << vm.name << " from " << snapshot_ram_file(vm) << std::endl;
+        } else {
+            if (meta) std::cerr << "[Snapshot] Resume state of " << vm.name << " no longer matches, discarding" << std::endl;
+            DiscardResumeLocked(vm);
+        }
+        cJSON_Delete(meta);
+        return plan;
+    }
+    DiscardResumeLocked(vm);
+    const std::string tag = idx.pending_restore;
+    idx.pending_restore.clear();
+    const SnapshotRecord* rec = idx.find(tag);
+    std::string error;
+    if (!rec || rec->info.mode != SnapshotMode::External || !PathExists(rec->info.disk_layer) ||
+        !PathExists(rec->manifest)) {
+        std::cerr << "[Snapshot] Pending restore '" << tag << "' is no longer valid, booting normally" << std::endl;
+    } else {
+        // 冻结层保持只读：在它上面新建 overlay 作为活动层，原活动层若无人引用则回收
+        const std::string overlay = SnapDir(vm) + "/layers/" + SafeTag(tag) + "-restore-" +
+                                    std::to_string(NowMs()) + ".qcow2";
+        MakeDirs(SnapDir(vm) + "/layers");
+        if (CreateQcow2Overlay(overlay, rec->info.disk_layer, error)) {
+            idx.layers[overlay] = rec->info.disk_layer;
+            idx.active_disk = overlay;
+            GcLayersLocked(idx);
+            plan.disk_path = overlay;
+            plan.restore_tag = tag;
+        } else {
+            std::cerr << "[Snapshot] Restore '" << tag << "' failed: " << error << std::endl;
+        }
+    }
+    SaveIndexLocked(vm, idx);
+    return plan;
+}
+
+void snapshot_finish_start(const SnapshotVm& vm, const SnapshotStartPlan& plan, SnapshotProgressCallback callback)
+{
+    Reporter rep{ std::move(callback), {} };
+    rep.p.tag = plan.resume ? "resume" : plan.restore_tag;
+    rep.p.op = "load";
+    std::string error;
+    if (!AcquireBusy(vm, error)) {
+        rep.finish(false, error);
+        return;
+    }
+    if (plan.resume) {
+        std::thread(ResumeJob, vm, std::move(rep)).detach();
+        return;
+    }
+    std::thread(FinishStartJob, vm, plan.restore_tag, std::move(rep)).detach();
+}
+
+std::string snapshot_ram_file(const SnapshotVm& vm)
+{
+    return ResumeDir(vm) + "/ram.img";
+}
+
+bool snapshot_suspend(const SnapshotVm& vm, const std::string& fingerprint, std::string& error)
+{
+    if (!AcquireBusy(vm, error)) return false;
+    std::shared_ptr<QmpClient> c = qmp_client_for(vm.qmp_socket);
+    bool ok = false;
+    if (!c->ensure_connected(2000)) {
+        error = "QMP not connected (is the VM running?)";
+        ReleaseBusy(vm);
+        return false;
+    }
+    std::string disk;
+    {
+        std::lock_guard<std::mutex> lk(g_index_mutex);
+        const SnapshotIndex idx = LoadIndexLocked(vm);
+        disk = (!idx.active_disk.empty() && PathExists(idx.active_disk)) ? idx.active_disk : vm.base_disk;
+    }
+    const bool running = QueryRunning(*c);
+    std::string ignored;
+    if ((!running || QmpCall(*c, "stop", "", error)) && SetIgnoreShared(*c, true, error)) {
+        MakeDirs(ResumeDir(vm));
+        const std::string sockPath = vm.dir + "/snap.sock";
+        const std::string tmp = ResumeStatePath(vm) + ".tmp";
+        int lfd = ListenUnix(sockPath, error);
+        if (lfd >= 0 && QmpCall(*c, "migrate", "{\"uri\": " + qmp_json_quote("unix:" + sockPath) + "}", error)) {
+            int fd = AcceptWithTimeout(lfd, 10000);
+            int out = open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+            if (fd < 0 || out < 0) {
+                error = fd < 0 ? "QEMU did not connect to the migration socket" : "cannot create resume state file";
+            } else {
+                std::vector<uint8_t> buf(256 * 1024);
+                ok = true;
+                while (ok) {
+                    ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) {
+                        if (n < 0) error = std::string("read migration stream: ") + strerror(errno);
+                        ok = n == 0;
+                        break;
+                    }
+                    ok = WriteAll(out, buf.data(), static_cast<size_t>(n));
+                    if (!ok) error = "failed to write resume state";
+                }
+                ok = ok && fsync(out) == 0 && WaitMigration(*c, 10000, error);
+            }
+            if (fd >= 0) close(fd);
+            if (out >= 0) close(out);
+            if (!ok) QmpCall(*c, "migrate_cancel", "", ignored);
+        }
+        if (lfd >= 0) close(lfd);
+        unlink(sockPath.c_str());
+
+        // RAM 走的是共享文件映射：落盘后挂起状态才可靠（应用被杀不影响页缓存，掉电则需要这一步）
+        int ramFd = ok ? open(snapshot_ram_file(vm).c_str(), O_RDWR) : -1;
+        if (ok && (ramFd < 0 || fsync(ramFd) != 0)) {
+            error = "failed to flush RAM file " + snapshot_ram_file(vm);
+            ok = false;
+        }
+        if (ramFd >= 0) close(ramFd);
+
+        if (ok) {
+            std::lock_guard<std::mutex> lk(g_index_mutex);
+            ok = rename(tmp.c_str(), ResumeStatePath(vm).c_str()) == 0;
+            cJSON* meta = cJSON_CreateObject();
+            cJSON_AddStringToObject(meta, "fingerprint", fingerprint.c_str());
+            cJSON_AddStringToObject(meta, "disk", disk.c_str());
+            cJSON_AddBoolToObject(meta, "running", running);
+            cJSON_AddNumberToObject(meta, "created", static_cast<double>(NowMs()));
+            char* text = cJSON_PrintUnformatted(meta);
+            cJSON_Delete(meta);
+            ok = ok && text && WriteFileAtomic(ResumeMetaPath(vm), text, strlen(text));
+            if (text) cJSON_free(text);
+            if (!ok) error = "failed to write resume metadata";
+        } else {
+            unlink(tmp.c_str());
+        }
+    }
+    if (!ok) {
+        SetIgnoreShared(*c, false, ignored);
+        if (running) QmpCall(*c, "cont", "", ignored);
+        std::cerr << "[Snapshot] Suspend of " << vm.name << " failed: " << error << std::endl;
+    }
+    ReleaseBusy(vm);
+    return ok;
+}
+
+bool snapshot_has_resume_state(const SnapshotVm& vm)
+{
+    std::lock_guard<std::mutex> lk(g_index_mutex);
+    return PathExists(ResumeMetaPath(vm)) && PathExists(ResumeStatePath(vm));
+}
+
+void snapshot_discard_resume_state(const SnapshotVm& vm)
+{
+    std::lock_guard<std::mutex> lk(g_index_mutex);
+    DiscardResumeLocked(vm);
+}
+
+void snapshot_vm_exited(const SnapshotVm& vm)
+{
+    std::lock_guard<std::mutex> lk(g_index_mutex);
+    if (!PathExists(ResumeMetaPath(vm))) unlink(snapshot_ram_file(vm).c_str());
+}
@@ -0,0 +1,89 @@
+#ifndef SNAPSHOT_MANAGER_H
+#define SNAPSHOT_MANAGER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+class QmpClient;
+
+// 快照类型
+enum class SnapshotMode {
+    External,   // 外部快照：磁盘切到新的 qcow2 overlay，RAM 状态流写入去重 + 压缩的块存储（默认）
+    Internal,   // 内部快照：QMP snapshot-save/snapshot-load 作业，状态写进 qcow2 镜像
+};
+
+// 快照所属 VM 的位置信息
+struct SnapshotVm {
+    std::string name;
+    std::string dir;              // VM 目录，快照数据放在 dir/snapshots
+    std::string qmp_socket;
+    std::string base_disk;        // 原始磁盘（未做过外部快照时即活动磁盘）
+    std::string drive_id = "hd0"; // -drive id
+};
+
+struct SnapshotInfo {
+    std::string tag;
+    SnapshotMode mode = SnapshotMode::External;
+    int64_t created_ms = 0;       // Unix 毫秒
+    bool was_running = false;     // 拍摄时来宾是否在运行（恢复后保持同样状态）
+    uint64_t ram_bytes = 0;       // RAM 状态流原始字节数
+    uint64_t stored_bytes = 0;    // 本次新写入块存储的字节数（去重、压缩之后）
+    std::string disk_layer;       // 外部快照冻结的磁盘层
+};
+
+// 进度 / 结果：在后台线程中回调
+struct SnapshotProgress {
+    std::string tag;
+    std::string op;               // "save" / "load" / "delete"
+    std::string phase;            // "disk" / "ram" / "job" / "pending" / "done" / "error"
+    double progress = 0.0;        // 0..1
+    uint64_t ram_bytes = 0;
+    uint64_t stored_bytes = 0;
+    bool done = false;
+    bool ok = false;
+    std::string error;
+};
+
+using SnapshotProgressCallback = std::function<void(const SnapshotProgress& progress)>;
+
+// StartVm 构建参数前调用：决定实际挂载的磁盘层，以及是否以 -incoming defer 启动来恢复 RAM
+struct SnapshotStartPlan {
+    std::string disk_path;
+    std::string restore_tag;      // 非空：启动后调用 snapshot_finish_start
+    bool resume = false;          // 快速恢复：RAM 在文件里（按需缺页读入），只回灌设备状态
+};
+
+// 异步作业（每个 VM 同一时间只允许一个）。返回 false 表示未启动，原因写入 error
+bool snapshot_save_async(const SnapshotVm& vm, const std::string& tag, SnapshotMode mode,
+                         SnapshotProgressCallback callback, std::string& error);
+// 外部快照需要 VM 已停止：只登记为待恢复，下次启动时生效（progress.phase == "pending"）
+bool snapshot_load_async(const SnapshotVm& vm, const std::string& tag, bool vm_running,
+                         SnapshotProgressCallback callback, std::string& error);
+bool snapshot_delete(const SnapshotVm& vm, const std::string& tag, bool vm_running, std::string& error);
+std::vector<SnapshotInfo> snapshot_list(const SnapshotVm& vm);
+
+// fingerprint：影响来宾硬件的启动配置摘要，与挂起时不一致则放弃快速恢复
+SnapshotStartPlan snapshot_prepare_start(const SnapshotVm& vm, const std::string& fingerprint);
+// QEMU 已以 -incoming defer 启动：后台把 RAM / 设备状态流回灌给 QEMU
+void snapshot_finish_start(const SnapshotVm& vm, const SnapshotStartPlan& plan, SnapshotProgressCallback callback);
+
+// 快速恢复（挂起到文件）：来宾 RAM 用 memory-backend-file(share=on) 映射该文件
+std::string snapshot_ram_file(const SnapshotVm& vm);
+// 暂停来宾并保存设备状态（x-ignore-shared，不含 RAM），成功后调用方退出 QEMU。同步执行
+bool snapshot_suspend(const SnapshotVm& vm, const std::string& fingerprint, std::string& error);
+bool snapshot_has_resume_state(const SnapshotVm& vm);
+void snapshot_discard_resume_state(const SnapshotVm& vm);
+// QEMU 退出后调用：没有挂起状态时删除 RAM 文件，释放存储
+void snapshot_vm_exited(const SnapshotVm& vm);
+
+// 内部快照作业（同步等待完成），qemu_wrapper 的 savevm/loadvm/delvm 替代实现
+// command: "snapshot-save" / "snapshot-load" / "snapshot-delete"
+bool snapshot_internal_job(QmpClient& client, const std::string& command, const std::string& tag,
+                           const std::string& drive_id, int timeout_ms, std::string& error,
+                           const std::function<void(double)>& on_progress = nullptr);
+// 列出镜像内的内部快照（需 VM 在运行）
+std::vector<std::string> snapshot_internal_list(QmpClient& client, const std::string& drive_id);
+
+#endif // SNAPSHOT_MANAGER_H
@@ -0,0 +1,261 @@
+#include "tcg_profile.h"
+#include "vm_sched.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+// 按性能模式的 vCPU 默认值与来宾内存（占宿主物理内存的百分比上限 / 未指定时的默认值）
+struct ProfileLimits {
+    int mem_percent;
+    int default_mem_mb;
+};
+
+ProfileLimits LimitsFor(TcgProfile p)
+{
+    switch (p) {
+    case TcgProfile::PowerSaver: return { 25, 1024 };
+    case TcgProfile::Turbo:      return { 75, 4096 };
+    default:                     return { 50, 2048 };
+    }
+}
+
+std::string Lower(const std::string& s)
+{
+    std::string out;
+    for (char c : s) {
+        if (!isspace(static_cast<unsigned char>(c))) out.push_back(static_cast<char>(tolower(static_cast<unsigned char>(c))));
+    }
+    return out;
+}
+
+int64_t MemAvailableMb()
+{
+    std::ifstream in("/proc/meminfo");
+    std::string key;
+    int64_t kb = 0;
+    std::string unit;
+    while (in >> key >> kb) {
+        std::getline(in, unit);
+        if (key == "MemAvailable:") return kb / 1024;
+    }
+    return 0;
+}
+
+// 取 "key   number" 或 "key   used/total" 行中 key 之后的第一个（和第二个）数字
+bool FindCounter(const std::string& text, const std::string& key, int64_t& first, int64_t* second = nullptr)
+{
+    size_t pos = 0;
+    while ((pos = text.find(key, pos)) != std::string::npos) {
+        const bool lineStart = pos == 0 || text[pos - 1] == '\n';
+        size_t p = pos + key.size();
+        pos = p;
+        if (!lineStart || p >= text.size() || !isspace(static_cast<unsigned char>(text[p]))) continue;
+        while (p < text.size() && text[p] == ' ') p++;
+        if (p >= text.size() || !isdigit(static_cast<unsigned char>(text[p]))) continue;
+        char* end = nullptr;
+        first = strtoll(text.c_str() + p, &end, 10);
+        if (second && end && *end == '/') *second = strtoll(end + 1, nullptr, 10);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool tcg_profile_from_string(const std::string& s, TcgProfile& out)
+{
+    const std::string v = Lower(s);
+    if (v == "powersaver" || v == "power-saver" || v == "power_saver" || v == "eco") {
+        out = TcgProfile::PowerSaver;
+    } else if (v == "balanced" || v == "standard" || v == "default") {
+        out = TcgProfile::Balanced;
+    } else if (v == "turbo" || v == "performance") {
+        out = TcgProfile::Turbo;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* tcg_profile_name(TcgProfile p)
+{
+    switch (p) {
+    case TcgProfile::PowerSaver: return "powersaver";
+    case TcgProfile::Turbo:      return "turbo";
+    default:                     return "balanced";
+    }
+}
+
+TcgHostCaps tcg_probe_host(bool jit, bool kvm)
+{
+    TcgHostCaps caps;
+    caps.jit = jit;
+    caps.kvm = kvm;
+    caps.cpus = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+    const long page = sysconf(_SC_PAGE_SIZE);
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    if (page > 0 && pages > 0) caps.total_mem_mb = static_cast<int64_t>(pages) * page / (1024 * 1024);
+    caps.avail_mem_mb = MemAvailableMb();
+
+    // 能效核 = 算力最低的一簇；其余（大核、超大核）都算性能核
+    const SchedTopology& topo = sched_topology();
+    caps.big_cpus = topo.performance;
+    caps.little_cpus = topo.efficiency;
+    return caps;
+}
+
+TcgTuning tcg_profile_plan(const TcgRequest& req, const TcgHostCaps& caps)
+{
+    TcgTuning t;
+    t.profile = req.profile;
+    const int hostCpus = std::max(1, caps.cpus);
+    const bool hetero = !caps.little_cpus.empty() && !caps.big_cpus.empty();
+    const int bigCpus = hetero ? static_cast<int>(caps.big_cpus.size()) : hostCpus;
+
+    // ---- vCPU 数量 ----
+    // MTTCG 下每个 vCPU 是一个宿主线程；留一个核给 ArkTS UI / 显示线程
+    int cap = std::max(1, hostCpus - 1);
+    int def = 2;
+    std::string capWhy = "留一个宿主核心给 UI 与显示线程";
+    if (req.profile == TcgProfile::PowerSaver) {
+        cap = std::min(2, hostCpus);
+        def = 1;
+        capWhy = "节能模式最多 2 个 vCPU";
+    } else if (req.profile == TcgProfile::Balanced && hetero) {
+        cap = std::max(1, std::min(cap, bigCpus));
+        capWhy = "只用性能核（" + std::to_string(bigCpus) + " 个）：落在能效核上的 vCPU 会拖慢来宾里等待它的其它 vCPU";
+    } else if (req.profile == TcgProfile::Turbo) {
+        def = 4;
+    }
+    def = std::min(def, cap);
+    if (req.cpus > 0) {
+        t.smp = std::min(req.cpus, cap);
+        if (t.smp != req.cpus) {
+            t.rationale.push_back("vCPU " + std::to_string(req.cpus) + " -> " + std::to_string(t.smp) + "：" + capWhy);
+        } else {
+            t.rationale.push_back("vCPU " + std::to_string(t.smp) + "（按配置）");
+        }
+    } else {
+        t.smp = def;
+        t.rationale.push_back("vCPU " + std::to_string(t.smp) + "（" + tcg_profile_name(req.profile) + " 默认，宿主 " +
+                              std::to_string(hostCpus) + " 核" +
+                              (hetero ? "，其中性能核 " + std::to_string(bigCpus) : std::string()) + "）");
+    }
+
+    // ---- 来宾内存 ----
+    // 只按物理内存总量规划，不随当前可用内存波动（挂起/快速恢复要求同一 VM 的内存大小不变）
+    const ProfileLimits lim = LimitsFor(req.profile);
+    const int memCap = caps.total_mem_mb > 0
+                           ? std::max(512, static_cast<int>(caps.total_mem_mb * lim.mem_percent / 100))
+                           : 0;
+    t.memory_mb = req.memory_mb > 0 ? req.memory_mb : lim.default_mem_mb;
+    if (memCap > 0 && t.memory_mb > memCap) {
+        t.rationale.push_back("内存 " + std::to_string(t.memory_mb) + "MB -> " + std::to_string(memCap) + "MB：" +
+                              tcg_profile_name(req.profile) + " 最多使用物理内存的 " +
+                              std::to_string(lim.mem_percent) + "%（" + std::to_string(caps.total_mem_mb) + "MB）");
+        t.memory_mb = memCap;
+    } else {
+        t.rationale.push_back("内存 " + std::to_string(t.memory_mb) + "MB" +
+                              (req.memory_mb > 0 ? "（按配置）" : "（默认）"));
+    }
+    t.memory_mb = std::max(512, t.memory_mb);
+
+    // ---- 加速器 ----
+    const std::string accel = Lower(req.accel);
+    const bool wantKvm = accel == "kvm";
+    const bool delegated = accel.empty() || accel == "auto" || accel == "tcg" || accel == "tcg,thread=multi" ||
+                           accel == "tcg,thread=single";
+    if (wantKvm && caps.kvm) {
+        t.accel = "kvm";
+        t.rationale.push_back("KVM 可用：vCPU 直接运行在宿主核心上，不涉及翻译缓存");
+        return t;
+    }
+    if (wantKvm) {
+        t.rationale.push_back("请求 KVM 但 /dev/kvm 不可用，改用 TCG");
+    } else if (!delegated) {
+        t.accel = req.accel;
+        t.mttcg = accel.find("thread=multi") != std::string::npos;
+        t.rationale.push_back("保留自定义 -accel " + req.accel);
+        return t;
+    }
+
+    // 节能：单线程轮转执行全部 vCPU（最多占一个宿主核），来宾时钟按指令数推进，空闲时宿主线程休眠
+    // 无 JIT 的标准模式单 vCPU 同样用 icount：解释执行慢一个数量级，按实时时钟来宾会被定时器中断淹没
+    if (req.profile == TcgProfile::PowerSaver) {
+        t.icount = "shift=auto,sleep=on";
+        t.rationale.push_back("-icount shift=auto,sleep=on：单线程 TCG，最多占用一个宿主核心，空闲时休眠");
+    } else if (req.profile == TcgProfile::Balanced && !caps.jit && t.smp == 1) {
+        t.icount = "shift=auto,sleep=on";
+        t.rationale.push_back("-icount shift=auto：无 JIT 解释执行，按指令数推进来宾时钟，避免定时器中断风暴");
+    }
+    t.mttcg = t.icount.empty() && t.smp > 1;
+    if (t.mttcg) {
+        t.rationale.push_back("MTTCG：" + std::to_string(t.smp) + " 个 vCPU 各占一个宿主线程");
+    } else if (t.icount.empty()) {
+        t.rationale.push_back("单线程 TCG：只有 1 个 vCPU");
+    }
+
+    // 翻译缓存：Windows 来宾代码量大，缓存太小会频繁整体 flush 重新翻译；但缓存常驻内存，按宿主内存逐级放大
+    const int64_t totalMb = caps.total_mem_mb;
+    if (req.profile == TcgProfile::PowerSaver) {
+        t.tb_size_mb = 64;
+    } else if (req.profile == TcgProfile::Turbo) {
+        t.tb_size_mb = totalMb >= 12288 ? 1024 : (totalMb >= 6144 ? 512 : 256);
+    } else {
+        t.tb_size_mb = totalMb >= 8192 ? 256 : 128;
+    }
+    if (!caps.jit && t.tb_size_mb > 128) {
+        t.tb_size_mb = 128;
+        t.rationale.push_back("tb-size 128MB：无 JIT（ALLOW_WRITABLE_CODE_MEMORY 未授予），翻译结果由解释器执行，大缓存收益有限");
+    } else {
+        t.rationale.push_back("tb-size " + std::to_string(t.tb_size_mb) + "MB（宿主内存 " + std::to_string(totalMb) +
+                              "MB，" + (caps.jit ? "JIT 可用" : "无 JIT") + "）");
+    }
+    t.accel = std::string("tcg,thread=") + (t.mttcg ? "multi" : "single") + ",tb-size=" + std::to_string(t.tb_size_mb);
+
+    if (caps.avail_mem_mb > 0 && t.memory_mb + t.tb_size_mb > caps.avail_mem_mb) {
+        t.rationale.push_back("注意：当前可用内存 " + std::to_string(caps.avail_mem_mb) + "MB 低于规划的 " +
+                              std::to_string(t.memory_mb + t.tb_size_mb) + "MB（来宾内存 + 翻译缓存）");
+    }
+    return t;
+}
+
+TcgJitStats tcg_parse_jit_stats(const std::string& hmp_output)
+{
+    TcgJitStats s;
+    const bool a = FindCounter(hmp_output, "TB count", s.tb_count);
+    const bool b = FindCounter(hmp_output, "TB flush count", s.tb_flushes);
+    FindCounter(hmp_output, "TB invalidate count", s.tb_invalidates);
+    FindCounter(hmp_output, "gen code size", s.code_used, &s.code_total);
+    s.valid = a || b;
+    return s;
+}
+
+int64_t tcg_process_cpu_ms(int32_t pid)
+{
+    const std::string path = pid > 0 ? "/proc/" + std::to_string(pid) + "/stat" : "/proc/self/stat";
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line)) return -1;
+    // comm 可能含空格，从最后一个 ')' 之后按字段解析：state 为第 3 个字段，utime/stime 为第 14/15 个
+    const size_t rp = line.rfind(')');
+    if (rp == std::string::npos) return -1;
+    std::istringstream ss(line.substr(rp + 1));
+    std::string field;
+    int64_t utime = -1;
+    int64_t stime = -1;
+    for (int i = 3; i <= 15 && ss >> field; i++) {
+        if (i == 14) utime = strtoll(field.c_str(), nullptr, 10);
+        if (i == 15) stime = strtoll(field.c_str(), nullptr, 10);
+    }
+    const long hz = sysconf(_SC_CLK_TCK);
+    if (utime < 0 || stime < 0 || hz <= 0) return -1;
+    return (utime + stime) * 1000 / hz;
+}
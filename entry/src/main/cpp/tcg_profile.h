@@ -0,0 +1,71 @@
+#ifndef TCG_PROFILE_H
+#define TCG_PROFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 性能模式（ROADMAP：节能 / 标准 / Turbo）：按宿主核心拓扑、内存与 JIT 可用性
+// 决定 TCG 翻译缓存大小、MTTCG 开关、vCPU 数量、-icount 与来宾内存，并给出每一项的依据
+
+enum class TcgProfile {
+    PowerSaver,
+    Balanced,
+    Turbo,
+};
+
+// "powersaver" / "balanced" / "turbo"（大小写不敏感，也接受 "power-saver"、"standard"）；无法识别返回 false
+bool tcg_profile_from_string(const std::string& s, TcgProfile& out);
+const char* tcg_profile_name(TcgProfile p);
+
+// 宿主能力
+struct TcgHostCaps {
+    int cpus = 1;                   // 在线核心数
+    std::vector<int> big_cpus;      // 性能核（超大核 + 大核）
+    std::vector<int> little_cpus;   // 能效核（同构 CPU 时为空）
+    int64_t total_mem_mb = 0;
+    int64_t avail_mem_mb = 0;       // MemAvailable，仅用于提示，不参与规划（保证同一台设备上规划结果稳定）
+    bool jit = false;               // ALLOW_WRITABLE_CODE_MEMORY
+    bool kvm = false;
+};
+
+// 读取 /sys 与 /proc 探测核心拓扑与内存；jit/kvm 由调用方给出
+TcgHostCaps tcg_probe_host(bool jit, bool kvm);
+
+// 调用方的请求；cpus / memory_mb 为 0 表示未指定，由性能模式决定
+struct TcgRequest {
+    TcgProfile profile = TcgProfile::Balanced;
+    std::string accel;              // 用户给出的 -accel（空、"auto"、"tcg"、"tcg,thread=multi" 视为交给性能模式）
+    int cpus = 0;
+    int memory_mb = 0;
+};
+
+struct TcgTuning {
+    TcgProfile profile = TcgProfile::Balanced;
+    std::string accel;              // 最终的 -accel 参数
+    std::string icount;             // 非空时追加 -icount
+    int smp = 1;
+    int memory_mb = 0;
+    int tb_size_mb = 0;             // 0 表示未设置（KVM 或用户自定义 accel）
+    bool mttcg = false;
+    std::vector<std::string> rationale;
+};
+
+TcgTuning tcg_profile_plan(const TcgRequest& req, const TcgHostCaps& caps);
+
+// "info jit" 中与翻译缓存相关的计数
+struct TcgJitStats {
+    bool valid = false;
+    int64_t tb_count = 0;
+    int64_t tb_flushes = 0;
+    int64_t tb_invalidates = 0;
+    int64_t code_used = 0;          // gen code size 已用 / 总量（字节）
+    int64_t code_total = 0;
+};
+
+TcgJitStats tcg_parse_jit_stats(const std::string& hmp_output);
+
+// 进程累计 CPU 时间（utime + stime，毫秒）；pid 为 0 表示当前进程，失败返回 -1
+int64_t tcg_process_cpu_ms(int32_t pid);
+
+#endif // TCG_PROFILE_H
@@ -9,16 +9,159 @@ export interface VMConfig {
   display?: string;
   nographic?: boolean;
   efiFirmware?: string;  // UEFI 固件路径
+  fastResume?: boolean;  // 来宾 RAM 映射到文件：suspendVm 后下次 startVm 按需缺页恢复，无需重新引导
+  runtime?: 'auto' | 'inprocess' | 'worker';  // auto：第一个 VM 在进程内运行，并行的 VM 各用一个工作进程
+  profile?: 'powersaver' | 'balanced' | 'turbo';  // 性能模式，默认 balanced；未给 cpuCount/memoryMB 时由它决定
+  profiler?: boolean;    // TCG 热点分析插件（默认 false，有额外开销）；getHotspots 读取
 }
 
 export interface VMStatus {
   name: string;
-  status: 'creating' | 'preparing' | 'running' | 'stopping' | 'stopped' | 'failed';
+  status: 'creating' | 'preparing' | 'starting' | 'running' | 'paused' | 'stopping' | 'stopped' | 'failed';
   createdAt: string;
   diskPath: string;
   logPath: string;
 }
 
+// VM 状态变化（由 qemu_main_loop 返回和 QMP STOP/RESUME/SHUTDOWN 事件驱动）
+export interface VmStateEvent {
+  vmName: string;
+  state: string;           // stopped | preparing | starting | running | paused | stopping | failed
+  previous: string;
+  reason: string;          // 触发原因，如 "STOP"、"SHUTDOWN: guest-shutdown"、"exit code 1"
+  timestamp: number;       // Unix 毫秒
+}
+
+// 增量日志（getVmLogsSince 返回值 / setVmLogCallback 推送）
+export interface VmLogChunk {
+  vmName: string;
+  text: string;            // 各行以 '\n' 结尾拼接
+  firstSeq: number;
+  nextSeq: number;         // 下次 getVmLogsSince 传入的 seq
+  lines: number;
+  gap: boolean;            // 中间有行已被环形存储覆盖
+  more: boolean;           // 受 maxBytes 限制未取完
+}
+
+// 运行中 VM 的运行方式与宿主端口（getVmRuntime）；并行 VM 的端口从端口池分配
+export interface VmRuntimeInfo {
+  vmName: string;
+  mode: 'inprocess' | 'worker';
+  pid: number;             // 工作进程 pid（进程内为 0）
+  ports: { rdp: number; ssh: number; http: number; https: number; vnc: number };
+}
+
+// 性能模式规划（planVmProfile / getVmProfile）：rationale 为每一项选择的依据，同时写入 VM 日志 [PROFILE]
+export interface VmProfilePlan {
+  profile: 'powersaver' | 'balanced' | 'turbo';
+  accel: string;           // 最终的 -accel，如 "tcg,thread=multi,tb-size=256"
+  icount: string;          // 非空时追加 -icount
+  smp: number;
+  memoryMB: number;
+  tbSizeMB: number;        // 0：KVM 或自定义 accel
+  mttcg: boolean;
+  rationale: string[];
+  bootMs?: number;         // getVmProfile：startVm 到 running 的耗时，尚未 running 为 -1
+  host?: {                 // planVmProfile：探测到的宿主能力
+    cpus: number;
+    performanceCpus: number;
+    efficiencyCpus: number;
+    totalMemoryMB: number;
+    availableMemoryMB: number;
+    jit: boolean;
+    kvm: boolean;
+  };
+}
+
+// 运行中基准测试（benchmarkVmProfile）
+export interface VmProfileBenchmark extends VmProfilePlan {
+  elapsedMs: number;
+  hostCpuMs: number;
+  hostCpuPercent: number;  // 100 = 占满一个宿主核心
+  jitStats: boolean;       // 以下翻译缓存计数是否可用（KVM 下没有）
+  tbCount?: number;
+  tbFlushes?: number;      // 采样期间整体 flush 次数，偏多说明 tb-size 偏小
+  tbInvalidates?: number;
+  codeUsedBytes?: number;
+  codeTotalBytes?: number;
+}
+
+// 线程绑核与每线程 CPU 时间（getThreadStats）
+export interface VmThreadStat {
+  tid: number;
+  name: string;
+  role: string;            // vcpu / io / other
+  vm: string;
+  cpuMs: number;           // 累计 utime + stime
+  lastCpu: number;         // 最近一次运行所在的核心
+  affinity: number[];
+}
+
+export interface VmThreadStats {
+  pinning: boolean;
+  performanceCpus: number[];
+  efficiencyCpus: number[];  // 同构 CPU 时为空
+  threads: VmThreadStat[];
+}
+
+// TCG 热点（getHotspots）：按执行的来宾指令数降序
+export interface VmHotspot {
+  pc: string;              // 来宾虚拟地址（十六进制）
+  exec: number;            // TB 执行次数
+  insns: number;           // TB 内指令数
+  helperInsns: number;     // 其中经 helper 执行的指令数
+  mem: number;             // 访存次数
+  mmio: number;            // 其中 MMIO 访存（softmmu 慢路径）
+  share: number;           // 占全部已执行来宾指令的比例
+  disas: string;           // 第一条指令
+}
+
+export interface VmHotspotReport {
+  tbs: number;
+  execs: number;
+  insns: number;
+  helperInsns: number;
+  memAccesses: number;
+  mmioAccesses: number;
+  helperRate: number;      // helperInsns / insns
+  mmioRate: number;        // mmioAccesses / memAccesses
+  hotspots: VmHotspot[];
+}
+
+// OHAudio 后端的 xrun 计数（getAudioStats），自进程启动累计
+export interface VmAudioStats {
+  outUnderruns: number;    // 播放回调数据不足，补了静音
+  outOverruns: number;     // 播放环满，来宾音频推迟到下一拍
+  inOverruns: number;      // 录音环满，丢弃了采集缓冲
+  inUnderruns: number;     // 读取时录音环为空
+  outBytes: number;
+  inBytes: number;
+  outRingBytes: number;
+  inRingBytes: number;
+}
+
+// 快照进度 / 结果（snapshotSave / snapshotLoad / snapshotDelete 的 onProgress 与 Promise 结果）
+export interface SnapshotProgress {
+  tag: string;
+  op: 'save' | 'load' | 'delete' | 'suspend';
+  phase: string;           // disk | ram | job | pending | done | error
+  progress: number;        // 0..1
+  ramBytes: number;        // RAM 状态流字节数
+  storedBytes: number;     // 去重、压缩后新写入的字节数
+  done: boolean;
+  ok: boolean;
+  error?: string;
+}
+
+export interface SnapshotInfo {
+  tag: string;
+  mode: 'external' | 'internal';
+  created: number;         // Unix 毫秒
+  running: boolean;        // 拍摄时来宾是否在运行
+  ramBytes: number;
+  storedBytes: number;
+}
+
 export interface DeviceCapabilities {
   kvmSupported: boolean;
   jitSupported: boolean;
@@ -67,7 +210,23 @@ export interface QemuModule {
   startVm(config: VMConfig): boolean;
   stopVm(name: string): boolean;
   getVmLogs(name: string, startLine?: number): string[];
+  getVmLogsSince?(name: string, seq: number, maxBytes?: number): VmLogChunk;
+  setVmLogCallback?(name: string, callback: (chunk: VmLogChunk) => void, sinceSeq?: number): boolean;  // 每个 VM 一个回调
+  clearVmLogCallback?(name: string): boolean;
+  getVmRuntime?(name: string): VmRuntimeInfo | null;
+  planVmProfile?(profile: string, cpuCount?: number, memoryMB?: number, accel?: string): VmProfilePlan;
+  getVmProfile?(name: string): VmProfilePlan | null;
+  benchmarkVmProfile?(name: string, seconds?: number): Promise<VmProfileBenchmark>;
+  getThreadStats?(name: string): VmThreadStats;
+  setCpuPinning?(enabled: boolean): number;                  // 返回重新绑核的 vCPU 线程数
+  getHotspots?(name: string, top?: number, reset?: boolean): VmHotspotReport | null;  // 未以 profiler 启动返回 null
+  getAudioStats?(name: string): VmAudioStats | null;
+  setDeviceInfo?(deviceType: number, model: string): void;  // 0=unknown, 1=phone, 2=tablet, 3=2in1, 4=pc
+  setJitPermission?(granted: boolean): void;                 // ohos.permission.kernel.ALLOW_WRITABLE_CODE_MEMORY
   getVmStatus(name: string): string;
+  getVmState?(name: string): { state: string; since: number; reason: string };
+  setVmStateCallback?(callback: (ev: VmStateEvent) => void): boolean;  // 全局一个回调，重复调用替换
+  clearVmStateCallback?(): boolean;
   getDeviceCapabilities?(): DeviceCapabilities;
   getSupportedDevices?(): SupportedDevices;
   scanQemuDevices?(): ScanResult;           // 同步版本（返回缓存或提示）
@@ -80,6 +239,15 @@ export interface QemuModule {
   restoreSnapshot?(name: string, snapshotName: string): boolean;
   listSnapshots?(name: string): string[];
   deleteSnapshot?(name: string, snapshotName: string): boolean;
+  // 快照引擎：external（默认）= qcow2 overlay + 去重压缩的 RAM 块存储，恢复在下次 startVm 时生效（phase 'pending'）
+  snapshotSave?(name: string, tag: string, options?: { mode?: 'external' | 'internal'; onProgress?: (p: SnapshotProgress) => void }): Promise<SnapshotProgress>;
+  snapshotLoad?(name: string, tag: string, options?: { onProgress?: (p: SnapshotProgress) => void }): Promise<SnapshotProgress>;
+  snapshotDelete?(name: string, tag: string): Promise<SnapshotProgress>;
+  snapshotList?(name: string): SnapshotInfo[];
+  // 挂起到文件（需 fastResume 启动）：保存设备状态并退出 QEMU；硬件配置不变时下次 startVm 自动恢复
+  suspendVm?(name: string): Promise<SnapshotProgress>;
+  hasResumeState?(name: string): boolean;
+  discardResumeState?(name: string): boolean;
   checkCoreLib?(): {
     loaded: boolean;
     foundLd: boolean;
@@ -102,9 +270,25 @@ export interface QemuModule {
     password: string;
     width?: number;
     height?: number;
+    trustedFingerprint?: string; // 用户确认过的服务器证书指纹，非回环主机必须匹配才会接受
   }): number;
   disconnectRdp?(clientId: string): number;
   getRdpStatus?(clientId: string): number;
+  // 连接因证书不受信任失败后返回被拒绝的证书，没有则 undefined
+  getRdpCertificate?(clientId: string): {
+    host: string;
+    port: number;
+    commonName: string;
+    subject: string;
+    issuer: string;
+    fingerprint: string;
+    changed: boolean;
+  } | undefined;
+  // key 为 X11 keysym；button: 0=移动 1=左 2=中 3=右 4/5=滚轮
+  rdpSendKey?(clientId: string, key: number, down: boolean): number;
+  rdpSendMouse?(clientId: string, x: number, y: number, button: number, down: boolean): number;
+  rdpSetSurface?(clientId: string, surfaceId: string, width: number, height: number): boolean; // 绑定 XComponent surface
+  rdpClearSurface?(clientId: string): boolean;
   destroyRdpClient?(clientId: string): number;
   // RDP 超时处理
   rdpCheckTimeout?(): number;           // 返回超时秒数，0表示未超时
@@ -114,13 +298,29 @@ export interface QemuModule {
   rdpGetStatusString?(): string;        // 获取状态: disconnected/connecting/connected/timeout/cancelling
   vncAvailable?(): boolean;
   vncCreate?(): number;
-  vncConnect?(id: number, host: string, port: number): boolean;
+  vncConnect?(id: number, host: string, port: number, options?: { profile?: 'auto' | 'loopback' | 'remote'; encodings?: string; quality?: number; compress?: number }): boolean;
   vncDisconnect?(id: number): void;
   vncGetFrame?(id: number): {
     width: number;
     height: number;
     pixels: ArrayBuffer;
+    seq?: number;
+    dirtyRects?: number[];
+  } | null;
+  vncGetStats?(id: number): {
+    encodings: string;
+    bytesReceived: number;
+    messages: number;
+    perEncoding: Array<{ name: string; rects: number; pixels: number; bytes: number; decodeUs: number }>;
   } | null;
+  // 进程内显示桥（QEMU 需以 display: 'xcomponent' 启动）：帧直接进入该 VNC session 的 surface/vncGetFrame
+  // vmName 为工作进程 VM 时接它的共享 surface
+  displayAttach?(id: number, vmName?: string): boolean;
+  displayDetach?(vmName?: string): void;
+  // QMP 长连接：命令在同一连接上流水线执行；事件（STOP/RESUME/SHUTDOWN/BLOCK_JOB_* 等）主动推送
+  qmpExecute?(vmName: string, command: string, argsJson?: string): Promise<{ ok: boolean; return?: string; errorClass?: string; errorDesc?: string }>;
+  qmpSubscribeEvents?(vmName: string, callback: (ev: { vmName: string; event: string; data: string; seconds: number; microseconds: number }) => void, events?: string[]): boolean;
+  qmpUnsubscribeEvents?(vmName: string): boolean;
 }
 
 // 声明 native 模块
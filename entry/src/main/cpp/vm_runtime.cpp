@@ -0,0 +1,127 @@
+#include "vm_runtime.h"
+#include <arpa/inet.h>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// 端口块 0 为旧的固定端口；块 k (k >= 1) 为 kPoolBase + k*kBlockStride 起的连续端口，VNC 为 5901+k
+constexpr int kPoolBase = 40000;
+constexpr int kBlockStride = 10;
+constexpr int kMaxBlocks = 32;
+constexpr int kVncBase = 5901;
+
+std::mutex g_runtime_mutex;
+std::map<std::string, VmRuntime> g_runtimes;
+std::map<std::string, int> g_blocks;   // vm -> 端口块
+std::string g_inprocess_vm;
+
+VmPorts PortsForBlock(int block)
+{
+    VmPorts p;                    // 默认值即块 0
+    if (block == 0) return p;
+    const int base = kPoolBase + block * kBlockStride;
+    p.rdp = base;
+    p.ssh = base + 1;
+    p.http = base + 2;
+    p.https = base + 3;
+    p.vnc = kVncBase + block;
+    return p;
+}
+
+// 试绑定判断端口是否空闲（hostfwd 绑 127.0.0.1，VNC 绑 0.0.0.0）
+bool PortFree(int port, bool any)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(any ? INADDR_ANY : INADDR_LOOPBACK);
+    const bool ok = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    close(fd);
+    return ok;
+}
+
+bool BlockFree(int block)
+{
+    const VmPorts p = PortsForBlock(block);
+    return PortFree(p.rdp, false) && PortFree(p.ssh, false) && PortFree(p.http, false) &&
+           PortFree(p.https, false) && PortFree(p.vnc, true);
+}
+
+} // namespace
+
+VmRuntimeAcquire vm_runtime_acquire(const std::string& vm, VmRuntimeMode mode, const std::string& log_path,
+                                    VmRuntime& out)
+{
+    std::lock_guard<std::mutex> lk(g_runtime_mutex);
+    if (mode == VmRuntimeMode::InProcess && !g_inprocess_vm.empty() && g_inprocess_vm != vm) {
+        return VmRuntimeAcquire::InProcessBusy;
+    }
+
+    auto held = g_blocks.find(vm);
+    int block = held != g_blocks.end() ? held->second : -1;
+    if (block < 0) {
+        for (int b = 0; b < kMaxBlocks && block < 0; b++) {
+            bool taken = false;
+            for (const auto& kv : g_blocks) taken = taken || kv.second == b;
+            if (!taken && BlockFree(b)) block = b;
+        }
+        if (block < 0) return VmRuntimeAcquire::NoFreePorts;
+        g_blocks[vm] = block;
+    }
+
+    VmRuntime& rt = g_runtimes[vm];
+    rt.vm_name = vm;
+    rt.mode = mode;
+    rt.pid = 0;
+    rt.ports = PortsForBlock(block);
+    rt.log_path = log_path;
+    if (mode == VmRuntimeMode::InProcess) g_inprocess_vm = vm;
+    out = rt;
+    return VmRuntimeAcquire::Ok;
+}
+
+void vm_runtime_release(const std::string& vm)
+{
+    std::lock_guard<std::mutex> lk(g_runtime_mutex);
+    g_runtimes.erase(vm);
+    g_blocks.erase(vm);
+    if (g_inprocess_vm == vm) g_inprocess_vm.clear();
+}
+
+void vm_runtime_set_pid(const std::string& vm, int32_t pid)
+{
+    std::lock_guard<std::mutex> lk(g_runtime_mutex);
+    auto it = g_runtimes.find(vm);
+    if (it != g_runtimes.end()) it->second.pid = pid;
+}
+
+bool vm_runtime_get(const std::string& vm, VmRuntime& out)
+{
+    std::lock_guard<std::mutex> lk(g_runtime_mutex);
+    auto it = g_runtimes.find(vm);
+    if (it == g_runtimes.end()) return false;
+    out = it->second;
+    return true;
+}
+
+std::vector<VmRuntime> vm_runtime_list()
+{
+    std::lock_guard<std::mutex> lk(g_runtime_mutex);
+    std::vector<VmRuntime> list;
+    for (const auto& kv : g_runtimes) list.push_back(kv.second);
+    return list;
+}
+
+std::string vm_runtime_inprocess_vm()
+{
+    std::lock_guard<std::mutex> lk(g_runtime_mutex);
+    return g_inprocess_vm;
+}
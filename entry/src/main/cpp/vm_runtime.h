@@ -0,0 +1,56 @@
+#ifndef VM_RUNTIME_H
+#define VM_RUNTIME_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 每个运行中 VM 的运行时上下文：端口、运行方式（进程内 / 工作进程）、工作进程 pid
+// 进程内 QEMU 全局状态只能有一份，同一时刻只允许一个 VM 占用；其余 VM 以工作进程方式运行
+
+enum class VmRuntimeMode {
+    InProcess,
+    Worker,
+};
+
+// 宿主侧转发端口（hostfwd 到来宾的 3389/22/80/443）与 VNC 端口
+// 第一个 VM 沿用旧的固定端口 3390/2222/8080/8443/5901，之后的 VM 从端口池按块分配
+struct VmPorts {
+    int rdp = 3390;
+    int ssh = 2222;
+    int http = 8080;
+    int https = 8443;
+    int vnc = 5901;
+};
+
+struct VmRuntime {
+    std::string vm_name;
+    VmRuntimeMode mode = VmRuntimeMode::InProcess;
+    int32_t pid = 0;              // 工作进程 pid（进程内为 0）
+    VmPorts ports;
+    std::string log_path;
+};
+
+enum class VmRuntimeAcquire {
+    Ok,
+    InProcessBusy,   // mode 为 InProcess，但进程内 QEMU 已被别的 VM 占用（应改用工作进程方式）
+    NoFreePorts,     // 端口池里没有空闲的端口块
+};
+
+// 登记 VM 并分配一组空闲端口
+VmRuntimeAcquire vm_runtime_acquire(const std::string& vm, VmRuntimeMode mode, const std::string& log_path,
+                                    VmRuntime& out);
+
+// VM 退出后释放端口与进程内占用
+void vm_runtime_release(const std::string& vm);
+
+void vm_runtime_set_pid(const std::string& vm, int32_t pid);
+
+bool vm_runtime_get(const std::string& vm, VmRuntime& out);
+
+std::vector<VmRuntime> vm_runtime_list();
+
+// 当前占用进程内 QEMU 的 VM（没有则为空）
+std::string vm_runtime_inprocess_vm();
+
+#endif // VM_RUNTIME_H
@@ -0,0 +1,286 @@
+#include "vm_sched.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct ThreadEntry {
+    SchedRole role = SchedRole::Other;
+    std::string name;
+    std::string vm;
+};
+
+std::atomic<bool> g_sched_enabled { true };
+std::mutex g_sched_mutex;
+std::map<int32_t, ThreadEntry> g_threads;   // 本进程中登记的线程（tid -> 角色）
+
+int32_t CurrentTid()
+{
+    return static_cast<int32_t>(syscall(SYS_gettid));
+}
+
+int64_t ReadInt(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "re");
+    if (!f) return -1;
+    long long v = -1;
+    if (fscanf(f, "%lld", &v) != 1) v = -1;
+    fclose(f);
+    return v;
+}
+
+std::string ReadLine(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+SchedTopology ProbeTopology()
+{
+    SchedTopology t;
+    const long configured = std::max(sysconf(_SC_NPROCESSORS_CONF), sysconf(_SC_NPROCESSORS_ONLN));
+    std::map<int64_t, std::vector<int>, std::greater<int64_t>> byCapacity;
+    for (int cpu = 0; cpu < configured; cpu++) {
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        // cpu0 通常没有 online 文件，视为在线
+        if (ReadInt(base + "/online") == 0) continue;
+        if (access(base.c_str(), F_OK) != 0) continue;
+        int64_t cap = ReadInt(base + "/cpu_capacity");
+        if (cap <= 0) cap = ReadInt(base + "/cpufreq/cpuinfo_max_freq");
+        byCapacity[std::max<int64_t>(cap, 0)].push_back(cpu);
+    }
+    for (auto& kv : byCapacity) t.clusters.push_back(kv.second);
+    if (t.clusters.empty()) {
+        // /sys 不可读：按在线核心数视为同构
+        std::vector<int> all;
+        for (long i = 0; i < std::max(1L, sysconf(_SC_NPROCESSORS_ONLN)); i++) all.push_back(static_cast<int>(i));
+        t.clusters.push_back(all);
+    }
+    t.cpus = 0;
+    for (const auto& c : t.clusters) t.cpus += static_cast<int>(c.size());
+    if (t.clusters.size() > 1) {
+        for (size_t i = 0; i + 1 < t.clusters.size(); i++) {
+            t.performance.insert(t.performance.end(), t.clusters[i].begin(), t.clusters[i].end());
+        }
+        t.efficiency = t.clusters.back();
+    } else {
+        t.performance = t.clusters.front();
+    }
+    std::sort(t.performance.begin(), t.performance.end());
+    std::sort(t.efficiency.begin(), t.efficiency.end());
+    return t;
+}
+
+std::vector<int> AllCpus()
+{
+    const SchedTopology& t = sched_topology();
+    std::vector<int> all;
+    for (const auto& c : t.clusters) all.insert(all.end(), c.begin(), c.end());
+    std::sort(all.begin(), all.end());
+    return all;
+}
+
+// 角色对应的核心集合；空表示不限制
+std::vector<int> CpusFor(SchedRole role, bool efficientVcpus)
+{
+    const SchedTopology& t = sched_topology();
+    if (!g_sched_enabled.load() || t.cpus <= 1 || role == SchedRole::Other) return {};
+    const bool hetero = !t.efficiency.empty();
+    std::vector<int> all = AllCpus();
+    const int reserved = all.back();
+    if (role == SchedRole::Vcpu && !efficientVcpus) {
+        if (hetero) return t.performance;
+        all.pop_back();
+        return all;
+    }
+    return hetero ? t.efficiency : std::vector<int> { reserved };
+}
+
+bool ApplyAffinity(int32_t tid, const std::vector<int>& cpus)
+{
+    const std::vector<int> target = cpus.empty() ? AllCpus() : cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : target) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(tid, sizeof(set), &set) == 0;
+}
+
+SchedRole RoleFromThreadName(const std::string& name)
+{
+    if (name.rfind("CPU ", 0) == 0 || name.rfind("ALL CPUs", 0) == 0) return SchedRole::Vcpu;
+    if (name == "qemu-main" || name == "call_rcu" || name.rfind("worker", 0) == 0 || name.rfind("IO ", 0) == 0 ||
+        name == "vnc_worker") {
+        return SchedRole::Io;
+    }
+    return SchedRole::Other;
+}
+
+const char* RoleName(SchedRole role)
+{
+    switch (role) {
+    case SchedRole::Vcpu: return "vcpu";
+    case SchedRole::Io:   return "io";
+    default:              return "other";
+    }
+}
+
+std::string TaskDir(int32_t pid)
+{
+    return pid > 0 ? "/proc/" + std::to_string(pid) + "/task" : "/proc/self/task";
+}
+
+std::vector<int32_t> ListTasks(int32_t pid)
+{
+    std::vector<int32_t> tids;
+    DIR* d = opendir(TaskDir(pid).c_str());
+    if (!d) return tids;
+    while (dirent* e = readdir(d)) {
+        if (e->d_name[0] < '0' || e->d_name[0] > '9') continue;
+        tids.push_back(static_cast<int32_t>(strtol(e->d_name, nullptr, 10)));
+    }
+    closedir(d);
+    return tids;
+}
+
+std::string ThreadName(int32_t pid, int32_t tid)
+{
+    return ReadLine(TaskDir(pid) + "/" + std::to_string(tid) + "/comm");
+}
+
+// /proc/.../stat：utime/stime 为第 14/15 个字段，processor 为第 39 个
+bool ReadThreadStat(int32_t pid, int32_t tid, SchedThreadStat& out)
+{
+    const std::string line = ReadLine(TaskDir(pid) + "/" + std::to_string(tid) + "/stat");
+    const size_t rp = line.rfind(')');
+    if (rp == std::string::npos) return false;
+    std::istringstream ss(line.substr(rp + 1));
+    std::string field;
+    int64_t utime = 0;
+    int64_t stime = 0;
+    for (int i = 3; i <= 39 && ss >> field; i++) {
+        if (i == 14) utime = strtoll(field.c_str(), nullptr, 10);
+        if (i == 15) stime = strtoll(field.c_str(), nullptr, 10);
+        if (i == 39) out.last_cpu = static_cast<int>(strtol(field.c_str(), nullptr, 10));
+    }
+    const long hz = sysconf(_SC_CLK_TCK);
+    out.cpu_ms = hz > 0 ? (utime + stime) * 1000 / hz : 0;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(tid, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) out.affinity.push_back(cpu);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const SchedTopology& sched_topology()
+{
+    static const SchedTopology topology = ProbeTopology();
+    return topology;
+}
+
+void sched_set_enabled(bool enabled)
+{
+    g_sched_enabled.store(enabled);
+    std::lock_guard<std::mutex> lk(g_sched_mutex);
+    for (auto it = g_threads.begin(); it != g_threads.end();) {
+        // 线程已退出则顺带清理登记
+        if (!ApplyAffinity(it->first, CpusFor(it->second.role, false))) {
+            it = g_threads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool sched_enabled()
+{
+    return g_sched_enabled.load();
+}
+
+void sched_pin_self(SchedRole role, const std::string& name, const std::string& vm)
+{
+    const int32_t tid = CurrentTid();
+    ApplyAffinity(tid, CpusFor(role, false));
+    std::lock_guard<std::mutex> lk(g_sched_mutex);
+    g_threads[tid] = ThreadEntry { role, name, vm };
+}
+
+void sched_unregister_self()
+{
+    const int32_t tid = CurrentTid();
+    std::lock_guard<std::mutex> lk(g_sched_mutex);
+    g_threads.erase(tid);
+}
+
+int sched_apply_qemu_threads(int32_t pid, bool efficient_vcpus)
+{
+    int vcpus = 0;
+    for (int32_t tid : ListTasks(pid)) {
+        const SchedRole role = RoleFromThreadName(ThreadName(pid, tid));
+        if (role == SchedRole::Other) continue;
+        ApplyAffinity(tid, CpusFor(role, efficient_vcpus));
+        if (role == SchedRole::Vcpu) vcpus++;
+    }
+    return vcpus;
+}
+
+std::vector<SchedThreadStat> sched_thread_stats(int32_t pid, const std::string& vm)
+{
+    std::map<int32_t, ThreadEntry> registered;
+    {
+        std::lock_guard<std::mutex> lk(g_sched_mutex);
+        registered = g_threads;
+    }
+
+    std::vector<SchedThreadStat> out;
+    for (int32_t tid : ListTasks(pid)) {
+        SchedThreadStat st;
+        st.tid = tid;
+        st.name = ThreadName(pid, tid);
+        SchedRole role = RoleFromThreadName(st.name);
+        auto it = pid > 0 ? registered.end() : registered.find(tid);
+        if (it != registered.end()) {
+            if (!vm.empty() && !it->second.vm.empty() && it->second.vm != vm) continue;
+            role = it->second.role;
+            st.name = it->second.name;
+            st.vm = it->second.vm;
+        } else if (pid <= 0 && role == SchedRole::Other) {
+            continue;   // 本进程中与 VM 无关的线程（ArkTS 等）不列出
+        }
+        st.role = RoleName(role);
+        if (pid > 0) st.vm = vm;
+        if (ReadThreadStat(pid, tid, st)) out.push_back(std::move(st));
+    }
+    if (pid > 0) {
+        // 工作进程 VM：本进程中为它服务的线程（读取线程、渲染线程）
+        for (const auto& kv : registered) {
+            if (kv.second.vm != vm) continue;
+            SchedThreadStat st;
+            st.tid = kv.first;
+            st.name = kv.second.name;
+            st.role = RoleName(kv.second.role);
+            st.vm = kv.second.vm;
+            if (ReadThreadStat(0, kv.first, st)) out.push_back(std::move(st));
+        }
+    }
+    return out;
+}
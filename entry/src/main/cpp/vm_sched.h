@@ -0,0 +1,55 @@
+#ifndef VM_SCHED_H
+#define VM_SCHED_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 线程绑核：手机/平板是大小核异构 CPU，MTTCG 的 vCPU 线程若随内核调度漂移，会和渲染、
+// 显示、音频回调线程抢同一批核心。这里把 vCPU 线程绑到性能核，把 QEMU 主循环（I/O）、
+// VNC 渲染、工作进程读取线程和 OHAudio 回调线程绑到其余核心。
+// 同构 CPU 时保留最后一个核心给 I/O 线程；单核设备不做任何绑定。
+
+enum class SchedRole {
+    Vcpu,
+    Io,
+    Other,
+};
+
+// 按算力（cpu_capacity，缺失时用 cpuinfo_max_freq）分簇，启动时探测一次
+struct SchedTopology {
+    int cpus = 1;                                // 在线核心数
+    std::vector<std::vector<int>> clusters;      // 按算力从高到低
+    std::vector<int> performance;                // 除最低一簇以外的核心（同构时为全部）
+    std::vector<int> efficiency;                 // 最低一簇（同构时为空）
+};
+
+const SchedTopology& sched_topology();
+
+// 关闭后新登记的线程不再绑核，已登记的本进程线程恢复为全部核心
+void sched_set_enabled(bool enabled);
+bool sched_enabled();
+
+// 当前线程按角色绑核并登记到统计（vm 为空表示不属于特定 VM）
+void sched_pin_self(SchedRole role, const std::string& name, const std::string& vm = "");
+void sched_unregister_self();
+
+// 按线程名给 QEMU 进程（pid 为 0 表示本进程）中的线程绑核："CPU n/TCG"、"ALL CPUs/TCG" 为 vCPU，
+// qemu-main / worker / call_rcu / IO 线程为 I/O；需要 -name debug-threads=on。
+// efficient_vcpus 为 true（节能模式）时 vCPU 也放到能效核。返回处理的 vCPU 线程数
+int sched_apply_qemu_threads(int32_t pid, bool efficient_vcpus);
+
+struct SchedThreadStat {
+    int32_t tid = 0;
+    std::string name;
+    std::string role;             // vcpu / io / other
+    std::string vm;
+    int64_t cpu_ms = 0;           // utime + stime
+    int last_cpu = -1;            // 最近一次运行所在的核心
+    std::vector<int> affinity;
+};
+
+// pid 为 0：本进程中已登记的线程与 QEMU 线程；否则为该进程的全部线程，外加本进程中登记给 vm 的线程
+std::vector<SchedThreadStat> sched_thread_stats(int32_t pid, const std::string& vm);
+
+#endif // VM_SCHED_H
@@ -0,0 +1,363 @@
+#include "vm_worker.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "log_pipeline.h"
+#include "vm_sched.h"
+#include "third_party/cjson/cJSON.h"
+
+#if defined(__has_include)
+#if __has_include(<AbilityKit/native_child_process.h>)
+#include <AbilityKit/native_child_process.h>
+#define VM_WORKER_HAVE_CHILD_PROCESS 1
+#endif
+#endif
+
+using namespace worker_proto;
+
+std::unique_ptr<VmWorker> VmWorker::Spawn(const VmWorkerLaunch& launch, Callbacks callbacks, std::string& err)
+{
+#ifndef VM_WORKER_HAVE_CHILD_PROCESS
+    (void)launch;
+    (void)callbacks;
+    err = "native child process API not available in this SDK";
+    return nullptr;
+#else
+    int ctl[2] = { -1, -1 };
+    int out[2] = { -1, -1 };
+    int errPipe[2] = { -1, -1 };
+    auto closeAll = [&]() {
+        for (int fd : { ctl[0], ctl[1], out[0], out[1], errPipe[0], errPipe[1] }) {
+            if (fd >= 0) close(fd);
+        }
+    };
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, ctl) != 0 ||
+        pipe2(out, O_CLOEXEC) != 0 || pipe2(errPipe, O_CLOEXEC) != 0) {
+        err = std::string("socketpair/pipe failed: ") + strerror(errno);
+        closeAll();
+        return nullptr;
+    }
+
+    // 启动参数：{"v":1,"vm":...,"lib":...,"console":...,"argv":[...]}
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "v", kVersion);
+    cJSON_AddStringToObject(root, "vm", launch.vm_name.c_str());
+    cJSON_AddStringToObject(root, "lib", launch.core_lib.c_str());
+    cJSON_AddStringToObject(root, "console", launch.console_chardev.c_str());
+    cJSON* argv = cJSON_AddArrayToObject(root, "argv");
+    for (const auto& a : launch.argv) cJSON_AddItemToArray(argv, cJSON_CreateString(a.c_str()));
+    char* params = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    NativeChildProcess_Fd fds[3] = {};
+    fds[0].fdName = const_cast<char*>(kFdCtl);
+    fds[0].fd = ctl[1];
+    fds[0].next = &fds[1];
+    fds[1].fdName = const_cast<char*>(kFdStdout);
+    fds[1].fd = out[1];
+    fds[1].next = &fds[2];
+    fds[2].fdName = const_cast<char*>(kFdStderr);
+    fds[2].fd = errPipe[1];
+    fds[2].next = nullptr;
+    NativeChildProcess_Args args {};
+    args.entryParams = params;
+    args.fdList.head = &fds[0];
+    NativeChildProcess_Options options {};
+    options.isolationMode = NCP_ISOLATION_MODE_NORMAL;
+
+    int32_t pid = 0;
+    const int rc = static_cast<int>(OH_Ability_StartNativeChildProcess(kEntry, args, options, &pid));
+    cJSON_free(params);
+    // 子进程已拿到自己的副本；写端只留在子进程里，它退出时管道 EOF
+    close(ctl[1]);
+    close(out[1]);
+    close(errPipe[1]);
+    ctl[1] = out[1] = errPipe[1] = -1;
+    if (rc != NCP_NO_ERROR) {
+        err = "OH_Ability_StartNativeChildProcess failed, rc=" + std::to_string(rc);
+        closeAll();
+        return nullptr;
+    }
+
+    std::unique_ptr<VmWorker> w(new VmWorker());
+    w->vm_name_ = launch.vm_name;
+    w->cb_ = std::move(callbacks);
+    w->pid_ = pid;
+    w->ctl_ = ctl[0];
+    w->out_ = out[0];
+    w->err_ = errPipe[0];
+    if (!launch.vm_dir.empty()) {
+        w->out_sink_ = log_sink(launch.vm_dir + "/qemu_stdout.log");
+        w->err_sink_ = log_sink(launch.vm_dir + "/qemu_stderr.log");
+    }
+    w->reader_ = std::thread(&VmWorker::Run, w.get());
+    return w;
+#endif
+}
+
+VmWorker::~VmWorker()
+{
+    // 工作进程在控制通道断开时自行关机；正常路径下此时它已退出
+    if (ctl_ >= 0) shutdown(ctl_, SHUT_RDWR);
+    if (reader_.joinable()) reader_.join();
+    for (int fd : { ctl_, out_, err_ }) {
+        if (fd >= 0) close(fd);
+    }
+    if (map_) munmap(map_, map_size_);
+}
+
+int VmWorker::Wait()
+{
+    std::unique_lock<std::mutex> lk(exit_mutex_);
+    exit_cv_.wait(lk, [this]() { return exited_; });
+    return exit_code_;
+}
+
+bool VmWorker::Send(uint32_t type, const void* payload, size_t len)
+{
+    std::lock_guard<std::mutex> lk(send_mutex_);
+    return SendMsg(ctl_, type, payload, len);
+}
+
+bool VmWorker::RequestShutdown()
+{
+    return Send(kMsgShutdown, nullptr, 0);
+}
+
+bool VmWorker::RequestFullFrame()
+{
+    return Send(kMsgFullFrame, nullptr, 0);
+}
+
+bool VmWorker::WriteConsole(const char* data, size_t len)
+{
+    while (len > 0) {
+        const size_t n = std::min(len, kMaxConsolePayload);
+        if (!Send(kMsgConsoleIn, data, n)) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool VmWorker::Request(uint32_t type, void* payload, size_t len, uint32_t reply_type, int timeout_ms,
+                       std::vector<char>& reply)
+{
+    std::lock_guard<std::mutex> req(request_mutex_);
+    uint32_t seq;
+    {
+        std::lock_guard<std::mutex> lk(reply_mutex_);
+        seq = ++reply_seq_;
+        reply_type_ = reply_type;
+        reply_ready_ = false;
+    }
+    memcpy(payload, &seq, sizeof(seq));
+    if (!Send(type, payload, len)) return false;
+
+    std::unique_lock<std::mutex> lk(reply_mutex_);
+    if (!reply_cv_.wait_for(lk, std::chrono::milliseconds(timeout_ms), [this]() { return reply_ready_; })) {
+        return false;
+    }
+    reply = std::move(reply_);
+    reply_.clear();
+    return true;
+}
+
+void VmWorker::CompleteRequest(uint32_t type, const char* payload, size_t len)
+{
+    uint32_t seq;
+    if (len < sizeof(seq)) return;
+    memcpy(&seq, payload, sizeof(seq));
+    std::lock_guard<std::mutex> lk(reply_mutex_);
+    if (type != reply_type_ || seq != reply_seq_ || reply_ready_) return;   // 已超时放弃的请求
+    reply_.assign(payload, payload + len);
+    reply_ready_ = true;
+    reply_cv_.notify_all();
+}
+
+bool VmWorker::QueryHotspots(uint32_t top, bool reset, int timeout_ms, AetherHotspotTotals& totals,
+                             std::vector<AetherHotspot>& out)
+{
+    HotspotQuery query { 0, std::min<uint32_t>(top, AETHER_HOTSPOT_MAX_TOP), reset ? 1u : 0u };
+    std::vector<char> reply;
+    if (!Request(kMsgHotspotQuery, &query, sizeof(query), kMsgHotspots, timeout_ms, reply)) return false;
+    if (reply.size() < sizeof(HotspotReply)) return false;
+    HotspotReply r;
+    memcpy(&r, reply.data(), sizeof(r));
+    if (!r.loaded) return false;
+    const size_t count = std::min<size_t>(r.count, (reply.size() - sizeof(r)) / sizeof(AetherHotspot));
+    totals = r.totals;
+    out.resize(count);
+    if (count > 0) memcpy(out.data(), reply.data() + sizeof(r), count * sizeof(AetherHotspot));
+    return true;
+}
+
+bool VmWorker::QueryAudioStats(int timeout_ms, AudioStats& out)
+{
+    AudioStatsQuery query {};
+    std::vector<char> reply;
+    if (!Request(kMsgAudioStatsQuery, &query, sizeof(query), kMsgAudioStats, timeout_ms, reply)) return false;
+    if (reply.size() < sizeof(AudioStatsReply)) return false;
+    AudioStatsReply r;
+    memcpy(&r, reply.data(), sizeof(r));
+    if (!r.available) return false;
+    out = r.stats;
+    return true;
+}
+
+void VmWorker::Kill()
+{
+    if (pid_ > 0) kill(pid_, SIGKILL);
+}
+
+void VmWorker::WithSurface(const std::function<void(const uint8_t* pixels, int width, int height, int stride,
+                                                    uint32_t format)>& fn)
+{
+    std::lock_guard<std::mutex> lk(surface_mutex_);
+    fn(map_, width_, height_, width_ * 4, format_);
+}
+
+bool VmWorker::PumpLog(int fd, int sink, const std::string& hilogPrefix)
+{
+    char buffer[4096];
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n < 0) return errno == EINTR || errno == EAGAIN;
+    if (n == 0) return false;
+    if (sink > 0) log_submit(sink, kLogRaw, "", std::string_view(buffer, static_cast<size_t>(n)));
+    size_t len = static_cast<size_t>(n);
+    if (buffer[len - 1] == '\n') len--;
+    log_submit(0, kLogHilog, hilogPrefix, std::string_view(buffer, len));
+    return true;
+}
+
+// 返回 true 表示收到了退出消息
+bool VmWorker::HandleMessage(const char* buf, size_t len, int fd)
+{
+    const auto* hdr = reinterpret_cast<const MsgHeader*>(buf);
+    const char* payload = buf + sizeof(MsgHeader);
+    const size_t plen = len - sizeof(MsgHeader);
+    bool exited = false;
+
+    switch (hdr->type) {
+    case kMsgRunning:
+        if (cb_.on_running) cb_.on_running();
+        break;
+    case kMsgExit:
+        if (plen >= sizeof(ExitMsg)) {
+            ExitMsg m;
+            memcpy(&m, payload, sizeof(m));
+            std::lock_guard<std::mutex> lk(exit_mutex_);
+            exit_code_ = m.code;
+        }
+        exited = true;
+        break;
+    case kMsgSwitch: {
+        if (plen < sizeof(SwitchMsg)) break;
+        SwitchMsg m;
+        memcpy(&m, payload, sizeof(m));
+        uint8_t* map = nullptr;
+        size_t size = 0;
+        if (m.width > 0 && m.height > 0 && fd >= 0) {
+            size = static_cast<size_t>(m.width) * static_cast<size_t>(m.height) * 4;
+            void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            map = p == MAP_FAILED ? nullptr : static_cast<uint8_t*>(p);
+        }
+        uint8_t* old = nullptr;
+        size_t oldSize = 0;
+        {
+            std::lock_guard<std::mutex> lk(surface_mutex_);
+            old = map_;
+            oldSize = map_size_;
+            map_ = map;
+            map_size_ = map ? size : 0;
+            width_ = map ? m.width : 0;
+            height_ = map ? m.height : 0;
+            format_ = m.format;
+        }
+        if (cb_.on_surface) cb_.on_surface(map, map ? m.width : 0, map ? m.height : 0, map ? m.width * 4 : 0, m.format);
+        // 回调已切到新映射，旧映射不再被引用
+        if (old) munmap(old, oldSize);
+        break;
+    }
+    case kMsgFrame: {
+        FrameMsg m {};
+        memcpy(&m, payload, std::min(plen, sizeof(m)));
+        const uint32_t count = std::min<uint32_t>(m.count, kMaxFrameRects);
+        if (cb_.on_frame && count > 0) cb_.on_frame(m.rects, count);
+        Send(kMsgFrameAck, nullptr, 0);
+        break;
+    }
+    case kMsgConsole:
+        if (cb_.on_console && plen > 0) cb_.on_console(payload, plen);
+        break;
+    case kMsgHotspots:
+    case kMsgAudioStats:
+        CompleteRequest(hdr->type, payload, plen);
+        break;
+    default:
+        break;
+    }
+    if (fd >= 0) close(fd);
+    return exited;
+}
+
+void VmWorker::Run()
+{
+    std::vector<char> buf(kMaxMsgBytes);
+    const std::string outPrefix = "QEMU: [" + vm_name_ + "/STDOUT] ";
+    const std::string errPrefix = "QEMU: [" + vm_name_ + "/STDERR] ";
+    bool outOpen = true;
+    bool errOpen = true;
+    bool gotExit = false;
+    sched_pin_self(SchedRole::Io, "vm-reader", vm_name_);
+
+    while (true) {
+        pollfd pfd[3] = {
+            { ctl_, POLLIN, 0 },
+            { outOpen ? out_ : -1, POLLIN, 0 },
+            { errOpen ? err_ : -1, POLLIN, 0 },
+        };
+        if (poll(pfd, 3, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pfd[1].revents) outOpen = PumpLog(out_, out_sink_, outPrefix);
+        if (pfd[2].revents) errOpen = PumpLog(err_, err_sink_, errPrefix);
+        if (pfd[0].revents & POLLIN) {
+            int fd = -1;
+            const ssize_t n = RecvMsg(ctl_, buf.data(), buf.size(), fd);
+            if (n == 0) break;
+            if (n < 0) {
+                if (errno == EPROTO) continue;
+                break;
+            }
+            gotExit = HandleMessage(buf.data(), static_cast<size_t>(n), fd) || gotExit;
+        } else if (pfd[0].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+            break;
+        }
+    }
+
+    // 控制通道断开：工作进程退出后管道写端随之关闭，把剩余输出读完（最多等 500ms）
+    for (int i = 0; i < 10 && (outOpen || errOpen); i++) {
+        pollfd pfd[2] = { { outOpen ? out_ : -1, POLLIN, 0 }, { errOpen ? err_ : -1, POLLIN, 0 } };
+        if (poll(pfd, 2, 50) <= 0) continue;
+        if (pfd[0].revents) outOpen = PumpLog(out_, out_sink_, outPrefix);
+        if (pfd[1].revents) errOpen = PumpLog(err_, err_sink_, errPrefix);
+    }
+    if (!gotExit) {
+        log_submit(0, kLogHilog, "", "QEMU: [" + vm_name_ + "] worker pid " + std::to_string(pid_) +
+                   " disappeared without exit status");
+    }
+
+    sched_unregister_self();
+    std::lock_guard<std::mutex> lk(exit_mutex_);
+    if (!gotExit) exit_code_ = -1;
+    exited_ = true;
+    exit_cv_.notify_all();
+}
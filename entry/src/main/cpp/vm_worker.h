@@ -0,0 +1,107 @@
+#ifndef VM_WORKER_H
+#define VM_WORKER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "worker_protocol.h"
+
+// QEMU 工作进程（主进程侧）：通过 OH_Ability_StartNativeChildProcess 拉起 libqemu_worker.so，
+// 每个 VM 一份独立的 QEMU 全局状态。读取线程负责控制通道与工作进程的 stdout/stderr：
+// 日志按 VM 落盘，显示 / 串口 / 状态通过回调交给调用方（回调都在读取线程中执行）
+
+struct VmWorkerLaunch {
+    std::string vm_name;
+    std::string vm_dir;
+    std::string core_lib;          // libqemu_{arch}.so
+    std::string console_chardev;   // 工作进程内的 aether-ring chardev id（空则不转发串口）
+    std::vector<std::string> argv;
+};
+
+class VmWorker {
+public:
+    struct Callbacks {
+        std::function<void()> on_running;
+        // pixels 为空表示当前没有可用 surface；指针在下一次 on_surface 之前有效
+        std::function<void(const uint8_t* pixels, int width, int height, int stride, uint32_t format)> on_surface;
+        // 返回后即向工作进程确认，工作进程才会再写共享 surface
+        std::function<void(const worker_proto::Rect* rects, uint32_t count)> on_frame;
+        std::function<void(const char* data, size_t len)> on_console;
+    };
+
+    // 失败时返回空并在 err 中给出原因（系统不支持原生子进程、拉起失败等）
+    static std::unique_ptr<VmWorker> Spawn(const VmWorkerLaunch& launch, Callbacks callbacks, std::string& err);
+    ~VmWorker();
+
+    VmWorker(const VmWorker&) = delete;
+    VmWorker& operator=(const VmWorker&) = delete;
+
+    int32_t pid() const { return pid_; }
+
+    // 阻塞到工作进程退出，返回 QEMU 退出码（进程异常消失为 -1）
+    int Wait();
+
+    bool RequestShutdown();
+    bool RequestFullFrame();
+    bool WriteConsole(const char* data, size_t len);
+    void Kill();
+
+    // 读取工作进程中热点分析插件的报告；插件未加载、超时或进程已退出返回 false
+    bool QueryHotspots(uint32_t top, bool reset, int timeout_ms, AetherHotspotTotals& totals,
+                       std::vector<AetherHotspot>& out);
+    // 读取工作进程中 OHAudio 后端的 xrun 计数；core 不支持或超时返回 false
+    bool QueryAudioStats(int timeout_ms, worker_proto::AudioStats& out);
+
+    // 持锁访问当前 surface（显示桥 attach 时回放）
+    void WithSurface(const std::function<void(const uint8_t* pixels, int width, int height, int stride,
+                                              uint32_t format)>& fn);
+
+private:
+    VmWorker() = default;
+    void Run();
+    bool Send(uint32_t type, const void* payload, size_t len);
+    bool HandleMessage(const char* buf, size_t len, int fd);
+    // 请求与回复负载都以 uint32_t seq 开头：这里填写 seq 并等待同 seq 的 reply_type 回复
+    bool Request(uint32_t type, void* payload, size_t len, uint32_t reply_type, int timeout_ms,
+                 std::vector<char>& reply);
+    void CompleteRequest(uint32_t type, const char* payload, size_t len);
+    bool PumpLog(int fd, int sink, const std::string& hilogPrefix);
+
+    std::string vm_name_;
+    Callbacks cb_;
+    int32_t pid_ = 0;
+    int ctl_ = -1;
+    int out_ = -1;
+    int err_ = -1;
+    int out_sink_ = 0;
+    int err_sink_ = 0;
+    std::thread reader_;
+    std::mutex send_mutex_;
+
+    std::mutex surface_mutex_;
+    uint8_t* map_ = nullptr;
+    size_t map_size_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    uint32_t format_ = 0;
+
+    std::mutex request_mutex_;   // 同一时间只有一个请求在等待回复
+    std::mutex reply_mutex_;
+    std::condition_variable reply_cv_;
+    uint32_t reply_seq_ = 0;
+    uint32_t reply_type_ = 0;
+    bool reply_ready_ = false;
+    std::vector<char> reply_;
+
+    std::mutex exit_mutex_;
+    std::condition_variable exit_cv_;
+    bool exited_ = false;
+    int exit_code_ = -1;
+};
+
+#endif // VM_WORKER_H
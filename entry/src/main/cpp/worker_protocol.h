@@ -0,0 +1,179 @@
+#ifndef WORKER_PROTOCOL_H
+#define WORKER_PROTOCOL_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "plugins/aether_hotspot.h"
+
+// 主进程与 QEMU 工作进程（libqemu_worker.so:Main）之间的控制通道协议
+// 通道为 SOCK_SEQPACKET socketpair：一次 send 对应一条完整消息（头 + 负载），
+// 显示 surface 放在工作进程创建的 memfd 里，随 Switch 消息以 SCM_RIGHTS 传给主进程映射
+
+namespace worker_proto {
+
+constexpr uint32_t kVersion = 1;
+constexpr const char* kEntry = "libqemu_worker.so:Main";
+
+// 启动参数中的 fd 名称（NativeChildProcess_Fd.fdName）
+constexpr const char* kFdCtl = "ctl";
+constexpr const char* kFdStdout = "out";
+constexpr const char* kFdStderr = "err";
+
+enum MsgType : uint32_t {
+    // 工作进程 -> 主进程
+    kMsgRunning = 1,      // qemu_init 完成，进入主循环
+    kMsgExit = 2,         // ExitMsg
+    kMsgSwitch = 3,       // SwitchMsg（width > 0 时附带 memfd）
+    kMsgFrame = 4,        // FrameMsg：脏区已写入共享 surface，主进程拷走后回 kMsgFrameAck
+    kMsgConsole = 5,      // 串口输出字节
+    kMsgHotspots = 6,     // HotspotReply + count 个 AetherHotspot（热点分析插件未加载时 count 为 0 且 loaded 为 0）
+    kMsgAudioStats = 7,   // AudioStatsReply
+    // 主进程 -> 工作进程
+    kMsgFrameAck = 16,
+    kMsgFullFrame = 17,   // 下一帧发送整屏（新 attach 的显示桥）
+    kMsgConsoleIn = 18,   // 串口输入字节
+    kMsgShutdown = 19,    // 相当于进程内的 qemu_system_shutdown_request(SHUTDOWN_CAUSE_HOST)
+    kMsgHotspotQuery = 20, // HotspotQuery：读取热点分析插件的报告
+    kMsgAudioStatsQuery = 21, // AudioStatsQuery：读取 OHAudio 后端的 xrun 计数
+};
+
+struct MsgHeader {
+    uint32_t type;
+    uint32_t len;         // 负载字节数
+};
+
+struct ExitMsg {
+    int32_t code;
+};
+
+// 共享 surface 总是紧密排列：stride == width * 4，像素格式沿用 pixman 格式码
+struct SwitchMsg {
+    int32_t width;
+    int32_t height;
+    uint32_t format;
+};
+
+struct Rect {
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+};
+
+// 超出条数的脏区由工作进程合并为外接矩形
+constexpr uint32_t kMaxFrameRects = 64;
+
+struct FrameMsg {
+    uint32_t count;
+    Rect rects[kMaxFrameRects];
+};
+
+constexpr size_t kMaxConsolePayload = 16 * 1024;
+constexpr size_t kMaxMsgBytes = sizeof(MsgHeader) + kMaxConsolePayload;
+
+// 查询与回复的负载都以 seq 开头：工作进程原样带回，主进程据此丢弃已超时查询的迟到回复
+struct HotspotQuery {
+    uint32_t seq;
+    uint32_t top;
+    uint32_t reset;
+};
+
+struct HotspotReply {
+    uint32_t seq;
+    uint32_t loaded;
+    uint32_t count;
+    uint32_t reserved;
+    AetherHotspotTotals totals;
+};
+
+static_assert(sizeof(HotspotReply) + AETHER_HOTSPOT_MAX_TOP * sizeof(AetherHotspot) <= kMaxConsolePayload,
+              "hotspot report must fit in one message");
+
+// 与补丁 0002 的 AetherAudioStats 布局一致，由 qemu_hmos_audio_get_stats 直接填充
+constexpr uint32_t kAudioStatsVersion = 1;
+
+struct AudioStats {
+    uint64_t out_underruns;   // 播放回调拿到的数据不足（补静音）
+    uint64_t out_overruns;    // 播放环满，来宾音频留待下一拍
+    uint64_t in_overruns;     // 录音环满，丢弃一个采集缓冲
+    uint64_t in_underruns;    // QEMU 读取时录音环为空
+    uint64_t out_bytes;
+    uint64_t in_bytes;
+    uint32_t out_ring_bytes;
+    uint32_t in_ring_bytes;
+};
+
+static_assert(sizeof(AudioStats) == 56, "AudioStats must match AetherAudioStats in patch 0002");
+
+struct AudioStatsQuery {
+    uint32_t seq;
+};
+
+struct AudioStatsReply {
+    uint32_t seq;
+    uint32_t available;       // core 不带该接口（旧补丁）时为 0
+    AudioStats stats;
+};
+
+// 发送一条消息（可附带一个 fd）；两端都可能多线程发送，SEQPACKET 保证单条消息不被交错
+inline bool SendMsg(int sock, uint32_t type, const void* payload, size_t len, int fd = -1)
+{
+    MsgHeader hdr { type, static_cast<uint32_t>(len) };
+    iovec iov[2] = { { &hdr, sizeof(hdr) }, { const_cast<void*>(payload), len } };
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = len > 0 ? 2 : 1;
+    if (fd >= 0) {
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &fd, sizeof(int));
+    }
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == static_cast<ssize_t>(sizeof(hdr) + len);
+}
+
+// 接收一条消息，附带的 fd 放入 fd（没有则为 -1）。返回 0 表示对端关闭
+inline ssize_t RecvMsg(int sock, char* buf, size_t cap, int& fd)
+{
+    fd = -1;
+    iovec iov { buf, cap };
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))];
+    msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) return n;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) memcpy(&fd, CMSG_DATA(c), sizeof(int));
+    }
+    if (n > 0 && (n < static_cast<ssize_t>(sizeof(MsgHeader)) ||
+                  reinterpret_cast<const MsgHeader*>(buf)->len != static_cast<size_t>(n) - sizeof(MsgHeader))) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+        errno = EPROTO;
+        return -1;
+    }
+    return n;
+}
+
+} // namespace worker_proto
+
+#endif // WORKER_PROTOCOL_H
@@ -7,6 +7,14 @@ export interface VMConfig {
   accel?: string;
   display?: string;
   nographic?: boolean;
+  // Map guest RAM to a file so suspendVm can park the VM and the next startVm resumes it
+  fastResume?: boolean;
+  // 'auto' runs the first VM in-process and each concurrent VM in its own worker process
+  runtime?: 'auto' | 'inprocess' | 'worker';
+  // Performance profile; picks vCPUs / memory when cpuCount / memoryMB are not given
+  profile?: 'powersaver' | 'balanced' | 'turbo';
+  // Load the TCG hot-spot profiler plugin (default false; adds per-access overhead)
+  profiler?: boolean;
 }
 
 export interface VMStatus {
@@ -24,18 +32,58 @@ export interface QemuAPI {
   startVm(config: VMConfig): boolean;
   stopVm(name: string): boolean;
   getVmLogs(name: string, startLine?: number): string[];
+  // Incremental logs from the per-VM ring store; pass nextSeq back to get only new lines
+  getVmLogsSince?: (name: string, seq: number, maxBytes?: number) => VmLogChunk;
+  setVmLogCallback?: (name: string, callback: (chunk: VmLogChunk) => void, sinceSeq?: number) => boolean;
+  clearVmLogCallback?: (name: string) => boolean;
+  // Runtime mode and host ports of a running VM; null when it is not running
+  getVmRuntime?: (name: string) => VmRuntimeInfo | null;
+  // Performance profiles: preview a plan, read the plan of the last start, sample a running VM
+  planVmProfile?: (profile: string, cpuCount?: number, memoryMB?: number, accel?: string) => VmProfilePlan;
+  getVmProfile?: (name: string) => VmProfilePlan | null;
+  benchmarkVmProfile?: (name: string, seconds?: number) => Promise<VmProfileBenchmark>;
+  // Thread pinning: vCPU threads on performance cores, I/O / render / audio threads on the rest
+  getThreadStats?: (name: string) => VmThreadStats;
+  setCpuPinning?: (enabled: boolean) => number;
+  // Hot translation blocks of a VM started with profiler: true; null otherwise
+  getHotspots?: (name: string, top?: number, reset?: boolean) => VmHotspotReport | null;
+  // OHAudio backend xrun counters; null when the VM is not running or the core predates them
+  getAudioStats?: (name: string) => VmAudioStats | null;
+  setDeviceInfo?: (deviceType: number, model: string) => void;
+  setJitPermission?: (granted: boolean) => void;
   getVmStatus(name: string): string;
+  // Event-driven VM state machine (no polling)
+  getVmState?: (name: string) => VmStateInfo;
+  setVmStateCallback?: (callback: (ev: VmStateEvent) => void) => boolean;
+  clearVmStateCallback?: () => boolean;
   // Diagnostics and testing (optional)
   testFunction?: () => boolean;
   checkCoreLib?: () => CoreDiag;
   // Native VNC (LibVNCClient) - optional methods
   vncAvailable?: () => boolean;
   vncCreate?: () => number;
-  vncConnect?: (id: number, host: string, port: number) => boolean;
+  vncConnect?: (id: number, host: string, port: number, options?: VncConnectOptions) => boolean;
   vncDisconnect?: (id: number) => void;
   vncGetFrame?: (id: number) => VncFrame | null;
+  vncGetStats?: (id: number) => VncStats | null;
   vncSendPointer?: (id: number, x: number, y: number, buttonMask: number) => boolean;
   vncSendKey?: (id: number, keysym: number, down: boolean) => boolean;
+  // In-process display bridge (QEMU started with display 'xcomponent'); pass vmName for a worker VM
+  displayAttach?: (id: number, vmName?: string) => boolean;
+  displayDetach?: (vmName?: string) => boolean;
+  // Persistent QMP session: pipelined commands and pushed events
+  qmpExecute?: (vmName: string, command: string, argsJson?: string) => Promise<QmpExecuteResult>;
+  qmpSubscribeEvents?: (vmName: string, callback: (ev: QmpEvent) => void, events?: string[]) => boolean;
+  qmpUnsubscribeEvents?: (vmName: string) => boolean;
+  // Snapshot engine; loading an external snapshot takes effect on the next startVm (phase 'pending')
+  snapshotSave?: (vmName: string, tag: string, options?: SnapshotSaveOptions) => Promise<SnapshotProgress>;
+  snapshotLoad?: (vmName: string, tag: string, options?: { onProgress?: (p: SnapshotProgress) => void }) => Promise<SnapshotProgress>;
+  snapshotDelete?: (vmName: string, tag: string) => Promise<SnapshotProgress>;
+  snapshotList?: (vmName: string) => SnapshotInfo[];
+  // Suspend to file (VM started with fastResume); the next startVm with the same hardware resumes lazily
+  suspendVm?: (vmName: string) => Promise<SnapshotProgress>;
+  hasResumeState?: (vmName: string) => boolean;
+  discardResumeState?: (vmName: string) => boolean;
 }
 
 // VNC frame shape for native client
@@ -45,6 +93,33 @@ export interface VncFrame {
   pixels: ArrayBuffer;
   // optional: frame sequence id (incremented when there is a new frame)
   seq?: number;
+  // optional: dirty rects since the previously returned frame, flattened [x, y, w, h, ...]
+  // pixels is a persistent native buffer that stays unchanged until the next vncGetFrame call
+  dirtyRects?: number[];
+}
+
+// Encoding policy for vncConnect. profile 'auto' picks loopback for 127.x/localhost.
+export interface VncConnectOptions {
+  profile?: 'auto' | 'loopback' | 'remote';
+  // space/comma separated; unsupported names are dropped and raw is always appended
+  encodings?: string;
+  quality?: number;   // 0-9
+  compress?: number;  // 0-9
+}
+
+export interface VncEncodingStat {
+  name: string;
+  rects: number;
+  pixels: number;
+  bytes: number;
+  decodeUs: number;
+}
+
+export interface VncStats {
+  encodings: string;
+  bytesReceived: number;
+  messages: number;
+  perEncoding: VncEncodingStat[];
 }
 
 // Module declaration for N-API native addon
@@ -68,3 +143,170 @@ export interface CoreDiag {
   errSelfDir?: string;
   errFiles?: string;
 }
+
+// QMP command result (return is the JSON text of the "return" member)
+export interface QmpExecuteResult {
+  ok: boolean;
+  return?: string;
+  errorClass?: string;
+  errorDesc?: string;
+}
+
+// QMP event pushed from the native session; QMP_DISCONNECTED is emitted when the socket closes
+export interface QmpEvent {
+  vmName: string;
+  event: string;
+  data: string;
+  seconds: number;
+  microseconds: number;
+}
+
+// Current VM state; since is the Unix time in ms the state was entered
+export interface VmLogChunk {
+  vmName: string;
+  text: string;       // lines joined, each terminated by '\n'
+  firstSeq: number;
+  nextSeq: number;
+  lines: number;
+  gap: boolean;       // some lines between seq and firstSeq were overwritten
+  more: boolean;      // truncated by maxBytes
+}
+
+// Host ports come from a per-VM pool; the first VM keeps 3390/2222/8080/8443/5901
+export interface VmRuntimeInfo {
+  vmName: string;
+  mode: 'inprocess' | 'worker';
+  pid: number;        // worker process pid, 0 when in-process
+  ports: { rdp: number; ssh: number; http: number; https: number; vnc: number };
+}
+
+// Tuning chosen by a performance profile; rationale explains each choice
+export interface VmProfilePlan {
+  profile: 'powersaver' | 'balanced' | 'turbo';
+  accel: string;
+  icount: string;
+  smp: number;
+  memoryMB: number;
+  tbSizeMB: number;
+  mttcg: boolean;
+  rationale: string[];
+  bootMs?: number;    // startVm to running, -1 while still booting
+  host?: {
+    cpus: number;
+    performanceCpus: number;
+    efficiencyCpus: number;
+    totalMemoryMB: number;
+    availableMemoryMB: number;
+    jit: boolean;
+    kvm: boolean;
+  };
+}
+
+export interface VmProfileBenchmark extends VmProfilePlan {
+  elapsedMs: number;
+  hostCpuMs: number;
+  hostCpuPercent: number;  // 100 = one host core fully busy
+  jitStats: boolean;
+  tbCount?: number;
+  tbFlushes?: number;      // full TB cache flushes during the sample; many means tb-size is too small
+  tbInvalidates?: number;
+  codeUsedBytes?: number;
+  codeTotalBytes?: number;
+}
+
+export interface VmThreadStat {
+  tid: number;
+  name: string;
+  role: string;            // vcpu / io / other
+  vm: string;
+  cpuMs: number;
+  lastCpu: number;
+  affinity: number[];
+}
+
+export interface VmThreadStats {
+  pinning: boolean;
+  performanceCpus: number[];
+  efficiencyCpus: number[];  // empty on homogeneous CPUs
+  threads: VmThreadStat[];
+}
+
+// Sorted by guest instructions executed (exec * insns); pc is a hex string
+export interface VmHotspot {
+  pc: string;
+  exec: number;
+  insns: number;
+  helperInsns: number;     // instructions TCG runs through helper calls
+  mem: number;
+  mmio: number;            // accesses that hit MMIO (always the softmmu slow path)
+  share: number;
+  disas: string;
+}
+
+export interface VmHotspotReport {
+  tbs: number;
+  execs: number;
+  insns: number;
+  helperInsns: number;
+  memAccesses: number;
+  mmioAccesses: number;
+  helperRate: number;
+  mmioRate: number;
+  hotspots: VmHotspot[];
+}
+
+// Cumulative since the QEMU process started
+export interface VmAudioStats {
+  outUnderruns: number;    // renderer callback padded with silence
+  outOverruns: number;     // playback ring full, guest audio deferred
+  inOverruns: number;      // capture ring full, buffer dropped
+  inUnderruns: number;     // capture ring empty on read
+  outBytes: number;
+  inBytes: number;
+  outRingBytes: number;
+  inRingBytes: number;
+}
+
+export interface VmStateInfo {
+  state: string;
+  since: number;
+  reason: string;
+}
+
+// VM state transition pushed by setVmStateCallback
+export interface VmStateEvent {
+  vmName: string;
+  state: string;
+  previous: string;
+  reason: string;
+  timestamp: number;
+}
+
+// external (default): disk switches to a new qcow2 overlay, RAM goes to a deduplicated, compressed chunk store
+// internal: QMP snapshot-save job inside the qcow2 image (VM must be running)
+export interface SnapshotSaveOptions {
+  mode?: 'external' | 'internal';
+  onProgress?: (p: SnapshotProgress) => void;
+}
+
+// Progress report; the last one (done = true) also resolves the promise
+export interface SnapshotProgress {
+  tag: string;
+  op: 'save' | 'load' | 'delete' | 'suspend';
+  phase: string;        // disk | ram | job | pending | done | error
+  progress: number;     // 0..1
+  ramBytes: number;     // size of the RAM state stream
+  storedBytes: number;  // bytes newly written after dedup and compression
+  done: boolean;
+  ok: boolean;
+  error?: string;
+}
+
+export interface SnapshotInfo {
+  tag: string;
+  mode: 'external' | 'internal';
+  created: number;      // Unix time in ms
+  running: boolean;     // guest was running when the snapshot was taken
+  ramBytes: number;
+  storedBytes: number;
+}
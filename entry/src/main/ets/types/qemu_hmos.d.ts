@@ -1,5 +1,120 @@
 // QEMU NAPI模块类型声明
 declare module 'qemu_hmos' {
+  interface SnapshotProgress {
+    tag: string;
+    op: string;
+    phase: string;
+    progress: number;
+    ramBytes: number;
+    storedBytes: number;
+    done: boolean;
+    ok: boolean;
+    error?: string;
+  }
+
+  interface VmLogChunk {
+    vmName: string;
+    text: string;            // 各行以 '\n' 结尾拼接
+    firstSeq: number;
+    nextSeq: number;         // 下次 getVmLogsSince 传入的 seq
+    lines: number;
+    gap: boolean;            // 中间有行已被环形存储覆盖
+    more: boolean;           // 受 maxBytes 限制未取完
+  }
+
+  interface VmRuntimeInfo {
+    vmName: string;
+    mode: 'inprocess' | 'worker';
+    pid: number;             // 工作进程 pid（进程内为 0）
+    ports: { rdp: number; ssh: number; http: number; https: number; vnc: number };
+  }
+
+  interface VmProfilePlan {
+    profile: 'powersaver' | 'balanced' | 'turbo';
+    accel: string;
+    icount: string;
+    smp: number;
+    memoryMB: number;
+    tbSizeMB: number;
+    mttcg: boolean;
+    rationale: string[];     // 每一项选择的依据
+    bootMs?: number;         // startVm 到 running 的耗时，尚未 running 为 -1
+    host?: {
+      cpus: number;
+      performanceCpus: number;
+      efficiencyCpus: number;
+      totalMemoryMB: number;
+      availableMemoryMB: number;
+      jit: boolean;
+      kvm: boolean;
+    };
+  }
+
+  interface VmProfileBenchmark extends VmProfilePlan {
+    elapsedMs: number;
+    hostCpuMs: number;
+    hostCpuPercent: number;  // 100 = 占满一个宿主核心
+    jitStats: boolean;
+    tbCount?: number;
+    tbFlushes?: number;      // 采样期间整体 flush 次数，偏多说明 tb-size 偏小
+    tbInvalidates?: number;
+    codeUsedBytes?: number;
+    codeTotalBytes?: number;
+  }
+
+  interface VmThreadStat {
+    tid: number;
+    name: string;
+    role: string;            // vcpu / io / other
+    vm: string;
+    cpuMs: number;
+    lastCpu: number;
+    affinity: number[];
+  }
+
+  interface VmThreadStats {
+    pinning: boolean;
+    performanceCpus: number[];
+    efficiencyCpus: number[];
+    threads: VmThreadStat[];
+  }
+
+  // TCG 热点：按执行的来宾指令数降序，pc 为十六进制字符串
+  interface VmHotspot {
+    pc: string;
+    exec: number;
+    insns: number;
+    helperInsns: number;
+    mem: number;
+    mmio: number;
+    share: number;
+    disas: string;
+  }
+
+  interface VmHotspotReport {
+    tbs: number;
+    execs: number;
+    insns: number;
+    helperInsns: number;
+    memAccesses: number;
+    mmioAccesses: number;
+    helperRate: number;
+    mmioRate: number;
+    hotspots: VmHotspot[];
+  }
+
+  // OHAudio 后端 xrun 计数，自进程启动累计
+  interface VmAudioStats {
+    outUnderruns: number;
+    outOverruns: number;
+    inOverruns: number;
+    inUnderruns: number;
+    outBytes: number;
+    inBytes: number;
+    outRingBytes: number;
+    inRingBytes: number;
+  }
+
   interface QemuModule {
     // 基础功能
     version(): string;
@@ -16,11 +131,38 @@ declare module 'qemu_hmos' {
       accel?: string;
       display?: string;
       nographic?: boolean;
+      fastResume?: boolean;
+      runtime?: 'auto' | 'inprocess' | 'worker';
+      profile?: 'powersaver' | 'balanced' | 'turbo';
+      profiler?: boolean;
     }): boolean;
     
     stopVm(vmName: string): boolean;
     getVmStatus(vmName: string): string;
+    // VM 状态机（事件驱动，无轮询）：state 为 stopped/preparing/starting/running/paused/stopping/failed
+    getVmState(vmName: string): { state: string; since: number; reason: string };
+    setVmStateCallback(callback: (ev: { vmName: string; state: string; previous: string; reason: string; timestamp: number }) => void): boolean;
+    clearVmStateCallback(): boolean;
     getVmLogs(vmName: string, startLine?: number): string[];
+    // 增量日志：只取序号 >= seq 的新行；setVmLogCallback 实时推送（多行合并为一次回调）
+    getVmLogsSince?(vmName: string, seq: number, maxBytes?: number): VmLogChunk;
+    setVmLogCallback?(vmName: string, callback: (chunk: VmLogChunk) => void, sinceSeq?: number): boolean;
+    clearVmLogCallback?(vmName: string): boolean;
+    // 运行方式与宿主端口：第一个 VM 在进程内运行，并行的 VM 各用一个工作进程和一组端口
+    getVmRuntime?(vmName: string): VmRuntimeInfo | null;
+    // 性能模式：预览规划、最近一次启动的规划（含启动耗时）、运行中采样宿主 CPU 与翻译缓存计数
+    planVmProfile?(profile: string, cpuCount?: number, memoryMB?: number, accel?: string): VmProfilePlan;
+    getVmProfile?(vmName: string): VmProfilePlan | null;
+    benchmarkVmProfile?(vmName: string, seconds?: number): Promise<VmProfileBenchmark>;
+    // 线程绑核：每线程 CPU 时间与所在核心；开关绑核
+    getThreadStats?(vmName: string): VmThreadStats;
+    setCpuPinning?(enabled: boolean): number;
+    // TCG 热点分析：以 profiler: true 启动的 VM 的热点 TB、helper 与 MMIO 比例；reset 开始新的采样窗口
+    getHotspots?(vmName: string, top?: number, reset?: boolean): VmHotspotReport | null;
+    // 音频：播放 / 录音环的欠载与溢出次数
+    getAudioStats?(vmName: string): VmAudioStats | null;
+    setDeviceInfo?(deviceType: number, model: string): void;
+    setJitPermission?(granted: boolean): void;
     
     // 核心库诊断
     checkCoreLib(): {
@@ -47,23 +189,62 @@ declare module 'qemu_hmos' {
       password: string;
       width?: number;
       height?: number;
+      trustedFingerprint?: string; // 用户确认过的服务器证书指纹，非回环主机必须匹配才会接受
     }): number;
     disconnectRdp(clientId: string): number;
     getRdpStatus(clientId: string): number;
+    // 连接因证书不受信任失败后返回被拒绝的证书，没有则 undefined
+    getRdpCertificate(clientId: string): {
+      host: string;
+      port: number;
+      commonName: string;
+      subject: string;
+      issuer: string;
+      fingerprint: string;
+      changed: boolean;
+    } | undefined;
+    rdpSendKey(clientId: string, key: number, down: boolean): number;
+    rdpSendMouse(clientId: string, x: number, y: number, button: number, down: boolean): number;
+    rdpSetSurface(clientId: string, surfaceId: string, width: number, height: number): boolean;
+    rdpClearSurface(clientId: string): boolean;
     destroyRdpClient(clientId: string): number;
     
     // VNC客户端
     vncAvailable(): boolean;
     vncCreate(): number;
-    vncConnect(id: number, host: string, port: number): boolean;
+    vncConnect(id: number, host: string, port: number, options?: { profile?: 'auto' | 'loopback' | 'remote'; encodings?: string; quality?: number; compress?: number }): boolean;
     vncDisconnect(id: number): boolean;
     vncGetFrame(id: number): {
       width: number;
       height: number;
       pixels: ArrayBuffer;
+      seq?: number;
+      dirtyRects?: number[];
+    } | null;
+    vncGetStats(id: number): {
+      encodings: string;
+      bytesReceived: number;
+      messages: number;
+      perEncoding: Array<{ name: string; rects: number; pixels: number; bytes: number; decodeUs: number }>;
     } | null;
     vncSendPointer(id: number, x: number, y: number, buttonMask: number): boolean;
     vncSendKey(id: number, keysym: number, down: boolean): boolean;
+    // 进程内显示桥（QEMU 需以 display: 'xcomponent' 启动）
+    displayAttach(id: number, vmName?: string): boolean;
+    displayDetach(vmName?: string): boolean;
+    // QMP 长连接（data / return 为 JSON 文本；events 支持 'BLOCK_JOB_*' 前缀匹配）
+    qmpExecute(vmName: string, command: string, argsJson?: string): Promise<{ ok: boolean; return?: string; errorClass?: string; errorDesc?: string }>;
+    qmpSubscribeEvents(vmName: string, callback: (ev: { vmName: string; event: string; data: string; seconds: number; microseconds: number }) => void, events?: string[]): boolean;
+    qmpUnsubscribeEvents(vmName: string): boolean;
+    // 快照引擎（external 默认；恢复外部快照在下次 startVm 时生效）
+    snapshotSave?(vmName: string, tag: string, options?: { mode?: 'external' | 'internal'; onProgress?: (p: SnapshotProgress) => void }): Promise<SnapshotProgress>;
+    snapshotLoad?(vmName: string, tag: string, options?: { onProgress?: (p: SnapshotProgress) => void }): Promise<SnapshotProgress>;
+    snapshotDelete?(vmName: string, tag: string): Promise<SnapshotProgress>;
+    snapshotList?(vmName: string): Array<{ tag: string; mode: string; created: number; running: boolean; ramBytes: number; storedBytes: number }>;
+    // 快速恢复（startVm 需 fastResume: true）
+    suspendVm?(vmName: string): Promise<SnapshotProgress>;
+    hasResumeState?(vmName: string): boolean;
+    discardResumeState?(vmName: string): boolean;
     
     // 测试和诊断
     testFunction(): boolean;
@@ -27,6 +27,8 @@ interface WorkerVMConfig {
   displayMode?: string
   nographic?: boolean
   efiFirmware?: string  // UEFI 固件路径
+  profile?: 'powersaver' | 'balanced' | 'turbo'  // 性能模式，默认 balanced
+  profiler?: boolean  // TCG 热点分析插件，默认关闭
 }
 
 interface QemuWorkerMessage {
@@ -44,6 +46,7 @@ interface QemuWorkerMessage {
   guestPath?: string
   deviceType?: number
   deviceModel?: string
+  jitPermission?: boolean
   isReleaseBuild?: boolean
 }
 
@@ -180,7 +183,9 @@ function startVM(config?: WorkerVMConfig): QemuWorkerResponse {
     accel: params.accelMode ?? params.accel,
     display: params.displayMode ?? params.display,
     nographic: params.nographic ?? false,
-    efiFirmware: params.efiFirmware  // 传递 UEFI 固件路径
+    efiFirmware: params.efiFirmware,  // 传递 UEFI 固件路径
+    profile: params.profile ?? 'balanced',
+    profiler: params.profiler ?? false
   })
 
   if (!success) {
@@ -347,6 +352,16 @@ function getKvmInfo(): QemuWorkerResponse {
   }
 }
 
+// 设备类型与 JIT 权限：性能模式据此规划 vCPU / 翻译缓存
+function setDeviceInfo(message: QemuWorkerMessage): QemuWorkerResponse {
+  if (typeof qemuNative.setDeviceInfo !== 'function') {
+    return unsupported(message.command)
+  }
+  qemuNative.setDeviceInfo(message.deviceType ?? 0, message.deviceModel ?? '')
+  qemuNative.setJitPermission?.(message.jitPermission ?? false)
+  return { success: true, message: '设备信息已设置' }
+}
+
 function unsupported(message: string): QemuWorkerResponse {
   return fail(`${message}：native 模块未实现`)
 }
@@ -389,9 +404,11 @@ workerPort.onmessage = (event: any) => {
       case 'forward_port':
       case 'setup_network':
       case 'mount_shared_dir':
-      case 'set_device_info':
         response = unsupported(message.command)
         break
+      case 'set_device_info':
+        response = setDeviceInfo(message)
+        break
       default:
         response = fail(`未知命令: ${message.command}`)
         break
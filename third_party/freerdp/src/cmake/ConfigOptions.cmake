@@ -153,6 +153,8 @@ if(WITH_VAAPI_H264_ENCODING)
   add_definitions("-DWITH_VAAPI_H264_ENCODING")
 endif()
 
+option(WITH_H264_BACKEND "Negotiate H264 for decoders registered at runtime (h264_register_decoder_backend)" OFF)
+
 option(WITH_CAIRO "Use CAIRO image library for screen resizing" OFF)
 option(WITH_SWSCALE "Use SWScale image library for screen resizing" ON)
 
@@ -121,6 +121,72 @@ extern "C"
 	                                    DWORD DstFormat, UINT32 nDstStep, UINT32 nDstWidth,
 	                                    UINT32 nDstHeight, UINT32 codecId);
 
+	/** @brief Create a decoder instance of an external backend
+	 *
+	 *  @param userdata The userdata of the registered backend
+	 *  @param width The surface width in pixels, \b 0 if not yet known
+	 *  @param height The surface height in pixels, \b 0 if not yet known
+	 *  @return A decoder handle or \b NULL if the backend is not usable
+	 *  @since version 3.18.0
+	 */
+	typedef void* (*pfnH264DecoderBackendNew)(void* userdata, UINT32 width, UINT32 height);
+
+	/** @brief Free a decoder instance created by \b pfnH264DecoderBackendNew
+	 *  @since version 3.18.0
+	 */
+	typedef void (*pfnH264DecoderBackendFree)(void* handle);
+
+	/** @brief Decode one H264 access unit to I420
+	 *
+	 *  The planes returned stay owned by the backend and must remain valid until the next call
+	 *  on the same handle. The YUV to RGB conversion is done by the H264 context.
+	 *
+	 *  @param handle The decoder handle
+	 *  @param pSrcData The H264 bitstream (annex B)
+	 *  @param SrcSize The length of \b pSrcData in bytes
+	 *  @param pYUVData A pointer to hold the Y, U and V planes of the decoded frame
+	 *  @param iStride A pointer to hold the byte length of a line of each plane
+	 *  @return \b 1 if a frame was decoded, \b 0 if no frame is available yet, \b <0 for an error
+	 *  @since version 3.18.0
+	 */
+	typedef INT32 (*pfnH264DecoderBackendDecode)(void* handle, const BYTE* pSrcData,
+	                                             UINT32 SrcSize, BYTE* pYUVData[3],
+	                                             UINT32 iStride[3]);
+
+	/** @brief An external H264 decoder, e.g. a platform hardware decoder
+	 *  @since version 3.18.0
+	 */
+	typedef struct
+	{
+		const char* name;
+		pfnH264DecoderBackendNew New;
+		pfnH264DecoderBackendFree Free;
+		pfnH264DecoderBackendDecode Decode;
+		void* userdata;
+	} H264_DECODER_BACKEND;
+
+	/** @brief Register an external H264 decoder backend
+	 *
+	 *  Registered backends are tried in registration order by every H264 decoder context
+	 *  created afterwards, before the built-in subsystems (OpenH264, FFmpeg, ...). A backend
+	 *  that fails to create a decoder falls back to the next one.
+	 *
+	 *  @param backend The backend to register, the structure is copied
+	 *  @return \b TRUE for success, \b FALSE if the name is already in use or the table is full
+	 *  @since version 3.18.0
+	 */
+	FREERDP_API BOOL h264_register_decoder_backend(const H264_DECODER_BACKEND* backend);
+
+	/** @brief Remove a backend registered with \b h264_register_decoder_backend
+	 *
+	 *  Contexts already using the backend keep their decoder until they are reset or freed.
+	 *
+	 *  @param name The name of the backend
+	 *  @return \b TRUE if the backend was found and removed
+	 *  @since version 3.18.0
+	 */
+	FREERDP_API BOOL h264_unregister_decoder_backend(const char* name);
+
 	FREERDP_API BOOL h264_context_reset(H264_CONTEXT* h264, UINT32 width, UINT32 height);
 
 	FREERDP_API void h264_context_free(H264_CONTEXT* h264);
@@ -214,6 +214,69 @@ typedef pstatus_t (*fn_orC_32u_t)(const UINT32* WINPR_RESTRICT pSrc, UINT32 val,
 	                              UINT32* WINPR_RESTRICT pDst, INT32 len);
 typedef pstatus_t (*primitives_uninit_t)(void);
 
+/**
+ * @brief Merge one scanline of separate color planes into packed pixels
+ *
+ * @param pSrc The R, G, B and A planes (in this order), advanced to the scanline start.
+ *             The alpha plane may be \b NULL, in which case the pixels are opaque.
+ * @param pDst The destination scanline
+ * @param DstFormat The destination pixel format @ref PIXEL_FORMAT
+ * @param width The number of pixels in the scanline
+ * @return \b <=0 for failure, success otherwise
+ *  @since version 3.18.0
+ */
+typedef pstatus_t (*fn_planarMerge_8u_P4C4R_t)(const BYTE* WINPR_RESTRICT pSrc[4],
+	                                           BYTE* WINPR_RESTRICT pDst, UINT32 DstFormat,
+	                                           UINT32 width);
+
+/**
+ * @brief Resolve a scanline of planar codec delta values in place
+ *
+ * Each byte of \b pSrcDst holds a sign-magnitude encoded delta (bit 0 is the
+ * sign) and is replaced by the previous scanline value plus that delta,
+ * modulo 256.
+ *
+ * @param pPrev The previous (already decoded) scanline
+ * @param pSrcDst The encoded deltas on input, the decoded scanline on output
+ * @param len The number of bytes in the scanline
+ * @return \b <=0 for failure, success otherwise
+ *  @since version 3.18.0
+ */
+typedef pstatus_t (*fn_planarDeltaDecode_8u_t)(const BYTE* WINPR_RESTRICT pPrev,
+	                                           BYTE* WINPR_RESTRICT pSrcDst, UINT32 len);
+
+/**
+ * @brief Expand a run of a repeated pixel pattern
+ *
+ * @param pPattern The pattern to repeat
+ * @param patternSize The size of the pattern in bytes, 1 to 8
+ * @param pDst The destination buffer
+ * @param count The number of times the pattern is written
+ * @return \b <=0 for failure, success otherwise
+ *  @since version 3.18.0
+ */
+typedef pstatus_t (*fn_rleExpand_8u_t)(const BYTE* WINPR_RESTRICT pPattern, UINT32 patternSize,
+	                                   BYTE* WINPR_RESTRICT pDst, UINT32 count);
+
+/**
+ * @brief XOR a run of pixels with a repeated pixel pattern
+ *
+ * Used by RLE decoders for foreground runs that are relative to the
+ * previous scanline. \b pSrc and \b pDst must not overlap, callers
+ * split longer runs at the scanline stride.
+ *
+ * @param pSrc The source pixels
+ * @param pPattern The pattern to XOR with
+ * @param patternSize The size of the pattern in bytes, 1 to 4
+ * @param pDst The destination buffer
+ * @param count The number of pixels
+ * @return \b <=0 for failure, success otherwise
+ *  @since version 3.18.0
+ */
+typedef pstatus_t (*fn_rleXorExpand_8u_t)(const BYTE* WINPR_RESTRICT pSrc,
+	                                      const BYTE* WINPR_RESTRICT pPattern, UINT32 patternSize,
+	                                      BYTE* WINPR_RESTRICT pDst, UINT32 count);
+
 #if defined(WITH_FREERDP_3x_DEPRECATED)
 typedef fn_copy_t __copy_t;
 typedef fn_copy_8u_t __copy_8u_t;
@@ -302,6 +365,12 @@ typedef struct
 	fn_add_16s_inplace_t add_16s_inplace;         /** @since version 3.6.0 */
 	fn_lShiftC_16s_inplace_t lShiftC_16s_inplace; /** @since version 3.6.0 */
 	fn_copy_no_overlap_t copy_no_overlap;         /** @since version 3.6.0 */
+
+	/* Planar and RLE bitmap codec helpers */
+	fn_planarMerge_8u_P4C4R_t planarMerge_8u_P4C4R; /** @since version 3.18.0 */
+	fn_planarDeltaDecode_8u_t planarDeltaDecode_8u; /** @since version 3.18.0 */
+	fn_rleExpand_8u_t rleExpand_8u;                 /** @since version 3.18.0 */
+	fn_rleXorExpand_8u_t rleXorExpand_8u;           /** @since version 3.18.0 */
 } primitives_t;
 
 typedef enum
@@ -0,0 +1,1346 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * bitmap codec benchmarking tool
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Decodes a set of recorded planar, interleaved, ClearCodec and AVC420 bitmaps
+ * into a frame buffer and reports the throughput per codec.
+ *
+ * A recording is a file starting with the 4 byte magic "FRCB" and a UINT32
+ * version (1), followed by any number of records, all fields little endian:
+ *
+ *   UINT32 codec   (0 = planar, 1 = interleaved, 2 = ClearCodec, 3 = AVC420)
+ *   UINT32 left, top, width, height
+ *   UINT32 bpp     (interleaved only, ignored otherwise)
+ *   UINT32 length
+ *   BYTE   data[length]
+ *
+ * AVC420 records hold one H264 access unit each, left/top/width/height is the
+ * updated region. They are replayed in order and the decoder is reset before
+ * every run, so a recording must start with an IDR frame.
+ *
+ * Without recordings a synthetic desktop-like frame is encoded with the
+ * planar and interleaved encoders (ClearCodec residual and band layers are
+ * generated directly) and decoded instead. If an H264 encoder is available a
+ * short AVC420 sequence is added. Use -record to store that set.
+ *
+ * -check-h264 decodes a hand-built I_PCM H264 stream through decoder backends
+ * registered with h264_register_decoder_backend (including one that cannot
+ * create a decoder) and then with the built-in decoder, and compares both.
+ */
+
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/file.h>
+#include <winpr/stream.h>
+#include <winpr/sysinfo.h>
+
+#include <freerdp/primitives.h>
+#include <freerdp/codec/color.h>
+#include <freerdp/codec/planar.h>
+#include <freerdp/codec/interleaved.h>
+#include <freerdp/codec/clear.h>
+#include <freerdp/codec/h264.h>
+
+#define CODEC_BENCHMARK_MAGIC "FRCB"
+#define CODEC_BENCHMARK_VERSION 1
+
+typedef enum
+{
+	CODEC_BENCHMARK_PLANAR = 0,
+	CODEC_BENCHMARK_INTERLEAVED = 1,
+	CODEC_BENCHMARK_CLEAR = 2,
+	CODEC_BENCHMARK_AVC420 = 3,
+	CODEC_BENCHMARK_COUNT
+} codec_benchmark_id;
+
+typedef struct
+{
+	UINT32 codec;
+	UINT32 left;
+	UINT32 top;
+	UINT32 width;
+	UINT32 height;
+	UINT32 bpp;
+	UINT32 length;
+	BYTE* data;
+} codec_benchmark_sample;
+
+typedef struct
+{
+	codec_benchmark_sample* samples;
+	size_t count;
+	size_t size;
+
+	UINT32 width;
+	UINT32 height;
+	UINT32 stride;
+	UINT32 format;
+	BYTE* frame;
+
+	BITMAP_PLANAR_CONTEXT* planar;
+	BITMAP_INTERLEAVED_CONTEXT* interleaved;
+	CLEAR_CONTEXT* clear;
+	BYTE clearSeq;
+	H264_CONTEXT* h264;
+	gdiPalette palette;
+} codec_benchmark;
+
+static const char* codec_benchmark_name(UINT32 codec)
+{
+	switch (codec)
+	{
+		case CODEC_BENCHMARK_PLANAR:
+			return "planar";
+		case CODEC_BENCHMARK_INTERLEAVED:
+			return "interleaved";
+		case CODEC_BENCHMARK_CLEAR:
+			return "clear";
+		case CODEC_BENCHMARK_AVC420:
+			return "avc420";
+		default:
+			return "unknown";
+	}
+}
+
+static const char* print_time(UINT64 t, char* buffer, size_t size)
+{
+	(void)_snprintf(buffer, size, "%u.%03u.%03u.%03u", (unsigned)(t / 1000000000ull),
+	                (unsigned)((t / 1000000ull) % 1000), (unsigned)((t / 1000ull) % 1000),
+	                (unsigned)((t) % 1000));
+	return buffer;
+}
+
+static void codec_benchmark_free(codec_benchmark* bench)
+{
+	if (!bench)
+		return;
+
+	for (size_t x = 0; x < bench->count; x++)
+		free(bench->samples[x].data);
+	free(bench->samples);
+	winpr_aligned_free(bench->frame);
+
+	freerdp_bitmap_planar_context_free(bench->planar);
+	bitmap_interleaved_context_free(bench->interleaved);
+	clear_context_free(bench->clear);
+	h264_context_free(bench->h264);
+
+	const codec_benchmark empty = { 0 };
+	*bench = empty;
+}
+
+static BOOL codec_benchmark_add(codec_benchmark* bench, UINT32 codec, UINT32 left, UINT32 top,
+                                UINT32 width, UINT32 height, UINT32 bpp, const BYTE* data,
+                                UINT32 length)
+{
+	if ((codec >= CODEC_BENCHMARK_COUNT) || (width == 0) || (height == 0) || (length == 0))
+		return FALSE;
+
+	if (bench->count == bench->size)
+	{
+		const size_t size = bench->size ? bench->size * 2 : 64;
+		codec_benchmark_sample* tmp = realloc(bench->samples, size * sizeof(*tmp));
+		if (!tmp)
+			return FALSE;
+		bench->samples = tmp;
+		bench->size = size;
+	}
+
+	codec_benchmark_sample* sample = &bench->samples[bench->count];
+	sample->data = malloc(length);
+	if (!sample->data)
+		return FALSE;
+
+	memcpy(sample->data, data, length);
+	sample->codec = codec;
+	sample->left = left;
+	sample->top = top;
+	sample->width = width;
+	sample->height = height;
+	sample->bpp = bpp;
+	sample->length = length;
+	bench->count++;
+	return TRUE;
+}
+
+static BOOL codec_benchmark_load(codec_benchmark* bench, const char* path)
+{
+	BOOL rc = FALSE;
+	BYTE* buffer = NULL;
+	wStream sbuffer = { 0 };
+	FILE* fp = winpr_fopen(path, "rb");
+	if (!fp)
+		goto fail;
+
+	if (_fseeki64(fp, 0, SEEK_END) != 0)
+		goto fail;
+	const INT64 size = _ftelli64(fp);
+	if ((size <= 0) || (_fseeki64(fp, 0, SEEK_SET) != 0))
+		goto fail;
+
+	buffer = malloc((size_t)size);
+	if (!buffer || (fread(buffer, 1, (size_t)size, fp) != (size_t)size))
+		goto fail;
+
+	wStream* s = Stream_StaticConstInit(&sbuffer, buffer, (size_t)size);
+	if (!Stream_CheckAndLogRequiredLength("codec-benchmark", s, 8))
+		goto fail;
+
+	if (memcmp(Stream_ConstPointer(s), CODEC_BENCHMARK_MAGIC, 4) != 0)
+		goto fail;
+	Stream_Seek(s, 4);
+
+	const UINT32 version = Stream_Get_UINT32(s);
+	if (version != CODEC_BENCHMARK_VERSION)
+		goto fail;
+
+	while (Stream_GetRemainingLength(s) > 0)
+	{
+		if (!Stream_CheckAndLogRequiredLength("codec-benchmark", s, 28))
+			goto fail;
+
+		const UINT32 codec = Stream_Get_UINT32(s);
+		const UINT32 left = Stream_Get_UINT32(s);
+		const UINT32 top = Stream_Get_UINT32(s);
+		const UINT32 width = Stream_Get_UINT32(s);
+		const UINT32 height = Stream_Get_UINT32(s);
+		const UINT32 bpp = Stream_Get_UINT32(s);
+		const UINT32 length = Stream_Get_UINT32(s);
+
+		if (!Stream_CheckAndLogRequiredLength("codec-benchmark", s, length))
+			goto fail;
+
+		if (!codec_benchmark_add(bench, codec, left, top, width, height, bpp,
+		                         Stream_ConstPointer(s), length))
+			goto fail;
+		Stream_Seek(s, length);
+	}
+
+	rc = TRUE;
+fail:
+	if (!rc)
+		(void)fprintf(stderr, "failed to load recording %s\n", path);
+	free(buffer);
+	if (fp)
+		(void)fclose(fp);
+	return rc;
+}
+
+static BOOL codec_benchmark_save(const codec_benchmark* bench, const char* path)
+{
+	BOOL rc = FALSE;
+	size_t size = 8;
+
+	for (size_t x = 0; x < bench->count; x++)
+		size += 28ull + bench->samples[x].length;
+
+	wStream* s = Stream_New(NULL, size);
+	FILE* fp = winpr_fopen(path, "wb");
+	if (!s || !fp)
+		goto fail;
+
+	Stream_Write(s, CODEC_BENCHMARK_MAGIC, 4);
+	Stream_Write_UINT32(s, CODEC_BENCHMARK_VERSION);
+
+	for (size_t x = 0; x < bench->count; x++)
+	{
+		const codec_benchmark_sample* sample = &bench->samples[x];
+		Stream_Write_UINT32(s, sample->codec);
+		Stream_Write_UINT32(s, sample->left);
+		Stream_Write_UINT32(s, sample->top);
+		Stream_Write_UINT32(s, sample->width);
+		Stream_Write_UINT32(s, sample->height);
+		Stream_Write_UINT32(s, sample->bpp);
+		Stream_Write_UINT32(s, sample->length);
+		Stream_Write(s, sample->data, sample->length);
+	}
+
+	rc = fwrite(Stream_Buffer(s), 1, Stream_GetPosition(s), fp) == Stream_GetPosition(s);
+fail:
+	if (!rc)
+		(void)fprintf(stderr, "failed to write recording %s\n", path);
+	Stream_Free(s, TRUE);
+	if (fp)
+		(void)fclose(fp);
+	return rc;
+}
+
+/* ------------------------------------------------------------------------- */
+static UINT32 codec_benchmark_rand(UINT32* state)
+{
+	*state = *state * 1103515245u + 12345u;
+	return (*state >> 16) & 0x7FFF;
+}
+
+static void fill_rect(BYTE* data, UINT32 stride, UINT32 left, UINT32 top, UINT32 width,
+                      UINT32 height, UINT32 color)
+{
+	for (UINT32 y = top; y < top + height; y++)
+	{
+		UINT32* line = (UINT32*)&data[1ull * y * stride];
+		for (UINT32 x = left; x < left + width; x++)
+			line[x] = color;
+	}
+}
+
+/* Desktop background, a few windows with gradient title bars and lines of
+ * text-like strokes, which is what bitmap updates mostly carry. */
+static void codec_benchmark_draw_desktop(BYTE* data, UINT32 stride, UINT32 width, UINT32 height)
+{
+	UINT32 seed = 0x1234;
+
+	fill_rect(data, stride, 0, 0, width, height, 0xFF3A6EA5);
+
+	for (UINT32 w = 0; w < 4; w++)
+	{
+		const UINT32 wl = (w * width) / 6 + 16;
+		const UINT32 wt = (w * height) / 8 + 16;
+		const UINT32 ww = width / 2;
+		const UINT32 wh = height / 2;
+
+		fill_rect(data, stride, wl, wt, ww, wh, 0xFF404040);
+		fill_rect(data, stride, wl + 1, wt + 1, ww - 2, wh - 2, 0xFFF0F0F0);
+
+		for (UINT32 y = wt + 1; y < wt + 24; y++)
+		{
+			UINT32* line = (UINT32*)&data[1ull * y * stride];
+			for (UINT32 x = wl + 1; x < wl + ww - 1; x++)
+			{
+				const UINT32 v = 0x40 + ((x - wl) * 0x80) / ww;
+				line[x] = 0xFF000000 | (v << 16) | (v << 8) | 0xC0;
+			}
+		}
+
+		for (UINT32 y = wt + 32; y + 12 < wt + wh; y += 16)
+		{
+			UINT32 x = wl + 8;
+			while (x + 64 < wl + ww)
+			{
+				const UINT32 word = 16 + codec_benchmark_rand(&seed) % 48;
+				for (UINT32 gy = y; gy < y + 11; gy++)
+				{
+					UINT32* line = (UINT32*)&data[1ull * gy * stride];
+					for (UINT32 gx = x; gx < x + word; gx++)
+					{
+						if (codec_benchmark_rand(&seed) % 3 == 0)
+							line[gx] = 0xFF101010;
+					}
+				}
+				x += word + 6;
+			}
+		}
+	}
+}
+
+static BOOL codec_benchmark_encode_planar(codec_benchmark* bench, const BYTE* image, UINT32 stride,
+                                          UINT32 width, UINT32 height, DWORD flags)
+{
+	BOOL rc = FALSE;
+	const UINT32 tile = 64;
+	BITMAP_PLANAR_CONTEXT* planar = freerdp_bitmap_planar_context_new(flags, tile, tile);
+	if (!planar)
+		return FALSE;
+
+	/* decoded like RDPGFX planar surface commands, top down */
+	freerdp_planar_topdown_image(planar, TRUE);
+
+	for (UINT32 y = 0; y + tile <= height; y += tile)
+	{
+		for (UINT32 x = 0; x + tile <= width; x += tile)
+		{
+			UINT32 size = 0;
+			BYTE* data = freerdp_bitmap_compress_planar(
+			    planar, &image[1ull * y * stride + 4ull * x], PIXEL_FORMAT_BGRA32, tile, tile,
+			    stride, NULL, &size);
+			if (!data)
+				goto fail;
+
+			const BOOL added = codec_benchmark_add(bench, CODEC_BENCHMARK_PLANAR, x, y, tile, tile,
+			                                       32, data, size);
+			free(data);
+			if (!added)
+				goto fail;
+		}
+	}
+
+	rc = TRUE;
+fail:
+	freerdp_bitmap_planar_context_free(planar);
+	return rc;
+}
+
+static BOOL codec_benchmark_encode_interleaved(codec_benchmark* bench, const BYTE* image,
+                                               UINT32 stride, UINT32 width, UINT32 height,
+                                               UINT32 bpp)
+{
+	BOOL rc = FALSE;
+	const UINT32 tile = 64;
+	BYTE* buffer = malloc(tile * tile * 4ull);
+	BITMAP_INTERLEAVED_CONTEXT* interleaved = bitmap_interleaved_context_new(TRUE);
+	if (!buffer || !interleaved)
+		goto fail;
+
+	for (UINT32 y = 0; y + tile <= height; y += tile)
+	{
+		for (UINT32 x = 0; x + tile <= width; x += tile)
+		{
+			UINT32 size = tile * tile * 4;
+			if (!interleaved_compress(interleaved, buffer, &size, tile, tile, image,
+			                          PIXEL_FORMAT_BGRX32, stride, x, y, NULL, bpp))
+				goto fail;
+
+			if (!codec_benchmark_add(bench, CODEC_BENCHMARK_INTERLEAVED, x, y, tile, tile, bpp,
+			                         buffer, size))
+				goto fail;
+		}
+	}
+
+	rc = TRUE;
+fail:
+	bitmap_interleaved_context_free(interleaved);
+	free(buffer);
+	return rc;
+}
+
+static void clear_write_run_length(wStream* s, UINT32 run)
+{
+	if (run < 0xFF)
+		Stream_Write_UINT8(s, (BYTE)run);
+	else
+	{
+		Stream_Write_UINT8(s, 0xFF);
+		if (run < 0xFFFF)
+			Stream_Write_UINT16(s, (UINT16)run);
+		else
+		{
+			Stream_Write_UINT16(s, 0xFFFF);
+			Stream_Write_UINT32(s, run);
+		}
+	}
+}
+
+static void clear_write_bgr(wStream* s, UINT32 color)
+{
+	Stream_Write_UINT8(s, color & 0xFF);
+	Stream_Write_UINT8(s, (color >> 8) & 0xFF);
+	Stream_Write_UINT8(s, (color >> 16) & 0xFF);
+}
+
+/* ClearCodec residual layer: the whole tile as BGR runs in raster order */
+static size_t clear_encode_residual(wStream* s, const BYTE* image, UINT32 stride, UINT32 left,
+                                    UINT32 top, UINT32 width, UINT32 height)
+{
+	const size_t start = Stream_GetPosition(s);
+	UINT32 color = 0;
+	UINT32 run = 0;
+
+	for (UINT32 y = top; y < top + height; y++)
+	{
+		const UINT32* line = (const UINT32*)&image[1ull * y * stride];
+		for (UINT32 x = left; x < left + width; x++)
+		{
+			const UINT32 cur = line[x] & 0xFFFFFF;
+			if ((run > 0) && (cur == color))
+			{
+				run++;
+				continue;
+			}
+
+			if (run > 0)
+			{
+				clear_write_bgr(s, color);
+				clear_write_run_length(s, run);
+			}
+			color = cur;
+			run = 1;
+		}
+	}
+
+	clear_write_bgr(s, color);
+	clear_write_run_length(s, run);
+	return Stream_GetPosition(s) - start;
+}
+
+/* ClearCodec bands layer: bands of up to 52 rows, every column a short vbar
+ * cache miss holding the pixels differing from the band background. */
+static size_t clear_encode_bands(wStream* s, const BYTE* image, UINT32 stride, UINT32 left,
+                                 UINT32 top, UINT32 width, UINT32 height)
+{
+	const size_t start = Stream_GetPosition(s);
+
+	for (UINT32 by = 0; by < height; by += 52)
+	{
+		const UINT32 bh = MIN(52, height - by);
+		const UINT32 bkg = *(const UINT32*)&image[1ull * (top + by) * stride + 4ull * left] &
+		                   0xFFFFFF;
+
+		Stream_Write_UINT16(s, 0);
+		Stream_Write_UINT16(s, (UINT16)(width - 1));
+		Stream_Write_UINT16(s, (UINT16)by);
+		Stream_Write_UINT16(s, (UINT16)(by + bh - 1));
+		clear_write_bgr(s, bkg);
+
+		for (UINT32 x = left; x < left + width; x++)
+		{
+			UINT32 yOn = bh;
+			UINT32 yOff = 0;
+
+			for (UINT32 y = 0; y < bh; y++)
+			{
+				const UINT32 color =
+				    *(const UINT32*)&image[1ull * (top + by + y) * stride + 4ull * x] & 0xFFFFFF;
+				if (color != bkg)
+				{
+					yOn = MIN(yOn, y);
+					yOff = y + 1;
+				}
+			}
+
+			if (yOff == 0)
+				yOn = 0;
+
+			Stream_Write_UINT16(s, (UINT16)((yOff << 8) | yOn));
+			for (UINT32 y = yOn; y < yOff; y++)
+				clear_write_bgr(
+				    s, *(const UINT32*)&image[1ull * (top + by + y) * stride + 4ull * x]);
+		}
+	}
+
+	return Stream_GetPosition(s) - start;
+}
+
+static BOOL codec_benchmark_encode_clear(codec_benchmark* bench, const BYTE* image, UINT32 stride,
+                                         UINT32 width, UINT32 height, BOOL bands)
+{
+	BOOL rc = FALSE;
+	const UINT32 tile = 128;
+	wStream* s = Stream_New(NULL, 1024);
+	if (!s)
+		return FALSE;
+
+	for (UINT32 y = 0; y + tile <= height; y += tile)
+	{
+		for (UINT32 x = 0; x + tile <= width; x += tile)
+		{
+			/* worst case is 3 bytes color, 1 byte run and a 2 byte vbar header per pixel */
+			if (!Stream_EnsureCapacity(s, 14ull + tile * tile * 6ull))
+				goto fail;
+
+			Stream_SetPosition(s, 0);
+			Stream_Write_UINT8(s, 0); /* glyphFlags */
+			Stream_Write_UINT8(s, 0); /* seqNumber, patched when decoding */
+			Stream_Write_UINT32(s, 0);
+			Stream_Write_UINT32(s, 0);
+			Stream_Write_UINT32(s, 0);
+
+			const size_t size = bands ? clear_encode_bands(s, image, stride, x, y, tile, tile)
+			                          : clear_encode_residual(s, image, stride, x, y, tile, tile);
+			const size_t end = Stream_GetPosition(s);
+			Stream_SetPosition(s, bands ? 6 : 2);
+			Stream_Write_UINT32(s, (UINT32)size);
+			Stream_SetPosition(s, end);
+
+			if (!codec_benchmark_add(bench, CODEC_BENCHMARK_CLEAR, x, y, tile, tile, 32,
+			                         Stream_Buffer(s), (UINT32)end))
+				goto fail;
+		}
+	}
+
+	rc = TRUE;
+fail:
+	Stream_Free(s, TRUE);
+	return rc;
+}
+
+/* A window moving over the desktop, the first frame is a full IDR frame */
+static BOOL codec_benchmark_encode_avc420(codec_benchmark* bench, BYTE* image, UINT32 stride,
+                                          UINT32 width, UINT32 height)
+{
+	BOOL rc = FALSE;
+	const UINT32 frames = 30;
+	const UINT32 size = 128;
+	H264_CONTEXT* h264 = h264_context_new(TRUE);
+	if (!h264)
+	{
+		printf("No H264 encoder available, skipping synthetic avc420 samples\n");
+		return TRUE;
+	}
+
+	if (!h264_context_reset(h264, width, height))
+		goto fail;
+
+	for (UINT32 frame = 0; frame < frames; frame++)
+	{
+		RDPGFX_H264_METABLOCK meta = { 0 };
+		RECTANGLE_16 rect = { 0, 0, (UINT16)width, (UINT16)height };
+		if (frame > 0)
+		{
+			const UINT32 left = (frame * 24) % (width - size);
+			const UINT32 top = (frame * 16) % (height - size);
+			fill_rect(image, stride, left, top, size, size, 0xFF2060C0 + frame * 0x0401);
+			rect.left = (UINT16)left;
+			rect.top = (UINT16)top;
+			rect.right = (UINT16)(left + size);
+			rect.bottom = (UINT16)(top + size);
+		}
+
+		BYTE* data = NULL;
+		UINT32 length = 0;
+		const INT32 status = avc420_compress(h264, image, PIXEL_FORMAT_BGRX32, stride, width,
+		                                     height, &rect, &data, &length, &meta);
+		free_h264_metablock(&meta);
+		if (status < 0)
+			goto fail;
+		if (status == 0)
+			continue;
+
+		if (!codec_benchmark_add(bench, CODEC_BENCHMARK_AVC420, rect.left, rect.top,
+		                         rect.right - rect.left, rect.bottom - rect.top, 0, data, length))
+			goto fail;
+	}
+
+	rc = TRUE;
+fail:
+	h264_context_free(h264);
+	return rc;
+}
+
+/* ------------------------------------------------------------------------- */
+/* A hand-built H264 baseline stream for the decoder check: an IDR frame of I_PCM
+ * macroblocks followed by P frames that skip all macroblocks but two, which are
+ * replaced by new I_PCM ones. I_PCM carries the samples verbatim and deblocking is
+ * off, so the decoded picture is known exactly without a reference encoder. */
+#define AVC_PCM_WIDTH 128
+#define AVC_PCM_HEIGHT 64
+#define AVC_PCM_FRAMES 8
+#define AVC_PCM_MB_COLS (AVC_PCM_WIDTH / 16)
+#define AVC_PCM_MBS (AVC_PCM_MB_COLS * (AVC_PCM_HEIGHT / 16))
+
+typedef struct
+{
+	wStream* s;
+	BYTE cur;
+	UINT32 used;
+} avc_rbsp;
+
+static BOOL avc_put_bits(avc_rbsp* rbsp, UINT32 value, UINT32 bits)
+{
+	for (UINT32 x = bits; x > 0; x--)
+	{
+		rbsp->cur = (BYTE)((rbsp->cur << 1) | ((value >> (x - 1)) & 1));
+		if (++rbsp->used < 8)
+			continue;
+
+		if (!Stream_EnsureRemainingCapacity(rbsp->s, 1))
+			return FALSE;
+		Stream_Write_UINT8(rbsp->s, rbsp->cur);
+		rbsp->cur = 0;
+		rbsp->used = 0;
+	}
+	return TRUE;
+}
+
+/* Exp-Golomb ue(v), se(v) is only ever 0 here which codes the same */
+static BOOL avc_put_ue(avc_rbsp* rbsp, UINT32 value)
+{
+	const UINT32 code = value + 1;
+	UINT32 bits = 0;
+	while ((code >> bits) > 1)
+		bits++;
+	return avc_put_bits(rbsp, 0, bits) && avc_put_bits(rbsp, code, bits + 1);
+}
+
+static BOOL avc_put_align(avc_rbsp* rbsp)
+{
+	return (rbsp->used == 0) || avc_put_bits(rbsp, 0, 8 - rbsp->used);
+}
+
+static BOOL avc_put_trailing(avc_rbsp* rbsp)
+{
+	return avc_put_bits(rbsp, 1, 1) && avc_put_align(rbsp);
+}
+
+/* Annex B start code, NAL header and the RBSP with emulation prevention bytes */
+static BOOL avc_put_nal(wStream* s, BYTE header, const avc_rbsp* rbsp)
+{
+	const size_t length = Stream_GetPosition(rbsp->s);
+	const BYTE* data = Stream_Buffer(rbsp->s);
+	size_t zeros = 0;
+
+	if (!Stream_EnsureRemainingCapacity(s, 5 + length + length / 2))
+		return FALSE;
+
+	Stream_Write_UINT32_BE(s, 1);
+	Stream_Write_UINT8(s, header);
+	for (size_t x = 0; x < length; x++)
+	{
+		if ((zeros >= 2) && (data[x] <= 3))
+		{
+			Stream_Write_UINT8(s, 3);
+			zeros = 0;
+		}
+		Stream_Write_UINT8(s, data[x]);
+		zeros = (data[x] == 0) ? zeros + 1 : 0;
+	}
+	return TRUE;
+}
+
+static BOOL avc_pcm_mb_changed(UINT32 frame, UINT32 mb)
+{
+	if (frame == 0)
+		return TRUE;
+	return (mb == (frame * 5) % AVC_PCM_MBS) || (mb == (frame * 5 + 7) % AVC_PCM_MBS);
+}
+
+/* Applies the macroblocks written by @frame to the I420 planes */
+static void avc_pcm_draw(BYTE* planes[3], UINT32 frame)
+{
+	for (UINT32 mb = 0; mb < AVC_PCM_MBS; mb++)
+	{
+		if (!avc_pcm_mb_changed(frame, mb))
+			continue;
+
+		const UINT32 mbx = (mb % AVC_PCM_MB_COLS) * 16;
+		const UINT32 mby = (mb / AVC_PCM_MB_COLS) * 16;
+		for (UINT32 y = mby; y < mby + 16; y++)
+		{
+			for (UINT32 x = mbx; x < mbx + 16; x++)
+				planes[0][y * AVC_PCM_WIDTH + x] = (BYTE)(16 + (x * 3 + y * 5 + frame * 37) % 220);
+		}
+		for (UINT32 y = mby / 2; y < mby / 2 + 8; y++)
+		{
+			for (UINT32 x = mbx / 2; x < mbx / 2 + 8; x++)
+			{
+				planes[1][y * AVC_PCM_WIDTH / 2 + x] =
+				    (BYTE)(16 + (x * 7 + y * 2 + frame * 53) % 225);
+				planes[2][y * AVC_PCM_WIDTH / 2 + x] =
+				    (BYTE)(16 + (x * 2 + y * 9 + frame * 17) % 225);
+			}
+		}
+	}
+}
+
+static BOOL avc_put_pcm_mb(avc_rbsp* rbsp, BYTE* planes[3], UINT32 mb, UINT32 mb_type)
+{
+	const UINT32 mbx = (mb % AVC_PCM_MB_COLS) * 16;
+	const UINT32 mby = (mb / AVC_PCM_MB_COLS) * 16;
+
+	if (!avc_put_ue(rbsp, mb_type) || !avc_put_align(rbsp))
+		return FALSE;
+	if (!Stream_EnsureRemainingCapacity(rbsp->s, 384))
+		return FALSE;
+
+	for (UINT32 y = mby; y < mby + 16; y++)
+		Stream_Write(rbsp->s, &planes[0][y * AVC_PCM_WIDTH + mbx], 16);
+	for (size_t p = 1; p < 3; p++)
+	{
+		for (UINT32 y = mby / 2; y < mby / 2 + 8; y++)
+			Stream_Write(rbsp->s, &planes[p][y * AVC_PCM_WIDTH / 2 + mbx / 2], 8);
+	}
+	return TRUE;
+}
+
+static BOOL avc_put_parameter_sets(wStream* s, avc_rbsp* rbsp)
+{
+	/* SPS: constrained baseline, level 3.0, 4 bit frame_num, POC type 2 (output in
+	 * decoding order), one reference frame, frame_mbs_only and direct_8x8_inference,
+	 * no cropping and no VUI */
+	Stream_SetPosition(rbsp->s, 0);
+	if (!avc_put_bits(rbsp, 66, 8) || !avc_put_bits(rbsp, 0xC0, 8) || !avc_put_bits(rbsp, 30, 8) ||
+	    !avc_put_ue(rbsp, 0) || !avc_put_ue(rbsp, 0) || !avc_put_ue(rbsp, 2) ||
+	    !avc_put_ue(rbsp, 1) || !avc_put_bits(rbsp, 0, 1) ||
+	    !avc_put_ue(rbsp, AVC_PCM_MB_COLS - 1) || !avc_put_ue(rbsp, AVC_PCM_HEIGHT / 16 - 1) ||
+	    !avc_put_bits(rbsp, 0xC, 4) || !avc_put_trailing(rbsp) || !avc_put_nal(s, 0x67, rbsp))
+		return FALSE;
+
+	/* PPS: CAVLC, no slice groups, QP 26, deblocking control in the slice header */
+	Stream_SetPosition(rbsp->s, 0);
+	return avc_put_ue(rbsp, 0) && avc_put_ue(rbsp, 0) && avc_put_bits(rbsp, 0, 2) &&
+	       avc_put_ue(rbsp, 0) && avc_put_ue(rbsp, 0) && avc_put_ue(rbsp, 0) &&
+	       avc_put_bits(rbsp, 0, 3) && avc_put_ue(rbsp, 0) && avc_put_ue(rbsp, 0) &&
+	       avc_put_ue(rbsp, 0) && avc_put_bits(rbsp, 0x4, 3) && avc_put_trailing(rbsp) &&
+	       avc_put_nal(s, 0x68, rbsp);
+}
+
+static BOOL avc_put_slice(wStream* s, avc_rbsp* rbsp, BYTE* planes[3], UINT32 frame)
+{
+	const BOOL idr = (frame == 0);
+	UINT32 skip = 0;
+
+	Stream_SetPosition(rbsp->s, 0);
+	if (!avc_put_ue(rbsp, 0) || !avc_put_ue(rbsp, idr ? 7 : 5) || !avc_put_ue(rbsp, 0) ||
+	    !avc_put_bits(rbsp, frame, 4))
+		return FALSE;
+	if (idr)
+	{
+		/* idr_pic_id, no_output_of_prior_pics_flag, long_term_reference_flag */
+		if (!avc_put_ue(rbsp, 0) || !avc_put_bits(rbsp, 0, 2))
+			return FALSE;
+	}
+	else
+	{
+		/* num_ref_idx_active_override_flag, ref_pic_list_modification_flag_l0,
+		 * adaptive_ref_pic_marking_mode_flag */
+		if (!avc_put_bits(rbsp, 0, 3))
+			return FALSE;
+	}
+	/* slice_qp_delta, disable_deblocking_filter_idc = 1 */
+	if (!avc_put_ue(rbsp, 0) || !avc_put_ue(rbsp, 1))
+		return FALSE;
+
+	for (UINT32 mb = 0; mb < AVC_PCM_MBS; mb++)
+	{
+		if (!avc_pcm_mb_changed(frame, mb))
+		{
+			skip++;
+			continue;
+		}
+		/* P slices code a skip run before every coded macroblock, I_PCM is mb_type 25 in
+		 * I slices and 5 + 25 in P slices */
+		if (!idr && !avc_put_ue(rbsp, skip))
+			return FALSE;
+		if (!avc_put_pcm_mb(rbsp, planes, mb, idr ? 25 : 30))
+			return FALSE;
+		skip = 0;
+	}
+	if ((skip > 0) && !avc_put_ue(rbsp, skip))
+		return FALSE;
+
+	return avc_put_trailing(rbsp) && avc_put_nal(s, idr ? 0x65 : 0x41, rbsp);
+}
+
+static BOOL codec_benchmark_encode_avc420_pcm(codec_benchmark* bench)
+{
+	BOOL rc = FALSE;
+	BYTE* planes[3] = { calloc(AVC_PCM_WIDTH, AVC_PCM_HEIGHT),
+		                calloc(AVC_PCM_WIDTH / 2, AVC_PCM_HEIGHT / 2),
+		                calloc(AVC_PCM_WIDTH / 2, AVC_PCM_HEIGHT / 2) };
+	avc_rbsp rbsp = { Stream_New(NULL, 1024), 0, 0 };
+	wStream* s = Stream_New(NULL, 1024);
+	if (!planes[0] || !planes[1] || !planes[2] || !rbsp.s || !s)
+		goto fail;
+
+	for (UINT32 frame = 0; frame < AVC_PCM_FRAMES; frame++)
+	{
+		avc_pcm_draw(planes, frame);
+
+		Stream_SetPosition(s, 0);
+		if ((frame == 0) && !avc_put_parameter_sets(s, &rbsp))
+			goto fail;
+		if (!avc_put_slice(s, &rbsp, planes, frame))
+			goto fail;
+
+		if (!codec_benchmark_add(bench, CODEC_BENCHMARK_AVC420, 0, 0, AVC_PCM_WIDTH,
+		                         AVC_PCM_HEIGHT, 0, Stream_Buffer(s),
+		                         (UINT32)Stream_GetPosition(s)))
+			goto fail;
+	}
+
+	rc = TRUE;
+fail:
+	Stream_Free(s, TRUE);
+	Stream_Free(rbsp.s, TRUE);
+	for (size_t x = 0; x < 3; x++)
+		free(planes[x]);
+	return rc;
+}
+
+static BOOL codec_benchmark_synthesize(codec_benchmark* bench)
+{
+	BOOL rc = FALSE;
+	const UINT32 width = 1024;
+	const UINT32 height = 768;
+	const UINT32 stride = width * 4;
+	BYTE* image = winpr_aligned_malloc(1ull * stride * height, 16);
+	if (!image)
+		return FALSE;
+
+	codec_benchmark_draw_desktop(image, stride, width, height);
+
+	if (!codec_benchmark_encode_planar(bench, image, stride, width, height,
+	                                   PLANAR_FORMAT_HEADER_RLE | PLANAR_FORMAT_HEADER_NA))
+		goto fail;
+	if (!codec_benchmark_encode_planar(bench, image, stride, width, height,
+	                                   PLANAR_FORMAT_HEADER_RLE))
+		goto fail;
+	if (!codec_benchmark_encode_planar(bench, image, stride, width, height,
+	                                   PLANAR_FORMAT_HEADER_NA))
+		goto fail;
+
+	for (size_t x = 0; x < 3; x++)
+	{
+		const UINT32 bpp[] = { 24, 16, 15 };
+		if (!codec_benchmark_encode_interleaved(bench, image, stride, width, height, bpp[x]))
+			goto fail;
+	}
+
+	if (!codec_benchmark_encode_clear(bench, image, stride, width, height, FALSE))
+		goto fail;
+	if (!codec_benchmark_encode_clear(bench, image, stride, width, height, TRUE))
+		goto fail;
+
+	if (!codec_benchmark_encode_avc420(bench, image, stride, width, height))
+		goto fail;
+
+	rc = TRUE;
+fail:
+	winpr_aligned_free(image);
+	return rc;
+}
+
+/* ------------------------------------------------------------------------- */
+static BOOL codec_benchmark_init(codec_benchmark* bench)
+{
+	UINT32 maxWidth = 0;
+	UINT32 maxHeight = 0;
+
+	for (size_t x = 0; x < bench->count; x++)
+	{
+		const codec_benchmark_sample* sample = &bench->samples[x];
+		bench->width = MAX(bench->width, sample->left + sample->width);
+		bench->height = MAX(bench->height, sample->top + sample->height);
+		maxWidth = MAX(maxWidth, sample->width);
+		maxHeight = MAX(maxHeight, sample->height);
+	}
+
+	if (bench->format == 0)
+		bench->format = PIXEL_FORMAT_BGRX32;
+	bench->stride = bench->width * FreeRDPGetBytesPerPixel(bench->format);
+	bench->frame = winpr_aligned_calloc(bench->stride, bench->height, 16);
+	bench->planar = freerdp_bitmap_planar_context_new(0, maxWidth, maxHeight);
+	bench->interleaved = bitmap_interleaved_context_new(FALSE);
+	bench->clear = clear_context_new(FALSE);
+	if (!bench->frame || !bench->planar || !bench->interleaved || !bench->clear)
+		return FALSE;
+
+	for (size_t x = 0; x < bench->count; x++)
+	{
+		if (bench->samples[x].codec != CODEC_BENCHMARK_AVC420)
+			continue;
+
+		/* Prefers a registered platform decoder backend, then the built-in ones */
+		bench->h264 = h264_context_new(FALSE);
+		if (!bench->h264)
+			printf("No H264 decoder available, skipping avc420 samples\n");
+		break;
+	}
+
+	bench->palette.format = bench->format;
+	for (UINT32 x = 0; x < ARRAYSIZE(bench->palette.palette); x++)
+		bench->palette.palette[x] = FreeRDPGetColor(bench->format, (BYTE)x, (BYTE)x, (BYTE)x, 0xFF);
+
+	return TRUE;
+}
+
+static BOOL codec_benchmark_decode(codec_benchmark* bench, codec_benchmark_sample* sample)
+{
+	/* Bitmap updates are decoded at their origin, like the gdi does */
+	BYTE* origin = &bench->frame[1ull * sample->top * bench->stride +
+	                             1ull * sample->left * FreeRDPGetBytesPerPixel(bench->format)];
+
+	switch (sample->codec)
+	{
+		case CODEC_BENCHMARK_PLANAR:
+			return planar_decompress(bench->planar, sample->data, sample->length, sample->width,
+			                         sample->height, origin, bench->format, bench->stride, 0, 0,
+			                         sample->width, sample->height, FALSE);
+
+		case CODEC_BENCHMARK_INTERLEAVED:
+			return interleaved_decompress(bench->interleaved, sample->data, sample->length,
+			                              sample->width, sample->height, sample->bpp, origin,
+			                              bench->format, bench->stride, 0, 0, sample->width,
+			                              sample->height, &bench->palette);
+
+		case CODEC_BENCHMARK_CLEAR:
+			/* Recordings are replayed repeatedly, keep the sequence numbers in order. */
+			sample->data[1] = bench->clearSeq++;
+			return clear_decompress(bench->clear, sample->data, sample->length, sample->width,
+			                        sample->height, bench->frame, bench->format, bench->stride,
+			                        sample->left, sample->top, bench->width, bench->height,
+			                        &bench->palette) >= 0;
+
+		case CODEC_BENCHMARK_AVC420:
+		{
+			const RECTANGLE_16 rect = { (UINT16)sample->left, (UINT16)sample->top,
+				                        (UINT16)(sample->left + sample->width),
+				                        (UINT16)(sample->top + sample->height) };
+			return avc420_decompress(bench->h264, sample->data, sample->length, bench->frame,
+			                         bench->format, bench->stride, bench->width, bench->height,
+			                         &rect, 1) >= 0;
+		}
+
+		default:
+			return FALSE;
+	}
+}
+
+/* FNV-1a of the frame, to compare the output of different implementations */
+static UINT64 codec_benchmark_hash(const codec_benchmark* bench)
+{
+	UINT64 hash = 14695981039346656037ull;
+	const size_t size = 1ull * bench->stride * bench->height;
+
+	for (size_t x = 0; x < size; x++)
+	{
+		hash ^= bench->frame[x];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static BOOL codec_benchmark_run(codec_benchmark* bench, UINT32 codec, size_t iterations)
+{
+	UINT64 best = UINT64_MAX;
+	UINT64 pixels = 0;
+	size_t samples = 0;
+
+	for (size_t x = 0; x < bench->count; x++)
+	{
+		if (bench->samples[x].codec != codec)
+			continue;
+		/* every H264 access unit is decoded to a full frame */
+		if (codec == CODEC_BENCHMARK_AVC420)
+			pixels += 1ull * bench->width * bench->height;
+		else
+			pixels += 1ull * bench->samples[x].width * bench->samples[x].height;
+		samples++;
+	}
+
+	if (samples == 0)
+		return TRUE;
+
+	if ((codec == CODEC_BENCHMARK_AVC420) && !bench->h264)
+		return TRUE;
+
+	memset(bench->frame, 0, 1ull * bench->stride * bench->height);
+
+	for (size_t i = 0; i < iterations; i++)
+	{
+		/* H264 samples depend on each other, every run starts over with a fresh decoder */
+		if ((codec == CODEC_BENCHMARK_AVC420) &&
+		    !h264_context_reset(bench->h264, bench->width, bench->height))
+			return FALSE;
+
+		const UINT64 start = winpr_GetTickCount64NS();
+		for (size_t x = 0; x < bench->count; x++)
+		{
+			codec_benchmark_sample* sample = &bench->samples[x];
+			if (sample->codec != codec)
+				continue;
+
+			if (!codec_benchmark_decode(bench, sample))
+			{
+				(void)fprintf(stderr, "%s: decoding sample %" PRIuz " failed\n",
+				              codec_benchmark_name(codec), x);
+				return FALSE;
+			}
+		}
+		const UINT64 end = winpr_GetTickCount64NS();
+
+		const UINT64 diff = end - start;
+		if (diff < best)
+			best = diff;
+	}
+
+	char buffer[32] = { 0 };
+	const double mpix = (1000.0 * (double)pixels) / (double)MAX(best, 1);
+	printf("%-12s %6" PRIuz " bitmaps best of %" PRIuz " took %sns, %8.2f MPixel/s, hash %016" PRIx64
+	       "\n",
+	       codec_benchmark_name(codec), samples, iterations, print_time(best, buffer, sizeof(buffer)),
+	       mpix, codec_benchmark_hash(bench));
+	return TRUE;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Decoder backends for -check-h264: one that is never usable, so contexts have to fall
+ * back to the next one, and a reference that returns the pictures the I_PCM stream
+ * carries. Decoding the stream with a built-in decoder must give the same frame. */
+typedef struct
+{
+	UINT32 created;
+	UINT32 decoded;
+} avc_check_counters;
+
+typedef struct
+{
+	avc_check_counters* counters;
+	UINT32 frame;
+	BYTE* planes[3];
+} avc_reference_decoder;
+
+static void* avc_unusable_new(void* userdata, WINPR_ATTR_UNUSED UINT32 width,
+                              WINPR_ATTR_UNUSED UINT32 height)
+{
+	avc_check_counters* counters = userdata;
+	counters->created++;
+	return NULL;
+}
+
+static void avc_unusable_free(WINPR_ATTR_UNUSED void* handle)
+{
+}
+
+static INT32 avc_unusable_decode(WINPR_ATTR_UNUSED void* handle,
+                                 WINPR_ATTR_UNUSED const BYTE* pSrcData,
+                                 WINPR_ATTR_UNUSED UINT32 SrcSize,
+                                 WINPR_ATTR_UNUSED BYTE* pYUVData[3],
+                                 WINPR_ATTR_UNUSED UINT32 iStride[3])
+{
+	return -1;
+}
+
+static void avc_reference_free(void* handle)
+{
+	avc_reference_decoder* dec = handle;
+	if (!dec)
+		return;
+	for (size_t x = 0; x < 3; x++)
+		free(dec->planes[x]);
+	free(dec);
+}
+
+static void* avc_reference_new(void* userdata, WINPR_ATTR_UNUSED UINT32 width,
+                               WINPR_ATTR_UNUSED UINT32 height)
+{
+	avc_reference_decoder* dec = calloc(1, sizeof(avc_reference_decoder));
+	if (!dec)
+		return NULL;
+
+	dec->counters = userdata;
+	dec->planes[0] = calloc(AVC_PCM_WIDTH, AVC_PCM_HEIGHT);
+	dec->planes[1] = calloc(AVC_PCM_WIDTH / 2, AVC_PCM_HEIGHT / 2);
+	dec->planes[2] = calloc(AVC_PCM_WIDTH / 2, AVC_PCM_HEIGHT / 2);
+	if (!dec->planes[0] || !dec->planes[1] || !dec->planes[2])
+	{
+		avc_reference_free(dec);
+		return NULL;
+	}
+	dec->counters->created++;
+	return dec;
+}
+
+static INT32 avc_reference_decode(void* handle, WINPR_ATTR_UNUSED const BYTE* pSrcData,
+                                  WINPR_ATTR_UNUSED UINT32 SrcSize, BYTE* pYUVData[3],
+                                  UINT32 iStride[3])
+{
+	avc_reference_decoder* dec = handle;
+	if (dec->frame >= AVC_PCM_FRAMES)
+		return -1;
+
+	avc_pcm_draw(dec->planes, dec->frame++);
+	dec->counters->decoded++;
+	for (size_t x = 0; x < 3; x++)
+	{
+		pYUVData[x] = dec->planes[x];
+		iStride[x] = (x == 0) ? AVC_PCM_WIDTH : AVC_PCM_WIDTH / 2;
+	}
+	return 1;
+}
+
+static BOOL codec_benchmark_check(BOOL condition, const char* what)
+{
+	printf("%s: %s\n", condition ? "ok" : "FAILED", what);
+	return condition;
+}
+
+/* Registers the check backends, decodes the I_PCM stream through them, then again with
+ * the built-in decoder if there is one and compares the frames. */
+static BOOL codec_benchmark_check_h264(size_t iterations)
+{
+	BOOL rc = FALSE;
+	BOOL registered = FALSE;
+	codec_benchmark bench = { 0 };
+	avc_check_counters unusable = { 0 };
+	avc_check_counters reference = { 0 };
+	const H264_DECODER_BACKEND backends[] = {
+		{ "benchmark-unusable", avc_unusable_new, avc_unusable_free, avc_unusable_decode,
+		  &unusable },
+		{ "benchmark-reference", avc_reference_new, avc_reference_free, avc_reference_decode,
+		  &reference }
+	};
+
+	if (!codec_benchmark_encode_avc420_pcm(&bench))
+		goto fail;
+
+	registered = h264_register_decoder_backend(&backends[0]) &&
+	             h264_register_decoder_backend(&backends[1]);
+	if (!codec_benchmark_check(registered, "register decoder backends"))
+		goto fail;
+	if (!codec_benchmark_check(!h264_register_decoder_backend(&backends[1]),
+	                           "reject a second backend with the same name"))
+		goto fail;
+
+	if (!codec_benchmark_init(&bench) ||
+	    !codec_benchmark_check(bench.h264 != NULL, "create a decoder context with backends"))
+		goto fail;
+	if (!codec_benchmark_run(&bench, CODEC_BENCHMARK_AVC420, iterations))
+		goto fail;
+	const UINT64 expected = codec_benchmark_hash(&bench);
+
+	if (!codec_benchmark_check(unusable.created > 0, "try the unusable backend first") ||
+	    !codec_benchmark_check(reference.created > 0, "fall back to the reference backend") ||
+	    !codec_benchmark_check(reference.decoded == AVC_PCM_FRAMES * iterations,
+	                           "decode every access unit with the reference backend"))
+		goto fail;
+
+	registered = FALSE;
+	if (!codec_benchmark_check(h264_unregister_decoder_backend(backends[0].name) &&
+	                               h264_unregister_decoder_backend(backends[1].name) &&
+	                               !h264_unregister_decoder_backend(backends[1].name),
+	                           "unregister decoder backends"))
+		goto fail;
+
+	h264_context_free(bench.h264);
+	bench.h264 = h264_context_new(FALSE);
+	if (!bench.h264)
+	{
+		printf("skipped: no built-in H264 decoder to check the bitstream with\n");
+		rc = TRUE;
+		goto fail;
+	}
+
+	reference.created = 0;
+	if (!codec_benchmark_run(&bench, CODEC_BENCHMARK_AVC420, iterations))
+		goto fail;
+	if (!codec_benchmark_check(reference.created == 0, "built-in decoder without backends") ||
+	    !codec_benchmark_check(codec_benchmark_hash(&bench) == expected,
+	                           "built-in decoder output matches the I_PCM pictures"))
+		goto fail;
+
+	rc = TRUE;
+fail:
+	if (registered)
+	{
+		h264_unregister_decoder_backend(backends[0].name);
+		h264_unregister_decoder_backend(backends[1].name);
+	}
+	codec_benchmark_free(&bench);
+	return rc;
+}
+
+static const struct
+{
+	const char* name;
+	UINT32 format;
+} codec_benchmark_formats[] = { { "bgrx32", PIXEL_FORMAT_BGRX32 },
+	                            { "bgr24", PIXEL_FORMAT_BGR24 },
+	                            { "rgb16", PIXEL_FORMAT_RGB16 },
+	                            { "rgb15", PIXEL_FORMAT_RGB15 } };
+
+static UINT32 codec_benchmark_format(const char* name)
+{
+	for (size_t x = 0; x < ARRAYSIZE(codec_benchmark_formats); x++)
+	{
+		if (_stricmp(codec_benchmark_formats[x].name, name) == 0)
+			return codec_benchmark_formats[x].format;
+	}
+	return 0;
+}
+
+static void codec_benchmark_usage(const char* name)
+{
+	printf("Usage: %s [-generic] [-iterations <n>] [-format <fmt>] [-record <file>] "
+	       "[-check-h264] [recording ...]\n",
+	       name);
+	printf("  -generic         use the generic primitives instead of the optimized ones\n");
+	printf("  -iterations <n>  decode every bitmap n times and report the best run\n");
+	printf("  -format <fmt>    decode to bgrx32 (default), bgr24, rgb16 or rgb15\n");
+	printf("  -record <file>   write the synthetic bitmaps to a recording file\n");
+	printf("  -check-h264      check the H264 decoder backends and the built-in decoder\n");
+}
+
+int main(int argc, char* argv[])
+{
+	int rc = -1;
+	size_t iterations = 20;
+	const char* record = NULL;
+	BOOL checkH264 = FALSE;
+	primitive_hints hints = PRIMITIVES_AUTODETECT;
+	codec_benchmark bench = { 0 };
+
+	for (int x = 1; x < argc; x++)
+	{
+		const char* arg = argv[x];
+
+		if (strcmp(arg, "-generic") == 0)
+			hints = PRIMITIVES_PURE_SOFT;
+		else if ((strcmp(arg, "-iterations") == 0) && (x + 1 < argc))
+		{
+			const unsigned long val = strtoul(argv[++x], NULL, 0);
+			iterations = MAX(val, 1);
+		}
+		else if ((strcmp(arg, "-format") == 0) && (x + 1 < argc))
+		{
+			bench.format = codec_benchmark_format(argv[++x]);
+			if (bench.format == 0)
+			{
+				(void)fprintf(stderr, "unknown format %s\n", argv[x]);
+				goto fail;
+			}
+		}
+		else if ((strcmp(arg, "-record") == 0) && (x + 1 < argc))
+			record = argv[++x];
+		else if (strcmp(arg, "-check-h264") == 0)
+			checkH264 = TRUE;
+		else if (arg[0] == '-')
+		{
+			codec_benchmark_usage(argv[0]);
+			return (strcmp(arg, "-help") == 0) ? 0 : -1;
+		}
+		else if (!codec_benchmark_load(&bench, arg))
+			goto fail;
+	}
+
+	/* The codecs pick up primitives_get(), the hint must be set before first use. */
+	primitives_set_hints(hints);
+	printf("Using %s primitives\n", primtives_hint_str(hints));
+	if (bench.format != 0)
+		printf("Decoding to %s\n", FreeRDPGetColorFormatName(bench.format));
+
+	if (checkH264)
+	{
+		rc = codec_benchmark_check_h264(iterations) ? 0 : -1;
+		goto fail;
+	}
+
+	if ((bench.count == 0) && !codec_benchmark_synthesize(&bench))
+	{
+		(void)fprintf(stderr, "failed to create synthetic bitmaps\n");
+		goto fail;
+	}
+
+	if (record && !codec_benchmark_save(&bench, record))
+		goto fail;
+
+	if (!codec_benchmark_init(&bench))
+	{
+		(void)fprintf(stderr, "failed to allocate codec benchmark contexts\n");
+		goto fail;
+	}
+
+	for (UINT32 codec = 0; codec < CODEC_BENCHMARK_COUNT; codec++)
+	{
+		if (!codec_benchmark_run(&bench, codec, iterations))
+			goto fail;
+	}
+
+	rc = 0;
+fail:
+	codec_benchmark_free(&bench);
+	return rc;
+}
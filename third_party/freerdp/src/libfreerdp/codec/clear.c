@@ -23,10 +23,12 @@
 
 #include <winpr/crt.h>
 #include <winpr/print.h>
+#include <winpr/assert.h>
 #include <winpr/bitstream.h>
 
 #include <freerdp/codec/color.h>
 #include <freerdp/codec/clear.h>
+#include <freerdp/primitives.h>
 #include <freerdp/log.h>
 
 #define TAG FREERDP_TAG("codec.clear")
@@ -113,6 +115,60 @@ static void clear_reset_glyph_cache(CLEAR_CONTEXT* WINPR_RESTRICT clear)
 	ZeroMemory(clear->GlyphCache, sizeof(clear->GlyphCache));
 }
 
+/* Writes count pixels of color, returns the number of bytes written */
+static INLINE size_t clear_write_color_run(const primitives_t* WINPR_RESTRICT prims,
+                                           BYTE* WINPR_RESTRICT dst, UINT32 format, UINT32 color,
+                                           UINT32 count)
+{
+	BYTE pixel[4] = { 0 };
+	const UINT32 bpp = FreeRDPGetBytesPerPixel(format);
+
+	if (count == 0)
+		return 0;
+
+	FreeRDPWriteColor(pixel, format, color);
+	prims->rleExpand_8u(pixel, bpp, dst, count);
+	return 1ull * count * bpp;
+}
+
+/* Writes a run of an RLEX bitmap starting at (*px, *py), wrapping at width and
+ * clipping against the destination size. */
+static INLINE void clear_write_rlex_run(const primitives_t* WINPR_RESTRICT prims,
+                                        BYTE* WINPR_RESTRICT pDstData, UINT32 DstFormat,
+                                        UINT32 nDstStep, UINT32 nXDstRel, UINT32 nYDstRel,
+                                        UINT32 nDstWidth, UINT32 nDstHeight, UINT32 width,
+                                        UINT32 color, UINT32 count, UINT32* WINPR_RESTRICT px,
+                                        UINT32* WINPR_RESTRICT py)
+{
+	const UINT32 bpp = FreeRDPGetBytesPerPixel(DstFormat);
+	UINT32 x = *px;
+	UINT32 y = *py;
+
+	while (count > 0)
+	{
+		const UINT32 run = MIN(count, width - x);
+
+		if ((nYDstRel + y < nDstHeight) && (nXDstRel + x < nDstWidth))
+		{
+			const UINT32 visible = MIN(run, nDstWidth - (nXDstRel + x));
+			BYTE* pTmpData = &pDstData[(nXDstRel + x) * bpp + (nYDstRel + y) * nDstStep];
+			clear_write_color_run(prims, pTmpData, DstFormat, color, visible);
+		}
+
+		count -= run;
+		x += run;
+
+		if (x >= width)
+		{
+			y++;
+			x = 0;
+		}
+	}
+
+	*px = x;
+	*py = y;
+}
+
 static BOOL convert_color(BYTE* WINPR_RESTRICT dst, UINT32 nDstStep, UINT32 DstFormat, UINT32 nXDst,
                           UINT32 nYDst, UINT32 nWidth, UINT32 nHeight,
                           const BYTE* WINPR_RESTRICT src, UINT32 nSrcStep, UINT32 SrcFormat,
@@ -165,6 +221,7 @@ static BOOL clear_decompress_subcode_rlex(wStream* WINPR_RESTRICT s, UINT32 bitm
 	BYTE suiteDepth = 0;
 	BYTE paletteCount = 0;
 	UINT32 palette[128] = { 0 };
+	const primitives_t* prims = primitives_get();
 
 	if (!Stream_CheckAndLogRequiredLength(TAG, s, bitmapDataByteCount))
 		return FALSE;
@@ -265,20 +322,8 @@ static BOOL clear_decompress_subcode_rlex(wStream* WINPR_RESTRICT s, UINT32 bitm
 			return FALSE;
 		}
 
-		for (UINT32 i = 0; i < runLengthFactor; i++)
-		{
-			BYTE* pTmpData = &pDstData[(nXDstRel + x) * FreeRDPGetBytesPerPixel(DstFormat) +
-			                           (nYDstRel + y) * nDstStep];
-
-			if ((nXDstRel + x < nDstWidth) && (nYDstRel + y < nDstHeight))
-				FreeRDPWriteColor(pTmpData, DstFormat, color);
-
-			if (++x >= width)
-			{
-				y++;
-				x = 0;
-			}
-		}
+		clear_write_rlex_run(prims, pDstData, DstFormat, nDstStep, nXDstRel, nYDstRel, nDstWidth,
+		                     nDstHeight, width, color, runLengthFactor, &x, &y);
 
 		pixelIndex += runLengthFactor;
 
@@ -366,6 +411,7 @@ static BOOL clear_decompress_residual_data(CLEAR_CONTEXT* WINPR_RESTRICT clear,
 	BYTE* dstBuffer = NULL;
 	UINT32 pixelIndex = 0;
 	UINT32 pixelCount = 0;
+	const primitives_t* prims = primitives_get();
 
 	if (!Stream_CheckAndLogRequiredLength(TAG, s, residualByteCount))
 		return FALSE;
@@ -424,12 +470,7 @@ static BOOL clear_decompress_residual_data(CLEAR_CONTEXT* WINPR_RESTRICT clear,
 			return FALSE;
 		}
 
-		for (UINT32 i = 0; i < runLengthFactor; i++)
-		{
-			FreeRDPWriteColor(dstBuffer, clear->format, color);
-			dstBuffer += FreeRDPGetBytesPerPixel(clear->format);
-		}
-
+		dstBuffer += clear_write_color_run(prims, dstBuffer, clear->format, color, runLengthFactor);
 		pixelIndex += runLengthFactor;
 	}
 
@@ -596,6 +637,12 @@ static BOOL clear_decompress_bands_data(CLEAR_CONTEXT* WINPR_RESTRICT clear,
                                         UINT32 nDstWidth, UINT32 nDstHeight)
 {
 	UINT32 suboffset = 0;
+	const primitives_t* prims = primitives_get();
+	const UINT32 bpp = FreeRDPGetBytesPerPixel(clear->format);
+	const UINT32 dstBpp = FreeRDPGetBytesPerPixel(DstFormat);
+	/* The vbar storage uses the destination format, see updateContextFormat. With 8 bits per
+	 * channel the vbar pixels can be copied as is, the 15/16bpp conversion does not round trip. */
+	const BOOL copyVBar = (clear->format == DstFormat) && (bpp >= 3);
 
 	if (!Stream_CheckAndLogRequiredLength(TAG, s, bandsByteCount))
 		return FALSE;
@@ -793,14 +840,7 @@ static BOOL clear_decompress_bands_data(CLEAR_CONTEXT* WINPR_RESTRICT clear,
 				if ((y + count) > vBarPixelCount)
 					count = (vBarPixelCount > y) ? (vBarPixelCount - y) : 0;
 
-				if (count > 0)
-				{
-					while (count--)
-					{
-						FreeRDPWriteColor(dstBuffer, clear->format, colorBkg);
-						dstBuffer += FreeRDPGetBytesPerPixel(clear->format);
-					}
-				}
+				dstBuffer += clear_write_color_run(prims, dstBuffer, clear->format, colorBkg, count);
 
 				/*
 				 * if ((y >= vBarYOn) && (y < (vBarYOn + vBarShortPixelCount))),
@@ -823,32 +863,17 @@ static BOOL clear_decompress_bands_data(CLEAR_CONTEXT* WINPR_RESTRICT clear,
 						return FALSE;
 					}
 				}
-				for (size_t x = 0; x < count; x++)
+				if (count > 0)
 				{
-					UINT32 color = 0;
-					color = FreeRDPReadColor(&pSrcPixel[x * FreeRDPGetBytesPerPixel(clear->format)],
-					                         clear->format);
-
-					if (!FreeRDPWriteColor(dstBuffer, clear->format, color))
-						return FALSE;
-
-					dstBuffer += FreeRDPGetBytesPerPixel(clear->format);
+					memcpy(dstBuffer, pSrcPixel, 1ull * count * bpp);
+					dstBuffer += 1ull * count * bpp;
 				}
 
 				/* if (y >= (vBarYOn + vBarShortPixelCount)), use colorBkg */
 				y = vBarYOn + vBarShortPixelCount;
 				count = (vBarPixelCount > y) ? (vBarPixelCount - y) : 0;
 
-				if (count > 0)
-				{
-					while (count--)
-					{
-						if (!FreeRDPWriteColor(dstBuffer, clear->format, colorBkg))
-							return FALSE;
-
-						dstBuffer += FreeRDPGetBytesPerPixel(clear->format);
-					}
-				}
+				dstBuffer += clear_write_color_run(prims, dstBuffer, clear->format, colorBkg, count);
 
 				vBarEntry->count = vBarPixelCount;
 				clear->VBarStorageCursor = (clear->VBarStorageCursor + 1) % CLEARCODEC_VBAR_SIZE;
@@ -878,21 +903,27 @@ static BOOL clear_decompress_bands_data(CLEAR_CONTEXT* WINPR_RESTRICT clear,
 				if (nXDstRel + i > nDstWidth)
 					return FALSE;
 
+				if ((count > 0) && (nYDstRel + count - 1 > nDstHeight))
+					return FALSE;
+
+				BYTE* pDstPixel8 =
+				    &pDstData[(1ull * nYDstRel * nDstStep) + ((nXDstRel + i) * dstBpp)];
+
 				for (UINT32 y = 0; y < count; y++)
 				{
-					if (nYDstRel + y > nDstHeight)
-						return FALSE;
-
-					BYTE* pDstPixel8 =
-					    &pDstData[((nYDstRel + y) * nDstStep) +
-					              ((nXDstRel + i) * FreeRDPGetBytesPerPixel(DstFormat))];
-					UINT32 color = FreeRDPReadColor(cpSrcPixel, clear->format);
-					color = FreeRDPConvertColor(color, clear->format, DstFormat, NULL);
+					if (copyVBar)
+						memcpy(pDstPixel8, cpSrcPixel, bpp);
+					else
+					{
+						UINT32 color = FreeRDPReadColor(cpSrcPixel, clear->format);
+						color = FreeRDPConvertColor(color, clear->format, DstFormat, NULL);
 
-					if (!FreeRDPWriteColor(pDstPixel8, DstFormat, color))
-						return FALSE;
+						if (!FreeRDPWriteColor(pDstPixel8, DstFormat, color))
+							return FALSE;
+					}
 
-					cpSrcPixel += FreeRDPGetBytesPerPixel(clear->format);
+					pDstPixel8 += nDstStep;
+					cpSrcPixel += bpp;
 				}
 			}
 		}
@@ -521,9 +521,14 @@ static BOOL avc444_process_rects(H264_CONTEXT* h264, const BYTE* pSrcData, UINT3
 	BYTE** ppYUVDstData = h264->pYUV444Data;
 	const UINT32* piStride = h264->iStride;
 
-	if (h264->subsystem->Decompress(h264, pSrcData, SrcSize) < 0)
+	const int status = h264->subsystem->Decompress(h264, pSrcData, SrcSize);
+	if (status < 0)
 		return FALSE;
 
+	/* No picture available (yet), keep the current surface content */
+	if (status == 0)
+		return TRUE;
+
 	pYUVData[0] = h264->pYUVData[0];
 	pYUVData[1] = h264->pYUVData[1];
 	pYUVData[2] = h264->pYUVData[2];
@@ -647,6 +652,11 @@ static BOOL CALLBACK h264_register_subsystems(WINPR_ATTR_UNUSED PINIT_ONCE once,
 {
 	int i = 0;
 
+	/* Externally registered decoders (platform hardware decoders) take precedence */
+	{
+		subSystems[i] = &g_Subsystem_backend;
+		i++;
+	}
 #ifdef WITH_MEDIACODEC
 	{
 		subSystems[i] = &g_Subsystem_mediacodec;
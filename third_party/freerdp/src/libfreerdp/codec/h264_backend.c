@@ -0,0 +1,254 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * H.264 Bitmap Compression
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <winpr/crt.h>
+#include <winpr/wlog.h>
+#include <winpr/assert.h>
+#include <winpr/synch.h>
+
+#include <freerdp/log.h>
+#include <freerdp/codec/h264.h>
+
+#include "h264.h"
+
+#define TAG FREERDP_TAG("codec.h264.backend")
+
+#define MAX_DECODER_BACKENDS 4
+
+/* Decoders supplied by the application (e.g. a platform hardware decoder) at runtime.
+ * The table is only touched under the lock, contexts take a copy of the entry they use. */
+static INIT_ONCE backends_once = INIT_ONCE_STATIC_INIT;
+static CRITICAL_SECTION backends_lock;
+static H264_DECODER_BACKEND backends[MAX_DECODER_BACKENDS] = { 0 };
+
+typedef struct
+{
+	H264_DECODER_BACKEND backend;
+	void* handle;
+} H264_CONTEXT_BACKEND;
+
+static BOOL CALLBACK h264_backends_init(WINPR_ATTR_UNUSED PINIT_ONCE once,
+                                        WINPR_ATTR_UNUSED PVOID param,
+                                        WINPR_ATTR_UNUSED PVOID* context)
+{
+	return InitializeCriticalSectionAndSpinCount(&backends_lock, 4000);
+}
+
+static BOOL h264_backends_lock(void)
+{
+	if (!InitOnceExecuteOnce(&backends_once, h264_backends_init, NULL, NULL))
+		return FALSE;
+	EnterCriticalSection(&backends_lock);
+	return TRUE;
+}
+
+static void h264_backends_unlock(void)
+{
+	LeaveCriticalSection(&backends_lock);
+}
+
+BOOL h264_register_decoder_backend(const H264_DECODER_BACKEND* backend)
+{
+	BOOL rc = FALSE;
+
+	if (!backend || !backend->name || !backend->New || !backend->Free || !backend->Decode)
+		return FALSE;
+
+	if (!h264_backends_lock())
+		return FALSE;
+
+	size_t free_slot = MAX_DECODER_BACKENDS;
+	for (size_t x = 0; x < MAX_DECODER_BACKENDS; x++)
+	{
+		if (!backends[x].name)
+		{
+			if (free_slot == MAX_DECODER_BACKENDS)
+				free_slot = x;
+		}
+		else if (strcmp(backends[x].name, backend->name) == 0)
+		{
+			WLog_WARN(TAG, "H264 decoder backend %s already registered", backend->name);
+			goto out;
+		}
+	}
+
+	if (free_slot == MAX_DECODER_BACKENDS)
+	{
+		WLog_ERR(TAG, "no free slot for H264 decoder backend %s", backend->name);
+		goto out;
+	}
+
+	H264_DECODER_BACKEND entry = *backend;
+	entry.name = _strdup(backend->name);
+	if (!entry.name)
+		goto out;
+
+	backends[free_slot] = entry;
+	WLog_DBG(TAG, "registered H264 decoder backend %s", entry.name);
+	rc = TRUE;
+out:
+	h264_backends_unlock();
+	return rc;
+}
+
+BOOL h264_unregister_decoder_backend(const char* name)
+{
+	BOOL rc = FALSE;
+
+	if (!name)
+		return FALSE;
+
+	if (!h264_backends_lock())
+		return FALSE;
+
+	for (size_t x = 0; x < MAX_DECODER_BACKENDS; x++)
+	{
+		if (backends[x].name && (strcmp(backends[x].name, name) == 0))
+		{
+			const H264_DECODER_BACKEND empty = { 0 };
+			free(WINPR_CAST_CONST_PTR_AWAY(backends[x].name, char*));
+			backends[x] = empty;
+			rc = TRUE;
+			break;
+		}
+	}
+
+	h264_backends_unlock();
+	return rc;
+}
+
+static void backend_uninit(H264_CONTEXT* h264)
+{
+	WINPR_ASSERT(h264);
+
+	H264_CONTEXT_BACKEND* sys = (H264_CONTEXT_BACKEND*)h264->pSystemData;
+	if (!sys)
+		return;
+
+	if (sys->handle)
+		sys->backend.Free(sys->handle);
+	free(WINPR_CAST_CONST_PTR_AWAY(sys->backend.name, char*));
+	free(sys);
+	h264->pSystemData = NULL;
+	h264->numSystemData = 0;
+
+	for (size_t x = 0; x < 3; x++)
+	{
+		h264->pYUVData[x] = NULL;
+		h264->iStride[x] = 0;
+	}
+}
+
+static BOOL backend_init(H264_CONTEXT* h264)
+{
+	WINPR_ASSERT(h264);
+
+	/* Backends only decode, encoding stays with the built-in subsystems. */
+	if (h264->Compressor)
+		return FALSE;
+
+	H264_CONTEXT_BACKEND* sys = calloc(1, sizeof(H264_CONTEXT_BACKEND));
+	if (!sys)
+		return FALSE;
+
+	if (!h264_backends_lock())
+	{
+		free(sys);
+		return FALSE;
+	}
+
+	for (size_t x = 0; x < MAX_DECODER_BACKENDS; x++)
+	{
+		const H264_DECODER_BACKEND* backend = &backends[x];
+		if (!backend->name)
+			continue;
+
+		void* handle = backend->New(backend->userdata, h264->width, h264->height);
+		if (!handle)
+		{
+			WLog_Print(h264->log, WLOG_DEBUG, "H264 decoder backend %s not usable", backend->name);
+			continue;
+		}
+
+		sys->backend = *backend;
+		sys->backend.name = _strdup(backend->name);
+		if (sys->backend.name)
+			sys->handle = handle;
+		else
+			backend->Free(handle);
+		break;
+	}
+
+	h264_backends_unlock();
+
+	if (!sys->handle)
+	{
+		free(sys);
+		return FALSE;
+	}
+
+	WLog_Print(h264->log, WLOG_DEBUG, "using H264 decoder backend %s", sys->backend.name);
+	h264->pSystemData = sys;
+	h264->numSystemData = 1;
+	return TRUE;
+}
+
+static int backend_decompress(H264_CONTEXT* WINPR_RESTRICT h264,
+                              const BYTE* WINPR_RESTRICT pSrcData, UINT32 SrcSize)
+{
+	WINPR_ASSERT(h264);
+	WINPR_ASSERT(pSrcData || (SrcSize == 0));
+
+	H264_CONTEXT_BACKEND* sys = (H264_CONTEXT_BACKEND*)h264->pSystemData;
+	WINPR_ASSERT(sys);
+
+	BYTE* pYUVData[3] = { 0 };
+	UINT32 iStride[3] = { 0 };
+	const INT32 status = sys->backend.Decode(sys->handle, pSrcData, SrcSize, pYUVData, iStride);
+	if (status <= 0)
+	{
+		if (status < 0)
+			WLog_Print(h264->log, WLOG_WARN, "H264 decoder backend %s failed with %" PRId32,
+			           sys->backend.name, status);
+		return status;
+	}
+
+	if (!pYUVData[0] || !pYUVData[1] || !pYUVData[2])
+		return -2005;
+
+	for (size_t x = 0; x < 3; x++)
+	{
+		h264->pYUVData[x] = pYUVData[x];
+		h264->iStride[x] = iStride[x];
+	}
+
+	return 1;
+}
+
+static int backend_compress(WINPR_ATTR_UNUSED H264_CONTEXT* WINPR_RESTRICT h264,
+                            WINPR_ATTR_UNUSED const BYTE** WINPR_RESTRICT pSrcYuv,
+                            WINPR_ATTR_UNUSED const UINT32* WINPR_RESTRICT pStride,
+                            WINPR_ATTR_UNUSED BYTE** WINPR_RESTRICT ppDstData,
+                            WINPR_ATTR_UNUSED UINT32* WINPR_RESTRICT pDstSize)
+{
+	return -1;
+}
+
+const H264_CONTEXT_SUBSYSTEM g_Subsystem_backend = { "backend", backend_init, backend_uninit,
+	                                                 backend_decompress, backend_compress };
@@ -95,7 +95,8 @@ static inline BYTE* WRITEFIRSTLINEFGBGIMAGE(BYTE* WINPR_RESTRICT pbDest,
 /**
  * Decompress an RLE compressed bitmap.
  */
-static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32 cbSrcBuffer,
+static inline BOOL RLEDECOMPRESS(const primitives_t* WINPR_RESTRICT prims,
+                                 const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32 cbSrcBuffer,
                                  BYTE* WINPR_RESTRICT pbDestBuffer, UINT32 rowDelta, UINT32 width,
                                  UINT32 height)
 {
@@ -111,6 +112,8 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 	UINT32 runLength = 0;
 	UINT32 code = 0;
 	UINT32 advance = 0;
+	BYTE pattern[2 * PIXEL_SIZE] = { 0 };
+	BYTE* pbPattern = NULL;
 	RLEEXTRA
 
 	if ((rowDelta == 0) || (rowDelta < width))
@@ -120,10 +123,10 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 		return FALSE;
 	}
 
-	if (!pbSrcBuffer || !pbDestBuffer)
+	if (!prims || !pbSrcBuffer || !pbDestBuffer)
 	{
-		WLog_ERR(TAG, "Invalid arguments: pbSrcBuffer=%p, pbDestBuffer=%p", pbSrcBuffer,
-		         pbDestBuffer);
+		WLog_ERR(TAG, "Invalid arguments: prims=%p, pbSrcBuffer=%p, pbDestBuffer=%p", prims,
+		         pbSrcBuffer, pbDestBuffer);
 		return FALSE;
 	}
 
@@ -174,7 +177,8 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 				if (!ENSURE_CAPACITY(pbDest, pbDestEnd, runLength))
 					return FALSE;
 
-				UNROLL(runLength, { DESTWRITEPIXEL(pbDest, BLACK_PIXEL); });
+				memset(pbDest, BLACK_PIXEL, 1ULL * runLength * PIXEL_SIZE);
+				pbDest += 1ULL * runLength * PIXEL_SIZE;
 			}
 			else
 			{
@@ -192,10 +196,7 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 				if (!ENSURE_CAPACITY(pbDest, pbDestEnd, runLength))
 					return FALSE;
 
-				UNROLL(runLength, {
-					DESTREADPIXEL(temp, pbDest - rowDelta);
-					DESTWRITEPIXEL(pbDest, temp);
-				});
+				pbDest = copy_from_previous_row(pbDest, rowDelta, 1ULL * runLength * PIXEL_SIZE);
 			}
 
 			/* A follow-on background run order will need a foreground pel inserted. */
@@ -229,16 +230,31 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 				if (!ENSURE_CAPACITY(pbDest, pbDestEnd, runLength))
 					return FALSE;
 
+				pbPattern = pattern;
+				DESTWRITEPIXEL(pbPattern, fgPel);
+
 				if (fFirstLine)
 				{
-					UNROLL(runLength, { DESTWRITEPIXEL(pbDest, fgPel); });
+					if (prims->rleExpand_8u(pattern, PIXEL_SIZE, pbDest, runLength) !=
+					    PRIMITIVES_SUCCESS)
+						return FALSE;
+
+					pbDest += 1ULL * runLength * PIXEL_SIZE;
 				}
 				else
 				{
-					UNROLL(runLength, {
-						DESTREADPIXEL(temp, pbDest - rowDelta);
-						DESTWRITEPIXEL(pbDest, temp ^ fgPel);
-					});
+					/* The source row must not overlap the destination, split at the stride. */
+					while (runLength > 0)
+					{
+						const UINT32 count = MIN(runLength, rowDelta / PIXEL_SIZE);
+
+						if (prims->rleXorExpand_8u(pbDest - rowDelta, pattern, PIXEL_SIZE, pbDest,
+						                           count) != PRIMITIVES_SUCCESS)
+							return FALSE;
+
+						pbDest += 1ULL * count * PIXEL_SIZE;
+						runLength -= count;
+					}
 				}
 
 				break;
@@ -260,10 +276,15 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 				if (!ENSURE_CAPACITY(pbDest, pbDestEnd, runLength * 2))
 					return FALSE;
 
-				UNROLL(runLength, {
-					DESTWRITEPIXEL(pbDest, pixelA);
-					DESTWRITEPIXEL(pbDest, pixelB);
-				});
+				pbPattern = pattern;
+				DESTWRITEPIXEL(pbPattern, pixelA);
+				DESTWRITEPIXEL(pbPattern, pixelB);
+
+				if (prims->rleExpand_8u(pattern, 2 * PIXEL_SIZE, pbDest, runLength) !=
+				    PRIMITIVES_SUCCESS)
+					return FALSE;
+
+				pbDest += 2ULL * runLength * PIXEL_SIZE;
 				break;
 
 			/* Handle Color Run Orders. */
@@ -280,7 +301,14 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 				if (!ENSURE_CAPACITY(pbDest, pbDestEnd, runLength))
 					return FALSE;
 
-				UNROLL(runLength, { DESTWRITEPIXEL(pbDest, pixelA); });
+				pbPattern = pattern;
+				DESTWRITEPIXEL(pbPattern, pixelA);
+
+				if (prims->rleExpand_8u(pattern, PIXEL_SIZE, pbDest, runLength) !=
+				    PRIMITIVES_SUCCESS)
+					return FALSE;
+
+				pbDest += 1ULL * runLength * PIXEL_SIZE;
 				break;
 
 			/* Handle Foreground/Background Image Orders. */
@@ -366,10 +394,9 @@ static inline BOOL RLEDECOMPRESS(const BYTE* WINPR_RESTRICT pbSrcBuffer, UINT32
 				if (!ENSURE_CAPACITY(pbSrc, pbEnd, runLength))
 					return FALSE;
 
-				UNROLL(runLength, {
-					SRCREADPIXEL(temp, pbSrc);
-					DESTWRITEPIXEL(pbDest, temp);
-				});
+				memcpy(pbDest, pbSrc, 1ULL * runLength * PIXEL_SIZE);
+				pbDest += 1ULL * runLength * PIXEL_SIZE;
+				pbSrc += 1ULL * runLength * PIXEL_SIZE;
 				break;
 
 			/* Handle Special Order 1. */
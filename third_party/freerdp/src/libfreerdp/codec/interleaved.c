@@ -25,6 +25,7 @@
 #include <winpr/cast.h>
 #include <freerdp/config.h>
 
+#include <freerdp/primitives.h>
 #include <freerdp/codec/interleaved.h>
 #include <freerdp/log.h>
 
@@ -391,6 +392,25 @@ static INLINE BOOL ensure_capacity_(const BYTE* start, const BYTE* end, size_t s
 	return res;
 }
 
+/**
+ * Copy a background run from the scanline above. Runs longer than a
+ * scanline read pixels written by the same run, so copy at most one
+ * stride at a time to keep source and destination apart.
+ */
+static INLINE BYTE* copy_from_previous_row(BYTE* WINPR_RESTRICT pbDest, UINT32 rowDelta,
+                                           size_t size)
+{
+	while (size > 0)
+	{
+		const size_t chunk = MIN(size, rowDelta);
+		memcpy(pbDest, pbDest - rowDelta, chunk);
+		pbDest += chunk;
+		size -= chunk;
+	}
+
+	return pbDest;
+}
+
 static INLINE void write_pixel_8(BYTE* _buf, BYTE _pix)
 {
 	WINPR_ASSERT(_buf);
@@ -537,6 +557,7 @@ BOOL interleaved_decompress(BITMAP_INTERLEAVED_CONTEXT* WINPR_RESTRICT interleav
 	UINT32 scanline = 0;
 	UINT32 SrcFormat = 0;
 	UINT32 BufferSize = 0;
+	const primitives_t* prims = primitives_get();
 
 	if (!interleaved || !pSrcData || !pDstData)
 	{
@@ -590,8 +611,8 @@ BOOL interleaved_decompress(BITMAP_INTERLEAVED_CONTEXT* WINPR_RESTRICT interleav
 	switch (bpp)
 	{
 		case 24:
-			if (!RleDecompress24to24(pSrcData, SrcSize, interleaved->TempBuffer, scanline,
-			                         nSrcWidth, nSrcHeight))
+			if (!RleDecompress24to24(prims, pSrcData, SrcSize, interleaved->TempBuffer,
+			                         scanline, nSrcWidth, nSrcHeight))
 			{
 				WLog_ERR(TAG, "RleDecompress24to24 failed");
 				return FALSE;
@@ -601,8 +622,8 @@ BOOL interleaved_decompress(BITMAP_INTERLEAVED_CONTEXT* WINPR_RESTRICT interleav
 
 		case 16:
 		case 15:
-			if (!RleDecompress16to16(pSrcData, SrcSize, interleaved->TempBuffer, scanline,
-			                         nSrcWidth, nSrcHeight))
+			if (!RleDecompress16to16(prims, pSrcData, SrcSize, interleaved->TempBuffer,
+			                         scanline, nSrcWidth, nSrcHeight))
 			{
 				WLog_ERR(TAG, "RleDecompress16to16 failed");
 				return FALSE;
@@ -611,8 +632,8 @@ BOOL interleaved_decompress(BITMAP_INTERLEAVED_CONTEXT* WINPR_RESTRICT interleav
 			break;
 
 		case 8:
-			if (!RleDecompress8to8(pSrcData, SrcSize, interleaved->TempBuffer, scanline, nSrcWidth,
-			                       nSrcHeight))
+			if (!RleDecompress8to8(prims, pSrcData, SrcSize, interleaved->TempBuffer, scanline,
+			                       nSrcWidth, nSrcHeight))
 			{
 				WLog_ERR(TAG, "RleDecompress8to8 failed");
 				return FALSE;
@@ -227,253 +227,96 @@ static INLINE INT32 planar_skip_plane_rle(const BYTE* WINPR_RESTRICT pSrcData, U
 	return (INT32)used;
 }
 
-static inline UINT8 clamp(INT16 val)
+/* Expands one RLE scanline of a plane. Runs repeat the last byte of the
+ * segment as it is encoded, so for delta coded scanlines the expanded
+ * values are resolved against the previous scanline in a second pass. */
+static INLINE BOOL planar_decompress_scanline_rle(const primitives_t* WINPR_RESTRICT prims,
+                                                  const BYTE** WINPR_RESTRICT ppSrc,
+                                                  const BYTE* WINPR_RESTRICT pSrcEnd,
+                                                  const BYTE* WINPR_RESTRICT previousScanline,
+                                                  BYTE* WINPR_RESTRICT currentScanline,
+                                                  UINT32 nWidth)
 {
-	return (UINT8)val;
-}
-
-static INLINE INT32 planar_decompress_plane_rle_only(const BYTE* WINPR_RESTRICT pSrcData,
-                                                     UINT32 SrcSize, BYTE* WINPR_RESTRICT pDstData,
-                                                     UINT32 nWidth, UINT32 nHeight)
-{
-	BYTE* previousScanline = NULL;
-	const BYTE* srcp = pSrcData;
+	const BYTE* srcp = *ppSrc;
+	BYTE pixel = 0;
 
-	WINPR_ASSERT(nHeight <= INT32_MAX);
-	WINPR_ASSERT(nWidth <= INT32_MAX);
-
-	for (UINT32 y = 0; y < nHeight; y++)
+	for (UINT32 x = 0; x < nWidth;)
 	{
-		BYTE* dstp = &pDstData[1ULL * (y)*nWidth];
-		INT16 pixel = 0;
-		BYTE* currentScanline = dstp;
-
-		for (UINT32 x = 0; x < nWidth;)
+		if (srcp >= pSrcEnd)
 		{
-			BYTE controlByte = *srcp;
-			srcp++;
-
-			if ((srcp - pSrcData) > SrcSize * 1ll)
-			{
-				WLog_ERR(TAG, "error reading input buffer");
-				return -1;
-			}
+			WLog_ERR(TAG, "error reading input buffer");
+			return FALSE;
+		}
 
-			UINT32 nRunLength = PLANAR_CONTROL_BYTE_RUN_LENGTH(controlByte);
-			UINT32 cRawBytes = PLANAR_CONTROL_BYTE_RAW_BYTES(controlByte);
+		const BYTE controlByte = *srcp++;
+		UINT32 nRunLength = PLANAR_CONTROL_BYTE_RUN_LENGTH(controlByte);
+		UINT32 cRawBytes = PLANAR_CONTROL_BYTE_RAW_BYTES(controlByte);
 
-			if (nRunLength == 1)
-			{
-				nRunLength = cRawBytes + 16;
-				cRawBytes = 0;
-			}
-			else if (nRunLength == 2)
-			{
-				nRunLength = cRawBytes + 32;
-				cRawBytes = 0;
-			}
+		if (nRunLength == 1)
+		{
+			nRunLength = cRawBytes + 16;
+			cRawBytes = 0;
+		}
+		else if (nRunLength == 2)
+		{
+			nRunLength = cRawBytes + 32;
+			cRawBytes = 0;
+		}
 
-			if (((dstp + (cRawBytes + nRunLength)) - currentScanline) > nWidth * 1ll)
-			{
-				WLog_ERR(TAG, "too many pixels in scanline");
-				return -1;
-			}
+		if ((cRawBytes + nRunLength) > (nWidth - x))
+		{
+			WLog_ERR(TAG, "too many pixels in scanline");
+			return FALSE;
+		}
 
-			if (!previousScanline)
+		if (cRawBytes > 0)
+		{
+			if (cRawBytes > (size_t)(pSrcEnd - srcp))
 			{
-				/* first scanline, absolute values */
-				while (cRawBytes > 0)
-				{
-					pixel = *srcp;
-					srcp++;
-					*dstp = clamp(pixel);
-					dstp++;
-					x++;
-					cRawBytes--;
-				}
-
-				while (nRunLength > 0)
-				{
-					*dstp = clamp(pixel);
-					dstp++;
-					x++;
-					nRunLength--;
-				}
+				WLog_ERR(TAG, "error reading input buffer");
+				return FALSE;
 			}
-			else
-			{
-				/* delta values relative to previous scanline */
-				while (cRawBytes > 0)
-				{
-					UINT8 deltaValue = *srcp;
-					srcp++;
-
-					if (deltaValue & 1)
-					{
-						deltaValue = deltaValue >> 1;
-						deltaValue = deltaValue + 1;
-						pixel = WINPR_ASSERTING_INT_CAST(int16_t, -1 * (int16_t)deltaValue);
-					}
-					else
-					{
-						deltaValue = deltaValue >> 1;
-						pixel = WINPR_ASSERTING_INT_CAST(INT16, deltaValue);
-					}
-
-					const INT16 delta =
-					    WINPR_ASSERTING_INT_CAST(int16_t, previousScanline[x] + pixel);
-					*dstp = clamp(delta);
-					dstp++;
-					x++;
-					cRawBytes--;
-				}
 
-				while (nRunLength > 0)
-				{
-					const INT16 deltaValue =
-					    WINPR_ASSERTING_INT_CAST(int16_t, previousScanline[x] + pixel);
-					*dstp = clamp(deltaValue);
-					dstp++;
-					x++;
-					nRunLength--;
-				}
-			}
+			memcpy(&currentScanline[x], srcp, cRawBytes);
+			srcp += cRawBytes;
+			pixel = srcp[-1];
+			x += cRawBytes;
 		}
 
-		previousScanline = currentScanline;
+		if (nRunLength > 0)
+		{
+			memset(&currentScanline[x], pixel, nRunLength);
+			x += nRunLength;
+		}
 	}
 
-	return (INT32)(srcp - pSrcData);
+	*ppSrc = srcp;
+
+	if (!previousScanline)
+		return TRUE; /* first scanline, absolute values */
+
+	return prims->planarDeltaDecode_8u(previousScanline, currentScanline, nWidth) ==
+	       PRIMITIVES_SUCCESS;
 }
 
-static INLINE INT32 planar_decompress_plane_rle(const BYTE* WINPR_RESTRICT pSrcData, UINT32 SrcSize,
-                                                BYTE* WINPR_RESTRICT pDstData, UINT32 nDstStep,
-                                                UINT32 nXDst, UINT32 nYDst, UINT32 nWidth,
-                                                UINT32 nHeight, UINT32 nChannel, BOOL vFlip)
+static INLINE INT32 planar_decompress_plane_rle_only(const primitives_t* WINPR_RESTRICT prims,
+                                                     const BYTE* WINPR_RESTRICT pSrcData,
+                                                     UINT32 SrcSize, BYTE* WINPR_RESTRICT pDstData,
+                                                     UINT32 nWidth, UINT32 nHeight)
 {
-	INT32 beg = 0;
-	INT32 end = 0;
-	INT32 inc = 0;
-	BYTE* previousScanline = NULL;
+	const BYTE* previousScanline = NULL;
 	const BYTE* srcp = pSrcData;
 
 	WINPR_ASSERT(nHeight <= INT32_MAX);
 	WINPR_ASSERT(nWidth <= INT32_MAX);
-	WINPR_ASSERT(nDstStep <= INT32_MAX);
-
-	previousScanline = NULL;
-
-	if (vFlip)
-	{
-		beg = (INT32)nHeight - 1;
-		end = -1;
-		inc = -1;
-	}
-	else
-	{
-		beg = 0;
-		end = (INT32)nHeight;
-		inc = 1;
-	}
 
-	for (INT32 y = beg; y != end; y += inc)
+	for (UINT32 y = 0; y < nHeight; y++)
 	{
-		const intptr_t off = ((1LL * nYDst + y) * nDstStep) + (4LL * nXDst) + nChannel * 1LL;
-		BYTE* dstp = &pDstData[off];
-		BYTE* currentScanline = dstp;
-		INT16 pixel = 0;
-
-		for (INT32 x = 0; x < (INT32)nWidth;)
-		{
-			const BYTE controlByte = *srcp;
-			srcp++;
-
-			if ((srcp - pSrcData) > SrcSize * 1ll)
-			{
-				WLog_ERR(TAG, "error reading input buffer");
-				return -1;
-			}
+		BYTE* currentScanline = &pDstData[1ULL * y * nWidth];
 
-			UINT32 nRunLength = PLANAR_CONTROL_BYTE_RUN_LENGTH(controlByte);
-			UINT32 cRawBytes = PLANAR_CONTROL_BYTE_RAW_BYTES(controlByte);
-
-			if (nRunLength == 1)
-			{
-				nRunLength = cRawBytes + 16;
-				cRawBytes = 0;
-			}
-			else if (nRunLength == 2)
-			{
-				nRunLength = cRawBytes + 32;
-				cRawBytes = 0;
-			}
-
-			if (((dstp + (cRawBytes + nRunLength)) - currentScanline) > nWidth * 4ll)
-			{
-				WLog_ERR(TAG, "too many pixels in scanline");
-				return -1;
-			}
-
-			if (!previousScanline)
-			{
-				/* first scanline, absolute values */
-				while (cRawBytes > 0)
-				{
-					pixel = *srcp;
-					srcp++;
-					*dstp = WINPR_ASSERTING_INT_CAST(BYTE, pixel);
-					dstp += 4;
-					x++;
-					cRawBytes--;
-				}
-
-				while (nRunLength > 0)
-				{
-					*dstp = WINPR_ASSERTING_INT_CAST(BYTE, pixel);
-					dstp += 4;
-					x++;
-					nRunLength--;
-				}
-			}
-			else
-			{
-				/* delta values relative to previous scanline */
-				while (cRawBytes > 0)
-				{
-					BYTE deltaValue = *srcp;
-					srcp++;
-
-					if (deltaValue & 1)
-					{
-						deltaValue = deltaValue >> 1;
-						deltaValue = deltaValue + 1;
-						pixel = WINPR_ASSERTING_INT_CAST(int16_t, -deltaValue);
-					}
-					else
-					{
-						deltaValue = deltaValue >> 1;
-						pixel = deltaValue;
-					}
-
-					const INT16 delta =
-					    WINPR_ASSERTING_INT_CAST(int16_t, previousScanline[4LL * x] + pixel);
-					*dstp = clamp(delta);
-					dstp += 4;
-					x++;
-					cRawBytes--;
-				}
-
-				while (nRunLength > 0)
-				{
-					const INT16 deltaValue =
-					    WINPR_ASSERTING_INT_CAST(int16_t, pixel + previousScanline[4LL * x]);
-					*dstp = clamp(deltaValue);
-					dstp += 4;
-					x++;
-					nRunLength--;
-				}
-			}
-		}
+		if (!planar_decompress_scanline_rle(prims, &srcp, &pSrcData[SrcSize], previousScanline,
+		                                    currentScanline, nWidth))
+			return -1;
 
 		previousScanline = currentScanline;
 	}
@@ -481,136 +324,75 @@ static INLINE INT32 planar_decompress_plane_rle(const BYTE* WINPR_RESTRICT pSrcD
 	return (INT32)(srcp - pSrcData);
 }
 
-static INLINE INT32 planar_set_plane(BYTE bValue, BYTE* pDstData, UINT32 nDstStep, UINT32 nXDst,
-                                     UINT32 nYDst, UINT32 nWidth, UINT32 nHeight, UINT32 nChannel,
-                                     BOOL vFlip)
+/* Decodes the R, G, B and (optional) A planes scanline by scanline into
+ * scratch rows and merges every scanline into the destination right away, so
+ * neither the planes nor the image are walked more than once. */
+static INLINE BOOL planar_decompress_planes_rle(BITMAP_PLANAR_CONTEXT* WINPR_RESTRICT planar,
+                                                const primitives_t* WINPR_RESTRICT prims,
+                                                const BYTE* WINPR_RESTRICT pSrcData[4],
+                                                const INT32 SrcSizes[4],
+                                                BYTE* WINPR_RESTRICT pDstData, UINT32 DstFormat,
+                                                UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
+                                                UINT32 nWidth, UINT32 nHeight, BOOL vFlip)
 {
-	INT32 beg = 0;
-	INT32 end = 0;
-	INT32 inc = 0;
+	const UINT32 bpp = FreeRDPGetBytesPerPixel(DstFormat);
+	const size_t nPlanes = pSrcData[3] ? 4 : 3;
+	const BYTE* srcp[4] = { 0 };
+	const BYTE* srcEnd[4] = { 0 };
+	BYTE* rows[4][2] = { { 0 } };
 
 	WINPR_ASSERT(nHeight <= INT32_MAX);
 	WINPR_ASSERT(nWidth <= INT32_MAX);
-	WINPR_ASSERT(nDstStep <= INT32_MAX);
 
-	if (vFlip)
+	if (8ULL * nWidth > 4ULL * planar->maxPlaneSize)
 	{
-		beg = (INT32)nHeight - 1;
-		end = -1;
-		inc = -1;
-	}
-	else
-	{
-		beg = 0;
-		end = (INT32)nHeight;
-		inc = 1;
+		WLog_ERR(TAG, "planar plane width %" PRIu32 " exceeds context size", nWidth);
+		return FALSE;
 	}
 
-	for (INT32 y = beg; y != end; y += inc)
+	for (size_t i = 0; i < nPlanes; i++)
 	{
-		const intptr_t off = ((1LL * nYDst + y) * nDstStep) + (4LL * nXDst) + nChannel * 1LL;
-		BYTE* dstp = &pDstData[off];
-
-		for (INT32 x = 0; x < (INT32)nWidth; ++x)
-		{
-			*dstp = bValue;
-			dstp += 4;
-		}
+		srcp[i] = pSrcData[i];
+		srcEnd[i] = &pSrcData[i][SrcSizes[i]];
+		rows[i][0] = &planar->rlePlanesBuffer[2ULL * i * nWidth];
+		rows[i][1] = rows[i][0] + nWidth;
 	}
 
-	return 0;
-}
-
-static INLINE BOOL writeLine(BYTE** WINPR_RESTRICT ppRgba, UINT32 DstFormat, UINT32 width,
-                             const BYTE** WINPR_RESTRICT ppR, const BYTE** WINPR_RESTRICT ppG,
-                             const BYTE** WINPR_RESTRICT ppB, const BYTE** WINPR_RESTRICT ppA)
-{
-	WINPR_ASSERT(ppRgba);
-	WINPR_ASSERT(ppR);
-	WINPR_ASSERT(ppG);
-	WINPR_ASSERT(ppB);
-
-	switch (DstFormat)
+	for (UINT32 y = 0; y < nHeight; y++)
 	{
-		case PIXEL_FORMAT_BGRA32:
-			for (UINT32 x = 0; x < width; x++)
-			{
-				*(*ppRgba)++ = *(*ppB)++;
-				*(*ppRgba)++ = *(*ppG)++;
-				*(*ppRgba)++ = *(*ppR)++;
-				*(*ppRgba)++ = *(*ppA)++;
-			}
-
-			return TRUE;
+		const BYTE* line[4] = { 0 };
+		const UINT32 cur = y % 2;
 
-		case PIXEL_FORMAT_BGRX32:
-			for (UINT32 x = 0; x < width; x++)
-			{
-				*(*ppRgba)++ = *(*ppB)++;
-				*(*ppRgba)++ = *(*ppG)++;
-				*(*ppRgba)++ = *(*ppR)++;
-				*(*ppRgba)++ = 0xFF;
-			}
+		for (size_t i = 0; i < nPlanes; i++)
+		{
+			const BYTE* previousScanline = (y > 0) ? rows[i][cur ^ 1] : NULL;
 
-			return TRUE;
+			if (!planar_decompress_scanline_rle(prims, &srcp[i], srcEnd[i], previousScanline,
+			                                    rows[i][cur], nWidth))
+				return FALSE;
 
-		default:
-			if (ppA)
-			{
-				for (UINT32 x = 0; x < width; x++)
-				{
-					BYTE alpha = *(*ppA)++;
-					UINT32 color =
-					    FreeRDPGetColor(DstFormat, *(*ppR)++, *(*ppG)++, *(*ppB)++, alpha);
-					FreeRDPWriteColor(*ppRgba, DstFormat, color);
-					*ppRgba += FreeRDPGetBytesPerPixel(DstFormat);
-				}
-			}
-			else
-			{
-				const BYTE alpha = 0xFF;
+			line[i] = rows[i][cur];
+		}
 
-				for (UINT32 x = 0; x < width; x++)
-				{
-					UINT32 color =
-					    FreeRDPGetColor(DstFormat, *(*ppR)++, *(*ppG)++, *(*ppB)++, alpha);
-					FreeRDPWriteColor(*ppRgba, DstFormat, color);
-					*ppRgba += FreeRDPGetBytesPerPixel(DstFormat);
-				}
-			}
+		const UINT32 dstY = vFlip ? nHeight - y - 1 : y;
+		BYTE* pRGB = &pDstData[((1ULL * nYDst + dstY) * nDstStep) + (1ULL * nXDst * bpp)];
 
-			return TRUE;
+		if (prims->planarMerge_8u_P4C4R(line, pRGB, DstFormat, nWidth) != PRIMITIVES_SUCCESS)
+			return FALSE;
 	}
+
+	return TRUE;
 }
 
-static INLINE BOOL planar_decompress_planes_raw(const BYTE* WINPR_RESTRICT pSrcData[4],
+static INLINE BOOL planar_decompress_planes_raw(const primitives_t* WINPR_RESTRICT prims,
+                                                const BYTE* WINPR_RESTRICT pSrcData[4],
                                                 BYTE* WINPR_RESTRICT pDstData, UINT32 DstFormat,
                                                 UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
                                                 UINT32 nWidth, UINT32 nHeight, BOOL vFlip,
                                                 UINT32 totalHeight)
 {
-	INT32 beg = 0;
-	INT32 end = 0;
-	INT32 inc = 0;
-	const BYTE* pR = pSrcData[0];
-	const BYTE* pG = pSrcData[1];
-	const BYTE* pB = pSrcData[2];
-	const BYTE* pA = pSrcData[3];
 	const UINT32 bpp = FreeRDPGetBytesPerPixel(DstFormat);
 
-	if (vFlip)
-	{
-		beg = WINPR_ASSERTING_INT_CAST(int32_t, nHeight - 1);
-		end = -1;
-		inc = -1;
-	}
-	else
-	{
-		beg = 0;
-		end = WINPR_ASSERTING_INT_CAST(int32_t, nHeight);
-		inc = 1;
-	}
-
 	if (nYDst + nHeight > totalHeight)
 	{
 		WLog_ERR(TAG,
@@ -629,21 +411,15 @@ static INLINE BOOL planar_decompress_planes_raw(const BYTE* WINPR_RESTRICT pSrcD
 		return FALSE;
 	}
 
-	for (INT32 y = beg; y != end; y += inc)
+	for (UINT32 y = 0; y < nHeight; y++)
 	{
-		BYTE* pRGB = NULL;
+		const size_t offset = 1ULL * y * nWidth;
+		const BYTE* line[4] = { pSrcData[0] + offset, pSrcData[1] + offset, pSrcData[2] + offset,
+			                    pSrcData[3] ? pSrcData[3] + offset : NULL };
+		const UINT32 dstY = vFlip ? nHeight - y - 1 : y;
+		BYTE* pRGB = &pDstData[((1ULL * nYDst + dstY) * nDstStep) + (1ULL * nXDst * bpp)];
 
-		if (y > WINPR_ASSERTING_INT_CAST(INT64, nHeight))
-		{
-			WLog_ERR(TAG, "planar plane destination Y %" PRId32 " exceeds height %" PRIu32, y,
-			         nHeight);
-			return FALSE;
-		}
-
-		const intptr_t off = ((1LL * nYDst + y) * nDstStep) + (1LL * nXDst * bpp);
-		pRGB = &pDstData[off];
-
-		if (!writeLine(&pRGB, DstFormat, nWidth, &pR, &pG, &pB, &pA))
+		if (prims->planarMerge_8u_P4C4R(line, pRGB, DstFormat, nWidth) != PRIMITIVES_SUCCESS)
 			return FALSE;
 	}
 
@@ -914,8 +690,9 @@ BOOL planar_decompress(BITMAP_PLANAR_CONTEXT* WINPR_RESTRICT planar,
 
 		if (!rle) /* RAW */
 		{
-			if (!planar_decompress_planes_raw(planes, pTempData, TempFormat, nTempStep, nXDst,
-			                                  nYDst, nSrcWidth, nSrcHeight, vFlip, nTotalHeight))
+			if (!planar_decompress_planes_raw(prims, planes, pTempData, TempFormat, nTempStep,
+			                                  nXDst, nYDst, nSrcWidth, nSrcHeight, vFlip,
+			                                  nTotalHeight))
 				return FALSE;
 
 			if (alpha)
@@ -928,42 +705,16 @@ BOOL planar_decompress(BITMAP_PLANAR_CONTEXT* WINPR_RESTRICT planar,
 		}
 		else /* RLE */
 		{
-			status = planar_decompress_plane_rle(
-			    planes[0], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[0]), pTempData, nTempStep,
-			    nXDst, nYDst, nSrcWidth, nSrcHeight, 2, vFlip); /* RedPlane */
+			const BYTE* rlePlanes[4] = { planes[0], planes[1], planes[2],
+				                         useAlpha ? planes[3] : NULL };
 
-			if (status < 0)
-				return FALSE;
-
-			status = planar_decompress_plane_rle(
-			    planes[1], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[1]), pTempData, nTempStep,
-			    nXDst, nYDst, nSrcWidth, nSrcHeight, 1, vFlip); /* GreenPlane */
-
-			if (status < 0)
-				return FALSE;
-
-			status = planar_decompress_plane_rle(
-			    planes[2], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[2]), pTempData, nTempStep,
-			    nXDst, nYDst, nSrcWidth, nSrcHeight, 0, vFlip); /* BluePlane */
-
-			if (status < 0)
+			if (!planar_decompress_planes_rle(planar, prims, rlePlanes, rleSizes, pTempData,
+			                                  TempFormat, nTempStep, nXDst, nYDst, nSrcWidth,
+			                                  nSrcHeight, vFlip))
 				return FALSE;
 
 			srcp += rleSizes[0] + rleSizes[1] + rleSizes[2];
 
-			if (useAlpha)
-			{
-				status = planar_decompress_plane_rle(
-				    planes[3], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[3]), pTempData,
-				    nTempStep, nXDst, nYDst, nSrcWidth, nSrcHeight, 3, vFlip); /* AlphaPlane */
-			}
-			else
-				status = planar_set_plane(0xFF, pTempData, nTempStep, nXDst, nYDst, nSrcWidth,
-				                          nSrcHeight, 3, vFlip);
-
-			if (status < 0)
-				return FALSE;
-
 			if (alpha)
 				srcp += rleSizes[3];
 		}
@@ -1009,8 +760,8 @@ BOOL planar_decompress(BITMAP_PLANAR_CONTEXT* WINPR_RESTRICT planar,
 			if (useAlpha)
 			{
 				status = planar_decompress_plane_rle_only(
-				    planes[3], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[3]), rleBuffer[3],
-				    rawWidths[3], rawHeights[3]); /* AlphaPlane */
+				    prims, planes[3], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[3]),
+				    rleBuffer[3], rawWidths[3], rawHeights[3]); /* AlphaPlane */
 
 				if (status < 0)
 					return FALSE;
@@ -1020,21 +771,21 @@ BOOL planar_decompress(BITMAP_PLANAR_CONTEXT* WINPR_RESTRICT planar,
 				srcp += rleSizes[3];
 
 			status = planar_decompress_plane_rle_only(
-			    planes[0], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[0]), rleBuffer[0],
+			    prims, planes[0], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[0]), rleBuffer[0],
 			    rawWidths[0], rawHeights[0]); /* LumaPlane */
 
 			if (status < 0)
 				return FALSE;
 
 			status = planar_decompress_plane_rle_only(
-			    planes[1], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[1]), rleBuffer[1],
+			    prims, planes[1], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[1]), rleBuffer[1],
 			    rawWidths[1], rawHeights[1]); /* OrangeChromaPlane */
 
 			if (status < 0)
 				return FALSE;
 
 			status = planar_decompress_plane_rle_only(
-			    planes[2], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[2]), rleBuffer[2],
+			    prims, planes[2], WINPR_ASSERTING_INT_CAST(uint32_t, rleSizes[2]), rleBuffer[2],
 			    rawWidths[2], rawHeights[2]); /* GreenChromaPlane */
 
 			if (status < 0)
@@ -1071,8 +822,9 @@ BOOL planar_decompress(BITMAP_PLANAR_CONTEXT* WINPR_RESTRICT planar,
 				rawHeights[2] = nSrcHeight;
 			}
 
-			if (!planar_decompress_planes_raw(planes, pTempData, TempFormat, nTempStep, nXDst,
-			                                  nYDst, nSrcWidth, nSrcHeight, vFlip, nTotalHeight))
+			if (!planar_decompress_planes_raw(prims, planes, pTempData, TempFormat, nTempStep,
+			                                  nXDst, nYDst, nSrcWidth, nSrcHeight, vFlip,
+			                                  nTotalHeight))
 				return FALSE;
 
 			if (alpha)
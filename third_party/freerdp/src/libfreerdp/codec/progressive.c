@@ -1577,18 +1577,19 @@ static void CALLBACK progressive_process_tiles_tile_work_callback(PTP_CALLBACK_I
 	{
 		case PROGRESSIVE_WBT_TILE_SIMPLE:
 		case PROGRESSIVE_WBT_TILE_FIRST:
-			progressive_decompress_tile_first(param->progressive, param->tile, param->region,
-			                                  param->context);
+			param->status = progressive_decompress_tile_first(param->progressive, param->tile,
+			                                                  param->region, param->context);
 			break;
 
 		case PROGRESSIVE_WBT_TILE_UPGRADE:
-			progressive_decompress_tile_upgrade(param->progressive, param->tile, param->region,
-			                                    param->context);
+			param->status = progressive_decompress_tile_upgrade(param->progressive, param->tile,
+			                                                    param->region, param->context);
 			break;
 		default:
 			WLog_Print(param->progressive->log, WLOG_ERROR, "Invalid block type %04" PRIx16 " (%s)",
 			           param->tile->blockType,
 			           rfx_get_progressive_block_type_string(param->tile->blockType));
+			param->status = -1;
 			break;
 	}
 }
@@ -1695,6 +1696,7 @@ static INLINE SSIZE_T progressive_process_tiles(
 		param->region = region;
 		param->context = context;
 		param->tile = tile;
+		param->status = 0;
 
 		if (progressive->rfx_context->priv->UseThreads)
 		{
@@ -1716,27 +1718,32 @@ static INLINE SSIZE_T progressive_process_tiles(
 		else
 		{
 			progressive_process_tiles_tile_work_callback(0, param, 0);
+			status = param->status;
 		}
 
 		if (status < 0)
 		{
 			WLog_Print(progressive->log, WLOG_ERROR, "Failed to decompress %s at %" PRIu16,
 			           rfx_get_progressive_block_type_string(tile->blockType), idx);
-			goto fail;
+			break;
 		}
 	}
 
-	if (progressive->rfx_context->priv->UseThreads)
+	/* Tiles already submitted must finish before the region state is touched again */
+	for (UINT32 idx = 0; idx < close_cnt; idx++)
 	{
-		for (UINT32 idx = 0; idx < close_cnt; idx++)
+		WaitForThreadpoolWorkCallbacks(progressive->work_objects[idx], FALSE);
+		CloseThreadpoolWork(progressive->work_objects[idx]);
+
+		const PROGRESSIVE_TILE_PROCESS_WORK_PARAM* param = &progressive->params[idx];
+		if (param->status < 0)
 		{
-			WaitForThreadpoolWorkCallbacks(progressive->work_objects[idx], FALSE);
-			CloseThreadpoolWork(progressive->work_objects[idx]);
+			WLog_Print(progressive->log, WLOG_ERROR, "Failed to decompress %s at %" PRIu32,
+			           rfx_get_progressive_block_type_string(param->tile->blockType), idx);
+			status = -1;
 		}
 	}
 
-fail:
-
 	if (status < 0)
 		return -1;
 
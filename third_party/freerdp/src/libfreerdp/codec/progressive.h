@@ -149,6 +149,7 @@ typedef struct
 	PROGRESSIVE_BLOCK_REGION* region;
 	const PROGRESSIVE_BLOCK_CONTEXT* context;
 	RFX_PROGRESSIVE_TILE* tile;
+	int status;
 } PROGRESSIVE_TILE_PROCESS_WORK_PARAM;
 
 struct S_PROGRESSIVE_BLOCK_REGION
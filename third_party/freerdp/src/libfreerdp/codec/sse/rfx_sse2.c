@@ -333,6 +333,259 @@ static void rfx_dwt_2d_decode_sse2(INT16* WINPR_RESTRICT buffer, INT16* WINPR_RE
 	rfx_dwt_2d_decode_block_sse2(&buffer[0], dwt_buffer, 32);
 }
 
+/* Reduce-extrapolate inverse DWT used by the progressive codec.
+ *
+ * The lifting steps are split into an even and an odd pass so each can work on
+ * 8 coefficients at a time. The scalar code clamps 32 bit intermediates to
+ * 16 bit, the saturating 16 bit arithmetic below gives identical results. */
+
+/* (a + b) / 2 with C (truncating) division, without a 17 bit intermediate */
+static __inline __m128i __attribute__((ATTRIBUTES)) mm_avg_trunc_epi16(__m128i a, __m128i b)
+{
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i floor = _mm_add_epi16(_mm_add_epi16(_mm_srai_epi16(a, 1), _mm_srai_epi16(b, 1)),
+	                                    _mm_and_si128(_mm_and_si128(a, b), one));
+	const __m128i odd = _mm_and_si128(_mm_xor_si128(a, b), one);
+	return _mm_add_epi16(floor, _mm_and_si128(odd, _mm_srli_epi16(floor, 15)));
+}
+
+static INLINE INT16 rfx_idwt_clamp16(INT32 val)
+{
+	if (val < INT16_MIN)
+		return INT16_MIN;
+	if (val > INT16_MAX)
+		return INT16_MAX;
+	return (INT16)val;
+}
+
+/* pDst[n] = clamp(pL[n] - (pHp[n] + pH[n]) / 2) */
+static __inline void __attribute__((ATTRIBUTES))
+rfx_idwt_extrapolate_even_sse2(const INT16* WINPR_RESTRICT pL, const INT16* WINPR_RESTRICT pHp,
+                               const INT16* WINPR_RESTRICT pH, INT16* WINPR_RESTRICT pDst,
+                               size_t count)
+{
+	if (count < 8)
+	{
+		for (size_t n = 0; n < count; n++)
+			pDst[n] = rfx_idwt_clamp16((INT32)pL[n] - ((pHp[n] + pH[n]) / 2));
+		return;
+	}
+
+	/* The last vector overlaps the previous one instead of a scalar tail */
+	for (size_t x = 0; x < count; x += 8)
+	{
+		const size_t n = (x + 8 <= count) ? x : count - 8;
+		const __m128i l = _mm_loadu_si128((const __m128i*)&pL[n]);
+		const __m128i hp = _mm_loadu_si128((const __m128i*)&pHp[n]);
+		const __m128i h = _mm_loadu_si128((const __m128i*)&pH[n]);
+		_mm_storeu_si128((__m128i*)&pDst[n], _mm_subs_epi16(l, mm_avg_trunc_epi16(hp, h)));
+	}
+}
+
+/* pDst[n] = clamp((pE0[n] + pE1[n]) / 2 + 2 * pH[n]) */
+static __inline void __attribute__((ATTRIBUTES))
+rfx_idwt_extrapolate_odd_sse2(const INT16* WINPR_RESTRICT pE0, const INT16* WINPR_RESTRICT pE1,
+                              const INT16* WINPR_RESTRICT pH, INT16* WINPR_RESTRICT pDst,
+                              size_t count)
+{
+	if (count < 8)
+	{
+		for (size_t n = 0; n < count; n++)
+			pDst[n] = rfx_idwt_clamp16(((pE0[n] + pE1[n]) / 2) + (2 * pH[n]));
+		return;
+	}
+
+	for (size_t x = 0; x < count; x += 8)
+	{
+		const size_t n = (x + 8 <= count) ? x : count - 8;
+		const __m128i e0 = _mm_loadu_si128((const __m128i*)&pE0[n]);
+		const __m128i e1 = _mm_loadu_si128((const __m128i*)&pE1[n]);
+		const __m128i h = _mm_loadu_si128((const __m128i*)&pH[n]);
+		/* Both additions of h saturate in the same direction, so this equals clamp(avg + 2h) */
+		const __m128i v = _mm_adds_epi16(_mm_adds_epi16(mm_avg_trunc_epi16(e0, e1), h), h);
+		_mm_storeu_si128((__m128i*)&pDst[n], v);
+	}
+}
+
+static __inline void __attribute__((ATTRIBUTES))
+rfx_idwt_extrapolate_horiz_sse2(const INT16* WINPR_RESTRICT pLowBand, size_t nLowStep,
+                                const INT16* WINPR_RESTRICT pHighBand, size_t nHighStep,
+                                INT16* WINPR_RESTRICT pDstBand, size_t nDstStep, size_t nLowCount,
+                                size_t nHighCount, size_t nDstCount)
+{
+	INT16 even[64] = { 0 };
+	INT16 odd[64] = { 0 };
+
+	WINPR_ASSERT(nHighCount > 0);
+	WINPR_ASSERT(nHighCount <= ARRAYSIZE(even));
+
+	for (size_t i = 0; i < nDstCount; i++)
+	{
+		const INT16* pL = pLowBand;
+		const INT16* pH = pHighBand;
+		INT16* pX = pDstBand;
+		const size_t n = nHighCount - 1;
+
+		even[0] = rfx_idwt_clamp16((INT32)pL[0] - pH[0]);
+		rfx_idwt_extrapolate_even_sse2(&pL[1], pH, &pH[1], &even[1], n);
+		rfx_idwt_extrapolate_odd_sse2(even, &even[1], pH, odd, n);
+
+		if (n < 8)
+		{
+			for (size_t j = 0; j < n; j++)
+			{
+				pX[2 * j] = even[j];
+				pX[2 * j + 1] = odd[j];
+			}
+		}
+		else
+		{
+			for (size_t x = 0; x < n; x += 8)
+			{
+				const size_t j = (x + 8 <= n) ? x : n - 8;
+				const __m128i e = _mm_loadu_si128((const __m128i*)&even[j]);
+				const __m128i o = _mm_loadu_si128((const __m128i*)&odd[j]);
+				_mm_storeu_si128((__m128i*)&pX[2 * j], _mm_unpacklo_epi16(e, o));
+				_mm_storeu_si128((__m128i*)&pX[2 * j + 8], _mm_unpackhi_epi16(e, o));
+			}
+		}
+
+		pX += 2 * n;
+		pL += nHighCount;
+		const INT16 X2 = even[n];
+		const INT16 H0 = pH[n];
+
+		if (nLowCount <= nHighCount)
+		{
+			pX[0] = X2;
+			pX[1] = rfx_idwt_clamp16((INT32)X2 + (2 * H0));
+		}
+		else if (nLowCount == nHighCount + 1)
+		{
+			const INT16 X0 = rfx_idwt_clamp16((INT32)pL[0] - H0);
+			pX[0] = X2;
+			pX[1] = rfx_idwt_clamp16(((X0 + X2) / 2) + (2 * H0));
+			pX[2] = X0;
+		}
+		else
+		{
+			const INT16 X0 = rfx_idwt_clamp16((INT32)pL[0] - (H0 / 2));
+			pX[0] = X2;
+			pX[1] = rfx_idwt_clamp16(((X0 + X2) / 2) + (2 * H0));
+			pX[2] = X0;
+			pX[3] = rfx_idwt_clamp16((X0 + pL[1]) / 2);
+		}
+
+		pLowBand += nLowStep;
+		pHighBand += nHighStep;
+		pDstBand += nDstStep;
+	}
+}
+
+/* Works on whole rows: the even output rows are computed first, the odd rows
+ * then interpolate between the even rows already stored in the destination. */
+static __inline void __attribute__((ATTRIBUTES))
+rfx_idwt_extrapolate_vert_sse2(const INT16* WINPR_RESTRICT pLowBand, size_t nLowStep,
+                               const INT16* WINPR_RESTRICT pHighBand, size_t nHighStep,
+                               INT16* WINPR_RESTRICT pDstBand, size_t nDstStep, size_t nLowCount,
+                               size_t nHighCount, size_t nDstCount)
+{
+	WINPR_ASSERT(nHighCount > 0);
+
+	const size_t n = nHighCount - 1;
+
+	rfx_idwt_extrapolate_even_sse2(pLowBand, pHighBand, pHighBand, pDstBand, nDstCount);
+
+	for (size_t k = 1; k <= n; k++)
+		rfx_idwt_extrapolate_even_sse2(&pLowBand[k * nLowStep], &pHighBand[(k - 1) * nHighStep],
+		                               &pHighBand[k * nHighStep], &pDstBand[2 * k * nDstStep],
+		                               nDstCount);
+
+	for (size_t k = 0; k < n; k++)
+		rfx_idwt_extrapolate_odd_sse2(&pDstBand[2 * k * nDstStep], &pDstBand[2 * (k + 1) * nDstStep],
+		                              &pHighBand[k * nHighStep], &pDstBand[(2 * k + 1) * nDstStep],
+		                              nDstCount);
+
+	const INT16* pL = &pLowBand[nHighCount * nLowStep];
+	const INT16* pH = &pHighBand[n * nHighStep];
+	const INT16* pX2 = &pDstBand[2 * n * nDstStep];
+	INT16* pX1 = &pDstBand[(2 * n + 1) * nDstStep];
+	INT16* pX0 = &pDstBand[(2 * n + 2) * nDstStep];
+
+	if (nLowCount <= nHighCount)
+	{
+		for (size_t x = 0; x < nDstCount; x++)
+			pX1[x] = rfx_idwt_clamp16((INT32)pX2[x] + (2 * pH[x]));
+	}
+	else if (nLowCount == nHighCount + 1)
+	{
+		rfx_idwt_extrapolate_even_sse2(pL, pH, pH, pX0, nDstCount);
+		rfx_idwt_extrapolate_odd_sse2(pX2, pX0, pH, pX1, nDstCount);
+	}
+	else
+	{
+		INT16* pX3 = &pDstBand[(2 * n + 3) * nDstStep];
+
+		for (size_t x = 0; x < nDstCount; x++)
+			pX0[x] = rfx_idwt_clamp16((INT32)pL[x] - (pH[x] / 2));
+
+		rfx_idwt_extrapolate_odd_sse2(pX2, pX0, pH, pX1, nDstCount);
+
+		for (size_t x = 0; x < nDstCount; x++)
+			pX3[x] = rfx_idwt_clamp16((pX0[x] + pL[nLowStep + x]) / 2);
+	}
+}
+
+static INLINE size_t prfx_get_band_l_count(size_t level)
+{
+	return (64 >> level) + 1;
+}
+
+static INLINE size_t prfx_get_band_h_count(size_t level)
+{
+	if (level == 1)
+		return (64 >> 1) - 1;
+	else
+		return (64 + (1 << (level - 1))) >> level;
+}
+
+static __inline void __attribute__((ATTRIBUTES))
+rfx_dwt_2d_decode_extrapolate_block_sse2(INT16* WINPR_RESTRICT buffer, INT16* WINPR_RESTRICT temp,
+                                         size_t level)
+{
+	const size_t nBandL = prfx_get_band_l_count(level);
+	const size_t nBandH = prfx_get_band_h_count(level);
+	const size_t nDstStep = nBandL + nBandH;
+
+	const INT16* HL = &buffer[0];
+	const INT16* LH = &HL[nBandH * nBandL];
+	const INT16* HH = &LH[nBandL * nBandH];
+	const INT16* LL = &HH[nBandH * nBandH];
+	INT16* L = &temp[0];
+	INT16* H = &temp[nBandL * nDstStep];
+
+	/* horizontal (LL + HL -> L) */
+	rfx_idwt_extrapolate_horiz_sse2(LL, nBandL, HL, nBandH, L, nDstStep, nBandL, nBandH, nBandL);
+
+	/* horizontal (LH + HH -> H) */
+	rfx_idwt_extrapolate_horiz_sse2(LH, nBandL, HH, nBandH, H, nDstStep, nBandL, nBandH, nBandH);
+
+	/* vertical (L + H -> LL) */
+	rfx_idwt_extrapolate_vert_sse2(L, nDstStep, H, nDstStep, buffer, nDstStep, nBandL, nBandH,
+	                               nBandL + nBandH);
+}
+
+static void rfx_dwt_2d_extrapolate_decode_sse2(INT16* WINPR_RESTRICT buffer,
+                                               INT16* WINPR_RESTRICT temp)
+{
+	WINPR_ASSERT(buffer);
+	WINPR_ASSERT(temp);
+
+	rfx_dwt_2d_decode_extrapolate_block_sse2(&buffer[3807], temp, 3);
+	rfx_dwt_2d_decode_extrapolate_block_sse2(&buffer[3007], temp, 2);
+	rfx_dwt_2d_decode_extrapolate_block_sse2(&buffer[0], temp, 1);
+}
+
 static __inline void __attribute__((ATTRIBUTES))
 rfx_dwt_2d_encode_block_vert_sse2(INT16* WINPR_RESTRICT src, INT16* WINPR_RESTRICT l,
                                   INT16* WINPR_RESTRICT h, size_t subband_width)
@@ -462,6 +715,7 @@ void rfx_init_sse2_int(RFX_CONTEXT* WINPR_RESTRICT context)
 	context->quantization_decode = rfx_quantization_decode_sse2;
 	context->quantization_encode = rfx_quantization_encode_sse2;
 	context->dwt_2d_decode = rfx_dwt_2d_decode_sse2;
+	context->dwt_2d_extrapolate_decode = rfx_dwt_2d_extrapolate_decode_sse2;
 	context->dwt_2d_encode = rfx_dwt_2d_encode_sse2;
 #else
 	WINPR_UNUSED(context);
@@ -20,6 +20,7 @@
 
 #include <stdio.h>
 
+#include <winpr/assert.h>
 #include <winpr/crypto.h>
 #include <winpr/sysinfo.h>
 #include <freerdp/primitives.h>
@@ -198,11 +199,331 @@ static BOOL primitives_RGB2444_benchmark_run(primitives_YUV_benchmark* bench, pr
 	return TRUE;
 }
 
+#define BASIC_BENCHMARK_COUNT 19
+
+typedef struct
+{
+	prim_size_t roi;
+	UINT32 stride;
+	UINT32 len;
+	size_t size;
+	BYTE* src1;
+	BYTE* src2;
+	BYTE* dst;
+	BYTE* dstInit;
+	BOOL haveReference;
+	UINT64 reference[BASIC_BENCHMARK_COUNT];
+} primitives_basic_benchmark;
+
+typedef pstatus_t (*primitives_basic_benchmark_fn)(primitives_basic_benchmark* bench,
+                                                    primitives_t* prims);
+
+static void primitives_basic_benchmark_free(primitives_basic_benchmark* bench)
+{
+	if (!bench)
+		return;
+
+	winpr_aligned_free(bench->src1);
+	winpr_aligned_free(bench->src2);
+	winpr_aligned_free(bench->dst);
+	winpr_aligned_free(bench->dstInit);
+
+	const primitives_basic_benchmark empty = { 0 };
+	*bench = empty;
+}
+
+static primitives_basic_benchmark primitives_basic_benchmark_init(void)
+{
+	primitives_basic_benchmark ret = { 0 };
+	ret.roi.width = 3840;
+	ret.roi.height = 2160;
+	ret.stride = ret.roi.width * 4;
+	ret.len = ret.roi.width * ret.roi.height;
+
+	ret.size = 1ull * ret.stride * ret.roi.height;
+	ret.src1 = winpr_aligned_malloc(ret.size, 16);
+	ret.src2 = winpr_aligned_malloc(ret.size, 16);
+	ret.dst = winpr_aligned_malloc(ret.size, 16);
+	ret.dstInit = winpr_aligned_malloc(ret.size, 16);
+	if (!ret.src1 || !ret.src2 || !ret.dst || !ret.dstInit)
+		goto fail;
+
+	winpr_RAND(ret.src1, ret.size);
+	winpr_RAND(ret.src2, ret.size);
+	winpr_RAND(ret.dstInit, ret.size);
+	return ret;
+
+fail:
+	primitives_basic_benchmark_free(&ret);
+	return ret;
+}
+
+static pstatus_t primitives_add_benchmark(primitives_basic_benchmark* bench, primitives_t* prims)
+{
+	/* The buffers are sized for 32bpp, so there are two INT16 per pixel. */
+	return prims->add_16s((const INT16*)bench->src1, (const INT16*)bench->src2,
+	                      (INT16*)bench->dst, bench->len * 2);
+}
+
+static pstatus_t primitives_add_inplace_benchmark(primitives_basic_benchmark* bench,
+                                                  primitives_t* prims)
+{
+	/* Both halves of dst are read and written. */
+	return prims->add_16s_inplace((INT16*)bench->dst, (INT16*)&bench->dst[bench->size / 2],
+	                              bench->len);
+}
+
+static pstatus_t primitives_alphaComp_benchmark(primitives_basic_benchmark* bench,
+                                                primitives_t* prims)
+{
+	return prims->alphaComp_argb(bench->src1, bench->stride, bench->src2, bench->stride,
+	                             bench->dst, bench->stride, bench->roi.width, bench->roi.height);
+}
+
+static pstatus_t primitives_andC_benchmark(primitives_basic_benchmark* bench, primitives_t* prims)
+{
+	return prims->andC_32u((const UINT32*)bench->src1, 0xFF00FF00, (UINT32*)bench->dst,
+	                       (INT32)bench->len);
+}
+
+static pstatus_t primitives_orC_benchmark(primitives_basic_benchmark* bench, primitives_t* prims)
+{
+	return prims->orC_32u((const UINT32*)bench->src1, 0xFF000000, (UINT32*)bench->dst,
+	                      (INT32)bench->len);
+}
+
+static pstatus_t primitives_copy_benchmark(primitives_basic_benchmark* bench, primitives_t* prims)
+{
+	return prims->copy_no_overlap(bench->dst, PIXEL_FORMAT_BGRA32, bench->stride, 0, 0,
+	                              bench->roi.width, bench->roi.height, bench->src1,
+	                              PIXEL_FORMAT_BGRX32, bench->stride, 0, 0, NULL,
+	                              FREERDP_KEEP_DST_ALPHA);
+}
+
+static pstatus_t primitives_copy24_benchmark(primitives_basic_benchmark* bench,
+                                             primitives_t* prims)
+{
+	return prims->copy_no_overlap(bench->dst, PIXEL_FORMAT_BGRA32, bench->stride, 0, 0,
+	                              bench->roi.width, bench->roi.height, bench->src1,
+	                              PIXEL_FORMAT_BGR24, bench->roi.width * 3, 0, 0, NULL,
+	                              FREERDP_KEEP_DST_ALPHA);
+}
+
+static pstatus_t primitives_set_benchmark(primitives_basic_benchmark* bench, primitives_t* prims)
+{
+	return prims->set_32u(0xFF336699, (UINT32*)bench->dst, bench->len);
+}
+
+static pstatus_t primitives_set32s_benchmark(primitives_basic_benchmark* bench,
+                                             primitives_t* prims)
+{
+	return prims->set_32s(-0x3399, (INT32*)bench->dst, bench->len);
+}
+
+static pstatus_t primitives_lShift_benchmark(primitives_basic_benchmark* bench,
+                                             primitives_t* prims)
+{
+	return prims->lShiftC_16s((const INT16*)bench->src1, 5, (INT16*)bench->dst, bench->len * 2);
+}
+
+static pstatus_t primitives_lShift_inplace_benchmark(primitives_basic_benchmark* bench,
+                                                     primitives_t* prims)
+{
+	return prims->lShiftC_16s_inplace((INT16*)bench->dst, 3, bench->len * 2);
+}
+
+static pstatus_t primitives_lShift16u_benchmark(primitives_basic_benchmark* bench,
+                                                primitives_t* prims)
+{
+	return prims->lShiftC_16u((const UINT16*)bench->src1, 7, (UINT16*)bench->dst, bench->len * 2);
+}
+
+static pstatus_t primitives_rShift16s_benchmark(primitives_basic_benchmark* bench,
+                                                primitives_t* prims)
+{
+	return prims->rShiftC_16s((const INT16*)bench->src1, 5, (INT16*)bench->dst, bench->len * 2);
+}
+
+static pstatus_t primitives_rShift_benchmark(primitives_basic_benchmark* bench,
+                                             primitives_t* prims)
+{
+	return prims->rShiftC_16u((const UINT16*)bench->src1, 5, (UINT16*)bench->dst, bench->len * 2);
+}
+
+static pstatus_t primitives_sign_benchmark(primitives_basic_benchmark* bench, primitives_t* prims)
+{
+	return prims->sign_16s((const INT16*)bench->src1, (INT16*)bench->dst, bench->len * 2);
+}
+
+static pstatus_t primitives_planarMerge_benchmark(primitives_basic_benchmark* bench,
+                                                  primitives_t* prims)
+{
+	const size_t plane = 1ull * bench->roi.width * bench->roi.height;
+	for (UINT32 y = 0; y < bench->roi.height; y++)
+	{
+		const size_t offset = 1ull * y * bench->roi.width;
+		const BYTE* planes[4] = { &bench->src1[offset], &bench->src1[plane + offset],
+			                      &bench->src1[2 * plane + offset], &bench->src2[offset] };
+		const pstatus_t status = prims->planarMerge_8u_P4C4R(
+		    planes, &bench->dst[1ull * y * bench->stride], PIXEL_FORMAT_BGRA32, bench->roi.width);
+		if (status != PRIMITIVES_SUCCESS)
+			return status;
+	}
+	return PRIMITIVES_SUCCESS;
+}
+
+static pstatus_t primitives_planarDelta_benchmark(primitives_basic_benchmark* bench,
+                                                  primitives_t* prims)
+{
+	for (UINT32 y = 0; y < bench->roi.height; y++)
+	{
+		const size_t offset = 1ull * y * bench->stride;
+		const pstatus_t status =
+		    prims->planarDeltaDecode_8u(&bench->src1[offset], &bench->dst[offset], bench->stride);
+		if (status != PRIMITIVES_SUCCESS)
+			return status;
+	}
+	return PRIMITIVES_SUCCESS;
+}
+
+static pstatus_t primitives_rleExpand_benchmark(primitives_basic_benchmark* bench,
+                                                primitives_t* prims)
+{
+	/* 24bpp pattern, one run per scanline */
+	for (UINT32 y = 0; y < bench->roi.height; y++)
+	{
+		const pstatus_t status = prims->rleExpand_8u(&bench->src1[y * 3ull], 3,
+		                                             &bench->dst[1ull * y * bench->stride],
+		                                             bench->roi.width);
+		if (status != PRIMITIVES_SUCCESS)
+			return status;
+	}
+	return PRIMITIVES_SUCCESS;
+}
+
+static pstatus_t primitives_rleXorExpand_benchmark(primitives_basic_benchmark* bench,
+                                                   primitives_t* prims)
+{
+	for (UINT32 y = 0; y < bench->roi.height; y++)
+	{
+		const size_t offset = 1ull * y * bench->stride;
+		const pstatus_t status = prims->rleXorExpand_8u(&bench->src1[offset], &bench->src2[y * 4ull],
+		                                                4, &bench->dst[offset], bench->roi.width);
+		if (status != PRIMITIVES_SUCCESS)
+			return status;
+	}
+	return PRIMITIVES_SUCCESS;
+}
+
+static UINT64 primitives_basic_benchmark_hash(const primitives_basic_benchmark* bench)
+{
+	UINT64 hash = 14695981039346656037ull;
+
+	for (size_t x = 0; x < bench->size; x++)
+	{
+		hash ^= bench->dst[x];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static BOOL primitives_basic_benchmark_run(primitives_basic_benchmark* bench, primitives_t* prims,
+                                           size_t index, const char* name,
+                                           primitives_basic_benchmark_fn fkt, BOOL exact)
+{
+	UINT64 best = UINT64_MAX;
+
+	for (size_t x = 0; x < 10; x++)
+	{
+		/* Every run starts from the same destination, some primitives read it. */
+		memcpy(bench->dst, bench->dstInit, bench->size);
+
+		const UINT64 start = winpr_GetTickCount64NS();
+		const pstatus_t status = fkt(bench, prims);
+		const UINT64 end = winpr_GetTickCount64NS();
+		if (status != PRIMITIVES_SUCCESS)
+		{
+			(void)fprintf(stderr, "Running %s failed\n", name);
+			return FALSE;
+		}
+
+		const UINT64 diff = end - start;
+		if (diff < best)
+			best = diff;
+	}
+
+	const UINT64 hash = primitives_basic_benchmark_hash(bench);
+	char buffer[32] = { 0 };
+	printf("%-24s %" PRIu32 "x%" PRIu32 " best of 10 took %sns, hash %016" PRIx64 "\n", name,
+	       bench->roi.width, bench->roi.height, print_time(best, buffer, sizeof(buffer)), hash);
+
+	/* The first pass runs the generic primitives, every other implementation must match.
+	 * Primitives that are allowed to approximate (the SSE alpha blending rounds differently)
+	 * only report the difference. */
+	WINPR_ASSERT(index < ARRAYSIZE(bench->reference));
+	if (!bench->haveReference)
+		bench->reference[index] = hash;
+	else if (bench->reference[index] != hash)
+	{
+		(void)fprintf(stderr, "%s differs from the generic implementation\n", name);
+		return !exact;
+	}
+	return TRUE;
+}
+
+static BOOL primitives_basic_benchmarks_run(primitives_basic_benchmark* bench,
+                                            primitives_t* prims)
+{
+	const struct
+	{
+		const char* name;
+		primitives_basic_benchmark_fn fkt;
+		BOOL exact;
+	} benchmarks[] = { { "add_16s", primitives_add_benchmark, TRUE },
+		               { "add_16s_inplace", primitives_add_inplace_benchmark, TRUE },
+		               { "alphaComp_argb", primitives_alphaComp_benchmark, FALSE },
+		               { "andC_32u", primitives_andC_benchmark, TRUE },
+		               { "orC_32u", primitives_orC_benchmark, TRUE },
+		               { "copy_no_overlap[32]", primitives_copy_benchmark, TRUE },
+		               { "copy_no_overlap[24]", primitives_copy24_benchmark, TRUE },
+		               { "set_32u", primitives_set_benchmark, TRUE },
+		               { "set_32s", primitives_set32s_benchmark, TRUE },
+		               { "lShiftC_16s", primitives_lShift_benchmark, TRUE },
+		               { "lShiftC_16s_inplace", primitives_lShift_inplace_benchmark, TRUE },
+		               { "lShiftC_16u", primitives_lShift16u_benchmark, TRUE },
+		               { "rShiftC_16s", primitives_rShift16s_benchmark, TRUE },
+		               { "rShiftC_16u", primitives_rShift_benchmark, TRUE },
+		               { "sign_16s", primitives_sign_benchmark, TRUE },
+		               { "planarMerge_8u_P4C4R", primitives_planarMerge_benchmark, TRUE },
+		               { "planarDeltaDecode_8u", primitives_planarDelta_benchmark, TRUE },
+		               { "rleExpand_8u", primitives_rleExpand_benchmark, TRUE },
+		               { "rleXorExpand_8u", primitives_rleXorExpand_benchmark, TRUE } };
+	WINPR_STATIC_ASSERT(ARRAYSIZE(benchmarks) == BASIC_BENCHMARK_COUNT);
+
+	for (size_t x = 0; x < ARRAYSIZE(benchmarks); x++)
+	{
+		if (!primitives_basic_benchmark_run(bench, prims, x, benchmarks[x].name, benchmarks[x].fkt,
+		                                    benchmarks[x].exact))
+			return FALSE;
+	}
+
+	bench->haveReference = TRUE;
+	return TRUE;
+}
+
 int main(int argc, char* argv[])
 {
+	int rc = -1;
 	WINPR_UNUSED(argc);
 	WINPR_UNUSED(argv);
 	primitives_YUV_benchmark bench = primitives_YUV_benchmark_init();
+	primitives_basic_benchmark basic = primitives_basic_benchmark_init();
+	if (!basic.dst)
+	{
+		(void)fprintf(stderr, "failed to allocate basic primitives benchmark buffers\n");
+		goto fail;
+	}
 
 	for (primitive_hints hint = PRIMITIVES_PURE_SOFT; hint < PRIMITIVES_AUTODETECT; hint++)
 	{
@@ -245,8 +566,18 @@ int main(int argc, char* argv[])
 			goto fail;
 		}
 		printf("\n");
+
+		printf("Running basic primitives benchmark on %s implementation:\n", hintstr);
+		if (!primitives_basic_benchmarks_run(&basic, prim))
+		{
+			(void)fprintf(stderr, "basic primitives benchmark failed\n");
+			goto fail;
+		}
+		printf("\n");
 	}
+	rc = 0;
 fail:
+	primitives_basic_benchmark_free(&basic);
 	primitives_YUV_benchmark_free(&bench);
-	return 0;
+	return rc;
 }
@@ -0,0 +1,93 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized add operations.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_add.h"
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+static primitives_t* generic = NULL;
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_add_16s(const INT16* WINPR_RESTRICT pSrc1, const INT16* WINPR_RESTRICT pSrc2,
+                              INT16* WINPR_RESTRICT pDst, UINT32 len)
+{
+	UINT32 x = 0;
+
+	/* NEON loads have no alignment requirement, so there is no scalar prologue. */
+	for (; x + 32 <= len; x += 32)
+	{
+		const int16x8_t d0 = vqaddq_s16(vld1q_s16(&pSrc1[x + 0]), vld1q_s16(&pSrc2[x + 0]));
+		const int16x8_t d1 = vqaddq_s16(vld1q_s16(&pSrc1[x + 8]), vld1q_s16(&pSrc2[x + 8]));
+		const int16x8_t d2 = vqaddq_s16(vld1q_s16(&pSrc1[x + 16]), vld1q_s16(&pSrc2[x + 16]));
+		const int16x8_t d3 = vqaddq_s16(vld1q_s16(&pSrc1[x + 24]), vld1q_s16(&pSrc2[x + 24]));
+		vst1q_s16(&pDst[x + 0], d0);
+		vst1q_s16(&pDst[x + 8], d1);
+		vst1q_s16(&pDst[x + 16], d2);
+		vst1q_s16(&pDst[x + 24], d3);
+	}
+
+	for (; x + 8 <= len; x += 8)
+		vst1q_s16(&pDst[x], vqaddq_s16(vld1q_s16(&pSrc1[x]), vld1q_s16(&pSrc2[x])));
+
+	if (x < len)
+		return generic->add_16s(&pSrc1[x], &pSrc2[x], &pDst[x], len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_add_16s_inplace(INT16* WINPR_RESTRICT pSrcDst1,
+                                      INT16* WINPR_RESTRICT pSrcDst2, UINT32 len)
+{
+	UINT32 x = 0;
+
+	for (; x + 8 <= len; x += 8)
+	{
+		const int16x8_t d = vqaddq_s16(vld1q_s16(&pSrcDst1[x]), vld1q_s16(&pSrcDst2[x]));
+		vst1q_s16(&pSrcDst1[x], d);
+		vst1q_s16(&pSrcDst2[x], d);
+	}
+
+	if (x < len)
+		return generic->add_16s_inplace(&pSrcDst1[x], &pSrcDst2[x], len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_add_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	generic = primitives_get_generic();
+
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->add_16s = neon_add_16s;
+	prims->add_16s_inplace = neon_add_16s_inplace;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
@@ -0,0 +1,110 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized alpha blending routines.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_alphaComp.h"
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+static primitives_t* generic = NULL;
+
+/* Four pixels per vector, computed with the same (alpha + 1) >> 8 double-op
+ * trick as the generic version so the output is bit-identical to it.
+ */
+static INLINE uint32x4_t neon_alphaComp_4px(uint32x4_t src1, uint32x4_t src2)
+{
+	const uint32x4_t mask = vdupq_n_u32(0x00FF00FFU);
+	const uint32x4_t alpha = vaddq_u32(vshrq_n_u32(src1, 24), vdupq_n_u32(1));
+
+	const uint32x4_t s1rb = vandq_u32(src1, mask);
+	const uint32x4_t s1ag = vandq_u32(vshrq_n_u32(src1, 8), mask);
+	const uint32x4_t s2rb = vandq_u32(src2, mask);
+	const uint32x4_t s2ag = vandq_u32(vshrq_n_u32(src2, 8), mask);
+
+	const uint32x4_t drb = vmulq_u32(vsubq_u32(s1rb, s2rb), alpha);
+	const uint32x4_t dag = vmulq_u32(vsubq_u32(s1ag, s2ag), alpha);
+
+	const uint32x4_t rb = vandq_u32(vaddq_u32(vshrq_n_u32(drb, 8), s2rb), mask);
+	const uint32x4_t ag = vshlq_n_u32(vandq_u32(vaddq_u32(vshrq_n_u32(dag, 8), s2ag), mask), 8);
+	const uint32x4_t blend = vorrq_u32(rb, ag);
+
+	/* alpha == 255 copies src1, alpha == 0 copies src2 */
+	const uint32x4_t opaque = vceqq_u32(alpha, vdupq_n_u32(256));
+	const uint32x4_t transparent = vcleq_u32(alpha, vdupq_n_u32(1));
+	return vbslq_u32(opaque, src1, vbslq_u32(transparent, src2, blend));
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_alphaComp_argb(const BYTE* WINPR_RESTRICT pSrc1, UINT32 src1Step,
+                                     const BYTE* WINPR_RESTRICT pSrc2, UINT32 src2Step,
+                                     BYTE* WINPR_RESTRICT pDst, UINT32 dstStep, UINT32 width,
+                                     UINT32 height)
+{
+	if ((width == 0) || (height == 0))
+		return PRIMITIVES_SUCCESS;
+
+	if (width < 4) /* pointless if too small */
+		return generic->alphaComp_argb(pSrc1, src1Step, pSrc2, src2Step, pDst, dstStep, width,
+		                               height);
+
+	const UINT32 rem = width % 4;
+	const UINT32 aligned = width - rem;
+
+	for (size_t y = 0; y < height; y++)
+	{
+		const UINT32* sptr1 = (const UINT32*)(pSrc1 + y * src1Step);
+		const UINT32* sptr2 = (const UINT32*)(pSrc2 + y * src2Step);
+		UINT32* dptr = (UINT32*)(pDst + y * dstStep);
+
+		for (UINT32 x = 0; x < aligned; x += 4)
+			vst1q_u32(&dptr[x], neon_alphaComp_4px(vld1q_u32(&sptr1[x]), vld1q_u32(&sptr2[x])));
+
+		if (rem > 0)
+		{
+			const pstatus_t status =
+			    generic->alphaComp_argb((const BYTE*)&sptr1[aligned], src1Step,
+			                            (const BYTE*)&sptr2[aligned], src2Step,
+			                            (BYTE*)&dptr[aligned], dstStep, rem, 1);
+			if (status != PRIMITIVES_SUCCESS)
+				return status;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_alphaComp_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	generic = primitives_get_generic();
+
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->alphaComp_argb = neon_alphaComp_argb;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
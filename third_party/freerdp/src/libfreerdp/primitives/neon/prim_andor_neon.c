@@ -0,0 +1,105 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized Logical operations.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_andor.h"
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_andC_32u(const UINT32* WINPR_RESTRICT pSrc, UINT32 val,
+                               UINT32* WINPR_RESTRICT pDst, INT32 len)
+{
+	/* Same contract as the generic version: a zero constant is a no-op. */
+	if (val == 0)
+		return PRIMITIVES_SUCCESS;
+
+	const uint32x4_t v = vdupq_n_u32(val);
+	INT32 x = 0;
+
+	for (; x + 16 <= len; x += 16)
+	{
+		const uint32x4_t s0 = vld1q_u32(&pSrc[x + 0]);
+		const uint32x4_t s1 = vld1q_u32(&pSrc[x + 4]);
+		const uint32x4_t s2 = vld1q_u32(&pSrc[x + 8]);
+		const uint32x4_t s3 = vld1q_u32(&pSrc[x + 12]);
+		vst1q_u32(&pDst[x + 0], vandq_u32(s0, v));
+		vst1q_u32(&pDst[x + 4], vandq_u32(s1, v));
+		vst1q_u32(&pDst[x + 8], vandq_u32(s2, v));
+		vst1q_u32(&pDst[x + 12], vandq_u32(s3, v));
+	}
+
+	for (; x + 4 <= len; x += 4)
+		vst1q_u32(&pDst[x], vandq_u32(vld1q_u32(&pSrc[x]), v));
+
+	for (; x < len; x++)
+		pDst[x] = pSrc[x] & val;
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_orC_32u(const UINT32* WINPR_RESTRICT pSrc, UINT32 val,
+                              UINT32* WINPR_RESTRICT pDst, INT32 len)
+{
+	if (val == 0)
+		return PRIMITIVES_SUCCESS;
+
+	const uint32x4_t v = vdupq_n_u32(val);
+	INT32 x = 0;
+
+	for (; x + 16 <= len; x += 16)
+	{
+		const uint32x4_t s0 = vld1q_u32(&pSrc[x + 0]);
+		const uint32x4_t s1 = vld1q_u32(&pSrc[x + 4]);
+		const uint32x4_t s2 = vld1q_u32(&pSrc[x + 8]);
+		const uint32x4_t s3 = vld1q_u32(&pSrc[x + 12]);
+		vst1q_u32(&pDst[x + 0], vorrq_u32(s0, v));
+		vst1q_u32(&pDst[x + 4], vorrq_u32(s1, v));
+		vst1q_u32(&pDst[x + 8], vorrq_u32(s2, v));
+		vst1q_u32(&pDst[x + 12], vorrq_u32(s3, v));
+	}
+
+	for (; x + 4 <= len; x += 4)
+		vst1q_u32(&pDst[x], vorrq_u32(vld1q_u32(&pSrc[x]), v));
+
+	for (; x < len; x++)
+		pDst[x] = pSrc[x] | val;
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_andor_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->andC_32u = neon_andC_32u;
+	prims->orC_32u = neon_orC_32u;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
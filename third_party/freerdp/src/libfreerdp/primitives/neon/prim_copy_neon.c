@@ -0,0 +1,391 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Copy operations.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <winpr/sysinfo.h>
+
+#include <freerdp/config.h>
+
+#include <string.h>
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <freerdp/log.h>
+
+#include "prim_internal.h"
+#include "prim_copy.h"
+#include "../codec/color.h"
+
+#include <freerdp/codec/color.h>
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+/* The structured loads de-interleave 16 pixels into per-channel registers, so
+ * keeping the destination alpha is a register move instead of a byte blend.
+ */
+static INLINE pstatus_t neon_image_copy_bgr24_bgrx32(BYTE* WINPR_RESTRICT pDstData,
+                                                     UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
+                                                     UINT32 nWidth, UINT32 nHeight,
+                                                     const BYTE* WINPR_RESTRICT pSrcData,
+                                                     UINT32 nSrcStep, UINT32 nXSrc, UINT32 nYSrc,
+                                                     int64_t srcVMultiplier, int64_t srcVOffset,
+                                                     int64_t dstVMultiplier, int64_t dstVOffset)
+{
+	const int64_t srcByte = 3;
+	const int64_t dstByte = 4;
+
+	const UINT32 rem = nWidth % 16;
+	const int64_t width = nWidth - rem;
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		int64_t x = 0;
+		for (; x < width; x += 16)
+		{
+			const uint8x16x3_t s = vld3q_u8(&srcLine[(x + nXSrc) * srcByte]);
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			uint8x16x4_t d = vld4q_u8(dst);
+			d.val[0] = s.val[0];
+			d.val[1] = s.val[1];
+			d.val[2] = s.val[2];
+			vst4q_u8(dst, d);
+		}
+
+		for (; x < nWidth; x++)
+		{
+			const BYTE* src = &srcLine[(x + nXSrc) * srcByte];
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			*dst++ = *src++;
+			*dst++ = *src++;
+			*dst++ = *src++;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+static INLINE pstatus_t neon_image_copy_bgrx32_bgrx32(BYTE* WINPR_RESTRICT pDstData,
+                                                      UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
+                                                      UINT32 nWidth, UINT32 nHeight,
+                                                      const BYTE* WINPR_RESTRICT pSrcData,
+                                                      UINT32 nSrcStep, UINT32 nXSrc, UINT32 nYSrc,
+                                                      int64_t srcVMultiplier, int64_t srcVOffset,
+                                                      int64_t dstVMultiplier, int64_t dstVOffset)
+{
+	const int64_t srcByte = 4;
+	const int64_t dstByte = 4;
+
+	const uint8x16_t mask = vreinterpretq_u8_u32(vdupq_n_u32(0x00FFFFFFU));
+	const UINT32 rem = nWidth % 4;
+	const int64_t width = nWidth - rem;
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		int64_t x = 0;
+		for (; x < width; x += 4)
+		{
+			const uint8x16_t s0 = vld1q_u8(&srcLine[(x + nXSrc) * srcByte]);
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			const uint8x16_t s1 = vld1q_u8(dst);
+			vst1q_u8(dst, vbslq_u8(mask, s0, s1));
+		}
+
+		for (; x < nWidth; x++)
+		{
+			const BYTE* src = &srcLine[(x + nXSrc) * srcByte];
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			*dst++ = *src++;
+			*dst++ = *src++;
+			*dst++ = *src++;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+static pstatus_t neon_image_copy_no_overlap_dst_alpha(
+    BYTE* WINPR_RESTRICT pDstData, DWORD DstFormat, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
+    UINT32 nWidth, UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, DWORD SrcFormat,
+    UINT32 nSrcStep, UINT32 nXSrc, UINT32 nYSrc, const gdiPalette* WINPR_RESTRICT palette,
+    UINT32 flags, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset)
+{
+	WINPR_ASSERT(pDstData);
+	WINPR_ASSERT(pSrcData);
+
+	switch (SrcFormat)
+	{
+		case PIXEL_FORMAT_BGR24:
+			switch (DstFormat)
+			{
+				case PIXEL_FORMAT_BGRX32:
+				case PIXEL_FORMAT_BGRA32:
+					return neon_image_copy_bgr24_bgrx32(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset);
+				default:
+					break;
+			}
+			break;
+		case PIXEL_FORMAT_BGRX32:
+		case PIXEL_FORMAT_BGRA32:
+			switch (DstFormat)
+			{
+				case PIXEL_FORMAT_BGRX32:
+				case PIXEL_FORMAT_BGRA32:
+					return neon_image_copy_bgrx32_bgrx32(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset);
+				default:
+					break;
+			}
+			break;
+		case PIXEL_FORMAT_RGBX32:
+		case PIXEL_FORMAT_RGBA32:
+			switch (DstFormat)
+			{
+				case PIXEL_FORMAT_RGBX32:
+				case PIXEL_FORMAT_RGBA32:
+					return neon_image_copy_bgrx32_bgrx32(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset);
+				default:
+					break;
+			}
+			break;
+		default:
+			break;
+	}
+
+	primitives_t* gen = primitives_get_generic();
+	return gen->copy_no_overlap(pDstData, DstFormat, nDstStep, nXDst, nYDst, nWidth, nHeight,
+	                            pSrcData, SrcFormat, nSrcStep, nXSrc, nYSrc, palette, flags);
+}
+
+static INLINE pstatus_t neon_image_copy_bgr24_bgrx32_opaque(
+    BYTE* WINPR_RESTRICT pDstData, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst, UINT32 nWidth,
+    UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, UINT32 nSrcStep, UINT32 nXSrc,
+    UINT32 nYSrc, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset)
+{
+	const int64_t srcByte = 3;
+	const int64_t dstByte = 4;
+
+	const UINT32 rem = nWidth % 16;
+	const int64_t width = nWidth - rem;
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		int64_t x = 0;
+		for (; x < width; x += 16)
+		{
+			const uint8x16x3_t s = vld3q_u8(&srcLine[(x + nXSrc) * srcByte]);
+			uint8x16x4_t d;
+			d.val[0] = s.val[0];
+			d.val[1] = s.val[1];
+			d.val[2] = s.val[2];
+			d.val[3] = vdupq_n_u8(0xFF);
+			vst4q_u8(&dstLine[(x + nXDst) * dstByte], d);
+		}
+
+		for (; x < nWidth; x++)
+		{
+			const BYTE* src = &srcLine[(x + nXSrc) * srcByte];
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			*dst++ = *src++;
+			*dst++ = *src++;
+			*dst++ = *src++;
+			*dst = 0xFF;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* Channels are expanded in 16 bit lanes with the FreeRDPSplitColor rounding,
+ * the saturating narrow clamps the RGB16 green channel like it does. */
+static INLINE pstatus_t neon_image_copy_rgb16_bgrx32(
+    BYTE* WINPR_RESTRICT pDstData, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst, UINT32 nWidth,
+    UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, UINT32 nSrcStep, UINT32 nXSrc,
+    UINT32 nYSrc, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset, BOOL rgb15)
+{
+	const int64_t srcByte = 2;
+	const int64_t dstByte = 4;
+	const int gBits = rgb15 ? 5 : 6;
+
+	const int16x8_t rShift = vdupq_n_s16((int16_t)(rgb15 ? -10 : -11));
+	const int16x8_t gShift = vdupq_n_s16(-5);
+	const int16x8_t gLShift = vdupq_n_s16((int16_t)(8 - gBits));
+	const int16x8_t gRShift = vdupq_n_s16((int16_t)(rgb15 ? -2 : -3));
+	const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+	const uint16x8_t gMask = vdupq_n_u16((uint16_t)((1 << gBits) - 1));
+
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		int64_t x = 0;
+		for (; x + 8 <= nWidth; x += 8)
+		{
+			const uint16x8_t s = vld1q_u16((const uint16_t*)&srcLine[(x + nXSrc) * srcByte]);
+			const uint16x8_t r = vandq_u16(vshlq_u16(s, rShift), mask5);
+			const uint16x8_t g = vandq_u16(vshlq_u16(s, gShift), gMask);
+			const uint16x8_t b = vandq_u16(s, mask5);
+			const uint16x8_t r8 = vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2));
+			const uint16x8_t g8 = vaddq_u16(vshlq_u16(g, gLShift), vshlq_u16(g, gRShift));
+			const uint16x8_t b8 = vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2));
+			uint8x8x4_t d;
+			d.val[0] = vmovn_u16(b8);
+			d.val[1] = vqmovn_u16(g8);
+			d.val[2] = vmovn_u16(r8);
+			d.val[3] = vdup_n_u8(0xFF);
+			vst4_u8(&dstLine[(x + nXDst) * dstByte], d);
+		}
+
+		for (; x < nWidth; x++)
+		{
+			const BYTE* src = &srcLine[(x + nXSrc) * srcByte];
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			const UINT32 color = ((UINT32)src[1] << 8) | src[0];
+			const UINT32 cr = (color >> (rgb15 ? 10 : 11)) & 0x1F;
+			const UINT32 cg = (color >> 5) & ((1u << gBits) - 1u);
+			const UINT32 cb = color & 0x1F;
+			dst[0] = (BYTE)((cb << 3) | (cb >> 2));
+			const UINT32 cg8 = (cg << (8 - gBits)) + (cg >> (rgb15 ? 2 : 3));
+			dst[1] = (BYTE)(cg8 > 255 ? 255 : cg8);
+			dst[2] = (BYTE)((cr << 3) | (cr >> 2));
+			dst[3] = 0xFF;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+static pstatus_t neon_image_copy_no_overlap_no_alpha(
+    BYTE* WINPR_RESTRICT pDstData, DWORD DstFormat, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
+    UINT32 nWidth, UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, DWORD SrcFormat,
+    UINT32 nSrcStep, UINT32 nXSrc, UINT32 nYSrc, const gdiPalette* WINPR_RESTRICT palette,
+    UINT32 flags, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset)
+{
+	switch (DstFormat)
+	{
+		case PIXEL_FORMAT_BGRX32:
+		case PIXEL_FORMAT_BGRA32:
+			switch (SrcFormat)
+			{
+				case PIXEL_FORMAT_BGR24:
+					return neon_image_copy_bgr24_bgrx32_opaque(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset);
+				case PIXEL_FORMAT_RGB16:
+				case PIXEL_FORMAT_RGB15:
+					return neon_image_copy_rgb16_bgrx32(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset,
+					    SrcFormat == PIXEL_FORMAT_RGB15);
+				default:
+					break;
+			}
+			break;
+		default:
+			break;
+	}
+
+	primitives_t* gen = primitives_get_generic();
+	return gen->copy_no_overlap(pDstData, DstFormat, nDstStep, nXDst, nYDst, nWidth, nHeight,
+	                            pSrcData, SrcFormat, nSrcStep, nXSrc, nYSrc, palette, flags);
+}
+
+static pstatus_t neon_image_copy_no_overlap(BYTE* WINPR_RESTRICT pDstData, DWORD DstFormat,
+                                            UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
+                                            UINT32 nWidth, UINT32 nHeight,
+                                            const BYTE* WINPR_RESTRICT pSrcData, DWORD SrcFormat,
+                                            UINT32 nSrcStep, UINT32 nXSrc, UINT32 nYSrc,
+                                            const gdiPalette* WINPR_RESTRICT palette, UINT32 flags)
+{
+	const BOOL vSrcVFlip = (flags & FREERDP_FLIP_VERTICAL) ? TRUE : FALSE;
+	int64_t srcVOffset = 0;
+	int64_t srcVMultiplier = 1;
+	int64_t dstVOffset = 0;
+	int64_t dstVMultiplier = 1;
+
+	if ((nWidth == 0) || (nHeight == 0))
+		return PRIMITIVES_SUCCESS;
+
+	if ((nHeight > INT32_MAX) || (nWidth > INT32_MAX))
+		return -1;
+
+	if (!pDstData || !pSrcData)
+		return -1;
+
+	if (nDstStep == 0)
+		nDstStep = nWidth * FreeRDPGetBytesPerPixel(DstFormat);
+
+	if (nSrcStep == 0)
+		nSrcStep = nWidth * FreeRDPGetBytesPerPixel(SrcFormat);
+
+	if (vSrcVFlip)
+	{
+		srcVOffset = (nHeight - 1ll) * nSrcStep;
+		srcVMultiplier = -1;
+	}
+
+	if (((flags & FREERDP_KEEP_DST_ALPHA) != 0) && FreeRDPColorHasAlpha(DstFormat))
+		return neon_image_copy_no_overlap_dst_alpha(pDstData, DstFormat, nDstStep, nXDst, nYDst,
+		                                            nWidth, nHeight, pSrcData, SrcFormat, nSrcStep,
+		                                            nXSrc, nYSrc, palette, flags, srcVMultiplier,
+		                                            srcVOffset, dstVMultiplier, dstVOffset);
+	else if (FreeRDPAreColorFormatsEqualNoAlpha(SrcFormat, DstFormat))
+		return generic_image_copy_no_overlap_memcpy(pDstData, DstFormat, nDstStep, nXDst, nYDst,
+		                                            nWidth, nHeight, pSrcData, SrcFormat, nSrcStep,
+		                                            nXSrc, nYSrc, palette, srcVMultiplier,
+		                                            srcVOffset, dstVMultiplier, dstVOffset, flags);
+	else
+		return neon_image_copy_no_overlap_no_alpha(pDstData, DstFormat, nDstStep, nXDst, nYDst,
+		                                           nWidth, nHeight, pSrcData, SrcFormat, nSrcStep,
+		                                           nXSrc, nYSrc, palette, flags, srcVMultiplier,
+		                                           srcVOffset, dstVMultiplier, dstVOffset);
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_copy_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->copy_no_overlap = neon_image_copy_no_overlap;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
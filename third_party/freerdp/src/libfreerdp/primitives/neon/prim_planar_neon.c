@@ -0,0 +1,125 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized planar codec helpers.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_planar.h"
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+static primitives_t* generic = NULL;
+
+/* ------------------------------------------------------------------------- */
+static INLINE void neon_planarMerge_C4(const BYTE* WINPR_RESTRICT p0,
+                                       const BYTE* WINPR_RESTRICT p1,
+                                       const BYTE* WINPR_RESTRICT p2,
+                                       const BYTE* WINPR_RESTRICT p3, BYTE* WINPR_RESTRICT pDst,
+                                       UINT32 width)
+{
+	const uint8x16_t opaque = vdupq_n_u8(0xFF);
+	UINT32 x = 0;
+
+	/* VST4 interleaves the four planes in one instruction. */
+	for (; x + 16 <= width; x += 16)
+	{
+		uint8x16x4_t px;
+		px.val[0] = vld1q_u8(&p0[x]);
+		px.val[1] = vld1q_u8(&p1[x]);
+		px.val[2] = vld1q_u8(&p2[x]);
+		px.val[3] = p3 ? vld1q_u8(&p3[x]) : opaque;
+		vst4q_u8(&pDst[4ULL * x], px);
+	}
+
+	for (; x < width; x++)
+	{
+		BYTE* dst = &pDst[4ULL * x];
+		dst[0] = p0[x];
+		dst[1] = p1[x];
+		dst[2] = p2[x];
+		dst[3] = p3 ? p3[x] : 0xFF;
+	}
+}
+
+static pstatus_t neon_planarMerge_8u_P4C4R(const BYTE* WINPR_RESTRICT pSrc[4],
+                                           BYTE* WINPR_RESTRICT pDst, UINT32 DstFormat,
+                                           UINT32 width)
+{
+	switch (DstFormat)
+	{
+		case PIXEL_FORMAT_BGRA32:
+			neon_planarMerge_C4(pSrc[2], pSrc[1], pSrc[0], pSrc[3], pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_BGRX32:
+			neon_planarMerge_C4(pSrc[2], pSrc[1], pSrc[0], NULL, pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_RGBA32:
+			neon_planarMerge_C4(pSrc[0], pSrc[1], pSrc[2], pSrc[3], pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_RGBX32:
+			neon_planarMerge_C4(pSrc[0], pSrc[1], pSrc[2], NULL, pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		default:
+			return generic->planarMerge_8u_P4C4R(pSrc, pDst, DstFormat, width);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_planarDeltaDecode_8u(const BYTE* WINPR_RESTRICT pPrev,
+                                           BYTE* WINPR_RESTRICT pSrcDst, UINT32 len)
+{
+	const uint8x16_t one = vdupq_n_u8(1);
+	UINT32 x = 0;
+
+	for (; x + 16 <= len; x += 16)
+	{
+		const uint8x16_t v = vld1q_u8(&pSrcDst[x]);
+		const uint8x16_t sign = vtstq_u8(v, one);
+		const uint8x16_t delta = veorq_u8(vshrq_n_u8(v, 1), sign);
+		vst1q_u8(&pSrcDst[x], vaddq_u8(vld1q_u8(&pPrev[x]), delta));
+	}
+
+	for (; x < len; x++)
+		pSrcDst[x] = planar_delta_decode(pPrev[x], pSrcDst[x]);
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_planar_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	generic = primitives_get_generic();
+
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->planarMerge_8u_P4C4R = neon_planarMerge_8u_P4C4R;
+	prims->planarDeltaDecode_8u = neon_planarDeltaDecode_8u;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
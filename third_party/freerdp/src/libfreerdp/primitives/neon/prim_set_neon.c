@@ -0,0 +1,75 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized routines to set a chunk of memory to a constant.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_set.h"
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+/* set_8u and zero stay on memset: the libc versions for arm already use
+ * wide NEON stores (and DC ZVA for zeroing), which a plain loop cannot beat.
+ */
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_set_32u(UINT32 val, UINT32* WINPR_RESTRICT pDst, UINT32 len)
+{
+	const uint32x4_t v = vdupq_n_u32(val);
+	UINT32 x = 0;
+
+	for (; x + 16 <= len; x += 16)
+	{
+		vst1q_u32(&pDst[x + 0], v);
+		vst1q_u32(&pDst[x + 4], v);
+		vst1q_u32(&pDst[x + 8], v);
+		vst1q_u32(&pDst[x + 12], v);
+	}
+
+	for (; x + 4 <= len; x += 4)
+		vst1q_u32(&pDst[x], v);
+
+	for (; x < len; x++)
+		pDst[x] = val;
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_set_32s(INT32 val, INT32* WINPR_RESTRICT pDst, UINT32 len)
+{
+	return neon_set_32u((UINT32)val, (UINT32*)pDst, len);
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_set_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->set_32s = neon_set_32s;
+	prims->set_32u = neon_set_32u;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
@@ -0,0 +1,187 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Shift operations.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_shift.h"
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+static primitives_t* generic = NULL;
+
+/* VSHL by register shifts left for positive counts and right for negative
+ * ones (arithmetic for signed lanes, logical for unsigned lanes), so one
+ * helper per lane type covers all four directions.
+ * Returns the number of elements processed; the caller finishes the tail.
+ */
+static INLINE UINT32 neon_shift_16s(const INT16* WINPR_RESTRICT pSrc, INT16* WINPR_RESTRICT pDst,
+                                    UINT32 len, int16_t count)
+{
+	const int16x8_t sh = vdupq_n_s16(count);
+	UINT32 x = 0;
+
+	for (; x + 32 <= len; x += 32)
+	{
+		const int16x8_t s0 = vld1q_s16(&pSrc[x + 0]);
+		const int16x8_t s1 = vld1q_s16(&pSrc[x + 8]);
+		const int16x8_t s2 = vld1q_s16(&pSrc[x + 16]);
+		const int16x8_t s3 = vld1q_s16(&pSrc[x + 24]);
+		vst1q_s16(&pDst[x + 0], vshlq_s16(s0, sh));
+		vst1q_s16(&pDst[x + 8], vshlq_s16(s1, sh));
+		vst1q_s16(&pDst[x + 16], vshlq_s16(s2, sh));
+		vst1q_s16(&pDst[x + 24], vshlq_s16(s3, sh));
+	}
+
+	for (; x + 8 <= len; x += 8)
+		vst1q_s16(&pDst[x], vshlq_s16(vld1q_s16(&pSrc[x]), sh));
+
+	return x;
+}
+
+static INLINE UINT32 neon_shift_16u(const UINT16* WINPR_RESTRICT pSrc, UINT16* WINPR_RESTRICT pDst,
+                                    UINT32 len, int16_t count)
+{
+	const int16x8_t sh = vdupq_n_s16(count);
+	UINT32 x = 0;
+
+	for (; x + 32 <= len; x += 32)
+	{
+		const uint16x8_t s0 = vld1q_u16(&pSrc[x + 0]);
+		const uint16x8_t s1 = vld1q_u16(&pSrc[x + 8]);
+		const uint16x8_t s2 = vld1q_u16(&pSrc[x + 16]);
+		const uint16x8_t s3 = vld1q_u16(&pSrc[x + 24]);
+		vst1q_u16(&pDst[x + 0], vshlq_u16(s0, sh));
+		vst1q_u16(&pDst[x + 8], vshlq_u16(s1, sh));
+		vst1q_u16(&pDst[x + 16], vshlq_u16(s2, sh));
+		vst1q_u16(&pDst[x + 24], vshlq_u16(s3, sh));
+	}
+
+	for (; x + 8 <= len; x += 8)
+		vst1q_u16(&pDst[x], vshlq_u16(vld1q_u16(&pSrc[x]), sh));
+
+	return x;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_lShiftC_16s(const INT16* WINPR_RESTRICT pSrc, UINT32 val,
+                                  INT16* WINPR_RESTRICT pDst, UINT32 len)
+{
+	if (val == 0)
+		return PRIMITIVES_SUCCESS;
+	if (val >= 16)
+		return -1;
+
+	const UINT32 x = neon_shift_16s(pSrc, pDst, len, (int16_t)val);
+	if (x < len)
+		return generic->lShiftC_16s(&pSrc[x], val, &pDst[x], len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_rShiftC_16s(const INT16* WINPR_RESTRICT pSrc, UINT32 val,
+                                  INT16* WINPR_RESTRICT pDst, UINT32 len)
+{
+	if (val == 0)
+		return PRIMITIVES_SUCCESS;
+	if (val >= 16)
+		return -1;
+
+	const UINT32 x = neon_shift_16s(pSrc, pDst, len, (int16_t)-(INT32)val);
+	if (x < len)
+		return generic->rShiftC_16s(&pSrc[x], val, &pDst[x], len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_lShiftC_16u(const UINT16* WINPR_RESTRICT pSrc, UINT32 val,
+                                  UINT16* WINPR_RESTRICT pDst, UINT32 len)
+{
+	if (val == 0)
+		return PRIMITIVES_SUCCESS;
+	if (val >= 16)
+		return -1;
+
+	const UINT32 x = neon_shift_16u(pSrc, pDst, len, (int16_t)val);
+	if (x < len)
+		return generic->lShiftC_16u(&pSrc[x], val, &pDst[x], len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_rShiftC_16u(const UINT16* WINPR_RESTRICT pSrc, UINT32 val,
+                                  UINT16* WINPR_RESTRICT pDst, UINT32 len)
+{
+	if (val == 0)
+		return PRIMITIVES_SUCCESS;
+	if (val >= 16)
+		return -1;
+
+	const UINT32 x = neon_shift_16u(pSrc, pDst, len, (int16_t)-(INT32)val);
+	if (x < len)
+		return generic->rShiftC_16u(&pSrc[x], val, &pDst[x], len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_lShiftC_16s_inplace(INT16* WINPR_RESTRICT pSrcDst, UINT32 val, UINT32 len)
+{
+	if (val == 0)
+		return PRIMITIVES_SUCCESS;
+	if (val >= 16)
+		return -1;
+
+	/* Loads of a vector always complete before its store, so src == dst is safe here. */
+	const int16x8_t sh = vdupq_n_s16((int16_t)val);
+	UINT32 x = 0;
+
+	for (; x + 8 <= len; x += 8)
+		vst1q_s16(&pSrcDst[x], vshlq_s16(vld1q_s16(&pSrcDst[x]), sh));
+
+	if (x < len)
+		return generic->lShiftC_16s_inplace(&pSrcDst[x], val, len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_shift_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	generic = primitives_get_generic();
+
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->lShiftC_16s_inplace = neon_lShiftC_16s_inplace;
+	prims->lShiftC_16s = neon_lShiftC_16s;
+	prims->rShiftC_16s = neon_rShiftC_16s;
+	prims->lShiftC_16u = neon_lShiftC_16u;
+	prims->rShiftC_16u = neon_rShiftC_16u;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
@@ -0,0 +1,75 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized sign operations.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_sign.h"
+
+#if defined(NEON_INTRINSICS_ENABLED)
+#include <arm_neon.h>
+
+static primitives_t* generic = NULL;
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t neon_sign_16s(const INT16* WINPR_RESTRICT pSrc, INT16* WINPR_RESTRICT pDst,
+                               UINT32 len)
+{
+	/* Clamping to [-1, 1] yields exactly -1, 0 or 1 for integer input. */
+	const int16x8_t one = vdupq_n_s16(1);
+	const int16x8_t minusOne = vdupq_n_s16(-1);
+	UINT32 x = 0;
+
+	for (; x + 32 <= len; x += 32)
+	{
+		const int16x8_t s0 = vld1q_s16(&pSrc[x + 0]);
+		const int16x8_t s1 = vld1q_s16(&pSrc[x + 8]);
+		const int16x8_t s2 = vld1q_s16(&pSrc[x + 16]);
+		const int16x8_t s3 = vld1q_s16(&pSrc[x + 24]);
+		vst1q_s16(&pDst[x + 0], vminq_s16(vmaxq_s16(s0, minusOne), one));
+		vst1q_s16(&pDst[x + 8], vminq_s16(vmaxq_s16(s1, minusOne), one));
+		vst1q_s16(&pDst[x + 16], vminq_s16(vmaxq_s16(s2, minusOne), one));
+		vst1q_s16(&pDst[x + 24], vminq_s16(vmaxq_s16(s3, minusOne), one));
+	}
+
+	for (; x + 8 <= len; x += 8)
+		vst1q_s16(&pDst[x], vminq_s16(vmaxq_s16(vld1q_s16(&pSrc[x]), minusOne), one));
+
+	if (x < len)
+		return generic->sign_16s(&pSrc[x], &pDst[x], len - x);
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_sign_neon_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(NEON_INTRINSICS_ENABLED)
+	generic = primitives_get_generic();
+
+	WLog_VRB(PRIM_TAG, "NEON optimizations");
+	prims->sign_16s = neon_sign_16s;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or neon intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
@@ -95,4 +95,5 @@ void primitives_init_alphaComp_opt(primitives_t* WINPR_RESTRICT prims)
 {
 	primitives_init_alphaComp(prims);
 	primitives_init_alphaComp_sse3(prims);
+	primitives_init_alphaComp_neon(prims);
 }
@@ -63,4 +63,5 @@ void primitives_init_andor_opt(primitives_t* WINPR_RESTRICT prims)
 {
 	primitives_init_andor(prims);
 	primitives_init_andor_sse3(prims);
+	primitives_init_andor_neon(prims);
 }
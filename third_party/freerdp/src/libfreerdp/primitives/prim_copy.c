@@ -221,6 +221,78 @@ static INLINE pstatus_t generic_image_copy_bgrx32_bgrx32(
 	return PRIMITIVES_SUCCESS;
 }
 
+/* Used when the destination alpha is not kept: the converted pixel is opaque,
+ * matching what FreeRDPConvertColor produces for a source without alpha. */
+static INLINE pstatus_t generic_image_copy_bgr24_bgrx32_opaque(
+    BYTE* WINPR_RESTRICT pDstData, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst, UINT32 nWidth,
+    UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, UINT32 nSrcStep, UINT32 nXSrc,
+    UINT32 nYSrc, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset)
+{
+	const int64_t srcByte = 3;
+	const int64_t dstByte = 4;
+
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		WINPR_PRAGMA_UNROLL_LOOP
+		for (int64_t x = 0; x < nWidth; x++)
+		{
+			dstLine[(x + nXDst) * dstByte + 0] = srcLine[(x + nXSrc) * srcByte + 0];
+			dstLine[(x + nXDst) * dstByte + 1] = srcLine[(x + nXSrc) * srcByte + 1];
+			dstLine[(x + nXDst) * dstByte + 2] = srcLine[(x + nXSrc) * srcByte + 2];
+			dstLine[(x + nXDst) * dstByte + 3] = 0xFF;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* Channel expansion mirrors FreeRDPSplitColor, including its rounding of the
+ * 6 bit RGB16 green channel, so the output is identical to the convert path. */
+static INLINE pstatus_t generic_image_copy_rgb16_bgrx32(
+    BYTE* WINPR_RESTRICT pDstData, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst, UINT32 nWidth,
+    UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, UINT32 nSrcStep, UINT32 nXSrc,
+    UINT32 nYSrc, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset, BOOL rgb15)
+{
+	const int64_t srcByte = 2;
+	const int64_t dstByte = 4;
+	const UINT32 rShift = rgb15 ? 10 : 11;
+	const UINT32 gBits = rgb15 ? 5 : 6;
+	const UINT32 gMask = (1u << gBits) - 1u;
+	const UINT32 gRShift = rgb15 ? 2 : 3;
+
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		for (int64_t x = 0; x < nWidth; x++)
+		{
+			const BYTE* src = &srcLine[(x + nXSrc) * srcByte];
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			const UINT32 color = ((UINT32)src[1] << 8) | src[0];
+			const UINT32 r = (color >> rShift) & 0x1F;
+			const UINT32 g = (color >> 5) & gMask;
+			const UINT32 b = color & 0x1F;
+			dst[0] = (BYTE)((b << 3) | (b >> 2));
+			const UINT32 g8 = (g << (8 - gBits)) + (g >> gRShift);
+			dst[1] = (BYTE)(g8 > 255 ? 255 : g8);
+			dst[2] = (BYTE)((r << 3) | (r >> 2));
+			dst[3] = 0xFF;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
 pstatus_t generic_image_copy_no_overlap_convert(
     BYTE* WINPR_RESTRICT pDstData, DWORD DstFormat, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
     UINT32 nWidth, UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, DWORD SrcFormat,
@@ -356,11 +428,35 @@ static INLINE pstatus_t generic_image_copy_no_overlap_no_alpha(
 		                                            nWidth, nHeight, pSrcData, SrcFormat, nSrcStep,
 		                                            nXSrc, nYSrc, palette, srcVMultiplier,
 		                                            srcVOffset, dstVMultiplier, dstVOffset, flags);
-	else
-		return generic_image_copy_no_overlap_convert(pDstData, DstFormat, nDstStep, nXDst, nYDst,
-		                                             nWidth, nHeight, pSrcData, SrcFormat, nSrcStep,
-		                                             nXSrc, nYSrc, palette, srcVMultiplier,
-		                                             srcVOffset, dstVMultiplier, dstVOffset);
+
+	switch (DstFormat)
+	{
+		case PIXEL_FORMAT_BGRX32:
+		case PIXEL_FORMAT_BGRA32:
+			switch (SrcFormat)
+			{
+				case PIXEL_FORMAT_BGR24:
+					return generic_image_copy_bgr24_bgrx32_opaque(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset);
+				case PIXEL_FORMAT_RGB16:
+				case PIXEL_FORMAT_RGB15:
+					return generic_image_copy_rgb16_bgrx32(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset,
+					    SrcFormat == PIXEL_FORMAT_RGB15);
+				default:
+					break;
+			}
+			break;
+		default:
+			break;
+	}
+
+	return generic_image_copy_no_overlap_convert(pDstData, DstFormat, nDstStep, nXDst, nYDst,
+	                                             nWidth, nHeight, pSrcData, SrcFormat, nSrcStep,
+	                                             nXSrc, nYSrc, palette, srcVMultiplier, srcVOffset,
+	                                             dstVMultiplier, dstVOffset);
 }
 
 static pstatus_t generic_image_copy_no_overlap(BYTE* WINPR_RESTRICT pDstData, DWORD DstFormat,
@@ -426,6 +522,7 @@ void primitives_init_copy_opt(primitives_t* WINPR_RESTRICT prims)
 {
 	primitives_init_copy(prims);
 	primitives_init_copy_sse41(prims);
+	primitives_init_copy_neon(prims);
 #if defined(WITH_AVX2)
 	primitives_init_copy_avx2(prims);
 #endif
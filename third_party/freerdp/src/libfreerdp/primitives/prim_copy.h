@@ -60,4 +60,12 @@ static inline void primitives_init_copy_avx2(primitives_t* WINPR_RESTRICT prims)
 }
 #endif
 
+FREERDP_LOCAL void primitives_init_copy_neon_int(primitives_t* WINPR_RESTRICT prims);
+static inline void primitives_init_copy_neon(primitives_t* WINPR_RESTRICT prims)
+{
+	if (!IsProcessorFeaturePresent(PF_ARM_NEON_INSTRUCTIONS_AVAILABLE))
+		return;
+	primitives_init_copy_neon_int(prims);
+}
+
 #endif
@@ -0,0 +1,114 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Planar codec helpers.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <freerdp/codec/color.h>
+
+#include "prim_internal.h"
+#include "prim_planar.h"
+
+/* ------------------------------------------------------------------------- */
+static INLINE void general_planarMerge_C4(const BYTE* WINPR_RESTRICT pR,
+                                          const BYTE* WINPR_RESTRICT pG,
+                                          const BYTE* WINPR_RESTRICT pB,
+                                          const BYTE* WINPR_RESTRICT pA, BYTE* WINPR_RESTRICT pDst,
+                                          UINT32 width, BOOL bgr)
+{
+	const BYTE* WINPR_RESTRICT p0 = bgr ? pB : pR;
+	const BYTE* WINPR_RESTRICT p2 = bgr ? pR : pB;
+
+	for (UINT32 x = 0; x < width; x++)
+	{
+		*pDst++ = p0[x];
+		*pDst++ = pG[x];
+		*pDst++ = p2[x];
+		*pDst++ = pA ? pA[x] : 0xFF;
+	}
+}
+
+static pstatus_t general_planarMerge_8u_P4C4R(const BYTE* WINPR_RESTRICT pSrc[4],
+                                              BYTE* WINPR_RESTRICT pDst, UINT32 DstFormat,
+                                              UINT32 width)
+{
+	const BYTE* pR = pSrc[0];
+	const BYTE* pG = pSrc[1];
+	const BYTE* pB = pSrc[2];
+	const BYTE* pA = pSrc[3];
+
+	switch (DstFormat)
+	{
+		case PIXEL_FORMAT_BGRA32:
+			general_planarMerge_C4(pR, pG, pB, pA, pDst, width, TRUE);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_BGRX32:
+			general_planarMerge_C4(pR, pG, pB, NULL, pDst, width, TRUE);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_RGBA32:
+			general_planarMerge_C4(pR, pG, pB, pA, pDst, width, FALSE);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_RGBX32:
+			general_planarMerge_C4(pR, pG, pB, NULL, pDst, width, FALSE);
+			return PRIMITIVES_SUCCESS;
+
+		default:
+		{
+			const size_t bpp = FreeRDPGetBytesPerPixel(DstFormat);
+			if (bpp == 0)
+				return -1;
+
+			for (UINT32 x = 0; x < width; x++)
+			{
+				const BYTE alpha = pA ? pA[x] : 0xFF;
+				const UINT32 color = FreeRDPGetColor(DstFormat, pR[x], pG[x], pB[x], alpha);
+				if (!FreeRDPWriteColor(pDst, DstFormat, color))
+					return -1;
+				pDst += bpp;
+			}
+		}
+			return PRIMITIVES_SUCCESS;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t general_planarDeltaDecode_8u(const BYTE* WINPR_RESTRICT pPrev,
+                                              BYTE* WINPR_RESTRICT pSrcDst, UINT32 len)
+{
+	for (UINT32 x = 0; x < len; x++)
+		pSrcDst[x] = planar_delta_decode(pPrev[x], pSrcDst[x]);
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_planar(primitives_t* WINPR_RESTRICT prims)
+{
+	prims->planarMerge_8u_P4C4R = general_planarMerge_8u_P4C4R;
+	prims->planarDeltaDecode_8u = general_planarDeltaDecode_8u;
+}
+
+void primitives_init_planar_opt(primitives_t* WINPR_RESTRICT prims)
+{
+	primitives_init_planar(prims);
+	primitives_init_planar_sse2(prims);
+	primitives_init_planar_neon(prims);
+}
@@ -0,0 +1,87 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * RLE run expansion helpers.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <string.h>
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+
+#include "prim_internal.h"
+#include "prim_rle.h"
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t general_rleExpand_8u(const BYTE* WINPR_RESTRICT pPattern, UINT32 patternSize,
+                                      BYTE* WINPR_RESTRICT pDst, UINT32 count)
+{
+	if ((patternSize == 0) || (patternSize > 8))
+		return -1;
+
+	if (count == 0)
+		return PRIMITIVES_SUCCESS;
+
+	if (patternSize == 1)
+	{
+		memset(pDst, pPattern[0], count);
+		return PRIMITIVES_SUCCESS;
+	}
+
+	/* Write the pattern once, then keep doubling the filled span. */
+	const size_t total = 1ull * patternSize * count;
+	size_t filled = patternSize;
+	memcpy(pDst, pPattern, patternSize);
+
+	while (filled < total)
+	{
+		const size_t chunk = MIN(filled, total - filled);
+		memcpy(&pDst[filled], pDst, chunk);
+		filled += chunk;
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t general_rleXorExpand_8u(const BYTE* WINPR_RESTRICT pSrc,
+                                         const BYTE* WINPR_RESTRICT pPattern, UINT32 patternSize,
+                                         BYTE* WINPR_RESTRICT pDst, UINT32 count)
+{
+	if ((patternSize == 0) || (patternSize > 4))
+		return -1;
+
+	for (UINT32 x = 0; x < count; x++)
+	{
+		for (UINT32 i = 0; i < patternSize; i++)
+			*pDst++ = *pSrc++ ^ pPattern[i];
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_rle(primitives_t* WINPR_RESTRICT prims)
+{
+	prims->rleExpand_8u = general_rleExpand_8u;
+	prims->rleXorExpand_8u = general_rleXorExpand_8u;
+}
+
+void primitives_init_rle_opt(primitives_t* WINPR_RESTRICT prims)
+{
+	primitives_init_rle(prims);
+	primitives_init_rle_sse2(prims);
+	primitives_init_rle_neon(prims);
+}
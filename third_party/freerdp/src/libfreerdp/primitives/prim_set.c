@@ -130,4 +130,5 @@ void primitives_init_set_opt(primitives_t* WINPR_RESTRICT prims)
 {
 	primitives_init_set(prims);
 	primitives_init_set_sse2(prims);
+	primitives_init_set_neon(prims);
 }
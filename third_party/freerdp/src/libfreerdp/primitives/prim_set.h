@@ -39,4 +39,12 @@ static inline void primitives_init_set_sse2(primitives_t* WINPR_RESTRICT prims)
 	primitives_init_set_sse2_int(prims);
 }
 
+FREERDP_LOCAL void primitives_init_set_neon_int(primitives_t* WINPR_RESTRICT prims);
+static inline void primitives_init_set_neon(primitives_t* WINPR_RESTRICT prims)
+{
+	if (!IsProcessorFeaturePresent(PF_ARM_NEON_INSTRUCTIONS_AVAILABLE))
+		return;
+	primitives_init_set_neon_int(prims);
+}
+
 #endif
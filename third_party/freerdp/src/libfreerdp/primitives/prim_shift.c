@@ -147,4 +147,5 @@ void primitives_init_shift_opt(primitives_t* WINPR_RESTRICT prims)
 {
 	primitives_init_shift(prims);
 	primitives_init_shift_sse3(prims);
+	primitives_init_shift_neon(prims);
 }
@@ -47,4 +47,5 @@ void primitives_init_sign_opt(primitives_t* WINPR_RESTRICT prims)
 {
 	primitives_init_sign(prims);
 	primitives_init_sign_ssse3(prims);
+	primitives_init_sign_neon(prims);
 }
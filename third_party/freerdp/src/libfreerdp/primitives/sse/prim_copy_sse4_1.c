@@ -191,6 +191,154 @@ static pstatus_t sse_image_copy_no_overlap_dst_alpha(
 	                            pSrcData, SrcFormat, nSrcStep, nXSrc, nYSrc, palette, flags);
 }
 
+static INLINE pstatus_t sse_image_copy_bgr24_bgrx32_opaque(
+    BYTE* WINPR_RESTRICT pDstData, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst, UINT32 nWidth,
+    UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, UINT32 nSrcStep, UINT32 nXSrc,
+    UINT32 nYSrc, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset)
+{
+	const int64_t srcByte = 3;
+	const int64_t dstByte = 4;
+
+	const __m128i alpha = mm_set1_epu32(0xFF000000);
+	const __m128i smask = mm_set_epu32(0xff0b0a09, 0xff080706, 0xff050403, 0xff020100);
+
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		int64_t x = 0;
+		/* Each load reads 16 bytes for 4 pixels, stop before it passes the line end */
+		for (; x + 6 <= nWidth; x += 4)
+		{
+			const __m128i s0 = LOAD_SI128(&srcLine[(x + nXSrc) * srcByte]);
+			const __m128i s1 = _mm_shuffle_epi8(s0, smask);
+			STORE_SI128(&dstLine[(x + nXDst) * dstByte], _mm_or_si128(s1, alpha));
+		}
+
+		for (; x < nWidth; x++)
+		{
+			const BYTE* src = &srcLine[(x + nXSrc) * srcByte];
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			*dst++ = *src++;
+			*dst++ = *src++;
+			*dst++ = *src++;
+			*dst = 0xFF;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+/* Same rounding and clamping as FreeRDPSplitColor for 5 and 6 bit channels */
+static INLINE __m128i sse_expand_channel(__m128i c, __m128i lshift, __m128i rshift)
+{
+	const __m128i v = _mm_add_epi16(_mm_sll_epi16(c, lshift), _mm_srl_epi16(c, rshift));
+	return _mm_min_epi16(v, _mm_set1_epi16(0xFF));
+}
+
+static INLINE pstatus_t sse_image_copy_rgb16_bgrx32(
+    BYTE* WINPR_RESTRICT pDstData, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst, UINT32 nWidth,
+    UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, UINT32 nSrcStep, UINT32 nXSrc,
+    UINT32 nYSrc, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset, BOOL rgb15)
+{
+	const int64_t srcByte = 2;
+	const int64_t dstByte = 4;
+	const int gBits = rgb15 ? 5 : 6;
+
+	const __m128i rShift = _mm_cvtsi32_si128(rgb15 ? 10 : 11);
+	const __m128i gShift = _mm_cvtsi32_si128(5);
+	const __m128i mask5 = _mm_set1_epi16(0x1F);
+	const __m128i gMask = _mm_set1_epi16((short)((1 << gBits) - 1));
+	const __m128i lshift5 = _mm_cvtsi32_si128(3);
+	const __m128i rshift5 = _mm_cvtsi32_si128(2);
+	const __m128i lshiftG = _mm_cvtsi32_si128(8 - gBits);
+	const __m128i rshiftG = _mm_cvtsi32_si128(rgb15 ? 2 : 3);
+	const __m128i alpha = _mm_set1_epi16((short)0xFF00);
+
+	for (int64_t y = 0; y < nHeight; y++)
+	{
+		const BYTE* WINPR_RESTRICT srcLine =
+		    &pSrcData[srcVMultiplier * (y + nYSrc) * nSrcStep + srcVOffset];
+		BYTE* WINPR_RESTRICT dstLine =
+		    &pDstData[dstVMultiplier * (y + nYDst) * nDstStep + dstVOffset];
+
+		int64_t x = 0;
+		for (; x + 8 <= nWidth; x += 8)
+		{
+			const __m128i s = LOAD_SI128(&srcLine[(x + nXSrc) * srcByte]);
+			const __m128i r = _mm_and_si128(_mm_srl_epi16(s, rShift), mask5);
+			const __m128i g = _mm_and_si128(_mm_srl_epi16(s, gShift), gMask);
+			const __m128i b = _mm_and_si128(s, mask5);
+			const __m128i r8 = sse_expand_channel(r, lshift5, rshift5);
+			const __m128i g8 = sse_expand_channel(g, lshiftG, rshiftG);
+			const __m128i b8 = sse_expand_channel(b, lshift5, rshift5);
+			const __m128i bg = _mm_or_si128(b8, _mm_slli_epi16(g8, 8));
+			const __m128i ra = _mm_or_si128(r8, alpha);
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			STORE_SI128(dst, _mm_unpacklo_epi16(bg, ra));
+			STORE_SI128(dst + 16, _mm_unpackhi_epi16(bg, ra));
+		}
+
+		for (; x < nWidth; x++)
+		{
+			const BYTE* src = &srcLine[(x + nXSrc) * srcByte];
+			BYTE* dst = &dstLine[(x + nXDst) * dstByte];
+			const UINT32 color = ((UINT32)src[1] << 8) | src[0];
+			const UINT32 cr = (color >> (rgb15 ? 10 : 11)) & 0x1F;
+			const UINT32 cg = (color >> 5) & ((1u << gBits) - 1u);
+			const UINT32 cb = color & 0x1F;
+			dst[0] = (BYTE)((cb << 3) | (cb >> 2));
+			const UINT32 cg8 = (cg << (8 - gBits)) + (cg >> (rgb15 ? 2 : 3));
+			dst[1] = (BYTE)(cg8 > 255 ? 255 : cg8);
+			dst[2] = (BYTE)((cr << 3) | (cr >> 2));
+			dst[3] = 0xFF;
+		}
+	}
+
+	return PRIMITIVES_SUCCESS;
+}
+
+static pstatus_t sse_image_copy_no_overlap_no_alpha(
+    BYTE* WINPR_RESTRICT pDstData, DWORD DstFormat, UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
+    UINT32 nWidth, UINT32 nHeight, const BYTE* WINPR_RESTRICT pSrcData, DWORD SrcFormat,
+    UINT32 nSrcStep, UINT32 nXSrc, UINT32 nYSrc, const gdiPalette* WINPR_RESTRICT palette,
+    UINT32 flags, int64_t srcVMultiplier, int64_t srcVOffset, int64_t dstVMultiplier,
+    int64_t dstVOffset)
+{
+	switch (DstFormat)
+	{
+		case PIXEL_FORMAT_BGRX32:
+		case PIXEL_FORMAT_BGRA32:
+			switch (SrcFormat)
+			{
+				case PIXEL_FORMAT_BGR24:
+					return sse_image_copy_bgr24_bgrx32_opaque(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset);
+				case PIXEL_FORMAT_RGB16:
+				case PIXEL_FORMAT_RGB15:
+					return sse_image_copy_rgb16_bgrx32(
+					    pDstData, nDstStep, nXDst, nYDst, nWidth, nHeight, pSrcData, nSrcStep,
+					    nXSrc, nYSrc, srcVMultiplier, srcVOffset, dstVMultiplier, dstVOffset,
+					    SrcFormat == PIXEL_FORMAT_RGB15);
+				default:
+					break;
+			}
+			break;
+		default:
+			break;
+	}
+
+	primitives_t* gen = primitives_get_generic();
+	return gen->copy_no_overlap(pDstData, DstFormat, nDstStep, nXDst, nYDst, nWidth, nHeight,
+	                            pSrcData, SrcFormat, nSrcStep, nXSrc, nYSrc, palette, flags);
+}
+
 static pstatus_t sse_image_copy_no_overlap(BYTE* WINPR_RESTRICT pDstData, DWORD DstFormat,
                                            UINT32 nDstStep, UINT32 nXDst, UINT32 nYDst,
                                            UINT32 nWidth, UINT32 nHeight,
@@ -236,11 +384,10 @@ static pstatus_t sse_image_copy_no_overlap(BYTE* WINPR_RESTRICT pDstData, DWORD
 		                                            nXSrc, nYSrc, palette, srcVMultiplier,
 		                                            srcVOffset, dstVMultiplier, dstVOffset, flags);
 	else
-	{
-		primitives_t* gen = primitives_get_generic();
-		return gen->copy_no_overlap(pDstData, DstFormat, nDstStep, nXDst, nYDst, nWidth, nHeight,
-		                            pSrcData, SrcFormat, nSrcStep, nXSrc, nYSrc, palette, flags);
-	}
+		return sse_image_copy_no_overlap_no_alpha(pDstData, DstFormat, nDstStep, nXDst, nYDst,
+		                                          nWidth, nHeight, pSrcData, SrcFormat, nSrcStep,
+		                                          nXSrc, nYSrc, palette, flags, srcVMultiplier,
+		                                          srcVOffset, dstVMultiplier, dstVOffset);
 }
 #endif
 
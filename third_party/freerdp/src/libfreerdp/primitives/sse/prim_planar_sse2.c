@@ -0,0 +1,136 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized planar codec helpers.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_avxsse.h"
+#include "prim_planar.h"
+
+#if defined(SSE_AVX_INTRINSICS_ENABLED)
+#include <emmintrin.h>
+
+static primitives_t* generic = NULL;
+
+/* ------------------------------------------------------------------------- */
+static INLINE void sse2_planarMerge_C4(const BYTE* WINPR_RESTRICT p0,
+                                       const BYTE* WINPR_RESTRICT p1,
+                                       const BYTE* WINPR_RESTRICT p2,
+                                       const BYTE* WINPR_RESTRICT p3, BYTE* WINPR_RESTRICT pDst,
+                                       UINT32 width)
+{
+	const __m128i opaque = _mm_set1_epi8(-1);
+	UINT32 x = 0;
+
+	for (; x + 16 <= width; x += 16)
+	{
+		const __m128i c0 = LOAD_SI128(&p0[x]);
+		const __m128i c1 = LOAD_SI128(&p1[x]);
+		const __m128i c2 = LOAD_SI128(&p2[x]);
+		const __m128i c3 = p3 ? LOAD_SI128(&p3[x]) : opaque;
+
+		const __m128i lo01 = _mm_unpacklo_epi8(c0, c1);
+		const __m128i hi01 = _mm_unpackhi_epi8(c0, c1);
+		const __m128i lo23 = _mm_unpacklo_epi8(c2, c3);
+		const __m128i hi23 = _mm_unpackhi_epi8(c2, c3);
+
+		BYTE* dst = &pDst[4ULL * x];
+		STORE_SI128(&dst[0], _mm_unpacklo_epi16(lo01, lo23));
+		STORE_SI128(&dst[16], _mm_unpackhi_epi16(lo01, lo23));
+		STORE_SI128(&dst[32], _mm_unpacklo_epi16(hi01, hi23));
+		STORE_SI128(&dst[48], _mm_unpackhi_epi16(hi01, hi23));
+	}
+
+	for (; x < width; x++)
+	{
+		BYTE* dst = &pDst[4ULL * x];
+		dst[0] = p0[x];
+		dst[1] = p1[x];
+		dst[2] = p2[x];
+		dst[3] = p3 ? p3[x] : 0xFF;
+	}
+}
+
+static pstatus_t sse2_planarMerge_8u_P4C4R(const BYTE* WINPR_RESTRICT pSrc[4],
+                                           BYTE* WINPR_RESTRICT pDst, UINT32 DstFormat,
+                                           UINT32 width)
+{
+	switch (DstFormat)
+	{
+		case PIXEL_FORMAT_BGRA32:
+			sse2_planarMerge_C4(pSrc[2], pSrc[1], pSrc[0], pSrc[3], pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_BGRX32:
+			sse2_planarMerge_C4(pSrc[2], pSrc[1], pSrc[0], NULL, pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_RGBA32:
+			sse2_planarMerge_C4(pSrc[0], pSrc[1], pSrc[2], pSrc[3], pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		case PIXEL_FORMAT_RGBX32:
+			sse2_planarMerge_C4(pSrc[0], pSrc[1], pSrc[2], NULL, pDst, width);
+			return PRIMITIVES_SUCCESS;
+
+		default:
+			return generic->planarMerge_8u_P4C4R(pSrc, pDst, DstFormat, width);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t sse2_planarDeltaDecode_8u(const BYTE* WINPR_RESTRICT pPrev,
+                                           BYTE* WINPR_RESTRICT pSrcDst, UINT32 len)
+{
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i low7 = _mm_set1_epi8(0x7F);
+	UINT32 x = 0;
+
+	for (; x + 16 <= len; x += 16)
+	{
+		const __m128i v = LOAD_SI128(&pSrcDst[x]);
+		const __m128i sign = _mm_cmpeq_epi8(_mm_and_si128(v, one), one);
+		const __m128i mag = _mm_and_si128(_mm_srli_epi16(v, 1), low7);
+		const __m128i delta = _mm_xor_si128(mag, sign);
+		STORE_SI128(&pSrcDst[x], _mm_add_epi8(LOAD_SI128(&pPrev[x]), delta));
+	}
+
+	for (; x < len; x++)
+		pSrcDst[x] = planar_delta_decode(pPrev[x], pSrcDst[x]);
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_planar_sse2_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(SSE_AVX_INTRINSICS_ENABLED)
+	generic = primitives_get_generic();
+
+	WLog_VRB(PRIM_TAG, "SSE2 optimizations");
+	prims->planarMerge_8u_P4C4R = sse2_planarMerge_8u_P4C4R;
+	prims->planarDeltaDecode_8u = sse2_planarDeltaDecode_8u;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or SSE2 intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
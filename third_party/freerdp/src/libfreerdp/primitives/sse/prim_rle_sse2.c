@@ -0,0 +1,120 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized RLE run expansion helpers.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <string.h>
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#include "prim_internal.h"
+#include "prim_avxsse.h"
+#include "prim_rle.h"
+
+#if defined(SSE_AVX_INTRINSICS_ENABLED)
+#include <emmintrin.h>
+
+static primitives_t* generic = NULL;
+
+/* 48 bytes is a multiple of every pixel pattern size we vectorize
+ * (1, 2, 3, 4, 6 and 8), so three registers always hold whole patterns.
+ */
+#define RLE_BLOCK_SIZE 48
+
+static INLINE BOOL rle_fill_block(BYTE block[RLE_BLOCK_SIZE], const BYTE* WINPR_RESTRICT pPattern,
+                                  UINT32 patternSize)
+{
+	if ((RLE_BLOCK_SIZE % patternSize) != 0)
+		return FALSE;
+
+	for (size_t x = 0; x < RLE_BLOCK_SIZE; x += patternSize)
+		memcpy(&block[x], pPattern, patternSize);
+	return TRUE;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t sse2_rleExpand_8u(const BYTE* WINPR_RESTRICT pPattern, UINT32 patternSize,
+                                   BYTE* WINPR_RESTRICT pDst, UINT32 count)
+{
+	BYTE block[RLE_BLOCK_SIZE] = { 0 };
+
+	if ((patternSize <= 1) || (patternSize > 8) || !rle_fill_block(block, pPattern, patternSize))
+		return generic->rleExpand_8u(pPattern, patternSize, pDst, count);
+
+	const __m128i b0 = LOAD_SI128(&block[0]);
+	const __m128i b1 = LOAD_SI128(&block[16]);
+	const __m128i b2 = LOAD_SI128(&block[32]);
+	const size_t total = 1ull * patternSize * count;
+	size_t x = 0;
+
+	for (; x + RLE_BLOCK_SIZE <= total; x += RLE_BLOCK_SIZE)
+	{
+		STORE_SI128(&pDst[x + 0], b0);
+		STORE_SI128(&pDst[x + 16], b1);
+		STORE_SI128(&pDst[x + 32], b2);
+	}
+
+	/* x is a multiple of the pattern size, so the block still lines up. */
+	memcpy(&pDst[x], block, total - x);
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+static pstatus_t sse2_rleXorExpand_8u(const BYTE* WINPR_RESTRICT pSrc,
+                                      const BYTE* WINPR_RESTRICT pPattern, UINT32 patternSize,
+                                      BYTE* WINPR_RESTRICT pDst, UINT32 count)
+{
+	BYTE block[RLE_BLOCK_SIZE] = { 0 };
+
+	if ((patternSize == 0) || (patternSize > 4) || !rle_fill_block(block, pPattern, patternSize))
+		return generic->rleXorExpand_8u(pSrc, pPattern, patternSize, pDst, count);
+
+	const __m128i b0 = LOAD_SI128(&block[0]);
+	const __m128i b1 = LOAD_SI128(&block[16]);
+	const __m128i b2 = LOAD_SI128(&block[32]);
+	const size_t total = 1ull * patternSize * count;
+	size_t x = 0;
+
+	for (; x + RLE_BLOCK_SIZE <= total; x += RLE_BLOCK_SIZE)
+	{
+		STORE_SI128(&pDst[x + 0], _mm_xor_si128(LOAD_SI128(&pSrc[x + 0]), b0));
+		STORE_SI128(&pDst[x + 16], _mm_xor_si128(LOAD_SI128(&pSrc[x + 16]), b1));
+		STORE_SI128(&pDst[x + 32], _mm_xor_si128(LOAD_SI128(&pSrc[x + 32]), b2));
+	}
+
+	for (size_t i = 0; x < total; x++, i++)
+		pDst[x] = pSrc[x] ^ block[i];
+
+	return PRIMITIVES_SUCCESS;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_rle_sse2_int(primitives_t* WINPR_RESTRICT prims)
+{
+#if defined(SSE_AVX_INTRINSICS_ENABLED)
+	generic = primitives_get_generic();
+
+	WLog_VRB(PRIM_TAG, "SSE2 optimizations");
+	prims->rleExpand_8u = sse2_rleExpand_8u;
+	prims->rleXorExpand_8u = sse2_rleXorExpand_8u;
+#else
+	WLog_VRB(PRIM_TAG, "undefined WITH_SIMD or SSE2 intrinsics not available");
+	WINPR_UNUSED(prims);
+#endif
+}
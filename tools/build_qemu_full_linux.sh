@@ -96,6 +96,8 @@ cd "${BUILD_DIR}"
 QEMU_PATCHES=(
   "${REPO_ROOT}/patches/qemu/0001-ohos-builtin-minimal-tpm2.patch"
   "${REPO_ROOT}/patches/qemu/0002-ohos-ohaudio-audiodev.patch"
+  "${REPO_ROOT}/patches/qemu/0003-ohos-xcomponent-display.patch"
+  "${REPO_ROOT}/patches/qemu/0004-ohos-chardev-ring.patch"
 )
 for p in "${QEMU_PATCHES[@]}"; do
   if [[ -f "${p}" ]]; then